@@ -9,27 +9,62 @@
 
 #include "base/ios/block_types.h"
 
+// The priority of a deferred block. When several blocks are ready to run, the
+// block with the highest priority is run first.
+typedef NS_ENUM(NSInteger, DeferredInitializationPriority) {
+  DeferredInitializationPriorityLow,
+  DeferredInitializationPriorityDefault,
+  DeferredInitializationPriorityHigh,
+};
+
+// The thread a deferred block is run on.
+typedef NS_ENUM(NSInteger, DeferredInitializationThread) {
+  // The block is run on the main thread, one block at a time.
+  DeferredInitializationThreadMain,
+  // The block is thread-safe and is run in a task of the TaskScheduler, in
+  // parallel with the other blocks. Blocks which only post a task do not need
+  // to run in the background.
+  DeferredInitializationThreadBackground,
+};
+
 // A singleton object to run initialization code asynchronously. Blocks are
-// scheduled to be run after a delay. The block is named when added to the
-// singleton so that other code can force a deferred block to be run
-// synchronously if necessary.
+// run when the main thread is idle, i.e. when its run loop has no more events
+// to process and is about to sleep, so that they do not delay the handling of
+// user interactions. The block is named when added to the singleton so that
+// other code can force a deferred block to be run synchronously if necessary.
+// The duration of each block is recorded in the "startup" trace category.
 @interface DeferredInitializationRunner : NSObject
 
 // Returns singleton instance.
 + (DeferredInitializationRunner*)sharedInstance;
 
-// Stores |block| under |name| to a queue of blocks to run. All blocks are run
-// sequentially with a small delay before the first block and between each
-// successive block. If a block is already registered under |name|, it is
-// replaced with |block| unless it has already been run.
+// Stores |block| under |name| to run it on the main thread once the main
+// thread is idle, with the default priority and no dependencies. Blocks of the
+// same priority are run in the order they were enqueued. If a block is already
+// registered under |name|, it is replaced with |block| unless it has already
+// been run.
 - (void)enqueueBlockNamed:(NSString*)name block:(ProceduralBlock)block;
 
+// Stores |block| under |name| to run it on |thread| once the main thread is
+// idle and all the blocks named in |dependencies| have been run. Dependencies
+// which are not registered, have been cancelled or have already been run are
+// ignored, so dependencies must be enqueued before the blocks depending on
+// them.
+- (void)enqueueBlockNamed:(NSString*)name
+             dependencies:(NSArray<NSString*>*)dependencies
+                 priority:(DeferredInitializationPriority)priority
+                   thread:(DeferredInitializationThread)thread
+                    block:(ProceduralBlock)block;
+
 // Looks up a previously scheduled block of |name|. If block has not been
-// run yet, run it synchronously now.
-- (void)runBlockIfNecessary:(NSString*)name;
+// run yet, run it synchronously now, after the dependencies that have not
+// been run yet. Returns NO if the block or one of its dependencies is running
+// on a background thread, in which case it is not waited for: the block is
+// left to run once the main thread is idle and its dependencies finished.
+- (BOOL)runBlockIfNecessary:(NSString*)name;
 
 // Cancels a previously scheduled block of |name|. This is a no-op if the
-// block has already been executed.
+// block has already been executed or is running.
 - (void)cancelBlockNamed:(NSString*)name;
 
 // Number of blocks that have been registered but not executed yet.
@@ -38,15 +73,4 @@
 
 @end
 
-@interface DeferredInitializationRunner (ExposedForTesting)
-
-// Time interval between two blocks. Default value is 200ms.
-@property(nonatomic, assign) NSTimeInterval delayBetweenBlocks;
-
-// Time interval before running the first block. To override default value of
-// 3s, set this property before the first call to |-enqueueBlockNamed:block:|.
-@property(nonatomic, assign) NSTimeInterval delayBeforeFirstBlock;
-
-@end
-
 #endif  // IOS_CHROME_APP_DEFERRED_INITIALIZATION_RUNNER_H_
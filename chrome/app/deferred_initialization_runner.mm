@@ -6,13 +6,49 @@
 
 #include <stdint.h>
 
+#include "base/bind.h"
 #include "base/logging.h"
-#include "base/mac/scoped_block.h"
+#include "base/strings/sys_string_conversions.h"
+#include "base/task/post_task.h"
+#include "base/trace_event/trace_event.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "This file requires ARC support."
 #endif
 
+namespace {
+
+// The order of the observer detecting that the main thread is idle. Greater
+// than the order of the observer committing the Core Animation transactions
+// (2000000), so that the pending UI changes are committed before a block is
+// run.
+const CFIndex kIdleObserverOrder = 2000001;
+
+// Runs |block| on the current thread and records its duration in the startup
+// trace.
+void RunAndTrace(NSString* name, ProceduralBlock block) {
+  TRACE_EVENT2("startup", "DeferredInitializationRunner::RunBlock", "name",
+               base::SysNSStringToUTF8(name), "main_thread",
+               static_cast<bool>([NSThread isMainThread]));
+  block();
+}
+
+// Returns the priority of the background task running a block of |priority|.
+base::TaskPriority TaskPriorityForBlock(
+    DeferredInitializationPriority priority) {
+  switch (priority) {
+    case DeferredInitializationPriorityLow:
+      return base::TaskPriority::BEST_EFFORT;
+    case DeferredInitializationPriorityDefault:
+    case DeferredInitializationPriorityHigh:
+      return base::TaskPriority::USER_VISIBLE;
+  }
+  NOTREACHED();
+  return base::TaskPriority::BEST_EFFORT;
+}
+
+}  // namespace
+
 // An object encapsulating the deferred execution of a block of initialization
 // code.
 @interface DeferredInitializationBlock : NSObject
@@ -21,10 +57,23 @@
 
 // Designated initializer.
 - (instancetype)initWithName:(NSString*)name
+                dependencies:(NSArray<NSString*>*)dependencies
+                    priority:(DeferredInitializationPriority)priority
+                      thread:(DeferredInitializationThread)thread
                        block:(ProceduralBlock)block NS_DESIGNATED_INITIALIZER;
 
-// Executes the deferred block now.
-- (void)run;
+// A string to reference the initialization block.
+@property(nonatomic, copy, readonly) NSString* name;
+// The names of the blocks which must be run before this one.
+@property(nonatomic, copy, readonly) NSArray<NSString*>* dependencies;
+@property(nonatomic, readonly) DeferredInitializationPriority priority;
+@property(nonatomic, readonly) DeferredInitializationThread thread;
+// Whether the block has started running.
+@property(nonatomic, readonly, getter=isStarted) BOOL started;
+
+// Marks the block as started and returns the code to execute, or nil if the
+// block has been cancelled.
+- (ProceduralBlock)start;
 
 // Cancels the block's execution.
 - (void)cancel;
@@ -32,29 +81,40 @@
 @end
 
 @implementation DeferredInitializationBlock {
-  // A string to reference the initialization block.
-  NSString* _name;
   // A block of code to execute.
   ProceduralBlock _runBlock;
 }
 
-- (instancetype)initWithName:(NSString*)name block:(ProceduralBlock)block {
+@synthesize name = _name;
+@synthesize dependencies = _dependencies;
+@synthesize priority = _priority;
+@synthesize thread = _thread;
+@synthesize started = _started;
+
+- (instancetype)initWithName:(NSString*)name
+                dependencies:(NSArray<NSString*>*)dependencies
+                    priority:(DeferredInitializationPriority)priority
+                      thread:(DeferredInitializationThread)thread
+                       block:(ProceduralBlock)block {
   DCHECK(block);
   self = [super init];
   if (self) {
     _name = [name copy];
+    _dependencies = [dependencies copy] ?: @[];
+    _priority = priority;
+    _thread = thread;
     _runBlock = block;
   }
   return self;
 }
 
-- (void)run {
+- (ProceduralBlock)start {
   DCHECK([NSThread isMainThread]);
+  DCHECK(!_started);
+  _started = YES;
   ProceduralBlock deferredBlock = _runBlock;
-  if (!deferredBlock)
-    return;
-  deferredBlock();
-  [[DeferredInitializationRunner sharedInstance] cancelBlockNamed:_name];
+  _runBlock = nil;
+  return deferredBlock;
 }
 
 - (void)cancel {
@@ -64,28 +124,42 @@
 @end
 
 @interface DeferredInitializationRunner () {
-  NSMutableArray* _blocksNameQueue;
-  NSMutableDictionary* _runBlocks;
-  BOOL _isBlockScheduled;
+  // The names of the blocks which have not started, in the order they were
+  // enqueued.
+  NSMutableArray<NSString*>* _blocksNameQueue;
+  // The blocks which have not finished running, by name.
+  NSMutableDictionary<NSString*, DeferredInitializationBlock*>* _runBlocks;
+  // Observes the main run loop to run the blocks when it is about to sleep.
+  // Only installed while |_blocksNameQueue| is not empty.
+  CFRunLoopObserverRef _idleObserver;
 }
 
-// Schedule the next block to be run after |delay| it will automatically
-// schedule the next block after |delayBetweenBlocks|.
-- (void)scheduleNextBlockWithDelay:(NSTimeInterval)delay;
+// Starts the ready background blocks and runs the ready main thread block with
+// the highest priority. Called when the main thread is idle.
+- (void)runBlocksOnIdle;
+
+// Returns the block of |_blocksNameQueue| with the highest priority whose
+// dependencies have been run and which is run on |thread|, or nil.
+- (DeferredInitializationBlock*)nextReadyBlockOnThread:
+    (DeferredInitializationThread)thread;
+
+// Runs |block| synchronously on the main thread.
+- (void)runBlock:(DeferredInitializationBlock*)block;
+
+// Runs |block| on a background thread.
+- (void)startBlockInBackground:(DeferredInitializationBlock*)block;
 
-// Time interval between two blocks. Default value is 200ms.
-@property(nonatomic) NSTimeInterval delayBetweenBlocks;
+// Removes |block| from the blocks to run, once it has been run.
+- (void)blockDidFinish:(DeferredInitializationBlock*)block;
 
-// Time interval before running the first block. Default value is 3s.
-@property(nonatomic) NSTimeInterval delayBeforeFirstBlock;
+// Installs or removes |_idleObserver| depending on whether there are blocks to
+// run.
+- (void)updateIdleObserver;
 
 @end
 
 @implementation DeferredInitializationRunner
 
-@synthesize delayBetweenBlocks = _delayBetweenBlocks;
-@synthesize delayBeforeFirstBlock = _delayBeforeFirstBlock;
-
 + (DeferredInitializationRunner*)sharedInstance {
   static dispatch_once_t once = 0;
   static DeferredInitializationRunner* instance = nil;
@@ -100,67 +174,194 @@
   if (self) {
     _blocksNameQueue = [NSMutableArray array];
     _runBlocks = [NSMutableDictionary dictionary];
-    _isBlockScheduled = NO;
-    _delayBetweenBlocks = 0.2;
-    _delayBeforeFirstBlock = 3.0;
   }
   return self;
 }
 
+- (void)dealloc {
+  if (_idleObserver) {
+    CFRunLoopObserverInvalidate(_idleObserver);
+    CFRelease(_idleObserver);
+  }
+}
+
 - (void)enqueueBlockNamed:(NSString*)name block:(ProceduralBlock)block {
+  [self enqueueBlockNamed:name
+             dependencies:nil
+                 priority:DeferredInitializationPriorityDefault
+                   thread:DeferredInitializationThreadMain
+                    block:block];
+}
+
+- (void)enqueueBlockNamed:(NSString*)name
+             dependencies:(NSArray<NSString*>*)dependencies
+                 priority:(DeferredInitializationPriority)priority
+                   thread:(DeferredInitializationThread)thread
+                    block:(ProceduralBlock)block {
   DCHECK(name);
   DCHECK([NSThread isMainThread]);
+  DCHECK(![dependencies containsObject:name]);
   [self cancelBlockNamed:name];
   [_blocksNameQueue addObject:name];
 
   DeferredInitializationBlock* deferredBlock =
-      [[DeferredInitializationBlock alloc] initWithName:name block:block];
+      [[DeferredInitializationBlock alloc] initWithName:name
+                                           dependencies:dependencies
+                                               priority:priority
+                                                 thread:thread
+                                                  block:block];
   [_runBlocks setObject:deferredBlock forKey:name];
+  [self updateIdleObserver];
+}
 
-  if (!_isBlockScheduled) {
-    [self scheduleNextBlockWithDelay:self.delayBeforeFirstBlock];
+- (BOOL)runBlockIfNecessary:(NSString*)name {
+  DCHECK([NSThread isMainThread]);
+  DeferredInitializationBlock* block = [_runBlocks objectForKey:name];
+  if (!block)
+    return YES;
+  // A block which has started but has not finished is running on a background
+  // thread.
+  if (block.started)
+    return NO;
+  BOOL dependenciesFinished = YES;
+  for (NSString* dependency in block.dependencies) {
+    if (![self runBlockIfNecessary:dependency])
+      dependenciesFinished = NO;
   }
+  // The block is run when idle once its background dependencies finish.
+  if (!dependenciesFinished)
+    return NO;
+  // Running a dependency may have run or cancelled the block.
+  if ([_runBlocks objectForKey:name] == block)
+    [self runBlock:block];
+  return YES;
 }
 
-- (void)scheduleNextBlockWithDelay:(NSTimeInterval)delay {
+- (void)cancelBlockNamed:(NSString*)name {
   DCHECK([NSThread isMainThread]);
-  _isBlockScheduled = NO;
-  NSString* nextBlockName = [_blocksNameQueue firstObject];
-  if (!nextBlockName)
+  DCHECK(name);
+  DeferredInitializationBlock* block = [_runBlocks objectForKey:name];
+  if (!block || block.started)
     return;
+  [_blocksNameQueue removeObject:name];
+  [block cancel];
+  [_runBlocks removeObjectForKey:name];
+  [self updateIdleObserver];
+}
 
-  DeferredInitializationBlock* nextBlock =
-      [_runBlocks objectForKey:nextBlockName];
-  DCHECK(nextBlock);
+- (NSUInteger)numberOfBlocksRemaining {
+  return [_runBlocks count];
+}
 
-  __weak DeferredInitializationRunner* weakSelf = self;
+#pragma mark - Private
 
-  dispatch_after(
-      dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
-      dispatch_get_main_queue(), ^{
-        [nextBlock run];
-        [weakSelf scheduleNextBlockWithDelay:[weakSelf delayBetweenBlocks]];
-      });
+- (void)runBlocksOnIdle {
+  DCHECK([NSThread isMainThread]);
+  // Background blocks do not use the main thread, so all the ready ones are
+  // started at once.
+  while (DeferredInitializationBlock* block = [self
+             nextReadyBlockOnThread:DeferredInitializationThreadBackground]) {
+    [self startBlockInBackground:block];
+  }
 
-  _isBlockScheduled = YES;
-  [_blocksNameQueue removeObjectAtIndex:0];
+  // Only one main thread block is run per run loop iteration, so that the
+  // events received while it runs are handled before the next one. Running it
+  // wakes the run loop up for the next iteration.
+  DeferredInitializationBlock* block =
+      [self nextReadyBlockOnThread:DeferredInitializationThreadMain];
+  if (block)
+    [self runBlock:block];
 }
 
-- (void)runBlockIfNecessary:(NSString*)name {
+- (DeferredInitializationBlock*)nextReadyBlockOnThread:
+    (DeferredInitializationThread)thread {
+  DeferredInitializationBlock* nextBlock = nil;
+  for (NSString* name in _blocksNameQueue) {
+    DeferredInitializationBlock* block = [_runBlocks objectForKey:name];
+    DCHECK(block);
+    if (block.thread != thread)
+      continue;
+    if (nextBlock && block.priority <= nextBlock.priority)
+      continue;
+    BOOL ready = YES;
+    for (NSString* dependency in block.dependencies) {
+      if ([_runBlocks objectForKey:dependency]) {
+        ready = NO;
+        break;
+      }
+    }
+    if (ready)
+      nextBlock = block;
+  }
+  return nextBlock;
+}
+
+- (void)runBlock:(DeferredInitializationBlock*)block {
   DCHECK([NSThread isMainThread]);
-  [[_runBlocks objectForKey:name] run];
+  [_blocksNameQueue removeObject:block.name];
+  ProceduralBlock deferredBlock = [block start];
+  if (deferredBlock)
+    RunAndTrace(block.name, deferredBlock);
+  [self blockDidFinish:block];
 }
 
-- (void)cancelBlockNamed:(NSString*)name {
+- (void)startBlockInBackground:(DeferredInitializationBlock*)block {
   DCHECK([NSThread isMainThread]);
-  DCHECK(name);
-  [_blocksNameQueue removeObject:name];
-  [[_runBlocks objectForKey:name] cancel];
-  [_runBlocks removeObjectForKey:name];
+  [_blocksNameQueue removeObject:block.name];
+  ProceduralBlock deferredBlock = [block start];
+  if (!deferredBlock) {
+    [self blockDidFinish:block];
+    return;
+  }
+  NSString* name = block.name;
+  __weak DeferredInitializationRunner* weakSelf = self;
+  // The runner is driven by the main run loop rather than by a task runner, so
+  // the end of the block is reported through the main queue.
+  base::PostTaskWithTraits(
+      FROM_HERE, {base::MayBlock(), TaskPriorityForBlock(block.priority)},
+      base::BindOnce(^{
+        RunAndTrace(name, deferredBlock);
+        dispatch_async(dispatch_get_main_queue(), ^{
+          [weakSelf blockDidFinish:block];
+        });
+      }));
 }
 
-- (NSUInteger)numberOfBlocksRemaining {
-  return [_runBlocks count];
+- (void)blockDidFinish:(DeferredInitializationBlock*)block {
+  DCHECK([NSThread isMainThread]);
+  // The block may have been replaced while it was running.
+  if ([_runBlocks objectForKey:block.name] == block)
+    [_runBlocks removeObjectForKey:block.name];
+  [self updateIdleObserver];
+}
+
+- (void)updateIdleObserver {
+  DCHECK([NSThread isMainThread]);
+  if (![_blocksNameQueue count]) {
+    if (_idleObserver) {
+      CFRunLoopObserverInvalidate(_idleObserver);
+      CFRelease(_idleObserver);
+      _idleObserver = nullptr;
+    }
+    return;
+  }
+
+  if (!_idleObserver) {
+    __weak DeferredInitializationRunner* weakSelf = self;
+    // Only observe the default mode, so that no block is run while the user
+    // is scrolling.
+    _idleObserver = CFRunLoopObserverCreateWithHandler(
+        kCFAllocatorDefault, kCFRunLoopBeforeWaiting, true, kIdleObserverOrder,
+        ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+          [weakSelf runBlocksOnIdle];
+        });
+    CFRunLoopAddObserver(CFRunLoopGetMain(), _idleObserver,
+                         kCFRunLoopDefaultMode);
+  }
+  // Wake the run loop up so that it goes through another iteration and runs
+  // the next block once idle, e.g. after a block was run or when a background
+  // block finished and unblocked other blocks.
+  CFRunLoopWakeUp(CFRunLoopGetMain());
 }
 
 @end
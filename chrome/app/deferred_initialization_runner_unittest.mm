@@ -5,14 +5,20 @@
 #import "ios/chrome/app/deferred_initialization_runner.h"
 
 #import "base/test/ios/wait_util.h"
+#include "base/test/scoped_task_environment.h"
 #include "base/time/time.h"
+#include "testing/gtest_mac.h"
 #include "testing/platform_test.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "This file requires ARC support."
 #endif
 
-using DeferredInitializationRunnerTest = PlatformTest;
+class DeferredInitializationRunnerTest : public PlatformTest {
+ protected:
+  // Runs the background blocks.
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+};
 
 TEST_F(DeferredInitializationRunnerTest, TestSharedInstance) {
   EXPECT_TRUE([DeferredInitializationRunner sharedInstance]);
@@ -21,7 +27,8 @@ TEST_F(DeferredInitializationRunnerTest, TestSharedInstance) {
       cancelBlockNamed:@"Invalid Name"];
 }
 
-// Tests that all blocks added on the queue are executed after a delay.
+// Tests that all blocks added on the queue are executed once the main thread
+// is idle, in order.
 TEST_F(DeferredInitializationRunnerTest, TestRunBlockSequentially) {
   // Setup.
   __block bool firstFlag = NO;
@@ -33,14 +40,13 @@ TEST_F(DeferredInitializationRunnerTest, TestRunBlockSequentially) {
     firstFlag = YES;
   };
   ProceduralBlock secondBlock = ^{
+    EXPECT_TRUE(firstFlag);
     EXPECT_FALSE(secondFlag);
     secondFlag = YES;
   };
   ConditionBlock secondBlockRun = ^bool {
     return secondFlag;
   };
-  runner.delayBetweenBlocks = 0.01;
-  runner.delayBeforeFirstBlock = 0.01;
 
   [runner enqueueBlockNamed:@"first block" block:firstBlock];
   [runner enqueueBlockNamed:@"second block" block:secondBlock];
@@ -69,25 +75,18 @@ TEST_F(DeferredInitializationRunnerTest, TestRunBlock) {
   ProceduralBlock quickBlock = ^{
     EXPECT_FALSE(quickFlag);
     quickFlag = YES;
-    // Make sure we have time to go back to this test before running the second
-    // task.
-    runner.delayBetweenBlocks = 1;
-  };
-  ConditionBlock quickBlockRun = ^bool {
-    return quickFlag;
   };
   ProceduralBlock slowBlock = ^{
     EXPECT_FALSE(slowFlag);
     slowFlag = YES;
   };
-  runner.delayBeforeFirstBlock = 0.01;
 
   // Action.
   [runner enqueueBlockNamed:@"quick block" block:quickBlock];
   [runner enqueueBlockNamed:@"slow block" block:slowBlock];
+  [runner runBlockIfNecessary:@"quick block"];
 
   // Test.
-  base::test::ios::WaitUntilCondition(quickBlockRun);
   EXPECT_TRUE(quickFlag);
   EXPECT_FALSE(slowFlag);
   EXPECT_EQ(1U, [runner numberOfBlocksRemaining]);
@@ -105,8 +104,6 @@ TEST_F(DeferredInitializationRunnerTest, TestCancelBlock) {
   __block BOOL blockFinished = NO;
   DeferredInitializationRunner* runner =
       [DeferredInitializationRunner sharedInstance];
-  runner.delayBeforeFirstBlock = 0.01;
-  runner.delayBetweenBlocks = 0.01;
 
   [runner enqueueBlockNamed:@"cancel me"
                       block:^{
@@ -128,8 +125,6 @@ TEST_F(DeferredInitializationRunnerTest, TestCancelledBlockDoNothing) {
   __block BOOL blockFinished = NO;
   DeferredInitializationRunner* runner =
       [DeferredInitializationRunner sharedInstance];
-  runner.delayBeforeFirstBlock = 0.01;
-  runner.delayBetweenBlocks = 0.01;
 
   [runner enqueueBlockNamed:@"cancel me"
                       block:^{
@@ -155,8 +150,6 @@ TEST_F(DeferredInitializationRunnerTest, TestSecondBlockInvalidatesFirst) {
   };
   DeferredInitializationRunner* runner =
       [DeferredInitializationRunner sharedInstance];
-  runner.delayBeforeFirstBlock = 0.01;
-  runner.delayBetweenBlocks = 0.01;
 
   // Action.
   [runner enqueueBlockNamed:@"multiple" block:runBlock];
@@ -168,3 +161,140 @@ TEST_F(DeferredInitializationRunnerTest, TestSecondBlockInvalidatesFirst) {
   EXPECT_EQ(0U, [runner numberOfBlocksRemaining]);
   EXPECT_EQ(1, blockRunCount);
 }
+
+// Tests that the blocks with the highest priority are run first.
+TEST_F(DeferredInitializationRunnerTest, TestPriority) {
+  // Setup.
+  NSMutableArray<NSString*>* runNames = [NSMutableArray array];
+  DeferredInitializationRunner* runner =
+      [DeferredInitializationRunner sharedInstance];
+
+  // Action.
+  for (NSString* name in @[ @"low", @"high" ]) {
+    [runner enqueueBlockNamed:name
+                 dependencies:nil
+                     priority:[name isEqualToString:@"low"]
+                                  ? DeferredInitializationPriorityLow
+                                  : DeferredInitializationPriorityHigh
+                       thread:DeferredInitializationThreadMain
+                        block:^{
+                          [runNames addObject:name];
+                        }];
+  }
+  base::test::ios::WaitUntilCondition(^bool {
+    return [runNames count] == 2;
+  });
+
+  // Test.
+  EXPECT_NSEQ((@[ @"high", @"low" ]), runNames);
+  EXPECT_EQ(0U, [runner numberOfBlocksRemaining]);
+}
+
+// Tests that a block is only run once its dependencies have been run, even if
+// they have a lower priority or are run on a background thread.
+TEST_F(DeferredInitializationRunnerTest, TestDependencies) {
+  // Setup.
+  NSMutableArray<NSString*>* runNames = [NSMutableArray array];
+  __block BOOL backgroundBlockRunOnMainThread = YES;
+  DeferredInitializationRunner* runner =
+      [DeferredInitializationRunner sharedInstance];
+
+  // Action.
+  [runner enqueueBlockNamed:@"background"
+               dependencies:nil
+                   priority:DeferredInitializationPriorityLow
+                     thread:DeferredInitializationThreadBackground
+                      block:^{
+                        backgroundBlockRunOnMainThread =
+                            [NSThread isMainThread];
+                        // |runNames| is only accessed on the main thread.
+                        dispatch_sync(dispatch_get_main_queue(), ^{
+                          [runNames addObject:@"background"];
+                        });
+                      }];
+  [runner enqueueBlockNamed:@"main"
+               dependencies:@[ @"background" ]
+                   priority:DeferredInitializationPriorityHigh
+                     thread:DeferredInitializationThreadMain
+                      block:^{
+                        [runNames addObject:@"main"];
+                      }];
+  EXPECT_EQ(2U, [runner numberOfBlocksRemaining]);
+  base::test::ios::WaitUntilCondition(^bool {
+    return [runNames count] == 2;
+  });
+
+  // Test.
+  EXPECT_FALSE(backgroundBlockRunOnMainThread);
+  EXPECT_NSEQ((@[ @"background", @"main" ]), runNames);
+  EXPECT_EQ(0U, [runner numberOfBlocksRemaining]);
+}
+
+// Tests that runBlockIfNecessary runs the dependencies of the block first.
+TEST_F(DeferredInitializationRunnerTest, TestRunBlockRunsDependencies) {
+  // Setup.
+  NSMutableArray<NSString*>* runNames = [NSMutableArray array];
+  DeferredInitializationRunner* runner =
+      [DeferredInitializationRunner sharedInstance];
+  [runner enqueueBlockNamed:@"dependency"
+                      block:^{
+                        [runNames addObject:@"dependency"];
+                      }];
+  [runner enqueueBlockNamed:@"dependent"
+               dependencies:@[ @"dependency", @"unknown" ]
+                   priority:DeferredInitializationPriorityDefault
+                     thread:DeferredInitializationThreadBackground
+                      block:^{
+                        [runNames addObject:@"dependent"];
+                      }];
+
+  // Action.
+  [runner runBlockIfNecessary:@"dependent"];
+
+  // Test.
+  EXPECT_NSEQ((@[ @"dependency", @"dependent" ]), runNames);
+  EXPECT_EQ(0U, [runner numberOfBlocksRemaining]);
+}
+
+// Tests that runBlockIfNecessary does not run a block while one of its
+// dependencies is running on a background thread, and that the block is run
+// once the dependency finishes.
+TEST_F(DeferredInitializationRunnerTest, TestRunBlockWithRunningDependency) {
+  // Setup.
+  dispatch_semaphore_t backgroundStarted = dispatch_semaphore_create(0);
+  dispatch_semaphore_t backgroundReleased = dispatch_semaphore_create(0);
+  __block BOOL mainFlag = NO;
+  DeferredInitializationRunner* runner =
+      [DeferredInitializationRunner sharedInstance];
+  [runner enqueueBlockNamed:@"background"
+               dependencies:nil
+                   priority:DeferredInitializationPriorityDefault
+                     thread:DeferredInitializationThreadBackground
+                      block:^{
+                        dispatch_semaphore_signal(backgroundStarted);
+                        dispatch_semaphore_wait(backgroundReleased,
+                                                DISPATCH_TIME_FOREVER);
+                      }];
+  [runner enqueueBlockNamed:@"main"
+               dependencies:@[ @"background" ]
+                   priority:DeferredInitializationPriorityDefault
+                     thread:DeferredInitializationThreadMain
+                      block:^{
+                        mainFlag = YES;
+                      }];
+  base::test::ios::WaitUntilCondition(^bool {
+    return !dispatch_semaphore_wait(backgroundStarted, DISPATCH_TIME_NOW);
+  });
+
+  // Action.
+  EXPECT_FALSE([runner runBlockIfNecessary:@"main"]);
+
+  // Test.
+  EXPECT_FALSE(mainFlag);
+  EXPECT_EQ(2U, [runner numberOfBlocksRemaining]);
+  dispatch_semaphore_signal(backgroundReleased);
+  base::test::ios::WaitUntilCondition(^bool {
+    return mainFlag;
+  });
+  EXPECT_EQ(0U, [runner numberOfBlocksRemaining]);
+}
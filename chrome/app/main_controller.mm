@@ -84,6 +84,7 @@
 #include "ios/chrome/browser/ios_chrome_io_thread.h"
 #include "ios/chrome/browser/mailto/features.h"
 #import "ios/chrome/browser/memory/memory_debugger_manager.h"
+#include "ios/chrome/browser/memory/memory_sampler.h"
 #include "ios/chrome/browser/metrics/first_user_action_recorder.h"
 #import "ios/chrome/browser/metrics/previous_session_info.h"
 #import "ios/chrome/browser/net/cookie_util.h"
@@ -246,6 +247,11 @@ enum class TabSwitcherDismissalMode { NONE, NORMAL, INCOGNITO };
 // The delay, in seconds, for cleaning external files.
 const int kExternalFilesCleanupDelaySeconds = 60;
 
+// The interval, in seconds, between two samples of the memory used when memory
+// debugging is enabled, and the number of samples kept (ten minutes' worth).
+const int kMemorySamplingIntervalSeconds = 1;
+const size_t kMaxMemorySamples = 600;
+
 // Delegate for the AuthenticationService.
 class MainControllerAuthenticationServiceDelegate
     : public AuthenticationServiceDelegate {
@@ -320,6 +326,10 @@ enum class EnterTabSwitcherSnapshotResult {
   // The object that drives the Chrome startup/shutdown logic.
   std::unique_ptr<IOSChromeMain> _chromeMain;
 
+  // Records the peak memory used during startup, session restore and while
+  // the tab grid is shown. Created once the TaskScheduler is running.
+  std::unique_ptr<memory_util::MemorySampler> _memorySampler;
+
   // The ChromeBrowserState associated with the main (non-OTR) browsing mode.
   ios::ChromeBrowserState* _mainBrowserState;  // Weak.
 
@@ -658,6 +668,11 @@ enum class EnterTabSwitcherSnapshotResult {
 
   _chromeMain = [ChromeMainStarter startChromeMain];
 
+  _memorySampler = std::make_unique<memory_util::MemorySampler>(
+      base::TimeDelta::FromSeconds(kMemorySamplingIntervalSeconds),
+      kMaxMemorySamples);
+  _memorySampler->BeginPhase(memory_util::MemorySampler::kStartupPhase);
+
   // Initialize the ChromeBrowserProvider.
   ios::GetChromeBrowserProvider()->Initialize();
 
@@ -753,7 +768,9 @@ enum class EnterTabSwitcherSnapshotResult {
   [MDCTypography setFontLoader:[MDFRobotoFontLoader sharedInstance]];
 
   // Ensure the main tab model is created. This also creates the BVC.
+  _memorySampler->BeginPhase(memory_util::MemorySampler::kSessionRestorePhase);
   [_browserViewWrangler createMainBrowser];
+  _memorySampler->EndPhase(memory_util::MemorySampler::kSessionRestorePhase);
 
   _spotlightManager =
       [SpotlightManager spotlightManagerWithBrowserState:_mainBrowserState];
@@ -818,6 +835,8 @@ enum class EnterTabSwitcherSnapshotResult {
 
   [self scheduleTasksRequiringBVCWithBrowserState];
 
+  _memorySampler->EndPhase(memory_util::MemorySampler::kStartupPhase);
+
   // Now that everything is properly set up, run the tests.
   tests_hook::RunTestsIfPresent();
 }
@@ -982,6 +1001,8 @@ enum class EnterTabSwitcherSnapshotResult {
   // Unregister the observer before the service is destroyed.
   _localStatePrefChangeRegistrar.RemoveAll();
 
+  // The sampler posts to the TaskScheduler, which is shut down by _chromeMain.
+  _memorySampler.reset();
   _chromeMain.reset();
 }
 
@@ -1025,6 +1046,9 @@ enum class EnterTabSwitcherSnapshotResult {
 - (void)schedulePrefObserverInitialization {
   [[DeferredInitializationRunner sharedInstance]
       enqueueBlockNamed:kPrefObserverInit
+           dependencies:nil
+               priority:DeferredInitializationPriorityHigh
+                 thread:DeferredInitializationThreadMain
                   block:^{
                     // Track changes to local state prefs.
                     _localStatePrefObserverBridge.reset(
@@ -1083,6 +1107,9 @@ enum class EnterTabSwitcherSnapshotResult {
 - (void)scheduleStartupAttemptReset {
   [[DeferredInitializationRunner sharedInstance]
       enqueueBlockNamed:kStartupAttemptReset
+           dependencies:nil
+               priority:DeferredInitializationPriorityHigh
+                 thread:DeferredInitializationThreadMain
                   block:^{
                     crash_util::ResetFailedStartupAttemptCount();
                   }];
@@ -1091,6 +1118,9 @@ enum class EnterTabSwitcherSnapshotResult {
 - (void)scheduleCrashReportCleanup {
   [[DeferredInitializationRunner sharedInstance]
       enqueueBlockNamed:kCleanupCrashReports
+           dependencies:nil
+               priority:DeferredInitializationPriorityLow
+                 thread:DeferredInitializationThreadMain
                   block:^{
                     breakpad_helper::CleanupCrashReports();
                   }];
@@ -1099,7 +1129,12 @@ enum class EnterTabSwitcherSnapshotResult {
 - (void)scheduleSnapshotPurge {
   [[DeferredInitializationRunner sharedInstance]
       enqueueBlockNamed:kPurgeSnapshots
+           dependencies:nil
+               priority:DeferredInitializationPriorityLow
+                 thread:DeferredInitializationThreadMain
                   block:^{
+                    // The live sessions are read on the main thread, the
+                    // files are deleted on the snapshot cache's sequence.
                     [self purgeSnapshots];
                   }];
 }
@@ -1129,6 +1164,7 @@ enum class EnterTabSwitcherSnapshotResult {
 
 - (void)scheduleMemoryDebuggingTools {
   if (experimental_flags::IsMemoryDebuggingEnabled()) {
+    _memorySampler->Start();
     [[DeferredInitializationRunner sharedInstance]
         enqueueBlockNamed:kMemoryDebuggingToolsStartup
                     block:^{
@@ -1241,6 +1277,9 @@ enum class EnterTabSwitcherSnapshotResult {
 - (void)scheduleDeleteDownloadsDirectory {
   [[DeferredInitializationRunner sharedInstance]
       enqueueBlockNamed:kDeleteDownloads
+           dependencies:nil
+               priority:DeferredInitializationPriorityLow
+                 thread:DeferredInitializationThreadMain
                   block:^{
                     DeleteDownloadsDirectory();
                   }];
@@ -2028,6 +2067,8 @@ enum class EnterTabSwitcherSnapshotResult {
   [_tabSwitcher restoreInternalStateWithMainTabModel:self.mainTabModel
                                          otrTabModel:self.otrTabModel
                                       activeTabModel:self.currentTabModel];
+  if (!_tabSwitcherIsActive)
+    _memorySampler->BeginPhase(memory_util::MemorySampler::kTabGridPhase);
   _tabSwitcherIsActive = YES;
   [_tabSwitcher setDelegate:self];
 
@@ -2131,6 +2172,7 @@ enum class EnterTabSwitcherSnapshotResult {
     action();
   }
 
+  _memorySampler->EndPhase(memory_util::MemorySampler::kTabGridPhase);
   _tabSwitcherIsActive = NO;
   _dismissingTabSwitcher = NO;
 }
@@ -2686,6 +2728,10 @@ enum class EnterTabSwitcherSnapshotResult {
 
 @implementation MainController (TestingOnly)
 
+- (memory_util::MemorySampler*)memorySampler {
+  return _memorySampler.get();
+}
+
 - (DeviceSharingManager*)deviceSharingManager {
   return [_browserViewWrangler deviceSharingManager];
 }
@@ -13,6 +13,9 @@
 
 @class DeviceSharingManager;
 class GURL;
+namespace memory_util {
+class MemorySampler;
+}  // namespace memory_util
 @protocol TabSwitcher;
 
 // Private methods and protocols that are made visible here for tests.
@@ -35,6 +38,9 @@ class GURL;
 @interface MainController (TestingOnly)
 
 @property(nonatomic, readonly) DeviceSharingManager* deviceSharingManager;
+// Records the memory used during the startup, session restore and tab grid
+// phases. Null before Chrome main is started.
+@property(nonatomic, readonly) memory_util::MemorySampler* memorySampler;
 @property(nonatomic, retain) id<TabSwitcher> tabSwitcher;
 
 // The top presented view controller that is not currently being dismissed.
@@ -13,6 +13,7 @@
 #include "ios/chrome/app/tests_hook.h"
 #include "ios/chrome/browser/application_context.h"
 #include "ios/chrome/browser/bookmarks/startup_task_runner_service_factory.h"
+#include "ios/chrome/browser/browser_state/browser_state_keyed_service_factories.h"
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
 #include "ios/chrome/browser/ios_chrome_io_thread.h"
 #import "ios/chrome/browser/omaha/omaha_service.h"
@@ -31,6 +32,8 @@ namespace {
 // Constants for deferred initilization of the profile start-up task runners.
 NSString* const kStartProfileStartupTaskRunners =
     @"StartProfileStartupTaskRunners";
+// Constant for deferred creation of the keyed services not needed at startup.
+NSString* const kCreateDeferredKeyedServices = @"CreateDeferredKeyedServices";
 }  // namespace
 
 @interface StartupTasks ()
@@ -58,6 +61,11 @@ NSString* const kStartProfileStartupTaskRunners =
                     [self performDeferredInitializationForBrowserState:
                               browserState];
                   }];
+  [[DeferredInitializationRunner sharedInstance]
+      enqueueBlockNamed:kCreateDeferredKeyedServices
+                  block:^{
+                    CreateDeferredBrowserStateKeyedServices(browserState);
+                  }];
 }
 
 - (void)initializeOmaha {
@@ -10,4 +10,25 @@
 // state creation time (as opposed to lazily on first access).
 void EnsureBrowserStateKeyedServiceFactoriesBuilt();
 
+namespace ios {
+class ChromeBrowserState;
+}
+
+// Creates the keyed services of |browser_state| which are created with it, one
+// at a time so that the cost of each is recorded by a
+// KeyedServiceCreationRecorder. The services which must exist for the whole
+// life of |browser_state| but are not needed to display the first window are
+// left to CreateDeferredBrowserStateKeyedServices() when
+// kLazyBrowserStateKeyedServices is enabled.
+void CreateStartupBrowserStateKeyedServices(
+    ios::ChromeBrowserState* browser_state);
+
+// Creates the keyed services of |browser_state| which must exist for its whole
+// life but are not needed to display the first window, when
+// kLazyBrowserStateKeyedServices is enabled. Otherwise these services are
+// created with the browser state and this is a no-op. Meant to be called once
+// the app is idle after startup.
+void CreateDeferredBrowserStateKeyedServices(
+    ios::ChromeBrowserState* browser_state);
+
 #endif  // IOS_CHROME_BROWSER_BROWSER_STATE_BROWSER_STATE_KEYED_SERVICE_FACTORIES_H_
@@ -11,6 +11,8 @@
 #include "ios/chrome/browser/autofill/personal_data_manager_factory.h"
 #include "ios/chrome/browser/bookmarks/bookmark_model_factory.h"
 #include "ios/chrome/browser/bookmarks/startup_task_runner_service_factory.h"
+#include "ios/chrome/browser/browser_state/features.h"
+#include "ios/chrome/browser/browser_state/keyed_service_creation_recorder.h"
 #include "ios/chrome/browser/browsing_data/browsing_data_remover_factory.h"
 #include "ios/chrome/browser/content_settings/cookie_settings_factory.h"
 #include "ios/chrome/browser/dom_distiller/dom_distiller_service_factory.h"
@@ -129,3 +131,38 @@ void EnsureBrowserStateKeyedServiceFactoriesBuilt() {
   UrlLanguageHistogramFactory::GetInstance();
   WebStateListWebUsageEnablerFactory::GetInstance();
 }
+
+namespace {
+
+// Creates the keyed services of |browser_state| which must exist for its whole
+// life but are not needed to display the first window, recording the cost of
+// each.
+void CreateLongLivedBrowserStateKeyedServices(
+    ios::ChromeBrowserState* browser_state) {
+  {
+    KeyedServiceCreationRecorder recorder("GoogleURLTracker");
+    ios::GoogleURLTrackerFactory::GetForBrowserState(browser_state);
+  }
+  {
+    KeyedServiceCreationRecorder recorder("SigninBrowserStateInfoUpdater");
+    SigninBrowserStateInfoUpdaterFactory::GetForBrowserState(browser_state);
+  }
+}
+
+}  // namespace
+
+void CreateStartupBrowserStateKeyedServices(
+    ios::ChromeBrowserState* browser_state) {
+  {
+    KeyedServiceCreationRecorder recorder("BrowserDownloadService");
+    BrowserDownloadServiceFactory::GetForBrowserState(browser_state);
+  }
+  if (!base::FeatureList::IsEnabled(kLazyBrowserStateKeyedServices))
+    CreateLongLivedBrowserStateKeyedServices(browser_state);
+}
+
+void CreateDeferredBrowserStateKeyedServices(
+    ios::ChromeBrowserState* browser_state) {
+  if (base::FeatureList::IsEnabled(kLazyBrowserStateKeyedServices))
+    CreateLongLivedBrowserStateKeyedServices(browser_state);
+}
@@ -23,6 +23,7 @@
 #include "ios/chrome/browser/application_context.h"
 #include "ios/chrome/browser/bookmarks/bookmark_model_factory.h"
 #include "ios/chrome/browser/browser_state/bookmark_model_loaded_observer.h"
+#include "ios/chrome/browser/browser_state/browser_state_keyed_service_factories.h"
 #include "ios/chrome/browser/browser_state/off_the_record_chrome_browser_state_impl.h"
 #include "ios/chrome/browser/chrome_constants.h"
 #include "ios/chrome/browser/chrome_paths_internal.h"
@@ -108,6 +109,9 @@ ChromeBrowserStateImpl::ChromeBrowserStateImpl(
   MigrateObsoleteLocalStatePrefs(local_state);
   MigrateObsoleteBrowserStatePrefs(prefs_.get());
 
+  // Create the startup-critical services first, so that the cost of each is
+  // recorded. The dependency manager then only creates the remaining ones.
+  CreateStartupBrowserStateKeyedServices(this);
   BrowserStateDependencyManager::GetInstance()->CreateBrowserStateServices(
       this);
 
@@ -0,0 +1,15 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_BROWSER_STATE_FEATURES_H_
+#define IOS_CHROME_BROWSER_BROWSER_STATE_FEATURES_H_
+
+#include "base/feature_list.h"
+
+// Used to only create the startup-critical keyed services with the browser
+// state. The other services are created on first access, or once the app is
+// idle for the ones which must exist for the whole life of the browser state.
+extern const base::Feature kLazyBrowserStateKeyedServices;
+
+#endif  // IOS_CHROME_BROWSER_BROWSER_STATE_FEATURES_H_
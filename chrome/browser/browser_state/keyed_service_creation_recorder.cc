@@ -0,0 +1,37 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/browser_state/keyed_service_creation_recorder.h"
+
+#include <string>
+
+#include "base/metrics/histogram_functions.h"
+#include "base/trace_event/trace_event.h"
+#include "ios/chrome/browser/memory/memory_metrics.h"
+
+const char KeyedServiceCreationRecorder::kCreationTimeHistogramPrefix[] =
+    "IOS.KeyedService.CreationTime.";
+const char KeyedServiceCreationRecorder::kCreationMemoryHistogramPrefix[] =
+    "IOS.KeyedService.CreationMemory.";
+
+KeyedServiceCreationRecorder::KeyedServiceCreationRecorder(const char* name)
+    : name_(name),
+      start_time_(base::TimeTicks::Now()),
+      start_memory_bytes_(memory_util::GetRealMemoryUsedInBytes()) {
+  TRACE_EVENT_BEGIN1("startup", "KeyedServiceCreation", "name", name_);
+}
+
+KeyedServiceCreationRecorder::~KeyedServiceCreationRecorder() {
+  TRACE_EVENT_END0("startup", "KeyedServiceCreation");
+  base::UmaHistogramTimes(std::string(kCreationTimeHistogramPrefix) + name_,
+                          base::TimeTicks::Now() - start_time_);
+  // The memory used may decrease, e.g. when caches are purged in parallel.
+  const uint64_t end_memory_bytes = memory_util::GetRealMemoryUsedInBytes();
+  uint64_t memory_growth_bytes = 0;
+  if (end_memory_bytes > start_memory_bytes_)
+    memory_growth_bytes = end_memory_bytes - start_memory_bytes_;
+  base::UmaHistogramMemoryKB(
+      std::string(kCreationMemoryHistogramPrefix) + name_,
+      static_cast<int>(memory_growth_bytes / 1024));
+}
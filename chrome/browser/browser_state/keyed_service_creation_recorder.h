@@ -0,0 +1,39 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_BROWSER_STATE_KEYED_SERVICE_CREATION_RECORDER_H_
+#define IOS_CHROME_BROWSER_BROWSER_STATE_KEYED_SERVICE_CREATION_RECORDER_H_
+
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+
+// Records the cost of the keyed services created during its lifetime, so that
+// the services slowing cold start down can be identified. The duration is
+// recorded as a "startup" trace event and in the
+// "IOS.KeyedService.CreationTime.<name>" histogram, and the growth of the
+// memory used in the "IOS.KeyedService.CreationMemory.<name>" histogram.
+// Creating a service also creates the services it depends on, so their cost is
+// included.
+class KeyedServiceCreationRecorder {
+ public:
+  // Prefixes of the names of the histograms.
+  static const char kCreationTimeHistogramPrefix[];
+  static const char kCreationMemoryHistogramPrefix[];
+
+  // |name| identifies the created services and must be a string literal, as
+  // it is recorded in the trace.
+  explicit KeyedServiceCreationRecorder(const char* name);
+  ~KeyedServiceCreationRecorder();
+
+ private:
+  const char* const name_;
+  const base::TimeTicks start_time_;
+  const uint64_t start_memory_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyedServiceCreationRecorder);
+};
+
+#endif  // IOS_CHROME_BROWSER_BROWSER_STATE_KEYED_SERVICE_CREATION_RECORDER_H_
@@ -0,0 +1,37 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/browser_state/keyed_service_creation_recorder.h"
+
+#include <string>
+
+#include "base/test/metrics/histogram_tester.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace {
+const char kServiceName[] = "TestService";
+}  // namespace
+
+using KeyedServiceCreationRecorderTest = PlatformTest;
+
+// Tests that the time and memory histograms of the services are recorded once
+// the recorder is destroyed.
+TEST_F(KeyedServiceCreationRecorderTest, RecordsHistograms) {
+  const std::string kTimeHistogram =
+      std::string(KeyedServiceCreationRecorder::kCreationTimeHistogramPrefix) +
+      kServiceName;
+  const std::string kMemoryHistogram =
+      std::string(
+          KeyedServiceCreationRecorder::kCreationMemoryHistogramPrefix) +
+      kServiceName;
+  base::HistogramTester histogram_tester;
+  {
+    KeyedServiceCreationRecorder recorder(kServiceName);
+    histogram_tester.ExpectTotalCount(kTimeHistogram, 0);
+    histogram_tester.ExpectTotalCount(kMemoryHistogram, 0);
+  }
+  histogram_tester.ExpectTotalCount(kTimeHistogram, 1);
+  histogram_tester.ExpectTotalCount(kMemoryHistogram, 1);
+}
@@ -3,10 +3,18 @@
 // found in the LICENSE file.
 
 #include "ios/chrome/browser/browsing_data/cache_counter.h"
+
+#include <map>
+#include <memory>
+
 #include "base/bind.h"
+#include "base/optional.h"
+#include "base/supports_user_data.h"
 #include "base/task/post_task.h"
+#include "base/time/time.h"
 #include "components/browsing_data/core/pref_names.h"
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
+#include "ios/net/http_cache_helper.h"
 #include "ios/web/public/browser_state.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/public/web_thread.h"
@@ -18,17 +26,85 @@
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_getter.h"
 
+// The size of the cache entries in a time range, and the state of the cache
+// when it was counted.
+struct CountedCacheSize {
+  // The size in bytes, or a net error code.
+  int64_t size = 0;
+  bool is_upper_limit = false;
+  // The net::GetHttpCacheModificationCount() of the cache.
+  uint64_t modification_count = 0;
+  base::Time counted_at;
+};
+
 namespace {
 
+// The key of the CachedCacheSizes of a browser state.
+const char kCachedCacheSizesKeyName[] = "cache_counter_cached_sizes";
+
+// The sizes counted by the CacheCounters of a browser state. Only used on the
+// UI thread.
+class CachedCacheSizes : public base::SupportsUserData::Data {
+ public:
+  CachedCacheSizes() {}
+  ~CachedCacheSizes() override {}
+
+  static CachedCacheSizes* FromBrowserState(
+      ios::ChromeBrowserState* browser_state) {
+    if (!browser_state->GetUserData(kCachedCacheSizesKeyName)) {
+      browser_state->SetUserData(kCachedCacheSizesKeyName,
+                                 std::make_unique<CachedCacheSizes>());
+    }
+    return static_cast<CachedCacheSizes*>(
+        browser_state->GetUserData(kCachedCacheSizesKeyName));
+  }
+
+  std::map<std::pair<int64_t, int64_t>, CountedCacheSize> sizes;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CachedCacheSizes);
+};
+
+// Returns the offset of |bound| from |now| in minutes, or -1 if |bound| is
+// unbounded.
+int64_t GetOffsetInMinutes(base::Time bound, base::Time now) {
+  if (bound.is_null() || bound.is_max())
+    return -1;
+  return (now - bound + base::TimeDelta::FromSeconds(30)).InMinutes();
+}
+
+// Returns how long the size of the cache entries between |begin| and |end| can
+// be reused. Apart from the entire cache, the ranges move with the current
+// time, so entries leave them without any cache write. The results are reused
+// for 1/60th of the range, e.g. one minute for the last hour, to bound the
+// error.
+base::TimeDelta GetMaxCachedSizeAge(base::Time begin,
+                                    base::Time end,
+                                    base::Time now) {
+  if (begin.is_null() && end.is_max())
+    return base::TimeDelta::Max();
+  base::Time moving_bound = begin.is_null() ? end : begin;
+  return (now - moving_bound) / 60;
+}
+
 class IOThreadCacheCounter {
  public:
+  using ResultCallback = base::OnceCallback<void(const CountedCacheSize&)>;
+
+  // Counts the size of the cache entries used between |begin| and |end|, or
+  // reuses |cached_size| if the cache was not modified since it was counted.
   IOThreadCacheCounter(
       const scoped_refptr<net::URLRequestContextGetter>& context_getter,
-      const net::Int64CompletionCallback& result_callback)
-      : next_step_(STEP_GET_BACKEND),
+      base::Time begin,
+      base::Time end,
+      const base::Optional<CountedCacheSize>& cached_size,
+      ResultCallback result_callback)
+      : next_step_(STEP_CHECK_CACHED_SIZE),
         context_getter_(context_getter),
-        result_callback_(result_callback),
-        result_(0),
+        begin_(begin),
+        end_(end),
+        cached_size_(cached_size),
+        result_callback_(std::move(result_callback)),
         backend_(nullptr) {}
 
   void Count() {
@@ -40,10 +116,12 @@ class IOThreadCacheCounter {
 
  private:
   enum Step {
-    STEP_GET_BACKEND,  // Get the disk_cache::Backend instance.
-    STEP_COUNT,        // Run CalculateSizeOfAllEntries() on it.
-    STEP_CALLBACK,     // Respond on the UI thread.
-    STEP_DONE          // Calculation completed.
+    STEP_CHECK_CACHED_SIZE,  // Reuse the cached size if the cache is unchanged.
+    STEP_GET_BACKEND,        // Get the disk_cache::Backend instance.
+    STEP_COUNT,              // Count the size of the entries in the range.
+    STEP_COUNTED,            // Count the entire cache if it is unsupported.
+    STEP_CALLBACK,           // Respond on the UI thread.
+    STEP_DONE                // Calculation completed.
   };
 
   void CountInternal(int64_t rv) {
@@ -51,12 +129,26 @@ class IOThreadCacheCounter {
 
     while (rv != net::ERR_IO_PENDING && next_step_ != STEP_DONE) {
       // In case of an error, skip to the last step.
-      if (rv < 0)
+      if (rv < 0 && next_step_ != STEP_COUNTED)
         next_step_ = STEP_CALLBACK;
 
-      // Process the counting in three steps: STEP_GET_BACKEND -> STEP_COUNT ->
-      // -> STEP_CALLBACK.
       switch (next_step_) {
+        case STEP_CHECK_CACHED_SIZE: {
+          next_step_ = STEP_GET_BACKEND;
+
+          // Read before counting, so that a modification made while counting
+          // invalidates the result.
+          result_.modification_count = net::GetHttpCacheModificationCount(
+              context_getter_->GetURLRequestContext());
+          if (cached_size_ && cached_size_->modification_count ==
+                                  result_.modification_count) {
+            next_step_ = STEP_CALLBACK;
+            result_ = *cached_size_;
+            rv = result_.size;
+          }
+          break;
+        }
+
         case STEP_GET_BACKEND: {
           next_step_ = STEP_COUNT;
 
@@ -74,17 +166,41 @@ class IOThreadCacheCounter {
         }
 
         case STEP_COUNT: {
-          next_step_ = STEP_CALLBACK;
+          next_step_ = STEP_COUNTED;
 
           DCHECK(backend_);
-          rv = backend_->CalculateSizeOfAllEntries(base::BindRepeating(
-              &IOThreadCacheCounter::CountInternal, base::Unretained(this)));
+          result_.counted_at = base::Time::Now();
+          if (begin_.is_null() && end_.is_max()) {
+            rv = backend_->CalculateSizeOfAllEntries(
+                base::BindRepeating(&IOThreadCacheCounter::CountInternal,
+                                    base::Unretained(this)));
+          } else {
+            rv = backend_->CalculateSizeOfEntriesBetween(
+                begin_, end_,
+                base::BindRepeating(&IOThreadCacheCounter::CountInternal,
+                                    base::Unretained(this)));
+          }
+          break;
+        }
+
+        case STEP_COUNTED: {
+          next_step_ = STEP_CALLBACK;
+
+          // The blockfile backend can't count a subset of the cache. The size
+          // of the entire cache is an upper limit of the size of the entries
+          // in the range.
+          if (rv == net::ERR_NOT_IMPLEMENTED) {
+            result_.is_upper_limit = true;
+            rv = backend_->CalculateSizeOfAllEntries(
+                base::BindRepeating(&IOThreadCacheCounter::CountInternal,
+                                    base::Unretained(this)));
+          }
           break;
         }
 
         case STEP_CALLBACK: {
           next_step_ = STEP_DONE;
-          result_ = rv;
+          result_.size = rv;
 
           base::PostTaskWithTraits(
               FROM_HERE, {web::WebThread::UI},
@@ -103,19 +219,29 @@ class IOThreadCacheCounter {
 
   void OnCountingFinished() {
     DCHECK_CURRENTLY_ON(web::WebThread::UI);
-    result_callback_.Run(result_);
+    std::move(result_callback_).Run(result_);
     delete this;
   }
 
   Step next_step_;
   scoped_refptr<net::URLRequestContextGetter> context_getter_;
-  net::Int64CompletionCallback result_callback_;
-  int64_t result_;
+  const base::Time begin_;
+  const base::Time end_;
+  const base::Optional<CountedCacheSize> cached_size_;
+  ResultCallback result_callback_;
+  CountedCacheSize result_;
   disk_cache::Backend* backend_;
 };
 
 }  // namespace
 
+CacheCounter::CacheResult::CacheResult(const CacheCounter* source,
+                                       int64_t cache_size,
+                                       bool is_upper_limit)
+    : FinishedResult(source, cache_size), is_upper_limit_(is_upper_limit) {}
+
+CacheCounter::CacheResult::~CacheResult() = default;
+
 CacheCounter::CacheCounter(ios::ChromeBrowserState* browser_state)
     : browser_state_(browser_state), weak_ptr_factory_(this) {}
 
@@ -126,22 +252,37 @@ const char* CacheCounter::GetPrefName() const {
 }
 
 void CacheCounter::Count() {
-  // disk_cache::Backend currently does not implement counting for subsets of
-  // cache, only for the entire cache. Thus, ignore the time period setting and
-  // always request counting for the unbounded time interval. It is up to the
-  // UI to interpret the results for finite time intervals as upper estimates.
+  const base::Time begin = GetPeriodStart();
+  const base::Time end = GetPeriodEnd();
+  const base::Time now = base::Time::Now();
+  const RangeKey key = std::make_pair(GetOffsetInMinutes(begin, now),
+                                      GetOffsetInMinutes(end, now));
+
+  base::Optional<CountedCacheSize> cached_size;
+  const auto& sizes = CachedCacheSizes::FromBrowserState(browser_state_)->sizes;
+  auto it = sizes.find(key);
+  // The size of the entire cache only changes when the cache is modified.
+  if (it != sizes.end() &&
+      (it->second.is_upper_limit ||
+       now - it->second.counted_at <= GetMaxCachedSizeAge(begin, end, now))) {
+    cached_size = it->second;
+  }
+
   // IOThreadCacheCounter deletes itself when done.
   (new IOThreadCacheCounter(
-       browser_state_->GetRequestContext(),
-       base::BindRepeating(&CacheCounter::OnCacheSizeCalculated,
-                           weak_ptr_factory_.GetWeakPtr())))
+       browser_state_->GetRequestContext(), begin, end, cached_size,
+       base::BindOnce(&CacheCounter::OnCacheSizeCalculated,
+                      weak_ptr_factory_.GetWeakPtr(), key)))
       ->Count();
 }
 
-void CacheCounter::OnCacheSizeCalculated(int64_t result_bytes) {
+void CacheCounter::OnCacheSizeCalculated(const RangeKey& key,
+                                         const CountedCacheSize& cache_size) {
   // A value less than 0 means a net error code.
-  if (result_bytes < 0)
+  if (cache_size.size < 0)
     return;
 
-  ReportResult(result_bytes);
+  CachedCacheSizes::FromBrowserState(browser_state_)->sizes[key] = cache_size;
+  ReportResult(std::make_unique<CacheResult>(this, cache_size.size,
+                                             cache_size.is_upper_limit));
 }
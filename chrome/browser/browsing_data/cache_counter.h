@@ -5,6 +5,10 @@
 #ifndef IOS_CHROME_BROWSER_BROWSING_DATA_CACHE_COUNTER_H_
 #define IOS_CHROME_BROWSER_BROWSING_DATA_CACHE_COUNTER_H_
 
+#include <stdint.h>
+
+#include <utility>
+
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "components/browsing_data/core/counters/browsing_data_counter.h"
@@ -13,9 +17,32 @@ namespace ios {
 class ChromeBrowserState;
 }
 
-// CacheCounter is a BrowsingDataCounter used to compute the cache size.
+struct CountedCacheSize;
+
+// CacheCounter is a BrowsingDataCounter used to compute the size of the cache
+// entries used in the selected time period. The results are kept per browser
+// state and reused until net::NotifyHttpCacheModified() is called for the
+// cache, so that counting again is cheap.
 class CacheCounter : public browsing_data::BrowsingDataCounter {
  public:
+  // The result of the counting. It is an upper limit of the size of the cache
+  // entries in the time period if the cache backend can only count the entire
+  // cache.
+  class CacheResult : public FinishedResult {
+   public:
+    CacheResult(const CacheCounter* source,
+                int64_t cache_size,
+                bool is_upper_limit);
+    ~CacheResult() override;
+
+    bool is_upper_limit() const { return is_upper_limit_; }
+
+   private:
+    bool is_upper_limit_;
+
+    DISALLOW_COPY_AND_ASSIGN(CacheResult);
+  };
+
   explicit CacheCounter(ios::ChromeBrowserState* browser_state);
   ~CacheCounter() override;
 
@@ -24,8 +51,13 @@ class CacheCounter : public browsing_data::BrowsingDataCounter {
   void Count() override;
 
  private:
-  // Invoked when cache size has been computed.
-  void OnCacheSizeCalculated(int64_t cache_size);
+  // Identifies a time period by the offsets of its bounds from the time it is
+  // counted at.
+  using RangeKey = std::pair<int64_t, int64_t>;
+
+  // Invoked when cache size has been computed for the range |key|.
+  void OnCacheSizeCalculated(const RangeKey& key,
+                             const CountedCacheSize& cache_size);
 
   ios::ChromeBrowserState* browser_state_;
 
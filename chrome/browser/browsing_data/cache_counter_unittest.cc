@@ -6,11 +6,13 @@
 // when it counts and when not, when result is nonzero and when not. It does not
 // test whether the result of the counting is correct. This is the
 // responsibility of a lower layer, and is tested in
-// DiskCacheBackendTest.CalculateSizeOfAllEntries in net_unittests.
+// DiskCacheBackendTest.CalculateSizeOfAllEntries and
+// DiskCacheBackendTest.CalculateSizeOfEntriesBetween in net_unittests.
 
 #include "ios/chrome/browser/browsing_data/cache_counter.h"
 
 #include <memory>
+#include <string>
 
 #include "base/bind.h"
 #include "base/run_loop.h"
@@ -20,6 +22,7 @@
 #include "components/browsing_data/core/pref_names.h"
 #include "components/prefs/testing_pref_service.h"
 #include "ios/chrome/browser/browser_state/test_chrome_browser_state.h"
+#include "ios/net/http_cache_helper.h"
 #include "ios/web/public/test/test_web_thread_bundle.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/public/web_thread.h"
@@ -56,9 +59,10 @@ class CacheCounterTest : public PlatformTest {
                         static_cast<int>(period));
   }
 
-  // Create a cache entry on the IO thread.
-  void CreateCacheEntry() {
+  // Create a cache entry containing |data| on the IO thread.
+  void CreateCacheEntry(const std::string& data = "entry data") {
     current_operation_ = OPERATION_ADD_ENTRY;
+    entry_data_ = data;
     next_step_ = STEP_GET_BACKEND;
 
     base::PostTaskWithTraits(
@@ -68,6 +72,12 @@ class CacheCounterTest : public PlatformTest {
     WaitForIOThread();
   }
 
+  // Whether creating an entry or clearing the cache notifies that the cache
+  // was modified, as the network stack does.
+  void set_notify_cache_modified(bool notify_cache_modified) {
+    notify_cache_modified_ = notify_cache_modified;
+  }
+
   // Clear the cache on the IO thread.
   void ClearCache() {
     current_operation_ = OPERATION_CLEAR_CACHE;
@@ -95,10 +105,10 @@ class CacheCounterTest : public PlatformTest {
     finished_ = result->Finished();
 
     if (finished_) {
-      result_ =
-          static_cast<browsing_data::BrowsingDataCounter::FinishedResult*>(
-              result.get())
-              ->Value();
+      CacheCounter::CacheResult* cache_result =
+          static_cast<CacheCounter::CacheResult*>(result.get());
+      result_ = cache_result->Value();
+      is_upper_limit_ = cache_result->is_upper_limit();
     }
 
     if (run_loop_ && finished_)
@@ -111,6 +121,12 @@ class CacheCounterTest : public PlatformTest {
     return result_;
   }
 
+  // Whether the last reported counter result is an upper limit.
+  bool IsUpperLimit() {
+    DCHECK(finished_);
+    return is_upper_limit_;
+  }
+
  private:
   enum CacheOperation {
     OPERATION_ADD_ENTRY,
@@ -178,11 +194,10 @@ class CacheCounterTest : public PlatformTest {
         case STEP_WRITE_DATA: {
           next_step_ = STEP_CALLBACK;
 
-          std::string data = "entry data";
-          auto buffer = base::MakeRefCounted<net::StringIOBuffer>(data);
+          auto buffer = base::MakeRefCounted<net::StringIOBuffer>(entry_data_);
 
           rv = entry_->WriteData(
-              0, 0, buffer.get(), data.size(),
+              0, 0, buffer.get(), entry_data_.size(),
               base::BindRepeating(&CacheCounterTest::CacheOperationStep,
                                   base::Unretained(this)),
               true);
@@ -196,6 +211,11 @@ class CacheCounterTest : public PlatformTest {
           if (current_operation_ == OPERATION_ADD_ENTRY)
             entry_->Close();
 
+          if (notify_cache_modified_) {
+            net::NotifyHttpCacheModified(
+                context_getter_->GetURLRequestContext());
+          }
+
           base::PostTaskWithTraits(FROM_HERE, {web::WebThread::UI},
                                    base::BindOnce(&CacheCounterTest::Callback,
                                                   base::Unretained(this)));
@@ -227,9 +247,12 @@ class CacheCounterTest : public PlatformTest {
   scoped_refptr<net::URLRequestContextGetter> context_getter_;
   disk_cache::Backend* backend_;
   disk_cache::Entry* entry_;
+  std::string entry_data_;
+  bool notify_cache_modified_ = true;
 
   bool finished_ = false;
   browsing_data::BrowsingDataCounter::ResultInt result_;
+  bool is_upper_limit_ = false;
 };
 
 // Tests that for the empty cache, the result is zero.
@@ -281,10 +304,9 @@ TEST_F(CacheCounterTest, PrefChanged) {
   EXPECT_EQ(0u, GetResult());
 }
 
-// Tests that the counting is restarted when the time period changes. Currently,
-// the results should be the same for every period. This is because the counter
-// always counts the size of the entire cache, and it is up to the UI
-// to interpret it as exact value or upper bound.
+// Tests that the counting is restarted when the time period changes. The
+// results should be the same for every period ending now, as the only entry
+// was just used.
 TEST_F(CacheCounterTest, PeriodChanged) {
   CreateCacheEntry();
 
@@ -314,4 +336,59 @@ TEST_F(CacheCounterTest, PeriodChanged) {
   EXPECT_EQ(result, GetResult());
 }
 
+// Tests that the entries used in the time period are counted exactly.
+TEST_F(CacheCounterTest, OlderThan30Days) {
+  CreateCacheEntry();
+
+  CacheCounter counter(browser_state());
+  counter.Init(prefs(), browsing_data::ClearBrowsingDataTab::ADVANCED,
+               base::BindRepeating(&CacheCounterTest::CountingCallback,
+                                   base::Unretained(this)));
+
+  SetDeletionPeriodPref(browsing_data::TimePeriod::OLDER_THAN_30_DAYS);
+  WaitForIOThread();
+  EXPECT_EQ(0u, GetResult());
+  EXPECT_FALSE(IsUpperLimit());
+
+  SetDeletionPeriodPref(browsing_data::TimePeriod::ALL_TIME);
+  WaitForIOThread();
+  EXPECT_NE(0u, GetResult());
+  EXPECT_FALSE(IsUpperLimit());
+}
+
+// Tests that a counted size is reused until the cache is modified.
+TEST_F(CacheCounterTest, CachedSizeReusedUntilModified) {
+  CreateCacheEntry("a");
+
+  CacheCounter counter(browser_state());
+  counter.Init(prefs(), browsing_data::ClearBrowsingDataTab::ADVANCED,
+               base::BindRepeating(&CacheCounterTest::CountingCallback,
+                                   base::Unretained(this)));
+  counter.Restart();
+
+  WaitForIOThread();
+  browsing_data::BrowsingDataCounter::ResultInt result = GetResult();
+  EXPECT_NE(0u, result);
+
+  // Another counter gets the cached size, as long as the cache is not known to
+  // be modified.
+  set_notify_cache_modified(false);
+  ClearCache();
+  CacheCounter other_counter(browser_state());
+  other_counter.Init(prefs(), browsing_data::ClearBrowsingDataTab::ADVANCED,
+                     base::BindRepeating(&CacheCounterTest::CountingCallback,
+                                         base::Unretained(this)));
+  other_counter.Restart();
+
+  WaitForIOThread();
+  EXPECT_EQ(result, GetResult());
+
+  set_notify_cache_modified(true);
+  CreateCacheEntry(std::string(1024, 'a'));
+  counter.Restart();
+
+  WaitForIOThread();
+  EXPECT_GT(GetResult(), result);
+}
+
 }  // namespace
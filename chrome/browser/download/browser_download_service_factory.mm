@@ -43,6 +43,9 @@ BrowserDownloadServiceFactory::BuildServiceInstanceFor(
 }
 
 bool BrowserDownloadServiceFactory::ServiceIsCreatedWithBrowserState() const {
+  // Startup-critical: the service must handle the downloads started by the
+  // restored tabs, so it is created with the browser state even when
+  // kLazyBrowserStateKeyedServices is enabled.
   return true;
 }
 
@@ -4,6 +4,7 @@
 
 #include "ios/chrome/browser/google/google_url_tracker_factory.h"
 
+#include "base/feature_list.h"
 #include "base/memory/ptr_util.h"
 #include "base/no_destructor.h"
 #include "components/google/core/browser/google_pref_names.h"
@@ -13,6 +14,7 @@
 #include "ios/chrome/browser/application_context.h"
 #include "ios/chrome/browser/browser_state/browser_state_otr_helper.h"
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
+#include "ios/chrome/browser/browser_state/features.h"
 #include "ios/chrome/browser/google/google_url_tracker_client_impl.h"
 
 namespace ios {
@@ -61,7 +63,8 @@ web::BrowserState* GoogleURLTrackerFactory::GetBrowserStateToUse(
 }
 
 bool GoogleURLTrackerFactory::ServiceIsCreatedWithBrowserState() const {
-  return true;
+  // Otherwise created by CreateDeferredBrowserStateKeyedServices().
+  return !base::FeatureList::IsEnabled(kLazyBrowserStateKeyedServices);
 }
 
 bool GoogleURLTrackerFactory::ServiceIsNULLWhileTesting() const {
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+// These metrics are read from Mach on iOS. On Linux, which is used by test and
+// perf jobs, they are read from /proc and are the closest equivalents.
 namespace memory_util {
 // "Physical Free" memory metric. This corresponds to the "Physical Memory Free"
 // value reported by the Memory Monitor in Instruments.
@@ -0,0 +1,124 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/memory/memory_metrics.h"
+#include "ios/chrome/browser/memory/memory_metrics_linux.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+
+namespace {
+
+// The files the metrics are read from.
+const char kMeminfoPath[] = "/proc/meminfo";
+const char kStatmPath[] = "/proc/self/statm";
+const char kSmapsRollupPath[] = "/proc/self/smaps_rollup";
+// Used when smaps_rollup is not available, which is the case before Linux
+// 4.14. It has the same format, with one set of fields per mapping.
+const char kSmapsPath[] = "/proc/self/smaps";
+
+// Returns the size of a memory page.
+uint64_t GetPageSize() {
+  return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Returns the sum of the fields named in |field_names| over all the mappings
+// of the process, in bytes.
+uint64_t SumSmapsFieldsInBytes(
+    const std::vector<base::StringPiece>& field_names) {
+  std::string smaps;
+  if (!base::ReadFileToString(base::FilePath(kSmapsRollupPath), &smaps) &&
+      !base::ReadFileToString(base::FilePath(kSmapsPath), &smaps)) {
+    LOG(ERROR) << "Reading " << kSmapsPath << " failed.";
+    return 0;
+  }
+  return memory_util::internal::SumFieldsInBytes(smaps, field_names);
+}
+
+}  // namespace
+
+namespace memory_util {
+
+namespace internal {
+
+uint64_t SumFieldsInBytes(const std::string& contents,
+                          const std::vector<base::StringPiece>& field_names) {
+  uint64_t total_kb = 0;
+  for (base::StringPiece line : base::SplitStringPiece(
+           contents, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    size_t separator = line.find(':');
+    if (separator == base::StringPiece::npos)
+      continue;
+    base::StringPiece name = line.substr(0, separator);
+    bool is_requested_field = false;
+    for (base::StringPiece field_name : field_names)
+      is_requested_field |= name == field_name;
+    if (!is_requested_field)
+      continue;
+
+    std::vector<base::StringPiece> tokens = base::SplitStringPiece(
+        line.substr(separator + 1), base::kWhitespaceASCII,
+        base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    uint64_t value_kb = 0;
+    if (tokens.empty() || !base::StringToUint64(tokens[0], &value_kb)) {
+      LOG(ERROR) << "Unexpected line: " << line;
+      continue;
+    }
+    total_kb += value_kb;
+  }
+  return total_kb * 1024;
+}
+
+}  // namespace internal
+
+uint64_t GetFreePhysicalBytes() {
+  std::string meminfo;
+  if (!base::ReadFileToString(base::FilePath(kMeminfoPath), &meminfo)) {
+    LOG(ERROR) << "Reading " << kMeminfoPath << " failed.";
+    return 0;
+  }
+  return internal::SumFieldsInBytes(meminfo, {"MemFree"});
+}
+
+uint64_t GetRealMemoryUsedInBytes() {
+  // The second field of statm is the number of resident pages.
+  std::string statm;
+  if (!base::ReadFileToString(base::FilePath(kStatmPath), &statm)) {
+    LOG(ERROR) << "Reading " << kStatmPath << " failed.";
+    return 0;
+  }
+  std::vector<base::StringPiece> fields =
+      base::SplitStringPiece(statm, base::kWhitespaceASCII,
+                             base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  uint64_t resident_pages = 0;
+  if (fields.size() < 2 || !base::StringToUint64(fields[1], &resident_pages)) {
+    LOG(ERROR) << "Unexpected " << kStatmPath << " format.";
+    return 0;
+  }
+  return resident_pages * GetPageSize();
+}
+
+uint64_t GetInternalVMBytes() {
+  // The anonymous memory is the closest equivalent of the "internal" memory of
+  // Mach tasks.
+  return SumSmapsFieldsInBytes({"Anonymous"});
+}
+
+uint64_t GetDirtyVMBytes() {
+  return SumSmapsFieldsInBytes({"Private_Dirty", "Shared_Dirty"});
+}
+
+}  // namespace memory_util
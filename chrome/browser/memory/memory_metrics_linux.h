@@ -0,0 +1,27 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_MEMORY_MEMORY_METRICS_LINUX_H_
+#define IOS_CHROME_BROWSER_MEMORY_MEMORY_METRICS_LINUX_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+
+namespace memory_util {
+namespace internal {
+
+// Returns the sum of the values of the fields named in |field_names| in
+// |contents|, which has the "<name>: <value> kB" lines of /proc/meminfo and
+// /proc/<pid>/smaps, in bytes. Exposed for testing.
+uint64_t SumFieldsInBytes(const std::string& contents,
+                          const std::vector<base::StringPiece>& field_names);
+
+}  // namespace internal
+}  // namespace memory_util
+
+#endif  // IOS_CHROME_BROWSER_MEMORY_MEMORY_METRICS_LINUX_H_
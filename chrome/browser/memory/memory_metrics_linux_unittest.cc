@@ -0,0 +1,82 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/memory/memory_metrics_linux.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace memory_util {
+namespace internal {
+
+namespace {
+
+// The beginning of a /proc/meminfo file.
+const char kMeminfo[] =
+    "MemTotal:        8052564 kB\n"
+    "MemFree:          512000 kB\n"
+    "MemAvailable:    4096000 kB\n"
+    "Buffers:          123456 kB\n";
+
+// Two mappings of a /proc/<pid>/smaps file.
+const char kSmaps[] =
+    "55d0c0a00000-55d0c0a21000 rw-p 00000000 00:00 0          [heap]\n"
+    "Size:                132 kB\n"
+    "Rss:                  24 kB\n"
+    "Shared_Dirty:          0 kB\n"
+    "Private_Dirty:        20 kB\n"
+    "Anonymous:            24 kB\n"
+    "VmFlags: rd wr mr mw me ac sd\n"
+    "7f1c2a000000-7f1c2a200000 r-xp 00000000 08:01 1234       /lib/libc.so\n"
+    "Size:               2048 kB\n"
+    "Rss:                1024 kB\n"
+    "Shared_Dirty:          8 kB\n"
+    "Private_Dirty:         4 kB\n"
+    "Anonymous:             0 kB\n"
+    "VmFlags: rd ex mr mw me sd\n";
+
+}  // namespace
+
+using MemoryMetricsLinuxTest = PlatformTest;
+
+// Tests that a single meminfo field is read and converted to bytes.
+TEST_F(MemoryMetricsLinuxTest, MeminfoField) {
+  EXPECT_EQ(512000U * 1024, SumFieldsInBytes(kMeminfo, {"MemFree"}));
+  EXPECT_EQ(8052564U * 1024, SumFieldsInBytes(kMeminfo, {"MemTotal"}));
+}
+
+// Tests that the requested fields are summed over all the mappings, and that
+// the other fields are ignored.
+TEST_F(MemoryMetricsLinuxTest, SmapsFieldsSummedOverMappings) {
+  EXPECT_EQ(24U * 1024, SumFieldsInBytes(kSmaps, {"Anonymous"}));
+  EXPECT_EQ((20U + 4 + 0 + 8) * 1024,
+            SumFieldsInBytes(kSmaps, {"Private_Dirty", "Shared_Dirty"}));
+}
+
+// Tests that a field is matched by its full name, not by a prefix.
+TEST_F(MemoryMetricsLinuxTest, FieldNameNotPrefixMatched) {
+  EXPECT_EQ(0U, SumFieldsInBytes(kMeminfo, {"Mem"}));
+  EXPECT_EQ(0U, SumFieldsInBytes(kSmaps, {"Private"}));
+}
+
+// Tests that missing fields, lines without a value and lines without a
+// separator do not count.
+TEST_F(MemoryMetricsLinuxTest, MalformedContents) {
+  EXPECT_EQ(0U, SumFieldsInBytes("", {"MemFree"}));
+  EXPECT_EQ(0U, SumFieldsInBytes(kMeminfo, {"SwapFree"}));
+  EXPECT_EQ(16U * 1024, SumFieldsInBytes("MemFree:\n"
+                                         "MemFree: abc kB\n"
+                                         "MemFree 32 kB\n"
+                                         "MemFree: 16 kB\n",
+                                         {"MemFree"}));
+}
+
+// Tests that the whitespace around the lines and the values is ignored.
+TEST_F(MemoryMetricsLinuxTest, Whitespace) {
+  EXPECT_EQ(48U * 1024, SumFieldsInBytes("  MemFree:\t 16 kB  \n\nMemFree:32\n",
+                                         {"MemFree"}));
+}
+
+}  // namespace internal
+}  // namespace memory_util
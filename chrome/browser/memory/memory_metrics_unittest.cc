@@ -0,0 +1,22 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/memory/memory_metrics.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace memory_util {
+
+using MemoryMetricsTest = PlatformTest;
+
+// Tests that the memory metrics can be read on the current platform.
+TEST_F(MemoryMetricsTest, MetricsAvailable) {
+  EXPECT_GT(GetFreePhysicalBytes(), 0U);
+  EXPECT_GT(GetRealMemoryUsedInBytes(), 0U);
+  EXPECT_GT(GetInternalVMBytes(), 0U);
+  EXPECT_GT(GetDirtyVMBytes(), 0U);
+}
+
+}  // namespace memory_util
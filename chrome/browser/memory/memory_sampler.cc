@@ -0,0 +1,172 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/memory/memory_sampler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/containers/circular_deque.h"
+#include "base/logging.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/task/post_task.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "ios/chrome/browser/memory/memory_metrics.h"
+
+namespace memory_util {
+
+// The data recorded by a MemorySampler. Updated on the sampling sequence, and
+// read from the sequence of the MemorySampler.
+class MemorySampler::State : public base::RefCountedThreadSafe<State> {
+ public:
+  State(size_t max_samples, SampleCallback sample_callback)
+      : max_samples_(max_samples),
+        sample_callback_(std::move(sample_callback)) {
+    DCHECK_GT(max_samples_, 0U);
+  }
+
+  // Takes a sample every |interval| until StopSampling() is called.
+  void StartSampling(base::TimeDelta interval) {
+    ++sampling_generation_;
+    SampleAndReschedule(interval, sampling_generation_);
+  }
+
+  void StopSampling() { ++sampling_generation_; }
+
+  // Takes a sample once |name| has begun, so that short phases have a peak.
+  void BeginPhase(const std::string& name) {
+    {
+      base::AutoLock lock(lock_);
+      ++active_phases_[name];
+      phase_peaks_.insert(std::make_pair(name, 0));
+    }
+    TakeSample();
+  }
+
+  // Takes a sample before |name| ends.
+  void EndPhase(const std::string& name) {
+    TakeSample();
+    base::AutoLock lock(lock_);
+    auto it = active_phases_.find(name);
+    if (it == active_phases_.end())
+      return;
+    if (--it->second == 0)
+      active_phases_.erase(it);
+  }
+
+  std::vector<Sample> GetSamples() const {
+    base::AutoLock lock(lock_);
+    return std::vector<Sample>(samples_.begin(), samples_.end());
+  }
+
+  std::map<std::string, uint64_t> GetPhasePeaks() const {
+    base::AutoLock lock(lock_);
+    return phase_peaks_;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<State>;
+  ~State() {}
+
+  void SampleAndReschedule(base::TimeDelta interval, int generation) {
+    if (generation != sampling_generation_)
+      return;
+    TakeSample();
+    base::SequencedTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&State::SampleAndReschedule, this, interval, generation),
+        interval);
+  }
+
+  void TakeSample() {
+    Sample sample = {base::TimeTicks::Now(), sample_callback_.Run()};
+
+    base::AutoLock lock(lock_);
+    if (samples_.size() == max_samples_)
+      samples_.pop_front();
+    samples_.push_back(sample);
+    for (const auto& phase : active_phases_) {
+      uint64_t& peak = phase_peaks_[phase.first];
+      peak = std::max(peak, sample.bytes);
+    }
+  }
+
+  const size_t max_samples_;
+  const SampleCallback sample_callback_;
+
+  // Incremented when sampling starts or stops, to drop the samples scheduled
+  // by a previous StartSampling().
+  int sampling_generation_ = 0;
+
+  // Guards the data below, which is read from another sequence.
+  mutable base::Lock lock_;
+  base::circular_deque<Sample> samples_;
+  // The number of occurrences of each active phase.
+  std::map<std::string, int> active_phases_;
+  std::map<std::string, uint64_t> phase_peaks_;
+
+  DISALLOW_COPY_AND_ASSIGN(State);
+};
+
+const char MemorySampler::kStartupPhase[] = "Startup";
+const char MemorySampler::kSessionRestorePhase[] = "SessionRestore";
+const char MemorySampler::kTabGridPhase[] = "TabGrid";
+
+MemorySampler::MemorySampler(base::TimeDelta interval, size_t max_samples)
+    : MemorySampler(interval,
+                    max_samples,
+                    base::BindRepeating(&GetRealMemoryUsedInBytes)) {}
+
+MemorySampler::MemorySampler(base::TimeDelta interval,
+                             size_t max_samples,
+                             SampleCallback sample_callback)
+    : task_runner_(base::CreateSequencedTaskRunnerWithTraits(
+          {base::MayBlock(), base::TaskPriority::USER_VISIBLE,
+           base::TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN})),
+      state_(base::MakeRefCounted<State>(max_samples,
+                                         std::move(sample_callback))),
+      interval_(interval) {
+  DCHECK_GT(interval_, base::TimeDelta());
+}
+
+MemorySampler::~MemorySampler() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  Stop();
+}
+
+void MemorySampler::Start() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&State::StartSampling, state_, interval_));
+}
+
+void MemorySampler::Stop() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&State::StopSampling, state_));
+}
+
+void MemorySampler::BeginPhase(const std::string& name) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&State::BeginPhase, state_, name));
+}
+
+void MemorySampler::EndPhase(const std::string& name) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&State::EndPhase, state_, name));
+}
+
+std::vector<MemorySampler::Sample> MemorySampler::GetSamples() const {
+  return state_->GetSamples();
+}
+
+std::map<std::string, uint64_t> MemorySampler::GetPhasePeaks() const {
+  return state_->GetPhasePeaks();
+}
+
+}  // namespace memory_util
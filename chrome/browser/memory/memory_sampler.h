@@ -0,0 +1,95 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_MEMORY_MEMORY_SAMPLER_H_
+#define IOS_CHROME_BROWSER_MEMORY_MEMORY_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequence_checker.h"
+#include "base/time/time.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+namespace memory_util {
+
+// Samples the memory used by the app at a regular interval on a background
+// sequence, and records the time series of the samples and the peak memory
+// used during named phases (e.g. startup, session restore or opening the tab
+// grid), so that test and perf jobs can detect memory regressions. Only the
+// real memory used is sampled, which is cheap to read on all platforms.
+// Must be used on a single sequence; the recorded data can be read from any.
+class MemorySampler {
+ public:
+  // A sample of the memory used.
+  struct Sample {
+    base::TimeTicks time;
+    uint64_t bytes;
+  };
+
+  // Returns the memory used, in bytes. Called on the background sequence.
+  using SampleCallback = base::RepeatingCallback<uint64_t()>;
+
+  // Names of the phases of the app.
+  static const char kStartupPhase[];
+  static const char kSessionRestorePhase[];
+  static const char kTabGridPhase[];
+
+  // Samples GetRealMemoryUsedInBytes() every |interval| once started. Only the
+  // |max_samples| most recent samples are kept.
+  MemorySampler(base::TimeDelta interval, size_t max_samples);
+  // Samples the value returned by |sample_callback| instead.
+  MemorySampler(base::TimeDelta interval,
+                size_t max_samples,
+                SampleCallback sample_callback);
+  // Stops sampling.
+  ~MemorySampler();
+
+  // Starts or stops sampling at a regular interval. The phases are sampled
+  // when they begin and end even if the sampler is not started.
+  void Start();
+  void Stop();
+
+  // Marks the beginning and the end of the phase |name|. The peak of a phase
+  // is the largest sample taken between the beginning and the end of any
+  // occurrence of the phase. Phases may overlap.
+  void BeginPhase(const std::string& name);
+  void EndPhase(const std::string& name);
+
+  // Returns the samples, oldest first. Samples are taken asynchronously, so
+  // the most recent ones may not be recorded yet.
+  std::vector<Sample> GetSamples() const;
+
+  // Returns the peak of each phase which has begun.
+  std::map<std::string, uint64_t> GetPhasePeaks() const;
+
+ private:
+  class State;
+
+  // The sequence the samples are taken on.
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  // The recorded data, which is updated on |task_runner_|.
+  scoped_refptr<State> state_;
+
+  const base::TimeDelta interval_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(MemorySampler);
+};
+
+}  // namespace memory_util
+
+#endif  // IOS_CHROME_BROWSER_MEMORY_MEMORY_SAMPLER_H_
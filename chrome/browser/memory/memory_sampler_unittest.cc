@@ -0,0 +1,119 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/browser/memory/memory_sampler.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "ios/chrome/browser/memory/memory_metrics.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace memory_util {
+
+namespace {
+
+// An interval long enough for no sample to be taken during a test.
+const base::TimeDelta kLongInterval = base::TimeDelta::FromHours(1);
+
+}  // namespace
+
+class MemorySamplerTest : public PlatformTest {
+ protected:
+  MemorySamplerTest() : next_value_index_(0) {}
+
+  // Returns a callback returning the values of |values_| in order.
+  MemorySampler::SampleCallback CreateSampleCallback() {
+    return base::BindRepeating(&MemorySamplerTest::GetNextValue,
+                               base::Unretained(this));
+  }
+
+  // Returns the bytes of |samples|.
+  std::vector<uint64_t> GetBytes(
+      const std::vector<MemorySampler::Sample>& samples) {
+    std::vector<uint64_t> bytes;
+    for (const MemorySampler::Sample& sample : samples)
+      bytes.push_back(sample.bytes);
+    return bytes;
+  }
+
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  std::vector<uint64_t> values_;
+
+ private:
+  // Called on the sampling sequence.
+  uint64_t GetNextValue() {
+    return next_value_index_ < values_.size() ? values_[next_value_index_++]
+                                              : 0;
+  }
+
+  size_t next_value_index_;
+};
+
+// Tests that the peaks of overlapping phases are recorded.
+TEST_F(MemorySamplerTest, PhasePeaks) {
+  values_ = {10, 30, 20, 40, 50};
+  MemorySampler sampler(kLongInterval, 10, CreateSampleCallback());
+
+  sampler.BeginPhase(MemorySampler::kStartupPhase);
+  sampler.BeginPhase(MemorySampler::kSessionRestorePhase);
+  sampler.EndPhase(MemorySampler::kStartupPhase);
+  sampler.EndPhase(MemorySampler::kSessionRestorePhase);
+  sampler.BeginPhase(MemorySampler::kTabGridPhase);
+  scoped_task_environment_.RunUntilIdle();
+
+  std::map<std::string, uint64_t> peaks = sampler.GetPhasePeaks();
+  EXPECT_EQ(3U, peaks.size());
+  EXPECT_EQ(30U, peaks[MemorySampler::kStartupPhase]);
+  EXPECT_EQ(40U, peaks[MemorySampler::kSessionRestorePhase]);
+  EXPECT_EQ(50U, peaks[MemorySampler::kTabGridPhase]);
+  EXPECT_EQ(values_, GetBytes(sampler.GetSamples()));
+}
+
+// Tests that only the most recent samples are kept.
+TEST_F(MemorySamplerTest, MaxSamples) {
+  values_ = {10, 20, 30};
+  MemorySampler sampler(kLongInterval, 2, CreateSampleCallback());
+
+  sampler.BeginPhase(MemorySampler::kStartupPhase);
+  sampler.EndPhase(MemorySampler::kStartupPhase);
+  sampler.BeginPhase(MemorySampler::kStartupPhase);
+  scoped_task_environment_.RunUntilIdle();
+
+  std::vector<MemorySampler::Sample> samples = sampler.GetSamples();
+  EXPECT_EQ(std::vector<uint64_t>({20, 30}), GetBytes(samples));
+  EXPECT_LE(samples[0].time, samples[1].time);
+}
+
+// Tests that samples are taken at a regular interval until the sampler is
+// stopped.
+TEST_F(MemorySamplerTest, Sampling) {
+  MemorySampler sampler(base::TimeDelta::FromMilliseconds(1), 100,
+                        base::BindRepeating(&GetRealMemoryUsedInBytes));
+  sampler.Start();
+  const base::TimeTicks deadline =
+      base::TimeTicks::Now() + base::TimeDelta::FromSeconds(10);
+  while (sampler.GetSamples().size() < 3 && base::TimeTicks::Now() < deadline)
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  sampler.Stop();
+  scoped_task_environment_.RunUntilIdle();
+
+  std::vector<MemorySampler::Sample> samples = sampler.GetSamples();
+  ASSERT_GE(samples.size(), 3U);
+  EXPECT_GT(samples.back().bytes, 0U);
+
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+  scoped_task_environment_.RunUntilIdle();
+  EXPECT_EQ(samples.size(), sampler.GetSamples().size());
+}
+
+}  // namespace memory_util
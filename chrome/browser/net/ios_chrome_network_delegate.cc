@@ -18,6 +18,7 @@
 #include "components/prefs/pref_member.h"
 #include "components/prefs/pref_service.h"
 #include "ios/chrome/browser/pref_names.h"
+#include "ios/net/http_cache_helper.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/public/web_thread.h"
 #include "net/base/load_flags.h"
@@ -88,6 +89,10 @@ void IOSChromeNetworkDelegate::OnCompleted(net::URLRequest* request,
                                            bool started,
                                            int net_error) {
   RecordNetworkErrorHistograms(request, net_error);
+  // Reading a cache entry updates its last used time, so any request using
+  // the cache may change the size of the entries in a time range.
+  if (started && !(request->load_flags() & net::LOAD_DISABLE_CACHE))
+    net::NotifyHttpCacheModified(request->context());
 }
 
 bool IOSChromeNetworkDelegate::OnCanGetCookies(
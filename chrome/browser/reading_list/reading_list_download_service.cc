@@ -42,6 +42,11 @@ const int kNumberOfFailsBeforeWifiOnly = 5;
 // it.
 const int kNumberOfFailsBeforeStop = 7;
 
+// Number of pages downloaded at a time. Downloads compete with browsing for
+// bandwidth, so fewer run at once on cellular connections.
+const size_t kMaxConcurrentDownloadsOnWifi = 4;
+const size_t kMaxConcurrentDownloadsOnCellular = 2;
+
 // Scans |root| directory and deletes all subdirectories not listed
 // in |directories_to_keep|.
 // Must be called on File thread.
@@ -85,6 +90,16 @@ ReadingListDownloadService::ReadingListDownloadService(
       base::Bind(&ReadingListDownloadService::OnDeleteEnd,
                  base::Unretained(this)));
 
+  // GetConnectionType returns false if the type isn't known yet, and calls
+  // UpdateDownloadConcurrency once it is.
+  auto connection_type = network::mojom::ConnectionType::CONNECTION_UNKNOWN;
+  if (GetApplicationContext()->GetNetworkConnectionTracker()->GetConnectionType(
+          &connection_type,
+          base::BindOnce(&ReadingListDownloadService::UpdateDownloadConcurrency,
+                         weak_ptr_factory_.GetWeakPtr()))) {
+    UpdateDownloadConcurrency(connection_type);
+  }
+
   GetApplicationContext()
       ->GetNetworkConnectionTracker()
       ->AddNetworkConnectionObserver(this);
@@ -309,8 +324,19 @@ void ReadingListDownloadService::OnDeleteEnd(const GURL& url, bool success) {
   // Nothing to update as this is only called when deleting reading list entries
 }
 
+void ReadingListDownloadService::UpdateDownloadConcurrency(
+    network::mojom::ConnectionType type) {
+  bool is_wifi = type == network::mojom::ConnectionType::CONNECTION_WIFI ||
+                 type == network::mojom::ConnectionType::CONNECTION_ETHERNET;
+  url_downloader_->SetMaxConcurrentTasks(is_wifi
+                                             ? kMaxConcurrentDownloadsOnWifi
+                                             : kMaxConcurrentDownloadsOnCellular);
+}
+
 void ReadingListDownloadService::OnConnectionChanged(
     network::mojom::ConnectionType type) {
+  UpdateDownloadConcurrency(type);
+
   if (type == network::mojom::ConnectionType::CONNECTION_NONE) {
     had_connection_ = false;
     return;
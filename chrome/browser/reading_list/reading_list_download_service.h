@@ -95,6 +95,10 @@ class ReadingListDownloadService
   // Callback for entry deletion.
   void OnDeleteEnd(const GURL& url, bool success);
 
+  // Sets how many pages |url_downloader_| downloads at a time for a connection
+  // of |type|.
+  void UpdateDownloadConcurrency(network::mojom::ConnectionType type);
+
   // network::NetworkConnectionTracker::NetworkConnectionObserver:
   void OnConnectionChanged(network::mojom::ConnectionType type) override;
 
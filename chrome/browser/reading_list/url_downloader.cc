@@ -4,6 +4,8 @@
 
 #include "ios/chrome/browser/reading_list/url_downloader.h"
 
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -12,8 +14,8 @@
 #include "base/files/file_util.h"
 #include "base/memory/ptr_util.h"
 #include "base/path_service.h"
-#include "base/stl_util.h"
 #include "base/task/post_task.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "components/reading_list/core/offline_url_utils.h"
 #include "ios/chrome/browser/chrome_paths.h"
 #include "ios/chrome/browser/dom_distiller/distiller_viewer.h"
@@ -42,6 +44,14 @@ const char kDisableImageContextMenuScript[] =
 
 // URLDownloader
 
+const size_t URLDownloader::kDefaultMaxConcurrentTasks = 1;
+const size_t URLDownloader::kDefaultMaxDownloadsPerHost = 2;
+
+URLDownloader::Task::Task(TaskType type, const GURL& url)
+    : type(type), url(url), state(PENDING), saved_size(0), saving(false) {}
+
+URLDownloader::Task::~Task() = default;
+
 URLDownloader::URLDownloader(
     dom_distiller::DistillerFactory* distiller_factory,
     reading_list::ReadingListDistillerPageFactory* distiller_page_factory,
@@ -55,44 +65,176 @@ URLDownloader::URLDownloader(
       pref_service_(prefs),
       download_completion_(download_completion),
       delete_completion_(delete_completion),
-      working_(false),
+      max_concurrent_tasks_(kDefaultMaxConcurrentTasks),
+      max_downloads_per_host_(kDefaultMaxDownloadsPerHost),
+      process_tasks_pending_(false),
       base_directory_(chrome_profile_path),
-      mime_type_(),
       url_loader_factory_(std::move(url_loader_factory)),
       task_runner_(base::CreateSequencedTaskRunnerWithTraits(
           {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
            base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})),
-      task_tracker_() {}
+      weak_ptr_factory_(this) {}
 
-URLDownloader::~URLDownloader() {
-  task_tracker_.TryCancelAll();
-}
-
-void URLDownloader::OfflinePathExists(const base::FilePath& path,
-                                      base::Callback<void(bool)> callback) {
-  task_tracker_.PostTaskAndReplyWithResult(task_runner_.get(), FROM_HERE,
-                                           base::Bind(&base::PathExists, path),
-                                           callback);
-}
+URLDownloader::~URLDownloader() {}
 
 void URLDownloader::RemoveOfflineURL(const GURL& url) {
   // Remove all download tasks for this url as it would be pointless work.
   CancelDownloadOfflineURL(url);
-  tasks_.push_back(std::make_pair(DELETE, url));
-  HandleNextTask();
+  tasks_.push_back(std::make_unique<Task>(DELETE, url));
+  HandleNextTasks();
 }
 
 void URLDownloader::DownloadOfflineURL(const GURL& url) {
-  if (!base::ContainsValue(tasks_, std::make_pair(DOWNLOAD, url))) {
-    tasks_.push_back(std::make_pair(DOWNLOAD, url));
-    HandleNextTask();
+  for (const auto& task : tasks_) {
+    if (task->type == DOWNLOAD && task->url == url && task->state == PENDING)
+      return;
   }
+  tasks_.push_back(std::make_unique<Task>(DOWNLOAD, url));
+  HandleNextTasks();
 }
 
 void URLDownloader::CancelDownloadOfflineURL(const GURL& url) {
-  tasks_.erase(
-      std::remove(tasks_.begin(), tasks_.end(), std::make_pair(DOWNLOAD, url)),
-      tasks_.end());
+  bool cancelled = false;
+  for (auto it = tasks_.begin(); it != tasks_.end();) {
+    const Task& task = **it;
+    if (task.type != DOWNLOAD || task.url != url || task.state == DONE) {
+      ++it;
+      continue;
+    }
+    if (task.saving) {
+      // Delete what the download saved. |task_runner_| is sequenced, so this
+      // runs after a save in progress.
+      task_runner_->PostTask(
+          FROM_HERE,
+          base::BindOnce(
+              base::IgnoreResult(&base::DeleteFile),
+              reading_list::OfflineURLDirectoryAbsolutePath(base_directory_,
+                                                            url),
+              true));
+    }
+    // Deleting the task drops the replies of the work it posted, and stops its
+    // distiller and URL loader.
+    it = tasks_.erase(it);
+    cancelled = true;
+  }
+  // The cancelled tasks may have been holding back completion callbacks and
+  // other tasks.
+  if (cancelled)
+    ScheduleProcessTasks();
+}
+
+void URLDownloader::SetMaxConcurrentTasks(size_t max_concurrent_tasks) {
+  max_concurrent_tasks_ = max_concurrent_tasks;
+  HandleNextTasks();
+}
+
+void URLDownloader::SetMaxDownloadsPerHost(size_t max_downloads_per_host) {
+  DCHECK_GT(max_downloads_per_host, 0u);
+  max_downloads_per_host_ = max_downloads_per_host;
+  HandleNextTasks();
+}
+
+URLDownloader::Task* URLDownloader::FindRunningTask(const GURL& url) {
+  for (const auto& task : tasks_) {
+    if (task->state == RUNNING && task->url == url)
+      return task.get();
+  }
+  return nullptr;
+}
+
+void URLDownloader::HandleNextTasks() {
+  size_t running_tasks = 0;
+  std::map<std::string, size_t> running_downloads_per_host;
+  for (const auto& task : tasks_) {
+    if (task->state != RUNNING)
+      continue;
+    ++running_tasks;
+    if (task->type == DOWNLOAD)
+      ++running_downloads_per_host[task->url.host()];
+  }
+
+  // A task only starts once the tasks queued before it for the same URL are
+  // done, so that a download never races with a deletion of the same URL.
+  std::set<GURL> busy_urls;
+  for (const auto& task : tasks_) {
+    if (running_tasks >= max_concurrent_tasks_)
+      return;
+    if (task->state == DONE)
+      continue;
+    bool url_is_busy = !busy_urls.insert(task->url).second;
+    if (task->state == RUNNING || url_is_busy)
+      continue;
+    if (task->type == DOWNLOAD) {
+      size_t& host_downloads = running_downloads_per_host[task->url.host()];
+      if (host_downloads >= max_downloads_per_host_)
+        continue;
+      ++host_downloads;
+    }
+    ++running_tasks;
+    StartTask(task.get());
+  }
+}
+
+void URLDownloader::StartTask(Task* task) {
+  DCHECK_EQ(PENDING, task->state);
+  task->state = RUNNING;
+  base::FilePath directory_path =
+      reading_list::OfflineURLDirectoryAbsolutePath(base_directory_, task->url);
+
+  if (task->type == DELETE) {
+    task->task_tracker.PostTaskAndReplyWithResult(
+        task_runner_.get(), FROM_HERE,
+        base::Bind(&base::DeleteFile, directory_path, true),
+        base::Bind(&URLDownloader::DeleteCompletionHandler,
+                   base::Unretained(this), task->url));
+  } else if (task->type == DOWNLOAD) {
+    DCHECK(!task->distiller);
+    task->task_tracker.PostTaskAndReplyWithResult(
+        task_runner_.get(), FROM_HERE,
+        base::Bind(&base::PathExists, directory_path),
+        base::Bind(&URLDownloader::DownloadURL, base::Unretained(this),
+                   task->url));
+  }
+}
+
+void URLDownloader::CompleteTask(Task* task, base::OnceClosure completion) {
+  DCHECK_EQ(RUNNING, task->state);
+  task->state = DONE;
+  task->completion = std::move(completion);
+  // The completion callback and the next tasks run from a new task, as this
+  // may be called by the distiller of |task|, which is deleted once |task| is
+  // done.
+  ScheduleProcessTasks();
+}
+
+void URLDownloader::ScheduleProcessTasks() {
+  if (process_tasks_pending_)
+    return;
+  process_tasks_pending_ = true;
+  base::SequencedTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, base::BindOnce(&URLDownloader::ProcessTasks,
+                                weak_ptr_factory_.GetWeakPtr()));
+}
+
+void URLDownloader::ProcessTasks() {
+  process_tasks_pending_ = false;
+
+  // Release the distillers and loaders of the tasks waiting for the tasks
+  // queued before them to complete.
+  for (const auto& task : tasks_) {
+    if (task->state == DONE) {
+      task->distiller.reset();
+      task->url_loader.reset();
+    }
+  }
+
+  while (!tasks_.empty() && tasks_.front()->state == DONE) {
+    std::unique_ptr<Task> task = std::move(tasks_.front());
+    tasks_.pop_front();
+    std::move(task->completion).Run();
+  }
+
+  HandleNextTasks();
 }
 
 void URLDownloader::DownloadCompletionHandler(
@@ -100,67 +242,45 @@ void URLDownloader::DownloadCompletionHandler(
     const std::string& title,
     const base::FilePath& offline_path,
     SuccessState success) {
-  DCHECK(working_);
-
-  auto post_delete = base::Bind(
-      [](URLDownloader* _this, const GURL& url, const std::string& title,
-         const base::FilePath& offline_path, SuccessState success) {
-        _this->download_completion_.Run(url, _this->distilled_url_, success,
-                                        offline_path, _this->saved_size_,
-                                        title);
-        _this->distiller_.reset();
-        _this->working_ = false;
-        _this->HandleNextTask();
-      },
-      base::Unretained(this), url, title, offline_path, success);
+  Task* task = FindRunningTask(url);
+  DCHECK(task);
+
+  base::OnceClosure completion =
+      base::BindOnce(download_completion_, url, task->distilled_url, success,
+                     offline_path, task->saved_size, title);
 
   // If downloading failed, clean up any partial download.
   if (success == ERROR) {
     base::FilePath directory_path =
         reading_list::OfflineURLDirectoryAbsolutePath(base_directory_, url);
-    task_tracker_.PostTaskAndReply(
+    task->task_tracker.PostTaskAndReply(
         task_runner_.get(), FROM_HERE,
-        base::Bind(
+        base::BindOnce(
             [](const base::FilePath& offline_directory_path) {
               base::DeleteFile(offline_directory_path, true);
             },
             directory_path),
-        post_delete);
+        base::BindOnce(&URLDownloader::CompleteTask, base::Unretained(this),
+                       task, std::move(completion)));
   } else {
-    post_delete.Run();
+    CompleteTask(task, std::move(completion));
   }
 }
 
-void URLDownloader::DeleteCompletionHandler(const GURL& url, bool success) {
-  DCHECK(working_);
-  delete_completion_.Run(url, success);
-  working_ = false;
-  HandleNextTask();
+void URLDownloader::SaveCompletionHandler(const GURL& url,
+                                          const std::string& title,
+                                          const base::FilePath& path,
+                                          const SaveResult& result) {
+  Task* task = FindRunningTask(url);
+  DCHECK(task);
+  task->saved_size += result.size;
+  DownloadCompletionHandler(url, title, path, result.success);
 }
 
-void URLDownloader::HandleNextTask() {
-  if (working_ || tasks_.empty()) {
-    return;
-  }
-  working_ = true;
-
-  Task task = tasks_.front();
-  tasks_.pop_front();
-  GURL url = task.second;
-  base::FilePath directory_path =
-      reading_list::OfflineURLDirectoryAbsolutePath(base_directory_, url);
-
-  if (task.first == DELETE) {
-    task_tracker_.PostTaskAndReplyWithResult(
-        task_runner_.get(), FROM_HERE,
-        base::Bind(&base::DeleteFile, directory_path, true),
-        base::Bind(&URLDownloader::DeleteCompletionHandler,
-                   base::Unretained(this), url));
-  } else if (task.first == DOWNLOAD) {
-    DCHECK(!distiller_);
-    OfflinePathExists(directory_path, base::Bind(&URLDownloader::DownloadURL,
-                                                 base::Unretained(this), url));
-  }
+void URLDownloader::DeleteCompletionHandler(const GURL& url, bool success) {
+  Task* task = FindRunningTask(url);
+  DCHECK(task);
+  CompleteTask(task, base::BindOnce(delete_completion_, url, success));
 }
 
 void URLDownloader::DownloadURL(const GURL& url, bool offline_url_exists) {
@@ -170,14 +290,14 @@ void URLDownloader::DownloadURL(const GURL& url, bool offline_url_exists) {
     return;
   }
 
-  original_url_ = url;
-  distilled_url_ = url;
-  saved_size_ = 0;
+  Task* task = FindRunningTask(url);
+  DCHECK(task);
+  task->distilled_url = url;
   std::unique_ptr<reading_list::ReadingListDistillerPage>
       reading_list_distiller_page =
           distiller_page_factory_->CreateReadingListDistillerPage(url, this);
 
-  distiller_.reset(new dom_distiller::DistillerViewer(
+  task->distiller.reset(new dom_distiller::DistillerViewer(
       distiller_factory_, std::move(reading_list_distiller_page), pref_service_,
       url,
       base::Bind(&URLDownloader::DistillerCallback, base::Unretained(this))));
@@ -185,65 +305,68 @@ void URLDownloader::DownloadURL(const GURL& url, bool offline_url_exists) {
 
 void URLDownloader::DistilledPageRedirectedToURL(const GURL& page_url,
                                                  const GURL& redirected_url) {
-  DCHECK(original_url_ == page_url);
-  distilled_url_ = redirected_url;
+  Task* task = FindRunningTask(page_url);
+  DCHECK(task);
+  task->distilled_url = redirected_url;
 }
 
 void URLDownloader::DistilledPageHasMimeType(const GURL& original_url,
                                              const std::string& mime_type) {
-  DCHECK(original_url_ == original_url);
-  mime_type_ = mime_type;
+  Task* task = FindRunningTask(original_url);
+  DCHECK(task);
+  task->mime_type = mime_type;
 }
 
 void URLDownloader::OnURLLoadComplete(const GURL& original_url,
                                       base::FilePath response_path) {
+  Task* task = FindRunningTask(original_url);
+  DCHECK(task);
   // At the moment, only pdf files are downloaded using URLFetcher.
-  DCHECK(mime_type_ == "application/pdf");
+  DCHECK(task->mime_type == "application/pdf");
   base::FilePath path = reading_list::OfflinePagePath(
-      original_url_, reading_list::OFFLINE_TYPE_PDF);
+      original_url, reading_list::OFFLINE_TYPE_PDF);
   std::string mime_type;
-  if (url_loader_->ResponseInfo()) {
-    mime_type = url_loader_->ResponseInfo()->mime_type;
+  if (task->url_loader->ResponseInfo()) {
+    mime_type = task->url_loader->ResponseInfo()->mime_type;
   }
-  if (response_path.empty() || mime_type != mime_type_) {
-    return DownloadCompletionHandler(original_url_, "", path, ERROR);
+  if (response_path.empty() || mime_type != task->mime_type) {
+    return DownloadCompletionHandler(original_url, "", path, ERROR);
   }
 
-  task_tracker_.PostTaskAndReplyWithResult(
+  task->saving = true;
+  task->task_tracker.PostTaskAndReplyWithResult(
       task_runner_.get(), FROM_HERE,
-      base::Bind(&URLDownloader::SavePDFFile, base::Unretained(this),
-                 response_path),
-      base::Bind(&URLDownloader::DownloadCompletionHandler,
-                 base::Unretained(this), original_url, "", path));
-
-  url_loader_.reset();
-}
+      base::BindOnce(&URLDownloader::SavePDFFile, base::Unretained(this),
+                     original_url, response_path),
+      base::BindOnce(&URLDownloader::SaveCompletionHandler,
+                     base::Unretained(this), original_url, "", path));
 
-void URLDownloader::CancelTask() {
-  task_tracker_.TryCancelAll();
-  distiller_.reset();
+  task->url_loader.reset();
 }
 
-void URLDownloader::FetchPDFFile() {
+void URLDownloader::FetchPDFFile(const GURL& original_url) {
+  Task* task = FindRunningTask(original_url);
+  DCHECK(task);
   const GURL& pdf_url =
-      distilled_url_.is_valid() ? distilled_url_ : original_url_;
+      task->distilled_url.is_valid() ? task->distilled_url : original_url;
   auto resource_request = std::make_unique<network::ResourceRequest>();
   resource_request->url = pdf_url;
   resource_request->load_flags = net::LOAD_SKIP_CACHE_VALIDATION;
 
-  url_loader_ = network::SimpleURLLoader::Create(std::move(resource_request),
-                                                 NO_TRAFFIC_ANNOTATION_YET);
-  url_loader_->DownloadToTempFile(
+  task->url_loader = network::SimpleURLLoader::Create(
+      std::move(resource_request), NO_TRAFFIC_ANNOTATION_YET);
+  task->url_loader->DownloadToTempFile(
       url_loader_factory_.get(),
       base::BindOnce(&URLDownloader::OnURLLoadComplete, base::Unretained(this),
-                     pdf_url));
+                     original_url));
 }
 
-URLDownloader::SuccessState URLDownloader::SavePDFFile(
+URLDownloader::SaveResult URLDownloader::SavePDFFile(
+    const GURL& url,
     const base::FilePath& temporary_path) {
-  if (CreateOfflineURLDirectory(original_url_)) {
-    base::FilePath path = reading_list::OfflinePagePath(
-        original_url_, reading_list::OFFLINE_TYPE_PDF);
+  if (CreateOfflineURLDirectory(url)) {
+    base::FilePath path =
+        reading_list::OfflinePagePath(url, reading_list::OFFLINE_TYPE_PDF);
     base::FilePath absolute_path =
         reading_list::OfflineURLAbsolutePathFromRelativePath(base_directory_,
                                                              path);
@@ -251,14 +374,13 @@ URLDownloader::SuccessState URLDownloader::SavePDFFile(
     if (base::Move(temporary_path, absolute_path)) {
       int64_t pdf_file_size;
       base::GetFileSize(absolute_path, &pdf_file_size);
-      saved_size_ += pdf_file_size;
-      return DOWNLOAD_SUCCESS;
+      return {DOWNLOAD_SUCCESS, pdf_file_size};
     } else {
-      return ERROR;
+      return {ERROR, 0};
     }
   }
 
-  return ERROR;
+  return {ERROR, 0};
 }
 
 void URLDownloader::DistillerCallback(
@@ -267,12 +389,14 @@ void URLDownloader::DistillerCallback(
     const std::vector<dom_distiller::DistillerViewerInterface::ImageInfo>&
         images,
     const std::string& title) {
+  Task* task = FindRunningTask(page_url);
+  DCHECK(task);
   if (html.empty()) {
     // The page may not be HTML. Check the mime-type to see if another handler
     // can save offline content.
-    if (mime_type_ == "application/pdf") {
+    if (task->mime_type == "application/pdf") {
       // PDF handler just downloads the PDF file.
-      FetchPDFFile();
+      FetchPDFFile(page_url);
       return;
     }
     // This content cannot be processed, return an error value to the client.
@@ -280,29 +404,31 @@ void URLDownloader::DistillerCallback(
     return;
   }
 
-  std::vector<dom_distiller::DistillerViewer::ImageInfo> images_block = images;
-  std::string block_html = html;
-  task_tracker_.PostTaskAndReplyWithResult(
+  task->saving = true;
+  task->task_tracker.PostTaskAndReplyWithResult(
       task_runner_.get(), FROM_HERE,
-      base::Bind(&URLDownloader::SaveDistilledHTML, base::Unretained(this),
-                 page_url, images_block, block_html),
-      base::Bind(&URLDownloader::DownloadCompletionHandler,
-                 base::Unretained(this), page_url, title,
-                 reading_list::OfflinePagePath(
-                     page_url, reading_list::OFFLINE_TYPE_HTML)));
+      base::BindOnce(&URLDownloader::SaveDistilledHTML, base::Unretained(this),
+                     page_url, task->distilled_url, images, html),
+      base::BindOnce(&URLDownloader::SaveCompletionHandler,
+                     base::Unretained(this), page_url, title,
+                     reading_list::OfflinePagePath(
+                         page_url, reading_list::OFFLINE_TYPE_HTML)));
 }
 
-URLDownloader::SuccessState URLDownloader::SaveDistilledHTML(
+URLDownloader::SaveResult URLDownloader::SaveDistilledHTML(
     const GURL& url,
+    const GURL& distilled_url,
     const std::vector<dom_distiller::DistillerViewerInterface::ImageInfo>&
         images,
     const std::string& html) {
-  if (CreateOfflineURLDirectory(url)) {
-    return SaveHTMLForURL(SaveAndReplaceImagesInHTML(url, html, images), url)
-               ? DOWNLOAD_SUCCESS
-               : ERROR;
+  SaveResult result = {ERROR, 0};
+  if (CreateOfflineURLDirectory(url) &&
+      SaveHTMLForURL(SaveAndReplaceImagesInHTML(url, distilled_url, html,
+                                                images, &result.size),
+                     url, &result.size)) {
+    result.success = DOWNLOAD_SUCCESS;
   }
-  return ERROR;
+  return result;
 }
 
 bool URLDownloader::CreateOfflineURLDirectory(const GURL& url) {
@@ -317,7 +443,8 @@ bool URLDownloader::CreateOfflineURLDirectory(const GURL& url) {
 bool URLDownloader::SaveImage(const GURL& url,
                               const GURL& image_url,
                               const std::string& data,
-                              std::string* image_name) {
+                              std::string* image_name,
+                              int64_t* saved_size) {
   std::string image_hash = base::MD5String(image_url.spec());
   *image_name = image_hash;
   base::FilePath directory_path =
@@ -328,7 +455,7 @@ bool URLDownloader::SaveImage(const GURL& url,
     if (written <= 0) {
       return false;
     }
-    saved_size_ += written;
+    *saved_size += written;
     return true;
   }
   return true;
@@ -336,9 +463,11 @@ bool URLDownloader::SaveImage(const GURL& url,
 
 std::string URLDownloader::SaveAndReplaceImagesInHTML(
     const GURL& url,
+    const GURL& distilled_url,
     const std::string& html,
     const std::vector<dom_distiller::DistillerViewerInterface::ImageInfo>&
-        images) {
+        images,
+    int64_t* saved_size) {
   std::string mutable_html = html;
   bool local_images_found = false;
   for (size_t i = 0; i < images.size(); i++) {
@@ -348,12 +477,13 @@ std::string URLDownloader::SaveAndReplaceImagesInHTML(
     }
     std::string local_image_name;
     // Mixed content is HTTP images on HTTPS pages.
-    bool image_is_mixed_content = distilled_url_.SchemeIsCryptographic() &&
+    bool image_is_mixed_content = distilled_url.SchemeIsCryptographic() &&
                                   !images[i].url.SchemeIsCryptographic();
     // Only save images if it is not mixed content and image data is valid.
     if (!image_is_mixed_content && images[i].url.is_valid() &&
         !images[i].data.empty()) {
-      if (!SaveImage(url, images[i].url, images[i].data, &local_image_name)) {
+      if (!SaveImage(url, images[i].url, images[i].data, &local_image_name,
+                     saved_size)) {
         return std::string();
       }
     }
@@ -373,7 +503,9 @@ std::string URLDownloader::SaveAndReplaceImagesInHTML(
   return mutable_html;
 }
 
-bool URLDownloader::SaveHTMLForURL(std::string html, const GURL& url) {
+bool URLDownloader::SaveHTMLForURL(std::string html,
+                                   const GURL& url,
+                                   int64_t* saved_size) {
   if (html.empty()) {
     return false;
   }
@@ -384,6 +516,6 @@ bool URLDownloader::SaveHTMLForURL(std::string html, const GURL& url) {
   if (written <= 0) {
     return false;
   }
-  saved_size_ += written;
+  *saved_size += written;
   return true;
 }
@@ -5,9 +5,15 @@
 #ifndef IOS_CHROME_BROWSER_READING_LIST_URL_DOWNLOADER_H_
 #define IOS_CHROME_BROWSER_READING_LIST_URL_DOWNLOADER_H_
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "base/callback.h"
 #include "base/containers/circular_deque.h"
 #include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
 #include "base/task/cancelable_task_tracker.h"
 #include "ios/chrome/browser/dom_distiller/distiller_viewer.h"
 #include "ios/chrome/browser/reading_list/reading_list_distiller_page.h"
@@ -33,11 +39,15 @@ class ReadingListDistillerPageFactory;
 // fetch the page and simplify it.
 // If the URL points to a PDF file, the PDF is simply downloaded and saved to
 // the disk.
-// Only one item is downloaded or deleted at a time using a queue of tasks that
-// are handled sequentially. Items (page + images) are saved to individual
-// folders within an offline folder, using md5 hashing to create unique file
-// names. When a deletion is requested, all previous downloads for that URL are
-// cancelled as they would be deleted.
+// Downloads and deletions are queued as tasks. Several tasks are handled at a
+// time (see SetMaxConcurrentTasks()), with a lower limit on the downloads from
+// the same host so that a single site is not overloaded. Tasks for the
+// same URL are handled one after the other, and completion callbacks are
+// called in the order the tasks were queued, even if a later task finished
+// first. Items (page + images) are saved to individual folders within an
+// offline folder, using md5 hashing to create unique file names. When a
+// deletion is requested, all previous downloads for that URL are cancelled as
+// they would be deleted.
 class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
   friend class MockURLDownloader;
 
@@ -71,6 +81,10 @@ class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
                                                  int64_t size,
                                                  const std::string&)>;
 
+  // Default limits on the tasks handled at a time.
+  static const size_t kDefaultMaxConcurrentTasks;
+  static const size_t kDefaultMaxDownloadsPerHost;
+
   // Create a URL downloader with completion callbacks for downloads and
   // deletions. The completion callbacks will be called with the original url
   // and a boolean indicating success. For downloads, if distillation was
@@ -88,35 +102,86 @@ class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
   // Asynchronously download an offline version of the URL.
   void DownloadOfflineURL(const GURL& url);
 
-  // Cancels the download job an offline version of the URL.
+  // Cancels the queued and running downloads of an offline version of the URL.
+  // Their completion callback is not called, and the files already saved by a
+  // running download are deleted.
   void CancelDownloadOfflineURL(const GURL& url);
 
   // Asynchronously remove the offline version of the URL if it exists.
   void RemoveOfflineURL(const GURL& url);
 
+  // Sets the number of tasks handled at a time. Running tasks are not
+  // interrupted when it is lowered. 0 pauses the downloader.
+  void SetMaxConcurrentTasks(size_t max_concurrent_tasks);
+
+  // Sets the number of downloads from the same host handled at a time.
+  void SetMaxDownloadsPerHost(size_t max_downloads_per_host);
+
   // URL loader completion callback.
   void OnURLLoadComplete(const GURL& original_url,
                          base::FilePath response_path);
 
-  // Cancels the current download task.
-  void CancelTask();
-
  private:
   enum TaskType { DELETE, DOWNLOAD };
-  using Task = std::pair<TaskType, GURL>;
-
-  // Calls callback with true if an offline path exists. |path| must be
-  // absolute.
-  void OfflinePathExists(const base::FilePath& url,
-                         base::Callback<void(bool)> callback);
-  // Handles the next task in the queue, if no task is currently being handled.
-  void HandleNextTask();
+  enum TaskState { PENDING, RUNNING, DONE };
+
+  // A queued deletion or download, with the state of the download once it
+  // runs.
+  struct Task {
+    Task(TaskType type, const GURL& url);
+    ~Task();
+
+    const TaskType type;
+    const GURL url;
+    TaskState state;
+    // Calls the completion callback of the task, once |state| is DONE.
+    base::OnceClosure completion;
+
+    GURL distilled_url;
+    int64_t saved_size;
+    std::string mime_type;
+    // Whether files may have been saved for the download.
+    bool saving;
+    // URL loader used to redownload the document and save it in the sandbox.
+    std::unique_ptr<network::SimpleURLLoader> url_loader;
+    std::unique_ptr<dom_distiller::DistillerViewerInterface> distiller;
+    // Tracks the work posted to |task_runner_|, so that its replies are
+    // dropped if the task is cancelled.
+    base::CancelableTaskTracker task_tracker;
+
+    DISALLOW_COPY_AND_ASSIGN(Task);
+  };
+
+  // The outcome of saving a download to disk.
+  struct SaveResult {
+    SuccessState success;
+    int64_t size;
+  };
+
+  // Returns the running task for |url|, or null if there is none.
+  Task* FindRunningTask(const GURL& url);
+  // Starts the queued tasks that the limits on concurrency allow.
+  void HandleNextTasks();
+  void StartTask(Task* task);
+  // Marks |task| as done. |completion| is called once all the tasks queued
+  // before |task| are done.
+  void CompleteTask(Task* task, base::OnceClosure completion);
+  // Posts a task to run ProcessTasks(), unless one is pending already.
+  void ScheduleProcessTasks();
+  // Calls the completion callbacks that are due, and starts the next tasks.
+  void ProcessTasks();
   // Callback for completed (or failed) download, handles calling
   // downloadCompletion and starting the next task.
   void DownloadCompletionHandler(const GURL& url,
                                  const std::string& title,
                                  const base::FilePath& path,
                                  SuccessState success);
+  // Callback for saved (or failed) download, adds the saved size to the task
+  // of |url| and calls DownloadCompletionHandler.
+  void SaveCompletionHandler(const GURL& url,
+                             const std::string& title,
+                             const base::FilePath& path,
+                             const SaveResult& result);
   // Callback for completed (or failed) deletion, handles calling
   // deleteCompletion and starting the next task.
   void DeleteCompletionHandler(const GURL& url, bool success);
@@ -136,26 +201,34 @@ class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
 
   // HTML processing methods.
 
+  // The saving methods run on |task_runner_|, and add the number of bytes they
+  // write to |saved_size|.
+
   // Saves the |data| for image at |imageURL| to disk, for main URL |url|;
   // puts path of saved file in |path| and returns whether save was successful.
   bool SaveImage(const GURL& url,
                  const GURL& imageURL,
                  const std::string& data,
-                 std::string* image_name);
+                 std::string* image_name,
+                 int64_t* saved_size);
   // Saves images in |images| array to disk and replaces references in |html| to
-  // local path. Returns updated html.
+  // local path. Returns updated html. |distilled_url| is the URL the page was
+  // distilled from, after redirections.
   // If some images could not be saved, returns an empty string. It is the
   // responsibility of the caller to clean the partial processing.
   std::string SaveAndReplaceImagesInHTML(
       const GURL& url,
+      const GURL& distilled_url,
       const std::string& html,
       const std::vector<dom_distiller::DistillerViewerInterface::ImageInfo>&
-          images);
+          images,
+      int64_t* saved_size);
   // Saves |html| to disk in the correct location for |url|; returns success.
-  bool SaveHTMLForURL(std::string html, const GURL& url);
+  bool SaveHTMLForURL(std::string html, const GURL& url, int64_t* saved_size);
   // Saves distilled html to disk, including saving images and main file.
-  SuccessState SaveDistilledHTML(
+  SaveResult SaveDistilledHTML(
       const GURL& url,
+      const GURL& distilled_url,
       const std::vector<dom_distiller::DistillerViewerInterface::ImageInfo>&
           images,
       const std::string& html);
@@ -169,12 +242,12 @@ class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
 
   // PDF processing methods
 
-  // Starts fetching the PDF file. If |original_url_| triggered a redirection,
-  // directly save |distilled_url_|.
-  virtual void FetchPDFFile();
-  // Saves the file downloaded by |url_loader_|. Creates the directory if
-  // needed.
-  SuccessState SavePDFFile(const base::FilePath& temporary_path);
+  // Starts fetching the PDF file of |original_url|. If |original_url|
+  // triggered a redirection, directly save the distilled URL.
+  virtual void FetchPDFFile(const GURL& original_url);
+  // Saves the file downloaded by the URL loader of |url|. Creates the directory
+  // if needed.
+  SaveResult SavePDFFile(const GURL& url, const base::FilePath& temporary_path);
 
   reading_list::ReadingListDistillerPageFactory* distiller_page_factory_;
   dom_distiller::DistillerFactory* distiller_factory_;
@@ -182,20 +255,18 @@ class URLDownloader : reading_list::ReadingListDistillerPageDelegate {
   const DownloadCompletion download_completion_;
   const SuccessCompletion delete_completion_;
 
-  base::circular_deque<Task> tasks_;
-  bool working_;
+  // The tasks, in the order they were queued. Tasks are removed once their
+  // completion callback is called.
+  base::circular_deque<std::unique_ptr<Task>> tasks_;
+  size_t max_concurrent_tasks_;
+  size_t max_downloads_per_host_;
+  bool process_tasks_pending_;
   base::FilePath base_directory_;
-  GURL original_url_;
-  GURL distilled_url_;
-  int64_t saved_size_;
-  std::string mime_type_;
-  // URL loader used to redownload the document and save it in the sandbox.
-  std::unique_ptr<network::SimpleURLLoader> url_loader_;
   // URLLoaderFactory needed for the URLLoader.
   scoped_refptr<network::SharedURLLoaderFactory> url_loader_factory_;
-  std::unique_ptr<dom_distiller::DistillerViewerInterface> distiller_;
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
-  base::CancelableTaskTracker task_tracker_;
+
+  base::WeakPtrFactory<URLDownloader> weak_ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(URLDownloader);
 };
@@ -4,6 +4,7 @@
 
 #include "ios/chrome/browser/reading_list/url_downloader.h"
 
+#include <set>
 #include <vector>
 
 #include "base/bind.h"
@@ -96,11 +97,14 @@ class MockURLDownloader : public URLDownloader {
             base_directory_, reading_list::OfflinePagePath(url, file_type)));
   }
 
-  void FakeWorking() { working_ = true; }
+  void FakeWorking() { SetMaxConcurrentTasks(0); }
 
-  void FakeEndWorking() {
-    working_ = false;
-    HandleNextTask();
+  void FakeEndWorking() { SetMaxConcurrentTasks(1); }
+
+  // Distills |url|, whose distillation was deferred.
+  void DistillDeferredURL(const GURL& url) {
+    deferred_urls_.erase(url);
+    Distill(url);
   }
 
   std::vector<GURL> downloaded_files_;
@@ -108,6 +112,8 @@ class MockURLDownloader : public URLDownloader {
   GURL redirect_url_;
   std::string mime_type_;
   std::string html_;
+  // URLs whose distillation waits for DistillDeferredURL().
+  std::set<GURL> deferred_urls_;
 
  private:
   void DownloadURL(const GURL& url, bool offline_url_exists) override {
@@ -116,9 +122,14 @@ class MockURLDownloader : public URLDownloader {
                                 DOWNLOAD_EXISTS);
       return;
     }
-    original_url_ = url;
-    saved_size_ = 0;
-    distiller_.reset(new DistillerViewerTest(
+    if (!base::ContainsKey(deferred_urls_, url))
+      Distill(url);
+  }
+
+  void Distill(const GURL& url) {
+    Task* task = FindRunningTask(url);
+    ASSERT_TRUE(task);
+    task->distiller.reset(new DistillerViewerTest(
         url,
         base::Bind(&URLDownloader::DistillerCallback, base::Unretained(this)),
         this, html_, redirect_url_, mime_type_));
@@ -277,4 +288,69 @@ TEST_F(URLDownloaderTest, DownloadAndRemoveAndRedownload) {
   ASSERT_TRUE(downloader_->CheckExistenceOfOfflineURLPagePath(url));
 }
 
+// Tests that downloads run concurrently, and that their completions are
+// reported in the order they were requested.
+TEST_F(URLDownloaderTest, ConcurrentDownloadsCompleteInOrder) {
+  GURL url = GURL("http://test.com");
+  GURL url2 = GURL("http://test2.com");
+  downloader_->SetMaxConcurrentTasks(2);
+  downloader_->deferred_urls_.insert(url);
+  downloader_->DownloadOfflineURL(url);
+  downloader_->DownloadOfflineURL(url2);
+  task_environment_.RunUntilIdle();
+
+  // The second download is saved, but waits for the first one to report.
+  EXPECT_TRUE(downloader_->CheckExistenceOfOfflineURLPagePath(url2));
+  EXPECT_TRUE(downloader_->downloaded_files_.empty());
+
+  downloader_->DistillDeferredURL(url);
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ((std::vector<GURL>{url, url2}), downloader_->downloaded_files_);
+  EXPECT_TRUE(downloader_->CheckExistenceOfOfflineURLPagePath(url));
+}
+
+// Tests that downloads from the same host are limited.
+TEST_F(URLDownloaderTest, LimitsDownloadsPerHost) {
+  GURL url = GURL("http://test.com/a");
+  GURL url2 = GURL("http://test.com/b");
+  GURL url3 = GURL("http://test2.com");
+  downloader_->SetMaxConcurrentTasks(3);
+  downloader_->SetMaxDownloadsPerHost(1);
+  downloader_->deferred_urls_.insert(url);
+  downloader_->DownloadOfflineURL(url);
+  downloader_->DownloadOfflineURL(url2);
+  downloader_->DownloadOfflineURL(url3);
+  task_environment_.RunUntilIdle();
+
+  EXPECT_FALSE(downloader_->CheckExistenceOfOfflineURLPagePath(url2));
+  EXPECT_TRUE(downloader_->CheckExistenceOfOfflineURLPagePath(url3));
+
+  downloader_->DistillDeferredURL(url);
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ((std::vector<GURL>{url, url2, url3}),
+            downloader_->downloaded_files_);
+  EXPECT_TRUE(downloader_->CheckExistenceOfOfflineURLPagePath(url2));
+}
+
+// Tests that cancelling a running download drops its completion and lets the
+// next downloads report.
+TEST_F(URLDownloaderTest, CancelRunningDownload) {
+  GURL url = GURL("http://test.com");
+  GURL url2 = GURL("http://test2.com");
+  downloader_->SetMaxConcurrentTasks(2);
+  downloader_->deferred_urls_.insert(url);
+  downloader_->DownloadOfflineURL(url);
+  downloader_->DownloadOfflineURL(url2);
+  task_environment_.RunUntilIdle();
+  EXPECT_TRUE(downloader_->downloaded_files_.empty());
+
+  downloader_->CancelDownloadOfflineURL(url);
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ(std::vector<GURL>{url2}, downloader_->downloaded_files_);
+  EXPECT_FALSE(downloader_->CheckExistenceOfOfflineURLPagePath(url));
+}
+
 }  // namespace
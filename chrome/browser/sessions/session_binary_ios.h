@@ -0,0 +1,31 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_SESSIONS_SESSION_BINARY_IOS_H_
+#define IOS_CHROME_BROWSER_SESSIONS_SESSION_BINARY_IOS_H_
+
+#import <Foundation/Foundation.h>
+
+@class SessionIOS;
+
+namespace web {
+namespace binary_session {
+class SessionReader;
+}
+}  // namespace web
+
+// Conversions between SessionIOS and the binary session format described in
+// ios/web/public/session_binary_format.h.
+namespace session_binary {
+
+// Returns the encoding of |session| in the binary session format.
+NSData* DataFromSession(SessionIOS* session);
+
+// Returns the session read from |reader|, decoding all of its tabs. Returns
+// nil if a tab is corrupted.
+SessionIOS* SessionFromReader(const web::binary_session::SessionReader& reader);
+
+}  // namespace session_binary
+
+#endif  // IOS_CHROME_BROWSER_SESSIONS_SESSION_BINARY_IOS_H_
@@ -0,0 +1,66 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/sessions/session_binary_ios.h"
+
+#include <string>
+#include <vector>
+
+#include "base/numerics/safe_conversions.h"
+#import "ios/chrome/browser/sessions/session_ios.h"
+#import "ios/chrome/browser/sessions/session_window_ios.h"
+#import "ios/web/public/crw_session_storage.h"
+#include "ios/web/public/session_binary_format.h"
+#import "ios/web/public/session_storage_binary_util.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace session_binary {
+
+NSData* DataFromSession(SessionIOS* session) {
+  std::vector<web::binary_session::WindowData> windows;
+  for (SessionWindowIOS* sessionWindow in session.sessionWindows) {
+    web::binary_session::WindowData window;
+    window.selected_index =
+        sessionWindow.selectedIndex == NSNotFound
+            ? -1
+            : base::checked_cast<int>(sessionWindow.selectedIndex);
+    for (CRWSessionStorage* storage in sessionWindow.sessions)
+      window.tabs.push_back(web::TabDataFromSessionStorage(storage));
+    windows.push_back(std::move(window));
+  }
+  std::string data = web::binary_session::EncodeSession(windows);
+  return [NSData dataWithBytes:data.data() length:data.size()];
+}
+
+SessionIOS* SessionFromReader(
+    const web::binary_session::SessionReader& reader) {
+  NSMutableArray<SessionWindowIOS*>* sessionWindows = [NSMutableArray array];
+  for (size_t windowIndex = 0; windowIndex < reader.GetWindowCount();
+       ++windowIndex) {
+    size_t tabCount = reader.GetTabCount(windowIndex);
+    NSMutableArray<CRWSessionStorage*>* tabs =
+        [NSMutableArray arrayWithCapacity:tabCount];
+    for (size_t tabIndex = 0; tabIndex < tabCount; ++tabIndex) {
+      web::binary_session::TabData tab;
+      if (!reader.ReadTab(windowIndex, tabIndex, &tab))
+        return nil;
+      [tabs addObject:web::SessionStorageFromTabData(tab)];
+    }
+    // The reader validated that the selected index is -1 or a valid index,
+    // but SessionWindowIOS requires a selected tab in non-empty windows.
+    int selectedIndex = reader.GetSelectedIndex(windowIndex);
+    NSUInteger sessionSelectedIndex = NSNotFound;
+    if (tabs.count)
+      sessionSelectedIndex = selectedIndex == -1 ? 0 : selectedIndex;
+    [sessionWindows addObject:[[SessionWindowIOS alloc]
+                                  initWithSessions:tabs
+                                     selectedIndex:sessionSelectedIndex]];
+  }
+  return [[SessionIOS alloc] initWithWindows:sessionWindows];
+}
+
+}  // namespace session_binary
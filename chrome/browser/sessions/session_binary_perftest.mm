@@ -0,0 +1,157 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import <Foundation/Foundation.h>
+
+#include <malloc/malloc.h>
+
+#include <memory>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/format_macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/sys_string_conversions.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/timer/elapsed_timer.h"
+#import "ios/chrome/browser/sessions/session_ios.h"
+#import "ios/chrome/browser/sessions/session_service_ios.h"
+#import "ios/chrome/browser/sessions/session_window_ios.h"
+#include "ios/chrome/test/base/perf_test_ios.h"
+#import "ios/web/public/crw_navigation_item_storage.h"
+#import "ios/web/public/crw_session_storage.h"
+#include "ios/web/public/session_binary_format.h"
+#import "ios/web/public/session_storage_binary_util.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace {
+
+// Size of the synthetic session.
+const NSUInteger kTabCount = 300;
+const NSUInteger kItemCount = 20;
+
+// Returns the number of bytes allocated with malloc.
+double MallocSizeInUse() {
+  malloc_statistics_t stats = {};
+  malloc_zone_statistics(nullptr, &stats);
+  return stats.size_in_use;
+}
+
+// Returns a session with a single window of |kTabCount| tabs, each with
+// |kItemCount| navigation items.
+SessionIOS* CreateLargeSession() {
+  NSMutableArray<CRWSessionStorage*>* tabs = [NSMutableArray array];
+  for (NSUInteger tab = 0; tab < kTabCount; ++tab) {
+    NSMutableArray<CRWNavigationItemStorage*>* items = [NSMutableArray array];
+    for (NSUInteger item = 0; item < kItemCount; ++item) {
+      CRWNavigationItemStorage* item_storage =
+          [[CRWNavigationItemStorage alloc] init];
+      item_storage.virtualURL = GURL(base::StringPrintf(
+          "https://www.example.com/section/%" PRIuNS "/article/%" PRIuNS
+          "?utm_source=perftest",
+          tab, item));
+      item_storage.referrer = web::Referrer(GURL("https://www.example.com/"),
+                                            web::ReferrerPolicyDefault);
+      item_storage.timestamp = base::Time::Now();
+      item_storage.title = base::ASCIIToUTF16(base::StringPrintf(
+          "Article %" PRIuNS " of section %" PRIuNS, item, tab));
+      item_storage.displayState = web::PageDisplayState(
+          CGPointMake(0, 100 * item), UIEdgeInsetsMake(64, 0, 0, 0), 0.25,
+          5.0, 1.0);
+      [items addObject:item_storage];
+    }
+    CRWSessionStorage* storage = [[CRWSessionStorage alloc] init];
+    storage.lastCommittedItemIndex = kItemCount - 1;
+    storage.previousItemIndex = kItemCount - 2;
+    storage.itemStorages = items;
+    [tabs addObject:storage];
+  }
+  SessionWindowIOS* window =
+      [[SessionWindowIOS alloc] initWithSessions:tabs selectedIndex:0];
+  return [[SessionIOS alloc] initWithWindows:@[ window ]];
+}
+
+// Compares loading a large session archived with NSKeyedArchiver to loading it
+// in the binary session format.
+class SessionBinaryPerfTest : public PerfTest {
+ protected:
+  SessionBinaryPerfTest() : PerfTest("Session Loading") {}
+
+  void SetUp() override {
+    PerfTest::SetUp();
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    session_service_ = [[SessionServiceIOS alloc]
+        initWithTaskRunner:base::ThreadTaskRunnerHandle::Get()];
+
+    SessionIOS* session = CreateLargeSession();
+    NSString* directory =
+        base::SysUTF8ToNSString(temp_dir_.GetPath().AsUTF8Unsafe());
+    archive_path_ = [directory stringByAppendingPathComponent:@"session.plist"];
+    ASSERT_TRUE([[NSKeyedArchiver archivedDataWithRootObject:session]
+        writeToFile:archive_path_
+         atomically:YES]);
+    binary_path_ = [directory stringByAppendingPathComponent:@"session.bin"];
+    ASSERT_TRUE([session_service_ convertSessionAtPath:archive_path_
+                                          toBinaryPath:binary_path_]);
+  }
+
+  // Runs |load| repeatedly and logs its duration and the memory allocated
+  // while it runs, including the temporary objects it autoreleases.
+  void MeasureLoad(const std::string& name, id (^load)()) {
+    __block double allocated = 0;
+    RepeatTimedRuns(name,
+                    ^base::TimeDelta(int) {
+                      base::TimeDelta elapsed;
+                      @autoreleasepool {
+                        double initial_size = MallocSizeInUse();
+                        base::ElapsedTimer timer;
+                        id result = load();
+                        elapsed = timer.Elapsed();
+                        EXPECT_TRUE(result);
+                        allocated = MallocSizeInUse() - initial_size;
+                      }
+                      return elapsed;
+                    },
+                    nil);
+    LogPerfValue(name + " memory", allocated / 1024, "KB");
+  }
+
+  base::ScopedTempDir temp_dir_;
+  SessionServiceIOS* session_service_;
+  NSString* archive_path_;
+  NSString* binary_path_;
+};
+
+// Loads the whole session archived with NSKeyedArchiver.
+TEST_F(SessionBinaryPerfTest, LoadArchivedSession) {
+  MeasureLoad("Archived session", ^id {
+    return [session_service_ loadSessionFromPath:archive_path_];
+  });
+}
+
+// Loads the whole session from the binary session format.
+TEST_F(SessionBinaryPerfTest, LoadBinarySession) {
+  MeasureLoad("Binary session", ^id {
+    return [session_service_ loadSessionFromPath:binary_path_];
+  });
+}
+
+// Loads a single tab from the binary session format, as needed to display the
+// selected tab before the other tabs are restored.
+TEST_F(SessionBinaryPerfTest, LoadSelectedTabFromBinarySession) {
+  MeasureLoad("Binary session selected tab", ^id {
+    std::unique_ptr<web::binary_session::SessionReader> reader =
+        web::binary_session::SessionReader::OpenFile(
+            temp_dir_.GetPath().AppendASCII("session.bin"));
+    web::binary_session::TabData tab;
+    if (!reader || !reader->ReadTab(0, reader->GetSelectedIndex(0), &tab))
+      return nil;
+    return web::SessionStorageFromTabData(tab);
+  });
+}
+
+}  // namespace
@@ -0,0 +1,61 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_SESSIONS_SESSION_JOURNAL_IOS_H_
+#define IOS_CHROME_BROWSER_SESSIONS_SESSION_JOURNAL_IOS_H_
+
+#import <Foundation/Foundation.h>
+
+@class SessionIOS;
+
+// Tracks the content of a session file written in the journaled format and
+// computes the data to write to bring it up to date with a new session.
+//
+// A journaled session file is a header followed by a sequence of records
+// describing the number of windows, the size, selected index and tab order of
+// each window and the archived CRWSessionStorage of each tab. Records are
+// grouped in batches terminated by a commit record, and each record is
+// checksummed. A batch that was not completely written (e.g. because the
+// application was killed while appending it) is ignored when the file is
+// loaded, so that the loaded session is the one of the last completely written
+// save.
+//
+// Each save only appends the records of the windows and tabs that changed since
+// the previous save. Closing or moving tabs only rewrites the order of their
+// window. When the appended records outgrow the rest of the file, the file is
+// compacted, i.e. rewritten with a single batch describing the whole session.
+//
+// Except for the class methods, a SessionJournalIOS must only be used on the
+// sequence writing the file.
+@interface SessionJournalIOS : NSObject
+
+// Returns whether |data| is the content of a file in the journaled format.
++ (BOOL)isJournalData:(NSData*)data;
+
+// Replays the records of |data| and returns the resulting session. Returns nil
+// if |data| is not in the journaled format or is corrupted.
++ (SessionIOS*)sessionFromJournalData:(NSData*)data;
+
+// Updates the receiver with |session| and returns the data to write to the
+// file, or nil if |session| has not changed since the previous call. If
+// |compact| is set to YES, the data must replace the content of the file,
+// otherwise it must be appended to it.
+//
+// The first call always requests a compaction since the content of the file is
+// unknown. The tabs of |session| whose CRWSessionStorage is the same object as
+// in the previous call are considered unchanged and are not archived again, so
+// the CRWSessionStorage passed to this method must not be modified afterwards.
+- (NSData*)updateWithSession:(SessionIOS*)session compact:(BOOL*)compact;
+
+// Returns the data describing the whole session of the last update, to replace
+// the content of the file. Used when appending to the file failed.
+- (NSData*)compactedData;
+
+// Informs the receiver that the data of the last update could not be written,
+// so that the next update rewrites the whole file.
+- (void)invalidate;
+
+@end
+
+#endif  // IOS_CHROME_BROWSER_SESSIONS_SESSION_JOURNAL_IOS_H_
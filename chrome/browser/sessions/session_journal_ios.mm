@@ -0,0 +1,491 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/sessions/session_journal_ios.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/hash.h"
+#include "base/logging.h"
+#import "base/mac/foundation_util.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/strings/sys_string_conversions.h"
+#import "ios/chrome/browser/sessions/session_ios.h"
+#import "ios/chrome/browser/sessions/session_window_ios.h"
+#import "ios/web/public/crw_session_storage.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+// When C++ exceptions are disabled, the C++ library defines |try| and
+// |catch| so as to allow exception-expecting C++ code to build properly when
+// language support for exceptions is not present.  These macros interfere
+// with the use of |@try| and |@catch| in Objective-C files such as this one.
+// Undefine these macros here, after everything has been #included, since
+// there will be no C++ uses and only Objective-C uses from this point on.
+#undef try
+#undef catch
+
+namespace {
+
+// Header of the files in the journaled format. Legacy session files are
+// binary property lists and start with "bplist".
+const char kJournalHeader[] = {'C', 'r', 'S', 'e', 's', 's', 'J', '1'};
+
+// Each record is the size of its payload and the checksum of its payload, as
+// uint32_t in host byte order, followed by the payload, a dictionary
+// serialized as a binary property list.
+const size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+
+// The file is compacted once the records appended since the last compaction
+// are larger than both this size and the compacted file.
+const NSUInteger kMinJournalSize = 64 * 1024;
+
+// Record keys.
+NSString* const kRecordTypeKey = @"type";
+NSString* const kWindowCountKey = @"windowCount";
+NSString* const kWindowIndexKey = @"window";
+NSString* const kTabCountKey = @"tabCount";
+NSString* const kSelectedIndexKey = @"selectedIndex";
+NSString* const kTabIndexKey = @"tab";
+NSString* const kTabOrderKey = @"order";
+NSString* const kTabDataKey = @"data";
+
+// Record types. Those values are persisted, do not renumber them.
+enum RecordType : NSInteger {
+  // Sets the number of windows. Added windows are empty.
+  kWindowCountRecord = 0,
+  // Sets the number of tabs and the selected index of a window. If the record
+  // has an order, the tabs are rearranged so that each tab comes from the
+  // position listed in the order, or is added if that position is -1.
+  // Otherwise tabs are added or removed at the end. Added tabs must be set by
+  // tab records of the same batch.
+  kWindowRecord = 1,
+  // Sets the archived CRWSessionStorage of a tab.
+  kTabRecord = 2,
+  // Ends a batch of records.
+  kCommitRecord = 3,
+};
+
+// Returns |index| as a NSNumber. NSNotFound is stored as -1 since its value
+// differs between 32-bit and 64-bit binaries.
+NSNumber* EncodeIndex(NSUInteger index) {
+  if (index == static_cast<NSUInteger>(NSNotFound))
+    return @(-1);
+  return @(index);
+}
+
+// Reads the index stored for |key| in |record| into |index|. Returns NO if
+// |record| has no valid index for |key|.
+BOOL DecodeIndex(NSDictionary* record, NSString* key, NSUInteger* index) {
+  NSNumber* number = base::mac::ObjCCast<NSNumber>(record[key]);
+  if (!number || number.integerValue < -1)
+    return NO;
+  *index = number.integerValue == -1 ? static_cast<NSUInteger>(NSNotFound)
+                                     : number.unsignedIntegerValue;
+  return YES;
+}
+
+// Appends |record| to |data|.
+void AppendRecord(NSMutableData* data, NSDictionary* record) {
+  NSError* error = nil;
+  NSData* payload = [NSPropertyListSerialization
+      dataWithPropertyList:record
+                    format:NSPropertyListBinaryFormat_v1_0
+                   options:0
+                     error:&error];
+  DCHECK(payload) << base::SysNSStringToUTF8([error description]);
+  const uint32_t header[] = {
+      base::checked_cast<uint32_t>(payload.length),
+      base::PersistentHash(payload.bytes, payload.length)};
+  static_assert(sizeof(header) == kRecordHeaderSize, "Invalid record header");
+  [data appendBytes:header length:sizeof(header)];
+  [data appendData:payload];
+}
+
+// Returns the records of the complete batches of |data|, which must be in the
+// journaled format. Parsing stops at the first truncated or corrupted record;
+// the records of the batch it belongs to are dropped.
+NSArray<NSDictionary*>* ParseCommittedRecords(NSData* data) {
+  NSMutableArray<NSDictionary*>* records = [NSMutableArray array];
+  NSUInteger committedRecordCount = 0;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data.bytes);
+  size_t offset = sizeof(kJournalHeader);
+  while (data.length - offset >= kRecordHeaderSize) {
+    uint32_t header[2];
+    memcpy(header, bytes + offset, sizeof(header));
+    offset += sizeof(header);
+    if (data.length - offset < header[0])
+      break;
+    if (base::PersistentHash(bytes + offset, header[0]) != header[1])
+      break;
+
+    NSDictionary* record = base::mac::ObjCCast<NSDictionary>(
+        [NSPropertyListSerialization
+            propertyListWithData:[data subdataWithRange:NSMakeRange(
+                                                            offset, header[0])]
+                         options:NSPropertyListImmutable
+                          format:nullptr
+                           error:nil]);
+    if (!record)
+      break;
+    offset += header[0];
+
+    [records addObject:record];
+    NSNumber* type = base::mac::ObjCCast<NSNumber>(record[kRecordTypeKey]);
+    if (type.integerValue == kCommitRecord)
+      committedRecordCount = records.count;
+  }
+  return [records subarrayWithRange:NSMakeRange(0, committedRecordCount)];
+}
+
+// Returns the CRWSessionStorage archived in |data| or nil if |data| is not a
+// valid archive.
+CRWSessionStorage* UnarchiveTab(NSData* data) {
+  if (!data)
+    return nil;
+  @try {
+    return base::mac::ObjCCast<CRWSessionStorage>(
+        [NSKeyedUnarchiver unarchiveObjectWithData:data]);
+  } @catch (NSException* exception) {
+    DLOG(ERROR) << "Error unarchiving tab from session journal: "
+                << base::SysNSStringToUTF8([exception reason]);
+    return nil;
+  }
+}
+
+// Returns the tabs of a window whose previous tabs are |tabs|, rearranged
+// according to |order| as described for kWindowRecord. Returns nil if |order|
+// is invalid.
+NSMutableArray* ReorderTabs(NSArray* tabs, NSArray* order) {
+  if (!order)
+    return nil;
+  NSMutableArray* reorderedTabs = [NSMutableArray array];
+  for (id object in order) {
+    NSNumber* index = base::mac::ObjCCast<NSNumber>(object);
+    if (!index || index.integerValue < -1 ||
+        index.integerValue >= static_cast<NSInteger>(tabs.count)) {
+      return nil;
+    }
+    [reorderedTabs addObject:index.integerValue == -1
+                                 ? [NSNull null]
+                                 : tabs[index.unsignedIntegerValue]];
+  }
+  return reorderedTabs;
+}
+
+// Returns, for each tab of |tabs|, the position of the same tab in
+// |previousTabs| or -1 if the tab was added or modified. A tab stays at its
+// position if its data is unchanged there. Otherwise it is looked up by
+// identity, since the tabs that did not change reuse the archived data of the
+// previous update.
+NSArray<NSNumber*>* PreviousTabPositions(NSArray<NSData*>* tabs,
+                                         NSArray<NSData*>* previousTabs) {
+  NSMutableArray<NSNumber*>* positions = [NSMutableArray array];
+  NSMutableIndexSet* unmatchedPositions = [NSMutableIndexSet
+      indexSetWithIndexesInRange:NSMakeRange(0, previousTabs.count)];
+  for (NSUInteger tabIndex = 0; tabIndex < tabs.count; ++tabIndex) {
+    if (tabIndex < previousTabs.count &&
+        (tabs[tabIndex] == previousTabs[tabIndex] ||
+         [tabs[tabIndex] isEqualToData:previousTabs[tabIndex]])) {
+      [positions addObject:@(tabIndex)];
+      [unmatchedPositions removeIndex:tabIndex];
+    } else {
+      [positions addObject:@(-1)];
+    }
+  }
+
+  NSMapTable<NSData*, NSMutableIndexSet*>* positionsByTab =
+      [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality
+                            valueOptions:NSMapTableStrongMemory];
+  [unmatchedPositions enumerateIndexesUsingBlock:^(NSUInteger index,
+                                                   BOOL* stop) {
+    NSData* previousTab = previousTabs[index];
+    NSMutableIndexSet* indexes = [positionsByTab objectForKey:previousTab];
+    if (!indexes) {
+      indexes = [NSMutableIndexSet indexSet];
+      [positionsByTab setObject:indexes forKey:previousTab];
+    }
+    [indexes addIndex:index];
+  }];
+  for (NSUInteger tabIndex = 0; tabIndex < tabs.count; ++tabIndex) {
+    if (positions[tabIndex].integerValue != -1)
+      continue;
+    NSMutableIndexSet* indexes = [positionsByTab objectForKey:tabs[tabIndex]];
+    if (!indexes.count)
+      continue;
+    positions[tabIndex] = @(indexes.firstIndex);
+    [indexes removeIndex:indexes.firstIndex];
+  }
+  return positions;
+}
+
+}  // namespace
+
+@implementation SessionJournalIOS {
+  // The archived CRWSessionStorage of the tabs of each window and the selected
+  // index of each window, as of the last update.
+  NSArray<NSArray<NSData*>*>* _windows;
+  NSArray<NSNumber*>* _selectedIndexes;
+
+  // Maps the CRWSessionStorage of the last update to their archived data.
+  NSMapTable<CRWSessionStorage*, NSData*>* _archivedTabs;
+
+  // Whether the file content matches the previous update.
+  BOOL _valid;
+
+  // The size of the file after its last compaction, and the size of the
+  // records appended to it since.
+  NSUInteger _compactedSize;
+  NSUInteger _journalSize;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+  if ((self = [super init])) {
+    _windows = @[];
+    _selectedIndexes = @[];
+  }
+  return self;
+}
+
+#pragma mark - Public
+
++ (BOOL)isJournalData:(NSData*)data {
+  return data.length >= sizeof(kJournalHeader) &&
+         !memcmp(data.bytes, kJournalHeader, sizeof(kJournalHeader));
+}
+
++ (SessionIOS*)sessionFromJournalData:(NSData*)data {
+  if (![self isJournalData:data])
+    return nil;
+
+  NSArray<NSDictionary*>* records = ParseCommittedRecords(data);
+  if (!records.count)
+    return nil;
+
+  // Tabs not set yet are represented by NSNull.
+  NSMutableArray<NSMutableArray*>* windows = [NSMutableArray array];
+  NSMutableArray<NSNumber*>* selectedIndexes = [NSMutableArray array];
+  for (NSDictionary* record in records) {
+    NSNumber* type = base::mac::ObjCCast<NSNumber>(record[kRecordTypeKey]);
+    NSUInteger windowCount = 0;
+    NSUInteger windowIndex = 0;
+    NSUInteger tabCount = 0;
+    NSUInteger tabIndex = 0;
+    NSUInteger selectedIndex = 0;
+    switch (type.integerValue) {
+      case kWindowCountRecord:
+        if (!DecodeIndex(record, kWindowCountKey, &windowCount))
+          return nil;
+        while (windows.count > windowCount) {
+          [windows removeLastObject];
+          [selectedIndexes removeLastObject];
+        }
+        while (windows.count < windowCount) {
+          [windows addObject:[NSMutableArray array]];
+          [selectedIndexes addObject:@(NSNotFound)];
+        }
+        break;
+
+      case kWindowRecord:
+        if (!DecodeIndex(record, kWindowIndexKey, &windowIndex) ||
+            windowIndex >= windows.count ||
+            !DecodeIndex(record, kTabCountKey, &tabCount) ||
+            !DecodeIndex(record, kSelectedIndexKey, &selectedIndex)) {
+          return nil;
+        }
+        if (record[kTabOrderKey]) {
+          NSMutableArray* tabs =
+              ReorderTabs(windows[windowIndex],
+                          base::mac::ObjCCast<NSArray>(record[kTabOrderKey]));
+          if (!tabs || tabs.count != tabCount)
+            return nil;
+          windows[windowIndex] = tabs;
+        }
+        while (windows[windowIndex].count > tabCount)
+          [windows[windowIndex] removeLastObject];
+        while (windows[windowIndex].count < tabCount)
+          [windows[windowIndex] addObject:[NSNull null]];
+        selectedIndexes[windowIndex] = @(selectedIndex);
+        break;
+
+      case kTabRecord: {
+        if (!DecodeIndex(record, kWindowIndexKey, &windowIndex) ||
+            windowIndex >= windows.count ||
+            !DecodeIndex(record, kTabIndexKey, &tabIndex) ||
+            tabIndex >= windows[windowIndex].count) {
+          return nil;
+        }
+        CRWSessionStorage* storage =
+            UnarchiveTab(base::mac::ObjCCast<NSData>(record[kTabDataKey]));
+        if (!storage)
+          return nil;
+        windows[windowIndex][tabIndex] = storage;
+        break;
+      }
+
+      case kCommitRecord:
+        break;
+
+      default:
+        return nil;
+    }
+  }
+
+  NSMutableArray<SessionWindowIOS*>* sessionWindows = [NSMutableArray array];
+  for (NSUInteger index = 0; index < windows.count; ++index) {
+    NSArray* tabs = windows[index];
+    if ([tabs containsObject:[NSNull null]])
+      return nil;
+    NSUInteger selectedIndex = selectedIndexes[index].unsignedIntegerValue;
+    if (!tabs.count) {
+      selectedIndex = NSNotFound;
+    } else if (selectedIndex >= tabs.count) {
+      selectedIndex = 0;
+    }
+    [sessionWindows addObject:[[SessionWindowIOS alloc]
+                                  initWithSessions:tabs
+                                     selectedIndex:selectedIndex]];
+  }
+  return [[SessionIOS alloc] initWithWindows:sessionWindows];
+}
+
+- (NSData*)updateWithSession:(SessionIOS*)session compact:(BOOL*)compact {
+  DCHECK(compact);
+  NSMutableArray<NSArray<NSData*>*>* windows = [NSMutableArray array];
+  NSMutableArray<NSNumber*>* selectedIndexes = [NSMutableArray array];
+  NSMapTable<CRWSessionStorage*, NSData*>* archivedTabs =
+      [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality
+                            valueOptions:NSMapTableStrongMemory];
+  for (SessionWindowIOS* sessionWindow in session.sessionWindows) {
+    NSMutableArray<NSData*>* tabs = [NSMutableArray array];
+    for (CRWSessionStorage* storage in sessionWindow.sessions) {
+      // Tabs that did not change since the previous update reuse the same
+      // CRWSessionStorage, which is not archived again.
+      NSData* tab = [_archivedTabs objectForKey:storage];
+      if (!tab)
+        tab = [NSKeyedArchiver archivedDataWithRootObject:storage];
+      [archivedTabs setObject:tab forKey:storage];
+      [tabs addObject:tab];
+    }
+    [windows addObject:tabs];
+    [selectedIndexes addObject:EncodeIndex(sessionWindow.selectedIndex)];
+  }
+
+  NSArray<NSArray<NSData*>*>* previousWindows = _windows;
+  NSArray<NSNumber*>* previousSelectedIndexes = _selectedIndexes;
+  _windows = windows;
+  _selectedIndexes = selectedIndexes;
+  _archivedTabs = archivedTabs;
+
+  if (!_valid) {
+    *compact = YES;
+    return [self compactedData];
+  }
+
+  NSMutableData* records = [NSMutableData data];
+  [self appendChangesFromWindows:previousWindows
+                 selectedIndexes:previousSelectedIndexes
+                          toData:records];
+  if (!records.length)
+    return nil;
+  AppendRecord(records, @{kRecordTypeKey : @(kCommitRecord)});
+
+  if (_journalSize + records.length >
+      std::max(_compactedSize, kMinJournalSize)) {
+    *compact = YES;
+    return [self compactedData];
+  }
+
+  _journalSize += records.length;
+  *compact = NO;
+  return records;
+}
+
+- (NSData*)compactedData {
+  NSMutableData* data = [NSMutableData dataWithBytes:kJournalHeader
+                                              length:sizeof(kJournalHeader)];
+  [self appendChangesFromWindows:@[] selectedIndexes:@[] toData:data];
+  AppendRecord(data, @{kRecordTypeKey : @(kCommitRecord)});
+
+  _valid = YES;
+  _compactedSize = data.length;
+  _journalSize = 0;
+  return data;
+}
+
+- (void)invalidate {
+  _valid = NO;
+}
+
+#pragma mark - Private
+
+// Appends to |data| the records turning the session described by
+// |previousWindows| and |previousSelectedIndexes| into the current one.
+- (void)appendChangesFromWindows:(NSArray<NSArray<NSData*>*>*)previousWindows
+                 selectedIndexes:(NSArray<NSNumber*>*)previousSelectedIndexes
+                          toData:(NSMutableData*)data {
+  if (_windows.count != previousWindows.count) {
+    AppendRecord(data, @{
+      kRecordTypeKey : @(kWindowCountRecord),
+      kWindowCountKey : @(_windows.count),
+    });
+  }
+
+  for (NSUInteger windowIndex = 0; windowIndex < _windows.count;
+       ++windowIndex) {
+    NSArray<NSData*>* tabs = _windows[windowIndex];
+    NSArray<NSData*>* previousTabs = nil;
+    NSNumber* previousSelectedIndex = nil;
+    if (windowIndex < previousWindows.count) {
+      previousTabs = previousWindows[windowIndex];
+      previousSelectedIndex = previousSelectedIndexes[windowIndex];
+    }
+
+    // Tabs that were closed or moved are described by the order of the window
+    // record, so that the tabs following them are not written again. The
+    // order is omitted when every tab is either at its previous position or
+    // rewritten.
+    NSArray<NSNumber*>* previousPositions =
+        PreviousTabPositions(tabs, previousTabs);
+    BOOL reordered = NO;
+    for (NSUInteger tabIndex = 0; tabIndex < tabs.count; ++tabIndex) {
+      NSInteger position = previousPositions[tabIndex].integerValue;
+      if (position != -1 && position != static_cast<NSInteger>(tabIndex))
+        reordered = YES;
+    }
+
+    if (!previousTabs || reordered || tabs.count != previousTabs.count ||
+        ![_selectedIndexes[windowIndex] isEqual:previousSelectedIndex]) {
+      NSMutableDictionary* record = [@{
+        kRecordTypeKey : @(kWindowRecord),
+        kWindowIndexKey : @(windowIndex),
+        kTabCountKey : @(tabs.count),
+        kSelectedIndexKey : _selectedIndexes[windowIndex],
+      } mutableCopy];
+      if (reordered)
+        record[kTabOrderKey] = previousPositions;
+      AppendRecord(data, record);
+    }
+
+    for (NSUInteger tabIndex = 0; tabIndex < tabs.count; ++tabIndex) {
+      if (previousPositions[tabIndex].integerValue != -1)
+        continue;
+      AppendRecord(data, @{
+        kRecordTypeKey : @(kTabRecord),
+        kWindowIndexKey : @(windowIndex),
+        kTabIndexKey : @(tabIndex),
+        kTabDataKey : tabs[tabIndex],
+      });
+    }
+  }
+}
+
+@end
@@ -30,20 +30,31 @@ using SessionIOSFactory = SessionIOS* (^)();
 // Saves the session returned by |factory| to |directory|. If |immediately|
 // is NO, the save is done after a delay. If another call is pending, this one
 // is ignored. If YES, the save is done now, cancelling any pending calls.
-// Either way, the save is done on a separate thread to avoid blocking the UI
-// thread.
+// Either way, the session is serialized and saved on a separate thread to
+// avoid blocking the UI thread. The session file is journaled: only the
+// windows and tabs that changed since the previous save are appended to it,
+// and it is compacted when the appended records grow too large. To avoid
+// serializing unchanged tabs again, |factory| should return the same
+// CRWSessionStorage objects as for the previous save for those tabs.
 - (void)saveSession:(SessionIOSFactory)factory
           directory:(NSString*)directory
         immediately:(BOOL)immediately;
 
 // Loads the session from default session file in |directory| on the main
-// thread. Returns nil in case of errors.
+// thread, replaying its journal if any. Returns nil in case of errors.
 - (SessionIOS*)loadSessionFromDirectory:(NSString*)directory;
 
 // Loads the session from |sessionPath| on the main thread. Returns nil in case
 // of errors.
 - (SessionIOS*)loadSessionFromPath:(NSString*)sessionPath;
 
+// Converts the session file at |sessionPath|, in any of the formats supported
+// by -loadSessionFromPath:, to a file at |binaryPath| in the binary session
+// format. Used to migrate legacy sessions archived with NSKeyedArchiver.
+// Returns whether the file was written.
+- (BOOL)convertSessionAtPath:(NSString*)sessionPath
+                toBinaryPath:(NSString*)binaryPath;
+
 // Schedules deletion of the file containing the last session in |directory|.
 - (void)deleteLastSessionFileInDirectory:(NSString*)directory
                               completion:(base::OnceClosure)callback;
@@ -59,7 +70,9 @@ using SessionIOSFactory = SessionIOS* (^)();
 // immediately so we can read it back in to verify various attributes. This
 // is not a situation we normally expect to be in because we never
 // want the session being saved on the main thread in the production app.
-- (void)performSaveSessionData:(NSData*)sessionData
+// Replaces the content of |sessionPath| with |sessionData|. Returns whether
+// the file was written.
+- (BOOL)performSaveSessionData:(NSData*)sessionData
                    sessionPath:(NSString*)sessionPath;
 
 @end
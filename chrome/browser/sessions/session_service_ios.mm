@@ -6,22 +6,29 @@
 
 #import <UIKit/UIKit.h>
 
+#include <memory>
+
 #include "base/bind.h"
 #include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/format_macros.h"
 #include "base/location.h"
 #include "base/logging.h"
 #import "base/mac/foundation_util.h"
 #include "base/memory/ref_counted.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/sequenced_task_runner.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/task/post_task.h"
 #include "base/threading/scoped_blocking_call.h"
+#import "ios/chrome/browser/sessions/session_binary_ios.h"
 #import "ios/chrome/browser/sessions/session_ios.h"
+#import "ios/chrome/browser/sessions/session_journal_ios.h"
 #import "ios/chrome/browser/sessions/session_window_ios.h"
 #import "ios/web/public/crw_navigation_item_storage.h"
 #import "ios/web/public/crw_session_certificate_policy_cache_storage.h"
 #import "ios/web/public/crw_session_storage.h"
+#include "ios/web/public/session_binary_format.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
 #error "This file requires ARC support."
@@ -75,6 +82,11 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
 
   // Maps session path to the pending session for the delayed save behaviour.
   NSMutableDictionary<NSString*, SessionIOSFactory>* _pendingSessions;
+
+  // Maps session path to the journal tracking the content of the file. Only
+  // accessed on the main thread, the journals themselves are only used on
+  // |_taskRunner|.
+  NSMutableDictionary<NSString*, SessionJournalIOS*>* _journals;
 }
 
 #pragma mark - NSObject overrides
@@ -103,6 +115,7 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
   self = [super init];
   if (self) {
     _pendingSessions = [NSMutableDictionary dictionary];
+    _journals = [NSMutableDictionary dictionary];
     _taskRunner = taskRunner;
   }
   return self;
@@ -134,10 +147,36 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
 - (SessionIOS*)loadSessionFromPath:(NSString*)sessionPath {
   NSObject<NSCoding>* rootObject = nil;
   @try {
+    // Binary sessions are memory-mapped rather than read.
+    std::unique_ptr<web::binary_session::SessionReader> reader =
+        web::binary_session::SessionReader::OpenFile(
+            base::mac::NSStringToFilePath(sessionPath));
+    if (reader) {
+      SessionIOS* session = session_binary::SessionFromReader(*reader);
+      DLOG_IF(ERROR, !session) << "Error loading binary session: "
+                               << base::SysNSStringToUTF8(sessionPath);
+      return session;
+    }
+
     NSData* data = [NSData dataWithContentsOfFile:sessionPath];
     if (!data)
       return nil;
 
+    // Binary sessions of an unsupported version or whose index is corrupted
+    // are not loaded.
+    if (web::binary_session::HasBinarySessionHeader(data.bytes, data.length)) {
+      DLOG(ERROR) << "Error loading binary session: "
+                  << base::SysNSStringToUTF8(sessionPath);
+      return nil;
+    }
+
+    if ([SessionJournalIOS isJournalData:data]) {
+      SessionIOS* session = [SessionJournalIOS sessionFromJournalData:data];
+      DLOG_IF(ERROR, !session) << "Error loading session journal: "
+                               << base::SysNSStringToUTF8(sessionPath);
+      return session;
+    }
+
     NSKeyedUnarchiver* unarchiver =
         [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
 
@@ -164,9 +203,20 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
   return base::mac::ObjCCastStrict<SessionIOS>(rootObject);
 }
 
+- (BOOL)convertSessionAtPath:(NSString*)sessionPath
+                toBinaryPath:(NSString*)binaryPath {
+  SessionIOS* session = [self loadSessionFromPath:sessionPath];
+  if (!session)
+    return NO;
+  return [self performSaveSessionData:session_binary::DataFromSession(session)
+                          sessionPath:binaryPath];
+}
+
 - (void)deleteLastSessionFileInDirectory:(NSString*)directory
                               completion:(base::OnceClosure)callback {
   NSString* sessionPath = [[self class] sessionPathForDirectory:directory];
+  // The next save rewrites the whole file.
+  [_journals removeObjectForKey:sessionPath];
   _taskRunner->PostTaskAndReply(
       FROM_HERE, base::BindOnce(^{
         base::ScopedBlockingCall scoped_blocking_call(
@@ -195,31 +245,68 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
   DCHECK(sessionPath);
   DCHECK([_pendingSessions objectForKey:sessionPath] != nil);
 
-  // Serialize to NSData on the main thread to avoid accessing potentially
-  // non-threadsafe objects on a background thread.
+  // The session objects returned by the factory are copies made for saving on
+  // a separate thread, so they are serialized on |_taskRunner|.
   SessionIOSFactory factory = [_pendingSessions objectForKey:sessionPath];
   [_pendingSessions removeObjectForKey:sessionPath];
   SessionIOS* session = factory();
 
+  SessionJournalIOS* journal = [_journals objectForKey:sessionPath];
+  if (!journal) {
+    journal = [[SessionJournalIOS alloc] init];
+    [_journals setObject:journal forKey:sessionPath];
+  }
+  _taskRunner->PostTask(FROM_HERE, base::BindOnce(^{
+                          [self performSaveSession:session
+                                           journal:journal
+                                       sessionPath:sessionPath];
+                        }));
+}
+
+// Writes the changes of |session| since the previous save to |sessionPath|,
+// either by appending them to the file or by rewriting it. Called on
+// |_taskRunner|.
+- (void)performSaveSession:(SessionIOS*)session
+                   journal:(SessionJournalIOS*)journal
+               sessionPath:(NSString*)sessionPath {
+  BOOL compact = NO;
+  NSData* sessionData = nil;
   @try {
-    NSData* sessionData = [NSKeyedArchiver archivedDataWithRootObject:session];
-    _taskRunner->PostTask(FROM_HERE, base::BindOnce(^{
-                            [self performSaveSessionData:sessionData
-                                             sessionPath:sessionPath];
-                          }));
+    sessionData = [journal updateWithSession:session compact:&compact];
   } @catch (NSException* exception) {
     NOTREACHED() << "Error serializing session for path: "
                  << base::SysNSStringToUTF8(sessionPath) << ": "
                  << base::SysNSStringToUTF8([exception description]);
+    [journal invalidate];
+    return;
+  }
+
+  if (!sessionData)
     return;
+
+  if (!compact) {
+    base::ScopedBlockingCall scoped_blocking_call(
+        base::BlockingType::MAY_BLOCK);
+    // Appending fails if the file was deleted or moved since the previous
+    // save, in which case the whole session is written instead.
+    if (base::AppendToFile(
+            base::FilePath(base::SysNSStringToUTF8(sessionPath)),
+            static_cast<const char*>(sessionData.bytes),
+            base::checked_cast<int>(sessionData.length))) {
+      return;
+    }
+    sessionData = [journal compactedData];
   }
+
+  if (![self performSaveSessionData:sessionData sessionPath:sessionPath])
+    [journal invalidate];
 }
 
 @end
 
 @implementation SessionServiceIOS (SubClassing)
 
-- (void)performSaveSessionData:(NSData*)sessionData
+- (BOOL)performSaveSessionData:(NSData*)sessionData
                    sessionPath:(NSString*)sessionPath {
   base::ScopedBlockingCall scoped_blocking_call(
             base::BlockingType::MAY_BLOCK);
@@ -238,7 +325,7 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
       NOTREACHED() << "Error creating destination directory: "
                    << base::SysNSStringToUTF8(directory) << ": "
                    << base::SysNSStringToUTF8([error description]);
-      return;
+      return NO;
     }
   }
 
@@ -246,7 +333,7 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
     NOTREACHED() << "Error creating destination directory: "
                  << base::SysNSStringToUTF8(directory) << ": "
                  << "file exists and is not a directory.";
-    return;
+    return NO;
   }
 
   NSDataWritingOptions options =
@@ -256,8 +343,9 @@ NSString* const kRootObjectKey = @"root";  // Key for the root object.
     NOTREACHED() << "Error writing session file: "
                  << base::SysNSStringToUTF8(sessionPath) << ": "
                  << base::SysNSStringToUTF8([error description]);
-    return;
+    return NO;
   }
+  return YES;
 }
 
 @end
@@ -20,6 +20,7 @@
 #import "ios/chrome/browser/sessions/session_service_ios.h"
 #import "ios/chrome/browser/sessions/session_window_ios.h"
 #import "ios/web/public/crw_session_storage.h"
+#include "ios/web/public/session_binary_format.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/gtest_mac.h"
 #include "testing/platform_test.h"
@@ -90,6 +91,42 @@ class SessionServiceTest : public PlatformTest {
     };
   }
 
+  // Create a SessionIOSFactory creating a SessionIOS with a single window with
+  // |tab_count| tabs, where only the tab at |opener_index| has an opener.
+  SessionIOSFactory CreateSessionFactoryWithOpener(NSUInteger tab_count,
+                                                   NSUInteger opener_index) {
+    return ^{
+      NSMutableArray<CRWSessionStorage*>* tabs = [NSMutableArray array];
+      while (tabs.count < tab_count) {
+        CRWSessionStorage* tab = [[CRWSessionStorage alloc] init];
+        tab.hasOpener = tabs.count == opener_index;
+        [tabs addObject:tab];
+      }
+      SessionWindowIOS* window =
+          [[SessionWindowIOS alloc] initWithSessions:[tabs copy]
+                                       selectedIndex:0];
+      return [[SessionIOS alloc] initWithWindows:@[ window ]];
+    };
+  }
+
+  // Saves the session returned by |factory| and waits for the save to
+  // complete.
+  void SaveSession(SessionIOSFactory factory) {
+    [session_service() saveSession:factory
+                         directory:directory()
+                       immediately:YES];
+    base::RunLoop().RunUntilIdle();
+  }
+
+  // Returns the size of the session file in |directory()|.
+  unsigned long long SessionFileSize() {
+    NSString* session_path =
+        [SessionServiceIOS sessionPathForDirectory:directory()];
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:session_path
+                                                             error:nil]
+        fileSize];
+  }
+
   SessionServiceIOS* session_service() { return session_service_; }
 
   NSString* directory() { return directory_; }
@@ -194,6 +231,149 @@ TEST_F(SessionServiceTest, LoadSessionFromPath) {
   }
 }
 
+// Tests that saving a session only appends the tabs that changed.
+TEST_F(SessionServiceTest, SaveSessionAppendsChangedTabs) {
+  SaveSession(CreateSessionFactoryWithOpener(10u, NSNotFound));
+  unsigned long long initial_size = SessionFileSize();
+  ASSERT_GT(initial_size, 0u);
+
+  // Saving an unchanged session does not write anything.
+  SaveSession(CreateSessionFactoryWithOpener(10u, NSNotFound));
+  EXPECT_EQ(initial_size, SessionFileSize());
+
+  SaveSession(CreateSessionFactoryWithOpener(10u, 1u));
+  unsigned long long appended_size = SessionFileSize() - initial_size;
+  EXPECT_GT(appended_size, 0u);
+  EXPECT_LT(appended_size * 5, initial_size);
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  NSArray<CRWSessionStorage*>* tabs = session.sessionWindows[0].sessions;
+  ASSERT_EQ(10u, tabs.count);
+  for (NSUInteger index = 0; index < tabs.count; ++index)
+    EXPECT_EQ(index == 1u, tabs[index].hasOpener);
+}
+
+// Tests that the tabs whose CRWSessionStorage is the one of the previous save
+// are not archived again.
+TEST_F(SessionServiceTest, SaveSessionSkipsReusedTabs) {
+  NSArray<CRWSessionStorage*>* tabs = @[
+    [[CRWSessionStorage alloc] init], [[CRWSessionStorage alloc] init]
+  ];
+  SessionIOSFactory factory = ^{
+    SessionWindowIOS* window =
+        [[SessionWindowIOS alloc] initWithSessions:tabs selectedIndex:0];
+    return [[SessionIOS alloc] initWithWindows:@[ window ]];
+  };
+  SaveSession(factory);
+  unsigned long long initial_size = SessionFileSize();
+
+  // The modification of a reused CRWSessionStorage is not saved.
+  tabs[0].hasOpener = YES;
+  SaveSession(factory);
+  EXPECT_EQ(initial_size, SessionFileSize());
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  ASSERT_EQ(2u, session.sessionWindows[0].sessions.count);
+  EXPECT_FALSE(session.sessionWindows[0].sessions[0].hasOpener);
+}
+
+// Tests that windows and tabs removed since the previous save are removed
+// from the loaded session.
+TEST_F(SessionServiceTest, SaveSessionRemovesWindowsAndTabs) {
+  SaveSession(CreateSessionFactory(2u, 3u));
+  SaveSession(CreateSessionFactory(1u, 1u));
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  EXPECT_EQ(1u, session.sessionWindows[0].sessions.count);
+  EXPECT_EQ(0u, session.sessionWindows[0].selectedIndex);
+}
+
+// Tests that closing and moving tabs does not write the tabs again.
+TEST_F(SessionServiceTest, SaveSessionClosesAndMovesTabs) {
+  NSMutableArray<CRWSessionStorage*>* tabs = [NSMutableArray array];
+  while (tabs.count < 10u) {
+    CRWSessionStorage* tab = [[CRWSessionStorage alloc] init];
+    tab.lastCommittedItemIndex = tabs.count;
+    [tabs addObject:tab];
+  }
+  SessionIOSFactory factory = ^{
+    SessionWindowIOS* window =
+        [[SessionWindowIOS alloc] initWithSessions:[tabs copy]
+                                     selectedIndex:0];
+    return [[SessionIOS alloc] initWithWindows:@[ window ]];
+  };
+  SaveSession(factory);
+  unsigned long long initial_size = SessionFileSize();
+  ASSERT_GT(initial_size, 0u);
+
+  // Close the first tab and move the last one to the front.
+  [tabs removeObjectAtIndex:0];
+  CRWSessionStorage* last_tab = tabs.lastObject;
+  [tabs removeLastObject];
+  [tabs insertObject:last_tab atIndex:0];
+  SaveSession(factory);
+  unsigned long long appended_size = SessionFileSize() - initial_size;
+  EXPECT_GT(appended_size, 0u);
+  EXPECT_LT(appended_size * 5, initial_size);
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  NSArray<CRWSessionStorage*>* loaded_tabs = session.sessionWindows[0].sessions;
+  ASSERT_EQ(9u, loaded_tabs.count);
+  EXPECT_EQ(9, loaded_tabs[0].lastCommittedItemIndex);
+  for (NSUInteger index = 1; index < loaded_tabs.count; ++index)
+    EXPECT_EQ(static_cast<NSInteger>(index),
+              loaded_tabs[index].lastCommittedItemIndex);
+}
+
+// Tests that a save that was not completely written is ignored when loading
+// the session.
+TEST_F(SessionServiceTest, LoadSessionIgnoresTruncatedSave) {
+  SaveSession(CreateSessionFactoryWithOpener(3u, 0u));
+  SaveSession(CreateSessionFactoryWithOpener(3u, 2u));
+
+  NSString* session_path =
+      [SessionServiceIOS sessionPathForDirectory:directory()];
+  NSData* data = [NSData dataWithContentsOfFile:session_path];
+  ASSERT_TRUE([[data subdataWithRange:NSMakeRange(0, data.length - 1)]
+      writeToFile:session_path
+       atomically:YES]);
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  NSArray<CRWSessionStorage*>* tabs = session.sessionWindows[0].sessions;
+  ASSERT_EQ(3u, tabs.count);
+  EXPECT_TRUE(tabs[0].hasOpener);
+  EXPECT_FALSE(tabs[2].hasOpener);
+}
+
+// Tests that the whole session is written if the session file was deleted
+// since the previous save.
+TEST_F(SessionServiceTest, SaveSessionAfterFileDeleted) {
+  SaveSession(CreateSessionFactoryWithOpener(3u, 0u));
+  NSString* session_path =
+      [SessionServiceIOS sessionPathForDirectory:directory()];
+  ASSERT_TRUE([[NSFileManager defaultManager] removeItemAtPath:session_path
+                                                         error:nil]);
+
+  SaveSession(CreateSessionFactoryWithOpener(3u, 1u));
+
+  SessionIOS* session =
+      [session_service() loadSessionFromDirectory:directory()];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  NSArray<CRWSessionStorage*>* tabs = session.sessionWindows[0].sessions;
+  ASSERT_EQ(3u, tabs.count);
+  EXPECT_TRUE(tabs[1].hasOpener);
+}
+
 TEST_F(SessionServiceTest, LoadCorruptedSession) {
   NSString* session_path =
       SessionPathForTestData(FILE_PATH_LITERAL("corrupted.plist"));
@@ -222,4 +402,64 @@ TEST_F(SessionServiceTest, LoadM58Session) {
   EXPECT_EQ(1u, session.sessionWindows.count);
 }
 
+// Tests that a legacy session is converted to the binary session format and
+// loaded back.
+TEST_F(SessionServiceTest, ConvertM58SessionToBinary) {
+  NSString* session_path =
+      SessionPathForTestData(FILE_PATH_LITERAL("session_m58.plist"));
+  ASSERT_NSNE(nil, session_path);
+  SessionIOS* legacy_session =
+      [session_service() loadSessionFromPath:session_path];
+  ASSERT_EQ(1u, legacy_session.sessionWindows.count);
+
+  ASSERT_TRUE([[NSFileManager defaultManager] createDirectoryAtPath:directory()
+                                        withIntermediateDirectories:YES
+                                                         attributes:nil
+                                                              error:nil]);
+  NSString* binary_path =
+      [directory() stringByAppendingPathComponent:@"session.bin"];
+  ASSERT_TRUE([session_service() convertSessionAtPath:session_path
+                                         toBinaryPath:binary_path]);
+  NSData* data = [NSData dataWithContentsOfFile:binary_path];
+  EXPECT_TRUE(
+      web::binary_session::HasBinarySessionHeader(data.bytes, data.length));
+
+  SessionIOS* session = [session_service() loadSessionFromPath:binary_path];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  SessionWindowIOS* window = session.sessionWindows[0];
+  SessionWindowIOS* legacy_window = legacy_session.sessionWindows[0];
+  EXPECT_EQ(legacy_window.selectedIndex, window.selectedIndex);
+  ASSERT_EQ(legacy_window.sessions.count, window.sessions.count);
+  for (NSUInteger index = 0; index < window.sessions.count; ++index) {
+    CRWSessionStorage* tab = window.sessions[index];
+    CRWSessionStorage* legacy_tab = legacy_window.sessions[index];
+    EXPECT_EQ(legacy_tab.lastCommittedItemIndex, tab.lastCommittedItemIndex);
+    EXPECT_EQ(legacy_tab.itemStorages.count, tab.itemStorages.count);
+  }
+}
+
+// Tests that a session saved by SessionServiceIOS is converted to the binary
+// session format, and that a corrupted binary session is not loaded.
+TEST_F(SessionServiceTest, LoadCorruptedBinarySession) {
+  SaveSession(CreateSessionFactoryWithOpener(3u, 1u));
+  NSString* session_path =
+      [SessionServiceIOS sessionPathForDirectory:directory()];
+  NSString* binary_path =
+      [directory() stringByAppendingPathComponent:@"session.bin"];
+  ASSERT_TRUE([session_service() convertSessionAtPath:session_path
+                                         toBinaryPath:binary_path]);
+
+  SessionIOS* session = [session_service() loadSessionFromPath:binary_path];
+  ASSERT_EQ(1u, session.sessionWindows.count);
+  NSArray<CRWSessionStorage*>* tabs = session.sessionWindows[0].sessions;
+  ASSERT_EQ(3u, tabs.count);
+  EXPECT_TRUE(tabs[1].hasOpener);
+
+  NSData* data = [NSData dataWithContentsOfFile:binary_path];
+  ASSERT_TRUE([[data subdataWithRange:NSMakeRange(0, data.length - 1)]
+      writeToFile:binary_path
+       atomically:YES]);
+  EXPECT_FALSE([session_service() loadSessionFromPath:binary_path]);
+}
+
 }  // anonymous namespace
@@ -8,8 +8,10 @@
 #error "This file requires ARC support."
 #endif
 
+#include "base/feature_list.h"
 #include "components/keyed_service/ios/browser_state_dependency_manager.h"
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
+#include "ios/chrome/browser/browser_state/features.h"
 #include "ios/chrome/browser/signin/identity_manager_factory.h"
 #include "ios/chrome/browser/signin/signin_browser_state_info_updater.h"
 #include "ios/chrome/browser/signin/signin_error_controller_factory.h"
@@ -53,5 +55,7 @@ SigninBrowserStateInfoUpdaterFactory::BuildServiceInstanceFor(
 
 bool SigninBrowserStateInfoUpdaterFactory::ServiceIsCreatedWithBrowserState()
     const {
-  return true;
+  // Otherwise created by CreateDeferredBrowserStateKeyedServices(). The
+  // browser state info is updated when the service is created.
+  return !base::FeatureList::IsEnabled(kLazyBrowserStateKeyedServices);
 }
@@ -7,33 +7,46 @@
 
 #import <Foundation/Foundation.h>
 
-// This class implements a cache with a limited size. Once the cache reach its
-// size limit, it will start to evict items in a Least Recently Used order
-// (where the term "used" is determined in terms of query to the cache).
+// This class implements a cache with a limited total cost. Each item is added
+// with a cost (for example its size in bytes), and once the sum of the costs
+// of the items exceeds the cost limit, the cache starts to evict items in a
+// Least Recently Used order (where the term "used" is determined in terms of
+// query to the cache).
 @interface LRUCache : NSObject
 
-// The maximum amount of items that the cache can hold before starting to
-// evict. The value 0 is used to signify that the cache can hold an unlimited
-// amount of elements (i.e. never evicts).
-@property(nonatomic, readonly) NSUInteger maxCacheSize;
+// The maximum total cost of the items that the cache can hold before starting
+// to evict. The value 0 is used to signify that the cache can hold an
+// unlimited amount of elements (i.e. never evicts).
+@property(nonatomic, readonly) NSUInteger costLimit;
 
-// Use the initWithCacheSize: designated initializer. The is no good general
-// default value for the cache size.
+// The sum of the costs of the items currently in the cache.
+@property(nonatomic, readonly) NSUInteger totalCost;
+
+// Use the initWithCostLimit: designated initializer. The is no good general
+// default value for the cost limit.
 - (instancetype)init NS_UNAVAILABLE;
 
-// |maxCacheSize| value is used to specify the maximum amount of items that the
-// cache can hold before starting to evict items.
-- (instancetype)initWithCacheSize:(NSUInteger)maxCacheSize
+// |costLimit| value is used to specify the maximum total cost of the items that
+// the cache can hold before starting to evict items.
+- (instancetype)initWithCostLimit:(NSUInteger)costLimit
     NS_DESIGNATED_INITIALIZER;
 
 // Query the cache for an item corresponding to the |key|. Returns nil if there
 // is no item corresponding to that key.
 - (id)objectForKey:(id<NSObject>)key;
 
-// Adds the pair |key|, |obj| to the cache. If the value of the maxCacheSize
-// property is non zero, the cache may evict an elements if the maximum cache
-// size is reached. If the |key| is already present in the cache, the value for
-// that key is replaced by |object|.
+// Adds the pair |key|, |obj| to the cache with the given |cost|. If the value
+// of the costLimit property is non zero, the cache may evict the least recently
+// used elements until the total cost is within the limit. The element that is
+// added is never evicted by this call, even if its cost alone exceeds the
+// limit. If the |key| is already present in the cache, the value for that key
+// is replaced by |object|.
+- (void)setObject:(id<NSObject>)object
+           forKey:(NSObject*)key
+             cost:(NSUInteger)cost;
+
+// Adds the pair |key|, |obj| to the cache with a cost of 1. A cache whose
+// elements are all added with this method holds at most costLimit elements.
 - (void)setObject:(id<NSObject>)object forKey:(NSObject*)key;
 
 // Remove the key, value pair corresponding to the given |key|.
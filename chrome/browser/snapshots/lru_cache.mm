@@ -34,8 +34,14 @@ struct MRUCacheNSObjectHashMap {
       std::unordered_map<KeyType, ValueType, HashType, NSObjectEqualTo>;
 };
 
+// An item of the cache and its cost.
+struct CostedObject {
+  id<NSObject> object;
+  NSUInteger cost;
+};
+
 using NSObjectMRUCache = base::MRUCacheBase<id<NSObject>,
-                                            id<NSObject>,
+                                            CostedObject,
                                             NSObjectHash,
                                             MRUCacheNSObjectHashMap>;
 
@@ -45,36 +51,59 @@ using NSObjectMRUCache = base::MRUCacheBase<id<NSObject>,
   std::unique_ptr<NSObjectMRUCache> _cache;
 }
 
-- (instancetype)initWithCacheSize:(NSUInteger)maxCacheSize {
+@synthesize costLimit = _costLimit;
+@synthesize totalCost = _totalCost;
+
+- (instancetype)initWithCostLimit:(NSUInteger)costLimit {
   if ((self = [super init])) {
-    _cache = std::make_unique<NSObjectMRUCache>(maxCacheSize);
+    // The eviction is done by this class according to the costs of the items,
+    // so the underlying cache never evicts by itself.
+    _cache =
+        std::make_unique<NSObjectMRUCache>(NSObjectMRUCache::NO_AUTO_EVICT);
+    _costLimit = costLimit;
   }
   return self;
 }
 
-- (NSUInteger)maxCacheSize {
-  return _cache->max_size();
-}
-
 - (id)objectForKey:(id<NSObject>)key {
   auto it = _cache->Get(key);
   if (it == _cache->end())
     return nil;
-  return it->second;
+  return it->second.object;
+}
+
+- (void)setObject:(id<NSObject>)value
+           forKey:(NSObject*)key
+             cost:(NSUInteger)cost {
+  auto it = _cache->Peek(key);
+  if (it != _cache->end())
+    _totalCost -= it->second.cost;
+  _cache->Put([key copy], CostedObject{value, cost});
+  _totalCost += cost;
+
+  // Evict the least recently used items, but never the one just added.
+  while (_costLimit && _totalCost > _costLimit && _cache->size() > 1) {
+    auto oldest = _cache->rbegin();
+    _totalCost -= oldest->second.cost;
+    _cache->Erase(oldest);
+  }
 }
 
 - (void)setObject:(id<NSObject>)value forKey:(NSObject*)key {
-  _cache->Put([key copy], value);
+  [self setObject:value forKey:key cost:1];
 }
 
 - (void)removeObjectForKey:(id<NSObject>)key {
   auto it = _cache->Peek(key);
-  if (it != _cache->end())
-    _cache->Erase(it);
+  if (it == _cache->end())
+    return;
+  _totalCost -= it->second.cost;
+  _cache->Erase(it);
 }
 
 - (void)removeAllObjects {
   _cache->Clear();
+  _totalCost = 0;
 }
 
 - (NSUInteger)count {
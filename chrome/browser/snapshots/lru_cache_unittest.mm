@@ -15,7 +15,7 @@ namespace {
 using LRUCacheTest = PlatformTest;
 
 TEST_F(LRUCacheTest, Basic) {
-  LRUCache* cache = [[LRUCache alloc] initWithCacheSize:3];
+  LRUCache* cache = [[LRUCache alloc] initWithCostLimit:3];
 
   NSString* value1 = @"Value 1";
   NSString* value2 = @"Value 2";
@@ -48,4 +48,38 @@ TEST_F(LRUCacheTest, Basic) {
   EXPECT_TRUE([cache isEmpty]);
 }
 
+// Tests that items are evicted according to their costs.
+TEST_F(LRUCacheTest, Cost) {
+  LRUCache* cache = [[LRUCache alloc] initWithCostLimit:100];
+
+  NSString* value1 = @"Value 1";
+  NSString* value2 = @"Value 2";
+  NSString* value3 = @"Value 3";
+
+  [cache setObject:value1 forKey:@"VALUE 1" cost:40];
+  [cache setObject:value2 forKey:@"VALUE 2" cost:40];
+  EXPECT_EQ(80U, [cache totalCost]);
+
+  // Use the first value so that the second one is the least recently used.
+  EXPECT_EQ(value1, [cache objectForKey:@"VALUE 1"]);
+  [cache setObject:value3 forKey:@"VALUE 3" cost:40];
+  EXPECT_EQ(2U, [cache count]);
+  EXPECT_EQ(80U, [cache totalCost]);
+  EXPECT_FALSE([cache objectForKey:@"VALUE 2"]);
+  EXPECT_EQ(value1, [cache objectForKey:@"VALUE 1"]);
+
+  // Replacing a value updates the total cost.
+  [cache setObject:value2 forKey:@"VALUE 3" cost:10];
+  EXPECT_EQ(50U, [cache totalCost]);
+
+  // An item whose cost exceeds the limit evicts all the others but is kept.
+  [cache setObject:value3 forKey:@"VALUE 4" cost:200];
+  EXPECT_EQ(1U, [cache count]);
+  EXPECT_EQ(200U, [cache totalCost]);
+  EXPECT_EQ(value3, [cache objectForKey:@"VALUE 4"]);
+
+  [cache removeObjectForKey:@"VALUE 4"];
+  EXPECT_EQ(0U, [cache totalCost]);
+}
+
 }  // namespace
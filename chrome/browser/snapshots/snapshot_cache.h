@@ -32,6 +32,14 @@
 - (void)retrieveImageForSessionID:(NSString*)sessionID
                          callback:(void (^)(UIImage*))callback;
 
+// Retrieve the thumbnail of the snapshot for the |sessionID|, a downscaled
+// copy of the snapshot suited to display many snapshots at once. The callback
+// is called synchronously if the thumbnail is in memory. Otherwise it is
+// called asynchronously, once the thumbnail has been read from disk or made
+// from the snapshot, or with nil if the snapshot is not present at all.
+- (void)retrieveThumbnailForSessionID:(NSString*)sessionID
+                             callback:(void (^)(UIImage*))callback;
+
 // Request the session's grey snapshot. If the image is already loaded in
 // memory, this will immediately call back on |callback|.
 - (void)retrieveGreyImageForSessionID:(NSString*)sessionID
@@ -39,6 +47,11 @@
 
 - (void)setImage:(UIImage*)img withSessionID:(NSString*)sessionID;
 
+// Cancels the requests for the images of |sessionID| that are being loaded,
+// e.g. because they are no longer going to be displayed. The callbacks of the
+// pending requests are called with nil.
+- (void)cancelPendingRequestsForSessionID:(NSString*)sessionID;
+
 // Removes the image from both the LRU and disk cache, unless it is marked for
 // deferred deletion. Images marked for deferred deletion can only be removed by
 // calling |-removeMarkedImages|.
@@ -96,7 +109,8 @@
 @interface SnapshotCache (TestingAdditions)
 - (BOOL)hasImageInMemory:(NSString*)sessionID;
 - (BOOL)hasGreyImageInMemory:(NSString*)sessionID;
-- (NSUInteger)lruCacheMaxSize;
+- (BOOL)hasThumbnailInMemory:(NSString*)sessionID;
+- (NSUInteger)lruCacheCostLimit;
 @end
 
 #endif  // IOS_CHROME_BROWSER_SNAPSHOTS_SNAPSHOT_CACHE_H_
@@ -5,8 +5,11 @@
 #import "ios/chrome/browser/snapshots/snapshot_cache.h"
 #import "ios/chrome/browser/snapshots/snapshot_cache_internal.h"
 
+#import <ImageIO/ImageIO.h>
 #import <UIKit/UIKit.h>
 
+#include <algorithm>
+
 #include "base/base_paths.h"
 #include "base/bind.h"
 #include "base/files/file_enumerator.h"
@@ -14,17 +17,18 @@
 #include "base/files/file_util.h"
 #import "base/ios/crb_protocol_observers.h"
 #include "base/logging.h"
-#include "base/mac/scoped_nsobject.h"
+#include "base/mac/scoped_cftyperef.h"
 #include "base/path_service.h"
 #include "base/sequence_checker.h"
 #include "base/sequenced_task_runner.h"
 #include "base/stl_util.h"
 #include "base/strings/sys_string_conversions.h"
+#include "base/system/sys_info.h"
 #include "base/task/post_task.h"
-#include "base/task_runner_util.h"
 #include "base/threading/scoped_blocking_call.h"
 #import "ios/chrome/browser/snapshots/lru_cache.h"
 #import "ios/chrome/browser/snapshots/snapshot_cache_observer.h"
+#import "ios/chrome/browser/snapshots/snapshot_decode_queue.h"
 #include "ios/chrome/browser/ui/util/ui_util.h"
 #import "ios/chrome/browser/ui/util/uikit_ui_util.h"
 
@@ -50,9 +54,10 @@
 // Marked set of identifiers for which images should not be immediately deleted.
 @property(nonatomic, strong) NSMutableSet* markedIDs;
 
-// Remove all UIImages from |lruCache_|.
+// Remove all UIImages from |lruCache_| and |thumbnailCache_|.
 - (void)handleEnterBackground;
-// Remove all but adjacent UIImages from |lruCache_|.
+// Remove all but adjacent UIImages from |lruCache_|, and all UIImages from
+// |thumbnailCache_|.
 - (void)handleLowMemory;
 // Restore adjacent UIImages to |lruCache_|.
 - (void)handleBecomeActive;
@@ -63,12 +68,34 @@
 // Save grey image to |greyImageDictionary_| and call into most recent
 // |mostRecentGreyBlock_| if |mostRecentGreySessionId_| matches |sessionID|.
 - (void)saveGreyImage:(UIImage*)greyImage forKey:(NSString*)sessionID;
+// Returns the color snapshot of |sessionID| if it is in memory, either in
+// |lruCache_| or waiting to be written to disk.
+- (UIImage*)colorImageInMemoryForSessionID:(NSString*)sessionID;
+// Loads the grey snapshot of |sessionID| from disk, or converts its color
+// snapshot to grey, on |decodeQueue_|.
+- (void)decodeGreyImageForSessionID:(NSString*)sessionID
+                           callback:(void (^)(UIImage*))callback;
+// Adds |image|, the color snapshot of |sessionID| read from disk, to
+// |lruCache_|, unless a more recent snapshot was set in the meantime. Returns
+// the snapshot that is in memory.
+- (UIImage*)cacheColorImage:(UIImage*)image forSessionID:(NSString*)sessionID;
+// Returns the number of times the snapshot of |sessionID| has been set.
+- (NSUInteger)snapshotVersionForSessionID:(NSString*)sessionID;
+// Adds |thumbnail| to |thumbnailCache_|, unless the snapshot of |sessionID|
+// has been set again since it was at |version|.
+- (void)cacheThumbnail:(UIImage*)thumbnail
+          forSessionID:(NSString*)sessionID
+               version:(NSUInteger)version;
+// Called when the color snapshot |image| of |sessionID| has been written to
+// disk.
+- (void)didWriteImage:(UIImage*)image forSessionID:(NSString*)sessionID;
 @end
 
 namespace {
 enum ImageType {
   IMAGE_TYPE_COLOR,
   IMAGE_TYPE_GREYSCALE,
+  IMAGE_TYPE_THUMBNAIL,
 };
 
 enum ImageScale {
@@ -78,15 +105,36 @@ enum ImageScale {
 };
 
 const ImageType kImageTypes[] = {
-    IMAGE_TYPE_COLOR, IMAGE_TYPE_GREYSCALE,
+    IMAGE_TYPE_COLOR, IMAGE_TYPE_GREYSCALE, IMAGE_TYPE_THUMBNAIL,
 };
 
 const NSUInteger kGreyInitialCapacity = 8;
-const CGFloat kJPEGImageQuality = 1.0;  // Highest quality. No compression.
 
-// Maximum size in number of elements that the LRU cache can hold before
-// starting to evict elements.
-const NSUInteger kLRUCacheMaxCapacity = 6;
+// Quality of the JPEG encoding of the snapshots. A light compression has no
+// visible artifacts on snapshots of web pages, and makes the files several
+// times smaller than with no compression.
+const CGFloat kJPEGImageQuality = 0.9;
+// Quality of the JPEG encoding of the thumbnails, which are only displayed at
+// a small size.
+const CGFloat kThumbnailJPEGImageQuality = 0.7;
+
+// Ratio between the size of the thumbnails and the size of the snapshots.
+const CGFloat kThumbnailSizeRatio = 0.5;
+
+// Maximum total size in bytes of the decoded snapshots that the LRU cache can
+// hold before starting to evict elements. Fits about six full screen
+// snapshots of a phone.
+const NSUInteger kLRUCacheCostLimit = 24 * 1024 * 1024;
+
+// The thumbnail cache can hold decoded thumbnails up to 1/256th of the
+// physical memory of the device, i.e. about 64 thumbnails of a phone with
+// 4GB of memory, within these bounds in bytes.
+const int64_t kThumbnailCacheMemoryDivisor = 256;
+const int64_t kThumbnailCacheMinCostLimit = 8 * 1024 * 1024;
+const int64_t kThumbnailCacheMaxCostLimit = 32 * 1024 * 1024;
+
+// Maximum number of snapshots decoded at the same time.
+const NSUInteger kMaxConcurrentDecodes = 2;
 
 // Returns the path of the directory containing the snapshots.
 bool GetSnapshotsCacheDirectory(base::FilePath* snapshots_cache_directory) {
@@ -114,6 +162,9 @@ base::FilePath ImagePath(NSString* session_id,
     case IMAGE_TYPE_GREYSCALE:
       filename = [filename stringByAppendingString:@"Grey"];
       break;
+    case IMAGE_TYPE_THUMBNAIL:
+      filename = [filename stringByAppendingString:@"Thumb"];
+      break;
   }
   switch (image_scale) {
     case IMAGE_SCALE_1X:
@@ -153,6 +204,38 @@ CGFloat ScaleFromImageScale(ImageScale image_scale) {
   }
 }
 
+// Returns the key of the requests of the decode queue for the image of
+// |session_id| of type |image_type|.
+NSString* DecodeKey(NSString* session_id, ImageType image_type) {
+  return [NSString stringWithFormat:@"%@-%d", session_id, image_type];
+}
+
+// Returns the number of bytes used by the decoded |image|.
+NSUInteger ImageCost(UIImage* image) {
+  CGImageRef cg_image = image.CGImage;
+  if (!cg_image) {
+    return image.size.width * image.scale * image.size.height * image.scale *
+           4;
+  }
+  return CGImageGetBytesPerRow(cg_image) * CGImageGetHeight(cg_image);
+}
+
+// Returns the cost limit of the thumbnail cache, for the amount of physical
+// memory of the device.
+NSUInteger ThumbnailCacheCostLimit() {
+  int64_t budget =
+      base::SysInfo::AmountOfPhysicalMemory() / kThumbnailCacheMemoryDivisor;
+  budget = std::max(budget, kThumbnailCacheMinCostLimit);
+  return static_cast<NSUInteger>(std::min(budget, kThumbnailCacheMaxCostLimit));
+}
+
+// Returns the thumbnail of the snapshot |image|.
+UIImage* ThumbnailFromImage(UIImage* image) {
+  CGSize size = CGSizeMake(image.size.width * kThumbnailSizeRatio,
+                           image.size.height * kThumbnailSizeRatio);
+  return ResizeImage(image, size, ProjectionMode::kFill, /*opaque=*/YES);
+}
+
 UIImage* ReadImageForSessionFromDisk(NSString* session_id,
                                      ImageType image_type,
                                      ImageScale image_scale,
@@ -165,13 +248,47 @@ UIImage* ReadImageForSessionFromDisk(NSString* session_id,
       ImagePath(session_id, image_type, image_scale, cache_directory);
   NSString* path = base::SysUTF8ToNSString(file_path.AsUTF8Unsafe());
   base::ScopedBlockingCall scoped_blocking_call(base::BlockingType::WILL_BLOCK);
-  return [UIImage imageWithData:[NSData dataWithContentsOfFile:path]
-                          scale:(image_type == IMAGE_TYPE_GREYSCALE
-                                     ? 1.0
-                                     : ScaleFromImageScale(image_scale))];
-}
+  NSData* data = [NSData dataWithContentsOfFile:path];
+  if (!data)
+    return nil;
 
-void WriteImageToDisk(UIImage* image, const base::FilePath& file_path) {
+  // Decode the image now, on the background thread, rather than the first
+  // time it is drawn on the main thread as -imageWithData would.
+  base::ScopedCFTypeRef<CGImageSourceRef> source(
+      CGImageSourceCreateWithData((__bridge CFDataRef)data, nullptr));
+  if (!source)
+    return nil;
+  NSDictionary* options =
+      @{(__bridge NSString*)kCGImageSourceShouldCacheImmediately : @YES};
+  base::ScopedCFTypeRef<CGImageRef> cg_image(CGImageSourceCreateImageAtIndex(
+      source, 0, (__bridge CFDictionaryRef)options));
+  if (!cg_image)
+    return nil;
+  return [UIImage imageWithCGImage:cg_image
+                             scale:(image_type == IMAGE_TYPE_GREYSCALE
+                                        ? 1.0
+                                        : ScaleFromImageScale(image_scale))
+                       orientation:UIImageOrientationUp];
+}
+
+// Returns the thumbnail of the snapshot of |session_id|, read from disk, or
+// made from the color snapshot on disk if the thumbnail was never written.
+UIImage* ReadThumbnailForSessionFromDisk(
+    NSString* session_id,
+    ImageScale image_scale,
+    const base::FilePath& cache_directory) {
+  UIImage* thumbnail = ReadImageForSessionFromDisk(
+      session_id, IMAGE_TYPE_THUMBNAIL, image_scale, cache_directory);
+  if (thumbnail)
+    return thumbnail;
+  UIImage* color_image = ReadImageForSessionFromDisk(
+      session_id, IMAGE_TYPE_COLOR, image_scale, cache_directory);
+  return color_image ? ThumbnailFromImage(color_image) : nil;
+}
+
+void WriteImageToDisk(UIImage* image,
+                      const base::FilePath& file_path,
+                      CGFloat jpeg_quality) {
   if (!image)
     return;
 
@@ -187,8 +304,8 @@ void WriteImageToDisk(UIImage* image, const base::FilePath& file_path) {
 
   NSString* path = base::SysUTF8ToNSString(file_path.AsUTF8Unsafe());
   base::ScopedBlockingCall scoped_blocking_call(base::BlockingType::WILL_BLOCK);
-  [UIImageJPEGRepresentation(image, kJPEGImageQuality) writeToFile:path
-                                                        atomically:YES];
+  [UIImageJPEGRepresentation(image, jpeg_quality) writeToFile:path
+                                                   atomically:YES];
 
   // Encrypt the snapshot file (mostly for Incognito, but can't hurt to
   // always do it).
@@ -217,8 +334,10 @@ void ConvertAndSaveGreyImage(NSString* session_id,
       return;
   }
   UIImage* grey_image = GreyImage(color_image);
-  WriteImageToDisk(grey_image, ImagePath(session_id, IMAGE_TYPE_GREYSCALE,
-                                         image_scale, cache_directory));
+  WriteImageToDisk(grey_image,
+                   ImagePath(session_id, IMAGE_TYPE_GREYSCALE, image_scale,
+                             cache_directory),
+                   kJPEGImageQuality);
 }
 
 }  // anonymous namespace
@@ -228,6 +347,20 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   // kept in memory on tablets.
   LRUCache* lruCache_;
 
+  // Cache to hold the thumbnails of the snapshots in memory. Holds more
+  // images than |lruCache_|, as thumbnails are smaller.
+  LRUCache* thumbnailCache_;
+
+  // Color snapshots that are being written to disk, by session ID, so that
+  // they are not read from disk before they are written even if they have
+  // been evicted from |lruCache_|.
+  NSMutableDictionary<NSString*, UIImage*>* pendingWrites_;
+
+  // Number of times the snapshot of each session has been set, used to tell
+  // whether a thumbnail was made from the current snapshot. Loading a
+  // snapshot from disk does not change it.
+  NSMutableDictionary<NSString*, NSNumber*>* snapshotVersions_;
+
   // Temporary dictionary to hold grey snapshots for tablet side swipe. This
   // will be nil before -createGreyCache is called and after -removeGreyCache
   // is called.
@@ -255,6 +388,10 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   // by not posting the task).
   scoped_refptr<base::SequencedTaskRunner> taskRunner_;
 
+  // Queue used to decode the snapshots and convert them to grey. Shut down
+  // with |taskRunner_|.
+  SnapshotDecodeQueue* decodeQueue_;
+
   // Check that public API is called from the correct sequence.
   SEQUENCE_CHECKER(sequenceChecker_);
 }
@@ -276,12 +413,18 @@ void ConvertAndSaveGreyImage(NSString* session_id,
                         snapshotsScale:(ImageScale)snapshotsScale {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
   if ((self = [super init])) {
-    lruCache_ = [[LRUCache alloc] initWithCacheSize:kLRUCacheMaxCapacity];
+    lruCache_ = [[LRUCache alloc] initWithCostLimit:kLRUCacheCostLimit];
+    thumbnailCache_ =
+        [[LRUCache alloc] initWithCostLimit:ThumbnailCacheCostLimit()];
+    pendingWrites_ = [[NSMutableDictionary alloc] init];
+    snapshotVersions_ = [[NSMutableDictionary alloc] init];
     cacheDirectory_ = cacheDirectory;
     snapshotsScale_ = snapshotsScale;
 
     taskRunner_ = base::CreateSequencedTaskRunnerWithTraits(
         {base::MayBlock(), base::TaskPriority::USER_VISIBLE});
+    decodeQueue_ = [[SnapshotDecodeQueue alloc]
+        initWithMaxConcurrentDecodes:kMaxConcurrentDecodes];
 
     _observers = [SnapshotCacheObservers observers];
     _markedIDs = [[NSMutableSet alloc] init];
@@ -332,7 +475,7 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   DCHECK(sessionID);
   DCHECK(callback);
 
-  if (UIImage* image = [lruCache_ objectForKey:sessionID]) {
+  if (UIImage* image = [self colorImageInMemoryForSessionID:sessionID]) {
     callback(image);
     return;
   }
@@ -346,19 +489,58 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   const base::FilePath cacheDirectory = cacheDirectory_;
   const ImageScale snapshotsScale = snapshotsScale_;
 
-  __weak LRUCache* weakLRUCache = lruCache_;
-  base::PostTaskAndReplyWithResult(
-      taskRunner_.get(), FROM_HERE,
-      base::BindOnce(^base::scoped_nsobject<UIImage>() {
-        // Retrieve the image on a high priority thread.
-        return base::scoped_nsobject<UIImage>(ReadImageForSessionFromDisk(
-            sessionID, IMAGE_TYPE_COLOR, snapshotsScale, cacheDirectory));
-      }),
-      base::BindOnce(^(base::scoped_nsobject<UIImage> image) {
-        if (image)
-          [weakLRUCache setObject:image forKey:sessionID];
+  __weak SnapshotCache* weakSelf = self;
+  [decodeQueue_ decodeImageForKey:DecodeKey(sessionID, IMAGE_TYPE_COLOR)
+      block:^UIImage*() {
+        return ReadImageForSessionFromDisk(sessionID, IMAGE_TYPE_COLOR,
+                                           snapshotsScale, cacheDirectory);
+      }
+      callback:^(UIImage* image) {
+        SnapshotCache* strongSelf = weakSelf;
+        if (image && strongSelf)
+          image = [strongSelf cacheColorImage:image forSessionID:sessionID];
         callback(image);
-      }));
+      }];
+}
+
+- (void)retrieveThumbnailForSessionID:(NSString*)sessionID
+                             callback:(void (^)(UIImage*))callback {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  DCHECK(sessionID);
+  DCHECK(callback);
+
+  if (UIImage* thumbnail = [thumbnailCache_ objectForKey:sessionID]) {
+    callback(thumbnail);
+    return;
+  }
+
+  if (!taskRunner_) {
+    callback(nil);
+    return;
+  }
+
+  // Copy ivars used by the block so that it does not reference |self|.
+  UIImage* colorImage = [self colorImageInMemoryForSessionID:sessionID];
+  const NSUInteger version = [self snapshotVersionForSessionID:sessionID];
+  const base::FilePath cacheDirectory = cacheDirectory_;
+  const ImageScale snapshotsScale = snapshotsScale_;
+
+  __weak SnapshotCache* weakSelf = self;
+  [decodeQueue_ decodeImageForKey:DecodeKey(sessionID, IMAGE_TYPE_THUMBNAIL)
+      block:^UIImage*() {
+        // Prefer downscaling the color snapshot if it is in memory, as it may
+        // not have been written to disk yet.
+        if (colorImage)
+          return ThumbnailFromImage(colorImage);
+        return ReadThumbnailForSessionFromDisk(sessionID, snapshotsScale,
+                                               cacheDirectory);
+      }
+      callback:^(UIImage* thumbnail) {
+        [weakSelf cacheThumbnail:thumbnail
+                    forSessionID:sessionID
+                         version:version];
+        callback(thumbnail);
+      }];
 }
 
 - (void)setImage:(UIImage*)image withSessionID:(NSString*)sessionID {
@@ -366,7 +548,13 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   if (!image || !sessionID || !taskRunner_)
     return;
 
-  [lruCache_ setObject:image forKey:sessionID];
+  [lruCache_ setObject:image forKey:sessionID cost:ImageCost(image)];
+  pendingWrites_[sessionID] = image;
+  snapshotVersions_[sessionID] =
+      @([self snapshotVersionForSessionID:sessionID] + 1);
+
+  // The thumbnail is made again from the new image when it is requested.
+  [thumbnailCache_ removeObjectForKey:sessionID];
 
   [self.observers snapshotCache:self didUpdateSnapshotForIdentifier:sessionID];
 
@@ -374,14 +562,35 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   const base::FilePath cacheDirectory = cacheDirectory_;
   const ImageScale snapshotsScale = snapshotsScale_;
 
-  // Save the image to disk.
-  taskRunner_->PostTask(
+  // Save the image and its thumbnail to disk, and delete the grey snapshot of
+  // the previous image. It is generated again from the new image when needed.
+  __weak SnapshotCache* weakSelf = self;
+  taskRunner_->PostTaskAndReply(
       FROM_HERE, base::BindOnce(^{
-        WriteImageToDisk(image, ImagePath(sessionID, IMAGE_TYPE_COLOR,
-                                          snapshotsScale, cacheDirectory));
+        WriteImageToDisk(image,
+                         ImagePath(sessionID, IMAGE_TYPE_COLOR, snapshotsScale,
+                                   cacheDirectory),
+                         kJPEGImageQuality);
+        WriteImageToDisk(ThumbnailFromImage(image),
+                         ImagePath(sessionID, IMAGE_TYPE_THUMBNAIL,
+                                   snapshotsScale, cacheDirectory),
+                         kThumbnailJPEGImageQuality);
+        base::DeleteFile(ImagePath(sessionID, IMAGE_TYPE_GREYSCALE,
+                                   snapshotsScale, cacheDirectory),
+                         false /* recursive */);
+      }),
+      base::BindOnce(^{
+        [weakSelf didWriteImage:image forSessionID:sessionID];
       }));
 }
 
+- (void)didWriteImage:(UIImage*)image forSessionID:(NSString*)sessionID {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  // A more recent image may have been set while this one was written.
+  if (pendingWrites_[sessionID] == image)
+    [pendingWrites_ removeObjectForKey:sessionID];
+}
+
 - (void)removeImageWithSessionID:(NSString*)sessionID {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
   // Do not immediately delete if the ID is marked.
@@ -389,6 +598,10 @@ void ConvertAndSaveGreyImage(NSString* session_id,
     return;
 
   [lruCache_ removeObjectForKey:sessionID];
+  [thumbnailCache_ removeObjectForKey:sessionID];
+  [pendingWrites_ removeObjectForKey:sessionID];
+  [snapshotVersions_ removeObjectForKey:sessionID];
+  [self cancelPendingRequestsForSessionID:sessionID];
 
   [self.observers snapshotCache:self didUpdateSnapshotForIdentifier:sessionID];
 
@@ -409,6 +622,12 @@ void ConvertAndSaveGreyImage(NSString* session_id,
       }));
 }
 
+- (void)cancelPendingRequestsForSessionID:(NSString*)sessionID {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  for (size_t index = 0; index < base::size(kImageTypes); ++index)
+    [decodeQueue_ cancelRequestForKey:DecodeKey(sessionID, kImageTypes[index])];
+}
+
 - (void)markImageWithSessionID:(NSString*)sessionID {
   [self.markedIDs addObject:sessionID];
 }
@@ -435,6 +654,11 @@ void ConvertAndSaveGreyImage(NSString* session_id,
                    cacheDirectory_);
 }
 
+- (base::FilePath)thumbnailPathForSessionID:(NSString*)sessionID {
+  return ImagePath(sessionID, IMAGE_TYPE_THUMBNAIL, snapshotsScale_,
+                   cacheDirectory_);
+}
+
 - (void)purgeCacheOlderThan:(const base::Time&)date
                     keeping:(NSSet*)liveSessionIds {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
@@ -482,7 +706,7 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   if (!sessionID)
     return;
   backgroundingImageSessionId_ = [sessionID copy];
-  backgroundingColorImage_ = [lruCache_ objectForKey:sessionID];
+  backgroundingColorImage_ = [self colorImageInMemoryForSessionID:sessionID];
 }
 
 - (void)handleLowMemory {
@@ -495,13 +719,18 @@ void ConvertAndSaveGreyImage(NSString* session_id,
       [dictionary setObject:image forKey:sessionID];
   }
   [lruCache_ removeAllObjects];
-  for (NSString* sessionID in self.pinnedIDs)
-    [lruCache_ setObject:[dictionary objectForKey:sessionID] forKey:sessionID];
+  [thumbnailCache_ removeAllObjects];
+  for (NSString* sessionID in self.pinnedIDs) {
+    UIImage* image = [dictionary objectForKey:sessionID];
+    if (image)
+      [lruCache_ setObject:image forKey:sessionID cost:ImageCost(image)];
+  }
 }
 
 - (void)handleEnterBackground {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
   [lruCache_ removeAllObjects];
+  [thumbnailCache_ removeAllObjects];
 }
 
 - (void)handleBecomeActive {
@@ -524,35 +753,46 @@ void ConvertAndSaveGreyImage(NSString* session_id,
 
 - (void)loadGreyImageAsync:(NSString*)sessionID {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
-  // Don't call -retrieveImageForSessionID here because it caches the colored
-  // image, which we don't need for the grey image cache. But if the image is
-  // already in the cache, use it.
-  UIImage* image = [lruCache_ objectForKey:sessionID];
-
   if (!taskRunner_)
     return;
 
+  __weak SnapshotCache* weakSelf = self;
+  [self decodeGreyImageForSessionID:sessionID
+                           callback:^(UIImage* greyImage) {
+                             [weakSelf saveGreyImage:greyImage
+                                              forKey:sessionID];
+                           }];
+}
+
+- (void)decodeGreyImageForSessionID:(NSString*)sessionID
+                           callback:(void (^)(UIImage*))callback {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  DCHECK(taskRunner_);
+  // Don't call -retrieveImageForSessionID here because it caches the colored
+  // image, which we don't need for the grey image. But if the image is
+  // already in memory, use it.
+  UIImage* colorImage = [self colorImageInMemoryForSessionID:sessionID];
+
   // Copy ivars used by the block so that it does not reference |self|.
   const base::FilePath cacheDirectory = cacheDirectory_;
   const ImageScale snapshotsScale = snapshotsScale_;
 
-  __weak SnapshotCache* weakSelf = self;
-  base::PostTaskAndReplyWithResult(
-      taskRunner_.get(), FROM_HERE,
-      base::BindOnce(^base::scoped_nsobject<UIImage>() {
-        // If the image is not in the cache, load it from disk.
-        UIImage* localImage = image;
+  [decodeQueue_ decodeImageForKey:DecodeKey(sessionID, IMAGE_TYPE_GREYSCALE)
+      block:^UIImage*() {
+        UIImage* localImage = colorImage;
         if (!localImage) {
+          // The grey snapshot on disk, if any, is made from the color snapshot
+          // on disk.
+          UIImage* greyImage = ReadImageForSessionFromDisk(
+              sessionID, IMAGE_TYPE_GREYSCALE, snapshotsScale, cacheDirectory);
+          if (greyImage)
+            return greyImage;
           localImage = ReadImageForSessionFromDisk(
               sessionID, IMAGE_TYPE_COLOR, snapshotsScale, cacheDirectory);
         }
-        if (localImage)
-          localImage = GreyImage(localImage);
-        return base::scoped_nsobject<UIImage>(localImage);
-      }),
-      base::BindOnce(^(base::scoped_nsobject<UIImage> greyImage) {
-        [weakSelf saveGreyImage:greyImage forKey:sessionID];
-      }));
+        return localImage ? GreyImage(localImage) : nil;
+      }
+      callback:callback];
 }
 
 - (void)createGreyCache:(NSArray*)sessionIDs {
@@ -609,30 +849,7 @@ void ConvertAndSaveGreyImage(NSString* session_id,
     return;
   }
 
-  // Copy ivars used by the block so that it does not reference |self|.
-  const base::FilePath cacheDirectory = cacheDirectory_;
-  const ImageScale snapshotsScale = snapshotsScale_;
-
-  __weak SnapshotCache* weakSelf = self;
-  base::PostTaskAndReplyWithResult(
-      taskRunner_.get(), FROM_HERE,
-      base::BindOnce(^base::scoped_nsobject<UIImage>() {
-        // Retrieve the image on a high priority thread.
-        return base::scoped_nsobject<UIImage>(ReadImageForSessionFromDisk(
-            sessionID, IMAGE_TYPE_GREYSCALE, snapshotsScale, cacheDirectory));
-      }),
-      base::BindOnce(^(base::scoped_nsobject<UIImage> image) {
-        if (image) {
-          callback(image);
-          return;
-        }
-        [weakSelf retrieveImageForSessionID:sessionID
-                                   callback:^(UIImage* localImage) {
-                                     if (localImage)
-                                       localImage = GreyImage(localImage);
-                                     callback(localImage);
-                                   }];
-      }));
+  [self decodeGreyImageForSessionID:sessionID callback:callback];
 }
 
 - (void)saveGreyInBackgroundForSessionID:(NSString*)sessionID {
@@ -671,8 +888,43 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   [self.observers removeObserver:observer];
 }
 
+- (UIImage*)colorImageInMemoryForSessionID:(NSString*)sessionID {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  return [lruCache_ objectForKey:sessionID] ?: pendingWrites_[sessionID];
+}
+
+- (UIImage*)cacheColorImage:(UIImage*)image forSessionID:(NSString*)sessionID {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  if (UIImage* imageInMemory = [self colorImageInMemoryForSessionID:sessionID])
+    return imageInMemory;
+  [lruCache_ setObject:image forKey:sessionID cost:ImageCost(image)];
+  return image;
+}
+
+- (NSUInteger)snapshotVersionForSessionID:(NSString*)sessionID {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  return [snapshotVersions_[sessionID] unsignedIntegerValue];
+}
+
+- (void)cacheThumbnail:(UIImage*)thumbnail
+          forSessionID:(NSString*)sessionID
+               version:(NSUInteger)version {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequenceChecker_);
+  if (!thumbnail)
+    return;
+  // Do not cache the thumbnail of a snapshot that has been replaced since the
+  // thumbnail was requested. The snapshot being loaded from disk in the
+  // meantime does not replace it.
+  if ([self snapshotVersionForSessionID:sessionID] != version)
+    return;
+  [thumbnailCache_ setObject:thumbnail
+                      forKey:sessionID
+                        cost:ImageCost(thumbnail)];
+}
+
 - (void)shutdown {
   taskRunner_ = nullptr;
+  [decodeQueue_ shutdown];
 }
 
 @end
@@ -687,8 +939,12 @@ void ConvertAndSaveGreyImage(NSString* session_id,
   return [greyImageDictionary_ objectForKey:sessionID] != nil;
 }
 
-- (NSUInteger)lruCacheMaxSize {
-  return [lruCache_ maxCacheSize];
+- (BOOL)hasThumbnailInMemory:(NSString*)sessionID {
+  return [thumbnailCache_ objectForKey:sessionID] != nil;
+}
+
+- (NSUInteger)lruCacheCostLimit {
+  return [lruCache_ costLimit];
 }
 
 @end
@@ -18,6 +18,8 @@ class FilePath;
 - (base::FilePath)imagePathForSessionID:(NSString*)sessionID;
 // Returns filepath to the greyscale snapshot of |sessionID|.
 - (base::FilePath)greyImagePathForSessionID:(NSString*)sessionID;
+// Returns filepath to the thumbnail of the snapshot of |sessionID|.
+- (base::FilePath)thumbnailPathForSessionID:(NSString*)sessionID;
 @end
 
 #endif  // IOS_CHROME_BROWSER_SNAPSHOTS_SNAPSHOT_CACHE_INTERNAL_H_
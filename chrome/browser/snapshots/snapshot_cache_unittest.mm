@@ -11,9 +11,7 @@
 #include "base/format_macros.h"
 #include "base/location.h"
 #include "base/mac/scoped_cftyperef.h"
-#include "base/run_loop.h"
 #include "base/strings/sys_string_conversions.h"
-#include "base/task/task_scheduler/task_scheduler.h"
 #include "base/time/time.h"
 #import "ios/chrome/browser/snapshots/snapshot_cache_internal.h"
 #import "ios/chrome/browser/snapshots/snapshot_cache_observer.h"
@@ -105,8 +103,10 @@ class SnapshotCacheTest : public PlatformTest {
 
   // Flushes all the runloops internally used by the snapshot cache.
   void FlushRunLoops() {
-    base::TaskScheduler::GetInstance()->FlushForTesting();
-    base::RunLoop().RunUntilIdle();
+    // The decode queue starts new tasks when the running ones reply, which
+    // requires to run the main thread and the task scheduler until both are
+    // idle.
+    thread_bundle_.RunUntilIdle();
   }
 
   // This function removes the snapshots both from dictionary and from disk.
@@ -237,7 +237,11 @@ class SnapshotCacheTest : public PlatformTest {
 TEST_F(SnapshotCacheTest, Cache) {
   SnapshotCache* cache = GetSnapshotCache();
 
-  NSUInteger expectedCacheSize = MIN(kSessionCount, [cache lruCacheMaxSize]);
+  CGImageRef cgImage = [[testImages_ objectAtIndex:0] CGImage];
+  NSUInteger imageCost =
+      CGImageGetBytesPerRow(cgImage) * CGImageGetHeight(cgImage);
+  NSUInteger expectedCacheSize =
+      MIN(kSessionCount, [cache lruCacheCostLimit] / imageCost);
 
   // Put all images in the cache.
   for (NSUInteger i = 0; i < expectedCacheSize; ++i) {
@@ -627,6 +631,118 @@ TEST_F(SnapshotCacheTest, UnmarkedImageNotDeleted) {
   EXPECT_TRUE(base::PathExists(image_path));
 }
 
+// Tests that thumbnails are written to disk with the snapshots, and read back
+// into memory when they are requested.
+TEST_F(SnapshotCacheTest, RetrieveThumbnail) {
+  LoadAllColorImagesIntoCache(true);
+  SnapshotCache* cache = GetSnapshotCache();
+  NSString* sessionID = [testSessions_ objectAtIndex:0];
+  EXPECT_TRUE(base::PathExists([cache thumbnailPathForSessionID:sessionID]));
+
+  // Ensure the thumbnail is read from disk.
+  TriggerMemoryWarning();
+  EXPECT_FALSE([cache hasThumbnailInMemory:sessionID]);
+
+  __block UIImage* thumbnail = nil;
+  [cache retrieveThumbnailForSessionID:sessionID
+                              callback:^(UIImage* image) {
+                                thumbnail = image;
+                              }];
+  EXPECT_FALSE(thumbnail);
+  FlushRunLoops();
+  ASSERT_TRUE(thumbnail);
+  UIImage* image = [testImages_ objectAtIndex:0];
+  EXPECT_LT(thumbnail.size.width, image.size.width);
+  EXPECT_LT(thumbnail.size.height, image.size.height);
+  EXPECT_TRUE([cache hasThumbnailInMemory:sessionID]);
+
+  // The thumbnail is now retrieved synchronously.
+  __block UIImage* thumbnailInMemory = nil;
+  [cache retrieveThumbnailForSessionID:sessionID
+                              callback:^(UIImage* image) {
+                                thumbnailInMemory = image;
+                              }];
+  EXPECT_EQ(thumbnail, thumbnailInMemory);
+
+  // Setting a new snapshot discards the thumbnail of the previous one.
+  [cache setImage:[testImages_ objectAtIndex:1] withSessionID:sessionID];
+  EXPECT_FALSE([cache hasThumbnailInMemory:sessionID]);
+  FlushRunLoops();
+}
+
+// Tests that a thumbnail read from disk is kept when the color snapshot is
+// loaded in the meantime, and dropped when the snapshot is set again.
+TEST_F(SnapshotCacheTest, ThumbnailOfReplacedSnapshotNotCached) {
+  LoadAllColorImagesIntoCache(true);
+  SnapshotCache* cache = GetSnapshotCache();
+  NSString* sessionID = [testSessions_ objectAtIndex:0];
+  TriggerMemoryWarning();
+
+  __block UIImage* thumbnail = nil;
+  __block UIImage* colorImage = nil;
+  [cache retrieveThumbnailForSessionID:sessionID
+                              callback:^(UIImage* image) {
+                                thumbnail = image;
+                              }];
+  [cache retrieveImageForSessionID:sessionID
+                          callback:^(UIImage* image) {
+                            colorImage = image;
+                          }];
+  FlushRunLoops();
+  ASSERT_TRUE(colorImage);
+  ASSERT_TRUE(thumbnail);
+  EXPECT_TRUE([cache hasThumbnailInMemory:sessionID]);
+
+  TriggerMemoryWarning();
+  thumbnail = nil;
+  [cache retrieveThumbnailForSessionID:sessionID
+                              callback:^(UIImage* image) {
+                                thumbnail = image;
+                              }];
+  [cache setImage:[testImages_ objectAtIndex:1] withSessionID:sessionID];
+  FlushRunLoops();
+  EXPECT_TRUE(thumbnail);
+  EXPECT_FALSE([cache hasThumbnailInMemory:sessionID]);
+}
+
+// Tests that concurrent requests for the same image are coalesced, and that
+// removing the image cancels them.
+TEST_F(SnapshotCacheTest, CoalesceAndCancelRequests) {
+  LoadAllColorImagesIntoCache(true);
+  SnapshotCache* cache = GetSnapshotCache();
+  NSString* sessionID = [testSessions_ objectAtIndex:0];
+  TriggerMemoryWarning();
+
+  __block UIImage* firstImage = nil;
+  __block UIImage* secondImage = nil;
+  [cache retrieveImageForSessionID:sessionID
+                          callback:^(UIImage* image) {
+                            firstImage = image;
+                          }];
+  [cache retrieveImageForSessionID:sessionID
+                          callback:^(UIImage* image) {
+                            secondImage = image;
+                          }];
+  FlushRunLoops();
+  ASSERT_TRUE(firstImage);
+  EXPECT_EQ(firstImage, secondImage);
+
+  TriggerMemoryWarning();
+  __block BOOL callbackCalled = NO;
+  __block UIImage* cancelledImage = nil;
+  [cache retrieveThumbnailForSessionID:sessionID
+                              callback:^(UIImage* image) {
+                                callbackCalled = YES;
+                                cancelledImage = image;
+                              }];
+  [cache removeImageWithSessionID:sessionID];
+  EXPECT_TRUE(callbackCalled);
+  EXPECT_FALSE(cancelledImage);
+  FlushRunLoops();
+  EXPECT_FALSE([cache hasThumbnailInMemory:sessionID]);
+  EXPECT_FALSE(base::PathExists([cache thumbnailPathForSessionID:sessionID]));
+}
+
 // Tests that observers are notified when a snapshot is cached and removed.
 TEST_F(SnapshotCacheTest, ObserversNotifiedOnSetAndRemoveImage) {
   SnapshotCache* cache = GetSnapshotCache();
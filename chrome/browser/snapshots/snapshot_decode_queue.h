@@ -0,0 +1,49 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_SNAPSHOTS_SNAPSHOT_DECODE_QUEUE_H_
+#define IOS_CHROME_BROWSER_SNAPSHOTS_SNAPSHOT_DECODE_QUEUE_H_
+
+#import <UIKit/UIKit.h>
+
+// Runs the blocks decoding snapshots on background threads, at most
+// |maxConcurrentDecodes| at a time. Each request is identified by a key: a
+// request made while another request with the same key is pending is coalesced
+// with it. The requests that are waiting to start are started in the reverse
+// order in which they were made, as the most recent requests are usually for
+// the images the user is looking at.
+// Must be used on a single sequence, on which the callbacks are called.
+@interface SnapshotDecodeQueue : NSObject
+
+// The maximum number of decode blocks running at the same time.
+@property(nonatomic, readonly) NSUInteger maxConcurrentDecodes;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (instancetype)initWithMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes
+    NS_DESIGNATED_INITIALIZER;
+
+// Runs |decode| on a background thread and calls |callback| with the image it
+// returns. If a request for |key| is pending, |decode| is dropped and
+// |callback| is called with the image returned by the pending request.
+// |callback| is always called asynchronously. Must not be called after
+// -shutdown.
+- (void)decodeImageForKey:(NSString*)key
+                    block:(UIImage* (^)(void))decode
+                 callback:(void (^)(UIImage*))callback;
+
+// Returns whether a request for |key| is pending.
+- (BOOL)hasPendingRequestForKey:(NSString*)key;
+
+// Cancels the pending request for |key|. Its callbacks are called with nil
+// right away, and the image returned by its decode block, if it is already
+// running, is dropped.
+- (void)cancelRequestForKey:(NSString*)key;
+
+// Cancels all the pending requests, and does not run any request afterwards.
+- (void)shutdown;
+
+@end
+
+#endif  // IOS_CHROME_BROWSER_SNAPSHOTS_SNAPSHOT_DECODE_QUEUE_H_
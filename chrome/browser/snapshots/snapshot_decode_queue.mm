@@ -0,0 +1,181 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/snapshots/snapshot_decode_queue.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/mac/scoped_nsobject.h"
+#include "base/sequence_checker.h"
+#include "base/task/post_task.h"
+#include "base/task_runner.h"
+#include "base/task_runner_util.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+// A pending request of a SnapshotDecodeQueue.
+@interface SnapshotDecodeRequest : NSObject
+// The key identifying the request.
+@property(nonatomic, readonly, copy) NSString* key;
+// The block decoding the image. Reset when the request starts.
+@property(nonatomic, copy) UIImage* (^decode)(void);
+// The callbacks of the request and of the requests coalesced with it.
+@property(nonatomic, readonly) NSMutableArray<void (^)(UIImage*)>* callbacks;
+
+- (instancetype)initWithKey:(NSString*)key decode:(UIImage* (^)(void))decode;
+@end
+
+@implementation SnapshotDecodeRequest
+
+@synthesize key = _key;
+@synthesize decode = _decode;
+@synthesize callbacks = _callbacks;
+
+- (instancetype)initWithKey:(NSString*)key decode:(UIImage* (^)(void))decode {
+  if ((self = [super init])) {
+    _key = [key copy];
+    _decode = [decode copy];
+    _callbacks = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+@end
+
+@interface SnapshotDecodeQueue ()
+// Starts the waiting requests, as long as fewer than |maxConcurrentDecodes|
+// requests are running.
+- (void)startWaitingRequests;
+// Called when the decode block of |request| has returned |image|.
+- (void)request:(SnapshotDecodeRequest*)request
+    didFinishWithImage:(UIImage*)image;
+@end
+
+@implementation SnapshotDecodeQueue {
+  // The pending requests, waiting or running, by key.
+  NSMutableDictionary<NSString*, SnapshotDecodeRequest*>* _requests;
+  // The keys of the requests that are waiting to start, in the order they
+  // were made.
+  NSMutableArray<NSString*>* _waitingKeys;
+  // The number of requests whose decode block is running.
+  NSUInteger _runningDecodes;
+  // Task runner used to run the decode blocks. Null after -shutdown.
+  scoped_refptr<base::TaskRunner> _taskRunner;
+  SEQUENCE_CHECKER(_sequenceChecker);
+}
+
+@synthesize maxConcurrentDecodes = _maxConcurrentDecodes;
+
+- (instancetype)initWithMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes {
+  DCHECK_GT(maxConcurrentDecodes, 0U);
+  if ((self = [super init])) {
+    _maxConcurrentDecodes = maxConcurrentDecodes;
+    _requests = [[NSMutableDictionary alloc] init];
+    _waitingKeys = [[NSMutableArray alloc] init];
+    _taskRunner = base::CreateTaskRunnerWithTraits(
+        {base::MayBlock(), base::TaskPriority::USER_VISIBLE});
+  }
+  return self;
+}
+
+- (void)decodeImageForKey:(NSString*)key
+                    block:(UIImage* (^)(void))decode
+                 callback:(void (^)(UIImage*))callback {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(_sequenceChecker);
+  DCHECK(_taskRunner);
+  DCHECK(key);
+  DCHECK(decode);
+  DCHECK(callback);
+
+  SnapshotDecodeRequest* request = _requests[key];
+  if (request) {
+    // Move a waiting request to the end of the queue, as it has just been
+    // requested again.
+    if (request.decode) {
+      [_waitingKeys removeObject:key];
+      [_waitingKeys addObject:key];
+    }
+  } else {
+    request = [[SnapshotDecodeRequest alloc] initWithKey:key decode:decode];
+    _requests[key] = request;
+    [_waitingKeys addObject:key];
+  }
+  [request.callbacks addObject:[callback copy]];
+  [self startWaitingRequests];
+}
+
+- (BOOL)hasPendingRequestForKey:(NSString*)key {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(_sequenceChecker);
+  return _requests[key] != nil;
+}
+
+- (void)cancelRequestForKey:(NSString*)key {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(_sequenceChecker);
+  SnapshotDecodeRequest* request = _requests[key];
+  if (!request)
+    return;
+
+  [_requests removeObjectForKey:key];
+  [_waitingKeys removeObject:key];
+  // The request may be running, in which case its result is dropped when it
+  // completes because it has no callbacks anymore.
+  NSArray<void (^)(UIImage*)>* callbacks = [request.callbacks copy];
+  [request.callbacks removeAllObjects];
+  for (void (^callback)(UIImage*) in callbacks)
+    callback(nil);
+}
+
+- (void)shutdown {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(_sequenceChecker);
+  _taskRunner = nullptr;
+  for (NSString* key in [_requests allKeys])
+    [self cancelRequestForKey:key];
+}
+
+#pragma mark - Private
+
+- (void)startWaitingRequests {
+  while (_taskRunner && _runningDecodes < _maxConcurrentDecodes &&
+         _waitingKeys.count) {
+    NSString* key = [_waitingKeys lastObject];
+    [_waitingKeys removeLastObject];
+    SnapshotDecodeRequest* request = _requests[key];
+    UIImage* (^decode)(void) = request.decode;
+    request.decode = nil;
+    ++_runningDecodes;
+
+    __weak SnapshotDecodeQueue* weakSelf = self;
+    base::PostTaskAndReplyWithResult(
+        _taskRunner.get(), FROM_HERE,
+        base::BindOnce(^base::scoped_nsobject<UIImage>() {
+          return base::scoped_nsobject<UIImage>(decode());
+        }),
+        base::BindOnce(^(base::scoped_nsobject<UIImage> image) {
+          [weakSelf request:request didFinishWithImage:image];
+        }));
+  }
+}
+
+- (void)request:(SnapshotDecodeRequest*)request
+    didFinishWithImage:(UIImage*)image {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(_sequenceChecker);
+  DCHECK_GT(_runningDecodes, 0U);
+  --_runningDecodes;
+
+  // A new request may have been made for the key after this one was
+  // cancelled.
+  if (_requests[request.key] == request)
+    [_requests removeObjectForKey:request.key];
+
+  NSArray<void (^)(UIImage*)>* callbacks = [request.callbacks copy];
+  [request.callbacks removeAllObjects];
+  for (void (^callback)(UIImage*) in callbacks)
+    callback(image);
+
+  [self startWaitingRequests];
+}
+
+@end
@@ -0,0 +1,111 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/snapshots/snapshot_decode_queue.h"
+
+#include "base/atomicops.h"
+#include "ios/web/public/test/test_web_thread_bundle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace {
+
+class SnapshotDecodeQueueTest : public PlatformTest {
+ protected:
+  SnapshotDecodeQueueTest()
+      : queue_([[SnapshotDecodeQueue alloc] initWithMaxConcurrentDecodes:2]),
+        image_([[UIImage alloc] init]) {}
+
+  ~SnapshotDecodeQueueTest() override { [queue_ shutdown]; }
+
+  // Runs the decode blocks and their callbacks.
+  void FlushRunLoops() { thread_bundle_.RunUntilIdle(); }
+
+  web::TestWebThreadBundle thread_bundle_;
+  SnapshotDecodeQueue* queue_;
+  UIImage* image_;
+};
+
+// Tests that the requests made for the same key while a request is pending
+// are coalesced with it.
+TEST_F(SnapshotDecodeQueueTest, CoalesceRequests) {
+  __block base::subtle::Atomic32 decode_count = 0;
+  __block int callback_count = 0;
+  UIImage* image = image_;
+  for (int i = 0; i < 3; ++i) {
+    [queue_ decodeImageForKey:@"key"
+        block:^UIImage*() {
+          base::subtle::NoBarrier_AtomicIncrement(&decode_count, 1);
+          return image;
+        }
+        callback:^(UIImage* decoded_image) {
+          EXPECT_EQ(image, decoded_image);
+          ++callback_count;
+        }];
+  }
+  EXPECT_TRUE([queue_ hasPendingRequestForKey:@"key"]);
+  EXPECT_EQ(0, callback_count);
+
+  FlushRunLoops();
+  EXPECT_EQ(1, base::subtle::NoBarrier_Load(&decode_count));
+  EXPECT_EQ(3, callback_count);
+  EXPECT_FALSE([queue_ hasPendingRequestForKey:@"key"]);
+}
+
+// Tests that cancelling a request calls its callbacks with nil and drops the
+// decoded image.
+TEST_F(SnapshotDecodeQueueTest, CancelRequest) {
+  __block int callback_count = 0;
+  UIImage* image = image_;
+  [queue_ decodeImageForKey:@"cancelled"
+      block:^UIImage*() {
+        return image;
+      }
+      callback:^(UIImage* decoded_image) {
+        EXPECT_FALSE(decoded_image);
+        ++callback_count;
+      }];
+  __block UIImage* other_image = nil;
+  [queue_ decodeImageForKey:@"other"
+      block:^UIImage*() {
+        return image;
+      }
+      callback:^(UIImage* decoded_image) {
+        other_image = decoded_image;
+      }];
+
+  [queue_ cancelRequestForKey:@"cancelled"];
+  EXPECT_EQ(1, callback_count);
+  EXPECT_FALSE([queue_ hasPendingRequestForKey:@"cancelled"]);
+
+  FlushRunLoops();
+  EXPECT_EQ(1, callback_count);
+  EXPECT_EQ(image, other_image);
+}
+
+// Tests that all the requests complete when there are more requests than
+// concurrent decodes.
+TEST_F(SnapshotDecodeQueueTest, MoreRequestsThanConcurrentDecodes) {
+  const int kRequestCount = 10;
+  __block int callback_count = 0;
+  UIImage* image = image_;
+  for (int i = 0; i < kRequestCount; ++i) {
+    [queue_ decodeImageForKey:[NSString stringWithFormat:@"key %d", i]
+        block:^UIImage*() {
+          return image;
+        }
+        callback:^(UIImage* decoded_image) {
+          EXPECT_EQ(image, decoded_image);
+          ++callback_count;
+        }];
+  }
+  FlushRunLoops();
+  EXPECT_EQ(kRequestCount, callback_count);
+}
+
+}  // namespace
@@ -44,6 +44,13 @@ class SnapshotTabHelper : public infobars::InfoBarManager::Observer,
   // snapshot does not exist.
   void RetrieveColorSnapshot(void (^callback)(UIImage*));
 
+  // Retrieves a downscaled color snapshot for the current page, suited to
+  // display many snapshots at once, invoking |callback| with the image. The
+  // callback may be called synchronously if there is a cached thumbnail
+  // available in memory. Invokes |callback| with nil if a snapshot does not
+  // exist.
+  void RetrieveThumbnail(void (^callback)(UIImage*));
+
   // Retrieves a grey snapshot for the current page, invoking |callback|
   // with the image. The callback may be called synchronously is there is
   // a cached snapshot available in memory, otherwise it will be invoked
@@ -164,6 +164,30 @@ TEST_F(SnapshotTabHelperTest, RetrieveColorSnapshotCachedSnapshot) {
   EXPECT_EQ(delegate_.snapshotTakenCount, 0u);
 }
 
+// Tests that RetrieveThumbnail returns a downscaled copy of the cached
+// snapshot.
+TEST_F(SnapshotTabHelperTest, RetrieveThumbnailCachedSnapshot) {
+  SetCachedSnapshot(
+      UIImageWithSizeAndSolidColor(kCachedSnapshotSize, [UIColor greenColor]));
+
+  base::RunLoop run_loop;
+  base::RunLoop* run_loop_ptr = &run_loop;
+
+  __block UIImage* thumbnail = nil;
+  SnapshotTabHelper::FromWebState(&web_state_)
+      ->RetrieveThumbnail(^(UIImage* image) {
+        thumbnail = image;
+        run_loop_ptr->Quit();
+      });
+
+  run_loop.Run();
+
+  ASSERT_TRUE(thumbnail);
+  EXPECT_LT(thumbnail.size.width, kCachedSnapshotSize.width);
+  EXPECT_LT(thumbnail.size.height, kCachedSnapshotSize.height);
+  EXPECT_EQ(delegate_.snapshotTakenCount, 0u);
+}
+
 // Tests that RetrieveColorSnapshot returns nil when there is no cached snapshot
 // and the WebState web usage is disabled.
 TEST_F(SnapshotTabHelperTest, RetrieveColorSnapshotWebUsageDisabled) {
@@ -11,6 +11,8 @@
 #include "components/sync_sessions/synced_window_delegates_getter.h"
 #include "components/sync_sessions/tab_node_pool.h"
 #include "ios/chrome/browser/sessions/ios_chrome_session_tab_helper.h"
+#import "ios/web/public/crw_navigation_item_storage.h"
+#import "ios/web/public/crw_session_storage.h"
 #include "ios/web/public/favicon_status.h"
 #include "ios/web/public/navigation_item.h"
 #import "ios/web/public/navigation_manager.h"
@@ -32,6 +34,20 @@ NavigationItem* GetPossiblyPendingItemAtIndex(web::WebState* web_state, int i) {
              : web_state->GetNavigationManager()->GetItemAtIndex(i);
 }
 
+// Returns the storage of the item at index |i| in the session of |web_state|,
+// which must be unrealized, or nil if there is no such item. Unrealized
+// WebStates answer from their session storage rather than from their
+// NavigationManager, which would realize them.
+CRWNavigationItemStorage* GetItemStorageAtIndex(web::WebState* web_state,
+                                                int i) {
+  DCHECK(!web_state->IsRealized());
+  NSArray<CRWNavigationItemStorage*>* item_storages =
+      web_state->BuildSessionStorage().itemStorages;
+  if (i < 0 || static_cast<NSUInteger>(i) >= item_storages.count)
+    return nil;
+  return item_storages[i];
+}
+
 }  // namespace
 
 IOSChromeSyncedTabDelegate::IOSChromeSyncedTabDelegate(web::WebState* web_state)
@@ -62,30 +78,45 @@ std::string IOSChromeSyncedTabDelegate::GetExtensionAppId() const {
 }
 
 bool IOSChromeSyncedTabDelegate::IsInitialBlankNavigation() const {
-  return web_state_->GetNavigationManager()->GetItemCount() == 0;
+  return GetEntryCount() == 0;
 }
 
 int IOSChromeSyncedTabDelegate::GetCurrentEntryIndex() const {
+  if (!web_state_->IsRealized())
+    return web_state_->BuildSessionStorage().lastCommittedItemIndex;
   return web_state_->GetNavigationManager()->GetLastCommittedItemIndex();
 }
 
 int IOSChromeSyncedTabDelegate::GetEntryCount() const {
+  if (!web_state_->IsRealized())
+    return web_state_->BuildSessionStorage().itemStorages.count;
   return web_state_->GetNavigationManager()->GetItemCount();
 }
 
 GURL IOSChromeSyncedTabDelegate::GetVirtualURLAtIndex(int i) const {
+  if (!web_state_->IsRealized()) {
+    CRWNavigationItemStorage* item_storage =
+        GetItemStorageAtIndex(web_state_, i);
+    return item_storage ? item_storage.virtualURL : GURL();
+  }
   NavigationItem* item = GetPossiblyPendingItemAtIndex(web_state_, i);
   return item ? item->GetVirtualURL() : GURL();
 }
 
 GURL IOSChromeSyncedTabDelegate::GetFaviconURLAtIndex(int i) const {
   DCHECK_GE(i, 0);
+  // The session storage does not keep the favicons.
+  if (!web_state_->IsRealized())
+    return GURL();
   NavigationItem* item = GetPossiblyPendingItemAtIndex(web_state_, i);
   return (item && item->GetFavicon().valid ? item->GetFavicon().url : GURL());
 }
 
 ui::PageTransition IOSChromeSyncedTabDelegate::GetTransitionAtIndex(
     int i) const {
+  // Restored items are reloads, as when the session is restored.
+  if (!web_state_->IsRealized())
+    return ui::PAGE_TRANSITION_RELOAD;
   NavigationItem* item = GetPossiblyPendingItemAtIndex(web_state_, i);
   return item->GetTransitionType();
 }
@@ -93,6 +124,22 @@ ui::PageTransition IOSChromeSyncedTabDelegate::GetTransitionAtIndex(
 void IOSChromeSyncedTabDelegate::GetSerializedNavigationAtIndex(
     int i,
     sessions::SerializedNavigationEntry* serialized_entry) const {
+  if (!web_state_->IsRealized()) {
+    CRWNavigationItemStorage* item_storage =
+        GetItemStorageAtIndex(web_state_, i);
+    if (!item_storage)
+      return;
+    std::unique_ptr<NavigationItem> item = NavigationItem::Create();
+    item->SetURL(item_storage.virtualURL);
+    item->SetVirtualURL(item_storage.virtualURL);
+    item->SetReferrer(item_storage.referrer);
+    item->SetTitle(item_storage.title);
+    item->SetTimestamp(item_storage.timestamp);
+    item->SetTransitionType(ui::PAGE_TRANSITION_RELOAD);
+    *serialized_entry =
+        sessions::IOSSerializedNavigationBuilder::FromNavigationItem(i, *item);
+    return;
+  }
   NavigationItem* item = GetPossiblyPendingItemAtIndex(web_state_, i);
   if (item) {
     *serialized_entry =
@@ -111,7 +158,9 @@ IOSChromeSyncedTabDelegate::GetBlockedNavigations() const {
 }
 
 bool IOSChromeSyncedTabDelegate::IsPlaceholderTab() const {
-  return false;
+  // An unrealized WebState only holds its serialized session until it is
+  // needed, and its history has not changed since it was last synced.
+  return !web_state_->IsRealized();
 }
 
 bool IOSChromeSyncedTabDelegate::ShouldSync(
@@ -123,6 +172,17 @@ bool IOSChromeSyncedTabDelegate::ShouldSync(
   if (IsInitialBlankNavigation())
     return false;  // This deliberately ignores a new pending entry.
 
+  if (!web_state_->IsRealized()) {
+    NSArray<CRWNavigationItemStorage*>* item_storages =
+        web_state_->BuildSessionStorage().itemStorages;
+    for (CRWNavigationItemStorage* item_storage in item_storages) {
+      const GURL& virtual_url = item_storage.virtualURL;
+      if (virtual_url.is_valid() && sessions_client->ShouldSyncURL(virtual_url))
+        return true;
+    }
+    return false;
+  }
+
   int entry_count = GetEntryCount();
   for (int i = 0; i < entry_count; ++i) {
     const GURL& virtual_url = GetVirtualURLAtIndex(i);
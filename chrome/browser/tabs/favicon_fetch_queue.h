@@ -0,0 +1,103 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_TABS_FAVICON_FETCH_QUEUE_H_
+#define IOS_CHROME_BROWSER_TABS_FAVICON_FETCH_QUEUE_H_
+
+#include <stddef.h>
+
+#include <map>
+
+#include "base/containers/circular_deque.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/task/cancelable_task_tracker.h"
+#import "ios/chrome/browser/web_state_list/web_state_list_observer.h"
+#include "ui/gfx/image/image.h"
+
+namespace favicon {
+class FaviconService;
+}
+
+namespace favicon_base {
+struct FaviconImageResult;
+}
+
+namespace web {
+class WebState;
+}
+
+// Fetches the favicons of unrealized WebStates from the FaviconService, using
+// their visible URL, in small batches from BEST_EFFORT tasks. This neither
+// realizes the WebStates nor queries the favicon database for every tab before
+// the UI is responsive. Once a WebState is activated, and thus realized, its
+// WebFaviconDriver fetches its favicon instead. Listens to the WebStateList
+// holding the WebStates to forget those that are closed.
+class FaviconFetchQueue : public WebStateListObserver {
+ public:
+  // Number of favicons fetched by each task.
+  static const size_t kBatchSize = 8;
+
+  // |favicon_service| may be null, in which case no favicon is fetched.
+  explicit FaviconFetchQueue(favicon::FaviconService* favicon_service);
+  ~FaviconFetchQueue() override;
+
+  // Queues the fetch of the favicon of the visible URL of |web_state|, which
+  // must not be realized.
+  void Enqueue(web::WebState* web_state);
+
+  // Returns the favicon fetched for |web_state|, or an empty image if it was
+  // not fetched yet.
+  gfx::Image GetFavicon(web::WebState* web_state) const;
+
+  // WebStateListObserver implementation:
+  void WebStateReplacedAt(WebStateList* web_state_list,
+                          web::WebState* old_web_state,
+                          web::WebState* new_web_state,
+                          int index) override;
+  void WebStateDetachedAt(WebStateList* web_state_list,
+                          web::WebState* web_state,
+                          int index) override;
+  void WebStateActivatedAt(WebStateList* web_state_list,
+                           web::WebState* old_web_state,
+                           web::WebState* new_web_state,
+                           int active_index,
+                           int reason) override;
+
+ private:
+  // Posts a task to fetch the next batch of favicons unless one is pending.
+  void ScheduleNextBatch();
+
+  // Fetches the favicons of the first |kBatchSize| queued WebStates.
+  void FetchNextBatch();
+
+  // Called when the favicon of |web_state| has been fetched.
+  void OnFaviconFetched(web::WebState* web_state,
+                        const favicon_base::FaviconImageResult& result);
+
+  // Forgets |web_state| and cancels the fetch of its favicon.
+  void Forget(web::WebState* web_state);
+
+  favicon::FaviconService* favicon_service_;
+
+  // The WebStates whose favicon has not been fetched yet, in fetch order.
+  base::circular_deque<web::WebState*> web_states_;
+
+  // The fetches in progress.
+  std::map<web::WebState*, base::CancelableTaskTracker::TaskId> fetches_;
+
+  // The fetched favicons.
+  std::map<web::WebState*, gfx::Image> favicons_;
+
+  // Whether a task to fetch the next batch is pending.
+  bool batch_scheduled_;
+
+  base::CancelableTaskTracker cancelable_task_tracker_;
+
+  base::WeakPtrFactory<FaviconFetchQueue> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(FaviconFetchQueue);
+};
+
+#endif  // IOS_CHROME_BROWSER_TABS_FAVICON_FETCH_QUEUE_H_
@@ -0,0 +1,134 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/tabs/favicon_fetch_queue.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "base/task/post_task.h"
+#include "components/favicon/core/favicon_service.h"
+#include "components/favicon/ios/web_favicon_driver.h"
+#include "components/favicon_base/favicon_types.h"
+#include "ios/web/public/web_state/web_state.h"
+#include "ios/web/public/web_task_traits.h"
+#include "ios/web/public/web_thread.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+// static
+const size_t FaviconFetchQueue::kBatchSize;
+
+FaviconFetchQueue::FaviconFetchQueue(favicon::FaviconService* favicon_service)
+    : favicon_service_(favicon_service),
+      batch_scheduled_(false),
+      weak_ptr_factory_(this) {}
+
+FaviconFetchQueue::~FaviconFetchQueue() = default;
+
+void FaviconFetchQueue::Enqueue(web::WebState* web_state) {
+  DCHECK_CURRENTLY_ON(web::WebThread::UI);
+  DCHECK(web_state);
+  DCHECK(!web_state->IsRealized());
+  if (!favicon_service_)
+    return;
+  web_states_.push_back(web_state);
+  ScheduleNextBatch();
+}
+
+gfx::Image FaviconFetchQueue::GetFavicon(web::WebState* web_state) const {
+  auto it = favicons_.find(web_state);
+  return it == favicons_.end() ? gfx::Image() : it->second;
+}
+
+void FaviconFetchQueue::WebStateReplacedAt(WebStateList* web_state_list,
+                                           web::WebState* old_web_state,
+                                           web::WebState* new_web_state,
+                                           int index) {
+  Forget(old_web_state);
+}
+
+void FaviconFetchQueue::WebStateDetachedAt(WebStateList* web_state_list,
+                                           web::WebState* web_state,
+                                           int index) {
+  Forget(web_state);
+}
+
+void FaviconFetchQueue::WebStateActivatedAt(WebStateList* web_state_list,
+                                            web::WebState* old_web_state,
+                                            web::WebState* new_web_state,
+                                            int active_index,
+                                            int reason) {
+  if (!new_web_state)
+    return;
+  bool tracked = base::ContainsValue(web_states_, new_web_state) ||
+                 base::ContainsKey(fetches_, new_web_state) ||
+                 base::ContainsKey(favicons_, new_web_state);
+  if (!tracked)
+    return;
+  Forget(new_web_state);
+
+  // The WebStateList realized |new_web_state|, so its favicon can be stored
+  // in its navigation items.
+  DCHECK(new_web_state->IsRealized());
+  const GURL& url = new_web_state->GetVisibleURL();
+  favicon::WebFaviconDriver* driver =
+      favicon::WebFaviconDriver::FromWebState(new_web_state);
+  if (driver && url.is_valid())
+    driver->FetchFavicon(url, /*is_same_document=*/false);
+}
+
+void FaviconFetchQueue::ScheduleNextBatch() {
+  if (batch_scheduled_ || web_states_.empty())
+    return;
+  batch_scheduled_ = true;
+  base::PostTaskWithTraits(
+      FROM_HERE, {web::WebThread::UI, base::TaskPriority::BEST_EFFORT},
+      base::BindOnce(&FaviconFetchQueue::FetchNextBatch,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+void FaviconFetchQueue::FetchNextBatch() {
+  DCHECK_CURRENTLY_ON(web::WebThread::UI);
+  batch_scheduled_ = false;
+  for (size_t count = 0; count < kBatchSize && !web_states_.empty();
+       ++count) {
+    web::WebState* web_state = web_states_.front();
+    web_states_.pop_front();
+
+    // The visible URL of an unrealized WebState is known without realizing
+    // it, which would defeat the purpose of restoring it lazily.
+    const GURL& url = web_state->GetVisibleURL();
+    if (!url.is_valid())
+      continue;
+    fetches_[web_state] = favicon_service_->GetFaviconImageForPageURL(
+        url,
+        base::Bind(&FaviconFetchQueue::OnFaviconFetched,
+                   weak_ptr_factory_.GetWeakPtr(), web_state),
+        &cancelable_task_tracker_);
+  }
+  ScheduleNextBatch();
+}
+
+void FaviconFetchQueue::OnFaviconFetched(
+    web::WebState* web_state,
+    const favicon_base::FaviconImageResult& result) {
+  // The fetch of the favicon of a forgotten WebState is cancelled.
+  DCHECK(base::ContainsKey(fetches_, web_state));
+  fetches_.erase(web_state);
+  if (!result.image.IsEmpty())
+    favicons_[web_state] = result.image;
+}
+
+void FaviconFetchQueue::Forget(web::WebState* web_state) {
+  base::Erase(web_states_, web_state);
+  favicons_.erase(web_state);
+  auto it = fetches_.find(web_state);
+  if (it != fetches_.end()) {
+    cancelable_task_tracker_.TryCancel(it->second);
+    fetches_.erase(it);
+  }
+}
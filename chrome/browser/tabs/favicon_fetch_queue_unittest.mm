@@ -0,0 +1,116 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/tabs/favicon_fetch_queue.h"
+
+#import <UIKit/UIKit.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/run_loop.h"
+#include "base/scoped_observer.h"
+#include "base/strings/stringprintf.h"
+#include "components/favicon/core/test/mock_favicon_service.h"
+#include "components/favicon_base/favicon_types.h"
+#import "ios/chrome/browser/web_state_list/fake_web_state_list_delegate.h"
+#import "ios/chrome/browser/web_state_list/web_state_list.h"
+#import "ios/chrome/browser/web_state_list/web_state_opener.h"
+#import "ios/web/public/test/fakes/test_web_state.h"
+#include "ios/web/public/test/test_web_thread_bundle.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+#include "ui/gfx/image/image.h"
+#include "url/gurl.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+using testing::_;
+
+class FaviconFetchQueueTest : public PlatformTest {
+ protected:
+  FaviconFetchQueueTest()
+      : web_state_list_(&web_state_list_delegate_),
+        favicon_fetch_queue_(&favicon_service_),
+        scoped_observer_(&favicon_fetch_queue_) {
+    scoped_observer_.Add(&web_state_list_);
+  }
+
+  // Appends an unrealized WebState whose visible URL is |url| to the
+  // WebStateList, and queues the fetch of its favicon.
+  web::TestWebState* AppendUnrealizedWebState(const GURL& url) {
+    auto web_state = std::make_unique<web::TestWebState>();
+    web_state->SetVisibleURL(url);
+    web_state->SetIsUnrealized();
+    web::TestWebState* web_state_ptr = web_state.get();
+    web_state_list_.InsertWebState(web_state_list_.count(),
+                                   std::move(web_state),
+                                   WebStateList::INSERT_FORCE_INDEX,
+                                   WebStateOpener());
+    favicon_fetch_queue_.Enqueue(web_state_ptr);
+    return web_state_ptr;
+  }
+
+  // Returns a result holding a favicon.
+  favicon_base::FaviconImageResult CreateFaviconResult() {
+    favicon_base::FaviconImageResult result;
+    result.image = gfx::Image([[UIImage alloc] init]);
+    return result;
+  }
+
+  web::TestWebThreadBundle thread_bundle_;
+  FakeWebStateListDelegate web_state_list_delegate_;
+  WebStateList web_state_list_;
+  testing::StrictMock<favicon::MockFaviconService> favicon_service_;
+  FaviconFetchQueue favicon_fetch_queue_;
+  ScopedObserver<WebStateList, WebStateListObserver> scoped_observer_;
+};
+
+// Tests that the favicons are fetched from the FaviconService by URL, in
+// several batches, without realizing the WebStates.
+TEST_F(FaviconFetchQueueTest, FetchWithoutRealizing) {
+  const size_t kWebStateCount = FaviconFetchQueue::kBatchSize + 1;
+  EXPECT_CALL(favicon_service_, GetFaviconImageForPageURL(_, _, _))
+      .Times(kWebStateCount)
+      .WillRepeatedly(favicon::PostReply<3>(CreateFaviconResult()));
+
+  std::vector<web::TestWebState*> web_states;
+  for (size_t i = 0; i < kWebStateCount; ++i) {
+    web_states.push_back(AppendUnrealizedWebState(
+        GURL(base::StringPrintf("http://www.example.com/%zu", i))));
+  }
+  base::RunLoop().RunUntilIdle();
+
+  for (web::TestWebState* web_state : web_states) {
+    EXPECT_FALSE(web_state->IsRealized());
+    EXPECT_FALSE(favicon_fetch_queue_.GetFavicon(web_state).IsEmpty());
+  }
+}
+
+// Tests that the favicon of a closed WebState is not fetched.
+TEST_F(FaviconFetchQueueTest, DetachedWebState) {
+  AppendUnrealizedWebState(GURL("http://www.example.com/"));
+  web_state_list_.DetachWebStateAt(0);
+
+  // |favicon_service_| is a strict mock, so any fetch fails the test.
+  base::RunLoop().RunUntilIdle();
+}
+
+// Tests that an activated WebState is realized and no longer uses the fetched
+// favicon.
+TEST_F(FaviconFetchQueueTest, ActivatedWebState) {
+  EXPECT_CALL(favicon_service_, GetFaviconImageForPageURL(_, _, _))
+      .WillOnce(favicon::PostReply<3>(CreateFaviconResult()));
+  web::TestWebState* web_state =
+      AppendUnrealizedWebState(GURL("http://www.example.com/"));
+  base::RunLoop().RunUntilIdle();
+  ASSERT_FALSE(favicon_fetch_queue_.GetFavicon(web_state).IsEmpty());
+
+  web_state_list_.ActivateWebStateAt(0);
+  EXPECT_TRUE(web_state->IsRealized());
+  EXPECT_TRUE(favicon_fetch_queue_.GetFavicon(web_state).IsEmpty());
+}
@@ -159,6 +159,10 @@ NSUInteger const kTabPositionAutomatically = NSNotFound;
 // Records tab session metrics.
 - (void)recordSessionMetrics;
 
+// Returns the favicon fetched for |webState| while it is not realized, or nil
+// if it is realized or its favicon was not fetched yet.
+- (UIImage*)restoredFaviconForWebState:(web::WebState*)webState;
+
 // Sets whether the user is primarily interacting with this tab model.
 - (void)setPrimary:(BOOL)primary;
 
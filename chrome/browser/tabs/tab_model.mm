@@ -19,6 +19,7 @@
 #include "base/task/cancelable_task_tracker.h"
 #include "base/task/post_task.h"
 #include "components/favicon/ios/web_favicon_driver.h"
+#include "components/keyed_service/core/service_access_type.h"
 #include "components/navigation_metrics/navigation_metrics.h"
 #include "components/sessions/core/serialized_navigation_entry.h"
 #include "components/sessions/core/session_id.h"
@@ -28,6 +29,7 @@
 #include "ios/chrome/browser/chrome_url_constants.h"
 #import "ios/chrome/browser/chrome_url_util.h"
 #include "ios/chrome/browser/crash_loop_detection_util.h"
+#include "ios/chrome/browser/favicon/favicon_service_factory.h"
 #import "ios/chrome/browser/geolocation/omnibox_geolocation_controller.h"
 #import "ios/chrome/browser/metrics/tab_usage_recorder.h"
 #import "ios/chrome/browser/prerender/prerender_service_factory.h"
@@ -38,6 +40,7 @@
 #import "ios/chrome/browser/snapshots/snapshot_cache.h"
 #import "ios/chrome/browser/snapshots/snapshot_cache_factory.h"
 #include "ios/chrome/browser/tab_parenting_global_observer.h"
+#import "ios/chrome/browser/tabs/favicon_fetch_queue.h"
 #import "ios/chrome/browser/tabs/legacy_tab_helper.h"
 #import "ios/chrome/browser/tabs/tab.h"
 #import "ios/chrome/browser/tabs/tab_model_closing_web_state_observer.h"
@@ -56,6 +59,7 @@
 #import "ios/chrome/browser/web_state_list/web_state_list_metrics_observer.h"
 #import "ios/chrome/browser/web_state_list/web_state_list_observer.h"
 #import "ios/chrome/browser/web_state_list/web_state_list_serialization.h"
+#import "ios/chrome/browser/web_state_list/web_state_list_session_cache.h"
 #import "ios/chrome/browser/web_state_list/web_state_opener.h"
 #import "ios/chrome/browser/web_state_list/web_usage_enabler/web_state_list_web_usage_enabler.h"
 #import "ios/chrome/browser/web_state_list/web_usage_enabler/web_state_list_web_usage_enabler_factory.h"
@@ -69,6 +73,7 @@
 #import "ios/web/public/web_state/web_state_observer_bridge.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/public/web_thread.h"
+#include "ui/gfx/image/image.h"
 #include "url/gurl.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
@@ -83,6 +88,9 @@ void UpdateCertificatePolicyCacheFromWebState(
     const web::WebState* web_state) {
   DCHECK(web_state);
   DCHECK_CURRENTLY_ON(web::WebThread::UI);
+  // Unrealized WebStates update the cache when they are realized.
+  if (!web_state->IsRealized())
+    return;
   web_state->GetSessionCertificatePolicyCache()->UpdateCertificatePolicyCache(
       policy_cache);
 }
@@ -242,6 +250,12 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
   // Counters for metrics.
   WebStateListMetricsObserver* _webStateListMetricsObserver;
 
+  // Fetches the favicons of the restored WebStates that are not realized.
+  FaviconFetchQueue* _faviconFetchQueue;
+
+  // Keeps the serialised sessions of the unchanged WebStates between saves.
+  std::unique_ptr<WebStateListSessionCache> _sessionCache;
+
   // Backs up property with the same name.
   std::unique_ptr<TabUsageRecorder> _tabUsageRecorder;
   // Saves session's state.
@@ -339,6 +353,8 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
     }
     _syncedWindowDelegate =
         std::make_unique<TabModelSyncedWindowDelegate>(_webStateList.get());
+    _sessionCache =
+        std::make_unique<WebStateListSessionCache>(_webStateList.get());
 
     // There must be a valid session service defined to consume session windows.
     DCHECK(service);
@@ -385,6 +401,14 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
     _webStateListMetricsObserver = webStateListMetricsObserver.get();
     _webStateListObservers.push_back(std::move(webStateListMetricsObserver));
 
+    favicon::FaviconService* faviconService =
+        ios::FaviconServiceFactory::GetForBrowserState(
+            _browserState, ServiceAccessType::IMPLICIT_ACCESS);
+    auto faviconFetchQueue =
+        std::make_unique<FaviconFetchQueue>(faviconService);
+    _faviconFetchQueue = faviconFetchQueue.get();
+    _webStateListObservers.push_back(std::move(faviconFetchQueue));
+
     auto tabModelNotificationObserver =
         std::make_unique<TabModelNotificationObserver>(self);
     _tabModelNotificationObserver = tabModelNotificationObserver.get();
@@ -555,6 +579,13 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
     _webStateListMetricsObserver->RecordSessionMetrics();
 }
 
+- (UIImage*)restoredFaviconForWebState:(web::WebState*)webState {
+  if (!_faviconFetchQueue || webState->IsRealized())
+    return nil;
+  gfx::Image favicon = _faviconFetchQueue->GetFavicon(webState);
+  return favicon.IsEmpty() ? nil : favicon.ToUIImage();
+}
+
 - (void)setPrimary:(BOOL)primary {
   if (_tabUsageRecorder) {
     _tabUsageRecorder->RecordPrimaryTabModelChange(primary,
@@ -574,6 +605,7 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
   // Clear weak pointer to observers before destroying them.
   _tabModelNotificationObserver = nullptr;
   _webStateListMetricsObserver = nullptr;
+  _faviconFetchQueue = nullptr;
 
   // Close all tabs. Do this in an @autoreleasepool as WebStateList observers
   // will be notified (they are unregistered later). As some of them may be
@@ -592,6 +624,7 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
   _retainedWebStateListObservers = nil;
 
   _clearPoliciesTaskTracker.TryCancelAll();
+  _sessionCache.reset();
   _tabUsageRecorder.reset();
   _webStateObserver.reset();
 }
@@ -618,11 +651,13 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
 
 - (SessionIOS*)sessionForSaving {
   // Build the array of sessions. Copy the session objects as the saving will
-  // be done on a separate thread.
-  // TODO(crbug.com/661986): This could get expensive especially since this
-  // window may never be saved (if another call comes in before the delay).
-  return [[SessionIOS alloc]
-      initWithWindows:@[ SerializeWebStateList(_webStateList.get()) ]];
+  // be done on a separate thread. Only the sessions of the tabs that changed
+  // since the previous save are built, the other ones are reused so that the
+  // SessionServiceIOS does not archive them again.
+  SessionWindowIOS* window = _sessionCache
+                                 ? _sessionCache->Serialize()
+                                 : SerializeWebStateList(_webStateList.get());
+  return [[SessionIOS alloc] initWithWindows:@[ window ]];
 }
 
 - (BOOL)isWebUsageEnabled {
@@ -658,7 +693,10 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
   int oldCount = _webStateList->count();
   DCHECK_GE(oldCount, 0);
 
+  // Only the active WebState is realized, the other ones restore their session
+  // when they are first needed.
   web::WebState::CreateParams createParams(_browserState);
+  createParams.restore_session_lazily = true;
   DeserializeWebStateList(
       _webStateList.get(), window,
       base::BindRepeating(&web::WebState::CreateWithStorageSession,
@@ -677,18 +715,21 @@ void RecordMainFrameNavigationMetric(web::WebState* web_state) {
 
   for (int index = oldCount; index < _webStateList->count(); ++index) {
     web::WebState* webState = _webStateList->GetWebStateAt(index);
-    web::NavigationItem* visible_item =
-        webState->GetNavigationManager()->GetVisibleItem();
+    // The visible URL of an unrealized WebState is known without realizing it.
+    const GURL& visibleURL = webState->GetVisibleURL();
 
-    if (!(visible_item &&
-          visible_item->GetVirtualURL() == kChromeUINewTabURL)) {
+    if (visibleURL != kChromeUINewTabURL) {
       PagePlaceholderTabHelper::FromWebState(webState)
           ->AddPlaceholderForNextNavigation();
     }
 
-    if (visible_item && visible_item->GetVirtualURL().is_valid()) {
-      favicon::WebFaviconDriver::FromWebState(webState)->FetchFavicon(
-          visible_item->GetVirtualURL(), /*is_same_document=*/false);
+    if (visibleURL.is_valid()) {
+      if (webState->IsRealized()) {
+        favicon::WebFaviconDriver::FromWebState(webState)->FetchFavicon(
+            visibleURL, /*is_same_document=*/false);
+      } else {
+        _faviconFetchQueue->Enqueue(webState);
+      }
     }
 
     // Restore the CertificatePolicyCache (note that webState is invalid after
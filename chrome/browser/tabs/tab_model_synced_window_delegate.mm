@@ -35,8 +35,13 @@ SessionID TabModelSyncedWindowDelegate::GetTabIdAt(int index) const {
 
 bool TabModelSyncedWindowDelegate::IsSessionRestoreInProgress() const {
   for (int index = 0; index < web_state_list_->count(); ++index) {
+    const web::WebState* web_state = web_state_list_->GetWebStateAt(index);
+    // An unrealized WebState has not started restoring its session, and
+    // accessing its NavigationManager would realize it.
+    if (!web_state->IsRealized())
+      continue;
     const web::NavigationManager* navigation_manager =
-        web_state_list_->GetWebStateAt(index)->GetNavigationManager();
+        web_state->GetNavigationManager();
     if (navigation_manager->IsRestoreSessionInProgress()) {
       return true;
     }
@@ -9,6 +9,10 @@
 #include "base/run_loop.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/test/scoped_feature_list.h"
+#include "components/sessions/core/serialized_navigation_entry.h"
+#include "components/sync_sessions/mock_sync_sessions_client.h"
+#include "components/sync_sessions/synced_tab_delegate.h"
+#include "components/sync_sessions/synced_window_delegates_getter.h"
 #include "ios/chrome/browser/browser_state/test_chrome_browser_state.h"
 #include "ios/chrome/browser/browser_state/test_chrome_browser_state_manager.h"
 #include "ios/chrome/browser/chrome_url_constants.h"
@@ -24,6 +28,7 @@
 #import "ios/chrome/browser/tabs/tab_helper_util.h"
 #import "ios/chrome/browser/tabs/tab_model.h"
 #import "ios/chrome/browser/tabs/tab_model_observer.h"
+#import "ios/chrome/browser/tabs/tab_model_synced_window_delegate.h"
 #import "ios/chrome/browser/tabs/tab_private.h"
 #include "ios/chrome/browser/ui/ui_feature_flags.h"
 #import "ios/chrome/browser/web/chrome_web_client.h"
@@ -33,6 +38,7 @@
 #import "ios/chrome/browser/web_state_list/web_usage_enabler/web_state_list_web_usage_enabler_factory.h"
 #include "ios/chrome/test/ios_chrome_scoped_testing_chrome_browser_state_manager.h"
 #import "ios/web/navigation/navigation_manager_impl.h"
+#import "ios/web/public/crw_navigation_item_storage.h"
 #import "ios/web/public/crw_session_storage.h"
 #include "ios/web/public/features.h"
 #import "ios/web/public/navigation_manager.h"
@@ -42,6 +48,7 @@
 #include "ios/web/public/test/test_web_thread_bundle.h"
 #include "ios/web/public/web_thread.h"
 #import "ios/web/web_state/web_state_impl.h"
+#include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/gtest_mac.h"
 #include "testing/platform_test.h"
@@ -78,6 +85,29 @@ namespace {
 const char kURL1[] = "https://www.some.url.com";
 const char kURL2[] = "https://www.some.url2.com";
 
+// SyncedWindowDelegatesGetter returning a single window.
+class TestSyncedWindowDelegatesGetter
+    : public sync_sessions::SyncedWindowDelegatesGetter {
+ public:
+  explicit TestSyncedWindowDelegatesGetter(
+      const sync_sessions::SyncedWindowDelegate* window)
+      : window_(window) {}
+
+  // sync_sessions::SyncedWindowDelegatesGetter:
+  SyncedWindowDelegateMap GetSyncedWindowDelegates() override {
+    return {{window_->GetSessionId(), window_}};
+  }
+  const sync_sessions::SyncedWindowDelegate* FindById(
+      SessionID session_id) override {
+    return session_id == window_->GetSessionId() ? window_ : nullptr;
+  }
+
+ private:
+  const sync_sessions::SyncedWindowDelegate* window_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestSyncedWindowDelegatesGetter);
+};
+
 // TabModelTest is parameterized on this enum to test both
 // LegacyNavigationManager and WKBasedNavigationManager.
 enum class NavigationManagerChoice {
@@ -472,6 +502,65 @@ TEST_P(TabModelTest, RestoreSessionOnAnyTest) {
   EXPECT_NSNE(tab, [tab_model_ tabAtIndex:3]);
 }
 
+// Tests that syncing a restored window reads the inactive tabs from their
+// session without realizing them.
+TEST_P(TabModelTest, SyncRestoredSessionKeepsTabsUnrealized) {
+  NSMutableArray<CRWSessionStorage*>* sessions = [NSMutableArray array];
+  for (const char* url : {kURL1, kURL2, kURL1}) {
+    CRWNavigationItemStorage* item_storage =
+        [[CRWNavigationItemStorage alloc] init];
+    item_storage.virtualURL = GURL(url);
+    CRWSessionStorage* session_storage = [[CRWSessionStorage alloc] init];
+    session_storage.itemStorages = @[ item_storage ];
+    session_storage.lastCommittedItemIndex = 0;
+    [sessions addObject:session_storage];
+  }
+  SessionWindowIOS* window =
+      [[SessionWindowIOS alloc] initWithSessions:sessions selectedIndex:1];
+  SetTabModel(CreateTabModel([[TestSessionService alloc] init], window));
+  ASSERT_EQ(3U, [tab_model_ count]);
+
+  TabModelSyncedWindowDelegate* synced_window = tab_model_.syncedWindowDelegate;
+  TestSyncedWindowDelegatesGetter window_getter(synced_window);
+  testing::NiceMock<sync_sessions::MockSyncSessionsClient> sessions_client;
+  ON_CALL(sessions_client, GetSyncedWindowDelegatesGetter())
+      .WillByDefault(testing::Return(&window_getter));
+  ON_CALL(sessions_client, ShouldSyncURL(testing::_))
+      .WillByDefault(testing::Return(true));
+
+  // Read the window and its tabs as sync does when associating them. Only
+  // the inactive tabs are checked, as the active tab restores its session
+  // asynchronously with WKBasedNavigationManager.
+  EXPECT_FALSE(synced_window->IsSessionRestoreInProgress());
+  ASSERT_EQ(3, synced_window->GetTabCount());
+  EXPECT_EQ(1, synced_window->GetActiveIndex());
+  for (int index = 0; index < synced_window->GetTabCount(); ++index) {
+    sync_sessions::SyncedTabDelegate* synced_tab =
+        synced_window->GetTabAt(index);
+    EXPECT_EQ(index != 1, synced_tab->IsPlaceholderTab());
+    bool should_sync = synced_tab->ShouldSync(&sessions_client);
+    bool is_blank = synced_tab->IsInitialBlankNavigation();
+    int entry_count = synced_tab->GetEntryCount();
+    int current_index = synced_tab->GetCurrentEntryIndex();
+    GURL virtual_url = synced_tab->GetVirtualURLAtIndex(0);
+    sessions::SerializedNavigationEntry entry;
+    synced_tab->GetSerializedNavigationAtIndex(0, &entry);
+    if (index == 1)
+      continue;
+
+    EXPECT_TRUE(should_sync);
+    EXPECT_FALSE(is_blank);
+    EXPECT_EQ(1, entry_count);
+    EXPECT_EQ(0, current_index);
+    EXPECT_EQ(GURL(kURL1), virtual_url);
+    EXPECT_EQ(GURL(kURL1), entry.virtual_url());
+  }
+
+  EXPECT_FALSE([tab_model_ tabAtIndex:0].webState->IsRealized());
+  EXPECT_TRUE([tab_model_ tabAtIndex:1].webState->IsRealized());
+  EXPECT_FALSE([tab_model_ tabAtIndex:2].webState->IsRealized());
+}
+
 TEST_P(TabModelTest, CloseAllTabs) {
   [tab_model_ insertTabWithURL:GURL(kURL1)
                       referrer:web::Referrer()
@@ -21,6 +21,7 @@
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
 #include "ios/chrome/browser/browsing_data/browsing_data_counter_wrapper.h"
 #include "ios/chrome/browser/browsing_data/browsing_data_remove_mask.h"
+#include "ios/chrome/browser/browsing_data/cache_counter.h"
 #include "ios/chrome/browser/chrome_url_constants.h"
 #include "ios/chrome/browser/experimental_flags.h"
 #include "ios/chrome/browser/feature_engagement/tracker_factory.h"
@@ -190,16 +191,16 @@ const CGFloat kTableViewButtonBackgroundColor = 0xE94235;
         browsing_data::GetCounterTextFromResult(&result));
   }
 
+  const CacheCounter::CacheResult* cacheResult =
+      static_cast<const CacheCounter::CacheResult*>(&result);
   browsing_data::BrowsingDataCounter::ResultInt cacheSizeBytes =
-      static_cast<const browsing_data::BrowsingDataCounter::FinishedResult*>(
-          &result)
-          ->Value();
-
-  // Three cases: Nonzero result for the entire cache, nonzero result for
-  // a subset of cache (i.e. a finite time interval), and almost zero (less
-  // than 1 MB). There is no exact information that the cache is empty so that
-  // falls into the almost zero case, which is displayed as less than 1 MB.
-  // Because of this, the lowest unit that can be used is MB.
+      cacheResult->Value();
+
+  // Three cases: Nonzero exact result, nonzero upper limit for a subset of
+  // cache (i.e. a finite time interval the cache backend can't count), and
+  // almost zero (less than 1 MB). There is no exact information that the cache
+  // is empty so that falls into the almost zero case, which is displayed as
+  // less than 1 MB. Because of this, the lowest unit that can be used is MB.
   static const int kBytesInAMegabyte = 1 << 20;
   if (cacheSizeBytes >= kBytesInAMegabyte) {
     NSByteCountFormatter* formatter = [[NSByteCountFormatter alloc] init];
@@ -208,11 +209,11 @@ const CGFloat kTableViewButtonBackgroundColor = 0xE94235;
                              (~NSByteCountFormatterUseKB);
     formatter.countStyle = NSByteCountFormatterCountStyleMemory;
     NSString* formattedSize = [formatter stringFromByteCount:cacheSizeBytes];
-    return (self.timePeriod == browsing_data::TimePeriod::ALL_TIME)
-               ? formattedSize
-               : l10n_util::GetNSStringF(
+    return cacheResult->is_upper_limit()
+               ? l10n_util::GetNSStringF(
                      IDS_DEL_CACHE_COUNTER_UPPER_ESTIMATE,
-                     base::SysNSStringToUTF16(formattedSize));
+                     base::SysNSStringToUTF16(formattedSize))
+               : formattedSize;
   }
 
   return l10n_util::GetNSString(IDS_DEL_CACHE_COUNTER_ALMOST_EMPTY);
@@ -149,8 +149,8 @@ TEST_F(ClearBrowsingDataManagerTest, TestCacheCounterFormattingForAllTime) {
   // clang-format on
 
   for (const TestCase& test_case : kTestCases) {
-    browsing_data::BrowsingDataCounter::FinishedResult result(
-        &counter, test_case.cache_size);
+    CacheCounter::CacheResult result(&counter, test_case.cache_size,
+                                     /*is_upper_limit=*/false);
     NSString* output = [manager_ counterTextFromResult:result];
     EXPECT_NSEQ(test_case.expected_output, output);
   }
@@ -186,8 +186,8 @@ TEST_F(ClearBrowsingDataManagerTest,
   // clang-format on
 
   for (const TestCase& test_case : kTestCases) {
-    browsing_data::BrowsingDataCounter::FinishedResult result(
-        &counter, test_case.cache_size);
+    CacheCounter::CacheResult result(&counter, test_case.cache_size,
+                                     /*is_upper_limit=*/true);
     NSString* output = [manager_ counterTextFromResult:result];
     EXPECT_NSEQ(test_case.expected_output, output);
   }
@@ -384,7 +384,7 @@ web::WebState* GetWebStateWithId(WebStateList* web_state_list,
   }
   web::WebState* webState = GetWebStateWithId(self.webStateList, identifier);
   if (webState) {
-    SnapshotTabHelper::FromWebState(webState)->RetrieveColorSnapshot(
+    SnapshotTabHelper::FromWebState(webState)->RetrieveThumbnail(
         ^(UIImage* image) {
             completion(image);
         });
@@ -413,6 +413,14 @@ web::WebState* GetWebStateWithId(WebStateList* web_state_list,
   }
   completion(defaultFavicon);
 
+  // The favicon driver of an unrealized WebState would realize it.
+  if (!webState->IsRealized()) {
+    UIImage* favicon = [self.tabModel restoredFaviconForWebState:webState];
+    if (favicon)
+      completion(favicon);
+    return;
+  }
+
   favicon::FaviconDriver* faviconDriver =
       favicon::WebFaviconDriver::FromWebState(webState);
   if (faviconDriver) {
@@ -4,10 +4,16 @@
 
 #include "ios/chrome/browser/ui/webui/inspect/inspect_ui.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "base/bind.h"
+#include "base/memory/weak_ptr.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/user_metrics.h"
 #include "base/metrics/user_metrics_action.h"
+#include "base/task/post_task.h"
 #include "ios/chrome/browser/browser_state/chrome_browser_state.h"
 #include "ios/chrome/browser/chrome_url_constants.h"
 #include "ios/chrome/browser/tabs/tab_model.h"
@@ -24,6 +30,8 @@
 #include "ios/web/public/web_state/web_frame_util.h"
 #import "ios/web/public/web_state/web_frames_manager.h"
 #import "ios/web/public/web_state/web_state.h"
+#include "ios/web/public/web_task_traits.h"
+#include "ios/web/public/web_thread.h"
 #include "ios/web/public/web_ui_ios_data_source.h"
 #include "ios/web/public/webui/web_ui_ios.h"
 #include "ios/web/public/webui/web_ui_ios_message_handler.h"
@@ -117,13 +125,27 @@ class InspectDOMHandler : public web::WebUIIOSMessageHandler,
       TabModel* tab_model,
       JavaScriptConsoleTabHelperDelegate* delegate);
 
+  // Queues the call of the JavaScript function |name| of the inspect page.
+  // Console messages arrive in bursts, so the queued calls are sent together
+  // by SendPendingCalls().
+  void CallInspectFunction(std::string name,
+                           std::vector<base::Value> parameters);
+
+  // Sends the queued calls to the main frame of the inspect page.
+  void SendPendingCalls();
+
   // Whether or not logging is enabled.
   bool logging_enabled_ = false;
 
+  // The calls queued by CallInspectFunction(), in order.
+  std::vector<web::WebFrame::FunctionCall> pending_calls_;
+
+  base::WeakPtrFactory<InspectDOMHandler> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(InspectDOMHandler);
 };
 
-InspectDOMHandler::InspectDOMHandler() {}
+InspectDOMHandler::InspectDOMHandler() : weak_ptr_factory_(this) {}
 
 InspectDOMHandler::~InspectDOMHandler() {
   // Clear delegate from WebStates.
@@ -203,8 +225,7 @@ void InspectDOMHandler::DidReceiveConsoleMessage(
   params.push_back(base::Value(message.level));
   params.push_back(message.message->Clone());
 
-  inspect_ui_main_frame->CallJavaScriptFunction(
-      "inspectWebUI.logMessageReceived", params);
+  CallInspectFunction("inspectWebUI.logMessageReceived", std::move(params));
 }
 
 void InspectDOMHandler::SetDelegateForWebStatesInTabModel(
@@ -246,8 +267,34 @@ void InspectDOMHandler::WillCloseWebStateAt(WebStateList* web_state_list,
   std::vector<base::Value> params;
   params.push_back(base::Value(web::GetMainWebFrameId(web_state)));
 
-  web::GetMainWebFrame(web_ui()->GetWebState())
-      ->CallJavaScriptFunction("inspectWebUI.tabClosed", params);
+  CallInspectFunction("inspectWebUI.tabClosed", std::move(params));
+}
+
+void InspectDOMHandler::CallInspectFunction(
+    std::string name,
+    std::vector<base::Value> parameters) {
+  if (pending_calls_.empty()) {
+    base::PostTaskWithTraits(
+        FROM_HERE, {web::WebThread::UI},
+        base::BindOnce(&InspectDOMHandler::SendPendingCalls,
+                       weak_ptr_factory_.GetWeakPtr()));
+  }
+  pending_calls_.emplace_back(std::move(name), std::move(parameters));
+}
+
+void InspectDOMHandler::SendPendingCalls() {
+  std::vector<web::WebFrame::FunctionCall> calls;
+  calls.swap(pending_calls_);
+
+  web::WebFrame* inspect_ui_main_frame =
+      web::GetMainWebFrame(web_ui()->GetWebState());
+  if (!inspect_ui_main_frame) {
+    // Disable logging and drop the calls because the main frame no longer
+    // exists.
+    SetLoggingEnabled(false);
+    return;
+  }
+  inspect_ui_main_frame->CallJavaScriptFunctions(std::move(calls));
 }
 
 }  // namespace
@@ -100,6 +100,8 @@ web::WebUIIOSDataSource* CreateVersionUIDataSource() {
                                IDR_VERSION_UI_CSS);
   html_source->SetDefaultResource(IDR_VERSION_UI_HTML);
   html_source->UseGzip();
+  // All the strings are known when the source is created.
+  html_source->ServeOnIOThread();
   return html_source;
 }
 
@@ -356,6 +356,11 @@ void WebStateList::NotifyIfActiveWebStateChanged(web::WebState* old_web_state,
   if (old_web_state == new_web_state)
     return;
 
+  // The active WebState is displayed, so restore its session before the
+  // observers access it.
+  if (new_web_state)
+    new_web_state->ForceRealized();
+
   for (auto& observer : observers_) {
     observer.WebStateActivatedAt(this, old_web_state, new_web_state,
                                  active_index_, reason);
@@ -23,6 +23,11 @@ class WebState;
 using WebStateFactory =
     base::RepeatingCallback<std::unique_ptr<web::WebState>(CRWSessionStorage*)>;
 
+// Returns the serialised session of the WebState at |index| in
+// |web_state_list|, including its opener-opened relationship.
+CRWSessionStorage* SerializeWebStateAt(WebStateList* web_state_list,
+                                       int index);
+
 // Returns an array of serialised sessions.
 SessionWindowIOS* SerializeWebStateList(WebStateList* web_state_list);
 
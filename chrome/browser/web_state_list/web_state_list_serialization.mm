@@ -29,32 +29,36 @@ NSString* const kOpenerIndexKey = @"OpenerIndex";
 NSString* const kOpenerNavigationIndexKey = @"OpenerNavigationIndex";
 }  // namespace
 
+CRWSessionStorage* SerializeWebStateAt(WebStateList* web_state_list,
+                                       int index) {
+  web::WebState* web_state = web_state_list->GetWebStateAt(index);
+  WebStateOpener opener = web_state_list->GetOpenerOfWebStateAt(index);
+
+  web::SerializableUserDataManager* user_data_manager =
+      web::SerializableUserDataManager::FromWebState(web_state);
+
+  int opener_index = WebStateList::kInvalidIndex;
+  if (opener.opener) {
+    opener_index = web_state_list->GetIndexOfWebState(opener.opener);
+    DCHECK_NE(opener_index, WebStateList::kInvalidIndex);
+    user_data_manager->AddSerializableData(@(opener_index), kOpenerIndexKey);
+    user_data_manager->AddSerializableData(@(opener.navigation_index),
+                                           kOpenerNavigationIndexKey);
+  } else {
+    user_data_manager->AddSerializableData([NSNull null], kOpenerIndexKey);
+    user_data_manager->AddSerializableData([NSNull null],
+                                           kOpenerNavigationIndexKey);
+  }
+
+  return web_state->BuildSessionStorage();
+}
+
 SessionWindowIOS* SerializeWebStateList(WebStateList* web_state_list) {
   NSMutableArray<CRWSessionStorage*>* serialized_session =
       [NSMutableArray arrayWithCapacity:web_state_list->count()];
 
-  for (int index = 0; index < web_state_list->count(); ++index) {
-    web::WebState* web_state = web_state_list->GetWebStateAt(index);
-    WebStateOpener opener = web_state_list->GetOpenerOfWebStateAt(index);
-
-    web::SerializableUserDataManager* user_data_manager =
-        web::SerializableUserDataManager::FromWebState(web_state);
-
-    int opener_index = WebStateList::kInvalidIndex;
-    if (opener.opener) {
-      opener_index = web_state_list->GetIndexOfWebState(opener.opener);
-      DCHECK_NE(opener_index, WebStateList::kInvalidIndex);
-      user_data_manager->AddSerializableData(@(opener_index), kOpenerIndexKey);
-      user_data_manager->AddSerializableData(@(opener.navigation_index),
-                                             kOpenerNavigationIndexKey);
-    } else {
-      user_data_manager->AddSerializableData([NSNull null], kOpenerIndexKey);
-      user_data_manager->AddSerializableData([NSNull null],
-                                             kOpenerNavigationIndexKey);
-    }
-
-    [serialized_session addObject:web_state->BuildSessionStorage()];
-  }
+  for (int index = 0; index < web_state_list->count(); ++index)
+    [serialized_session addObject:SerializeWebStateAt(web_state_list, index)];
 
   NSUInteger selectedIndex =
       web_state_list->active_index() != WebStateList::kInvalidIndex
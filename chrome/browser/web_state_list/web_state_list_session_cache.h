@@ -0,0 +1,87 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_BROWSER_WEB_STATE_LIST_WEB_STATE_LIST_SESSION_CACHE_H_
+#define IOS_CHROME_BROWSER_WEB_STATE_LIST_WEB_STATE_LIST_SESSION_CACHE_H_
+
+#import <Foundation/Foundation.h>
+
+#include <map>
+
+#include "base/macros.h"
+#include "base/scoped_observer.h"
+#include "ios/chrome/browser/web_state_list/all_web_state_observation_forwarder.h"
+#include "ios/chrome/browser/web_state_list/web_state_list_observer.h"
+#include "ios/web/public/web_state/web_state_observer.h"
+
+@class CRWSessionStorage;
+@class SessionWindowIOS;
+
+// WebStateListSessionCache serializes a WebStateList like
+// SerializeWebStateList(), but keeps the serialised session of each WebState
+// until the WebState changes, so that only the sessions of the WebStates that
+// were inserted or navigated since the previous call are built. The sessions
+// of the unchanged WebStates are the very objects returned by the previous
+// call, which allows SessionJournalIOS to skip archiving them again.
+class WebStateListSessionCache : public WebStateListObserver,
+                                 public web::WebStateObserver {
+ public:
+  // |web_state_list| must outlive this object.
+  explicit WebStateListSessionCache(WebStateList* web_state_list);
+  ~WebStateListSessionCache() override;
+
+  // Returns the serialised session of the WebStateList.
+  SessionWindowIOS* Serialize();
+
+  // WebStateListObserver:
+  void WebStateInsertedAt(WebStateList* web_state_list,
+                          web::WebState* web_state,
+                          int index,
+                          bool activating) override;
+  void WebStateReplacedAt(WebStateList* web_state_list,
+                          web::WebState* old_web_state,
+                          web::WebState* new_web_state,
+                          int index) override;
+  void WebStateDetachedAt(WebStateList* web_state_list,
+                          web::WebState* web_state,
+                          int index) override;
+
+  // web::WebStateObserver:
+  void WasHidden(web::WebState* web_state) override;
+  void NavigationItemsPruned(web::WebState* web_state,
+                             size_t pruned_item_count) override;
+  void DidFinishNavigation(web::WebState* web_state,
+                           web::NavigationContext* navigation_context) override;
+  void DidStopLoading(web::WebState* web_state) override;
+  void DidChangeBackForwardState(web::WebState* web_state) override;
+  void TitleWasSet(web::WebState* web_state) override;
+  void WebStateDestroyed(web::WebState* web_state) override;
+
+ private:
+  // The serialised session of a WebState and the opener-opened relationship
+  // it was built with. The relationship is stored as indexes in the
+  // WebStateList, so the session is built again when they change.
+  struct CachedSession {
+    CRWSessionStorage* session_storage = nil;
+    int opener_index = 0;
+    int opener_navigation_index = 0;
+  };
+
+  // Returns the index of the opener and the navigation index of the opener of
+  // the WebState at |index|.
+  CachedSession GetOpenerIndexesAt(int index) const;
+
+  // Forgets the serialised session of |web_state|.
+  void Invalidate(web::WebState* web_state);
+
+  WebStateList* web_state_list_;
+  std::map<web::WebState*, CachedSession> cached_sessions_;
+
+  ScopedObserver<WebStateList, WebStateListObserver> web_state_list_observer_;
+  AllWebStateObservationForwarder web_state_observation_forwarder_;
+
+  DISALLOW_COPY_AND_ASSIGN(WebStateListSessionCache);
+};
+
+#endif  // IOS_CHROME_BROWSER_WEB_STATE_LIST_WEB_STATE_LIST_SESSION_CACHE_H_
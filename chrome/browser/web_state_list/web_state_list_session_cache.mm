@@ -0,0 +1,125 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/web_state_list/web_state_list_session_cache.h"
+
+#include "base/logging.h"
+#import "ios/chrome/browser/sessions/session_window_ios.h"
+#import "ios/chrome/browser/web_state_list/web_state_list.h"
+#import "ios/chrome/browser/web_state_list/web_state_list_serialization.h"
+#import "ios/chrome/browser/web_state_list/web_state_opener.h"
+#import "ios/web/public/crw_session_storage.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+WebStateListSessionCache::WebStateListSessionCache(
+    WebStateList* web_state_list)
+    : web_state_list_(web_state_list),
+      web_state_list_observer_(this),
+      web_state_observation_forwarder_(web_state_list, this) {
+  DCHECK(web_state_list_);
+  web_state_list_observer_.Add(web_state_list_);
+}
+
+WebStateListSessionCache::~WebStateListSessionCache() = default;
+
+SessionWindowIOS* WebStateListSessionCache::Serialize() {
+  NSMutableArray<CRWSessionStorage*>* serialized_session =
+      [NSMutableArray arrayWithCapacity:web_state_list_->count()];
+
+  for (int index = 0; index < web_state_list_->count(); ++index) {
+    CachedSession opener_indexes = GetOpenerIndexesAt(index);
+    CachedSession& cached_session =
+        cached_sessions_[web_state_list_->GetWebStateAt(index)];
+    if (!cached_session.session_storage ||
+        cached_session.opener_index != opener_indexes.opener_index ||
+        cached_session.opener_navigation_index !=
+            opener_indexes.opener_navigation_index) {
+      cached_session = opener_indexes;
+      cached_session.session_storage =
+          SerializeWebStateAt(web_state_list_, index);
+    }
+    [serialized_session addObject:cached_session.session_storage];
+  }
+
+  NSUInteger selectedIndex =
+      web_state_list_->active_index() != WebStateList::kInvalidIndex
+          ? static_cast<NSUInteger>(web_state_list_->active_index())
+          : static_cast<NSUInteger>(NSNotFound);
+
+  return [[SessionWindowIOS alloc] initWithSessions:[serialized_session copy]
+                                      selectedIndex:selectedIndex];
+}
+
+void WebStateListSessionCache::WebStateInsertedAt(WebStateList* web_state_list,
+                                                  web::WebState* web_state,
+                                                  int index,
+                                                  bool activating) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::WebStateReplacedAt(
+    WebStateList* web_state_list,
+    web::WebState* old_web_state,
+    web::WebState* new_web_state,
+    int index) {
+  Invalidate(old_web_state);
+  Invalidate(new_web_state);
+}
+
+void WebStateListSessionCache::WebStateDetachedAt(WebStateList* web_state_list,
+                                                  web::WebState* web_state,
+                                                  int index) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::WasHidden(web::WebState* web_state) {
+  // The scroll position of the page is saved when it is hidden.
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::NavigationItemsPruned(web::WebState* web_state,
+                                                     size_t pruned_item_count) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::DidFinishNavigation(
+    web::WebState* web_state,
+    web::NavigationContext* navigation_context) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::DidStopLoading(web::WebState* web_state) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::DidChangeBackForwardState(
+    web::WebState* web_state) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::TitleWasSet(web::WebState* web_state) {
+  Invalidate(web_state);
+}
+
+void WebStateListSessionCache::WebStateDestroyed(web::WebState* web_state) {
+  Invalidate(web_state);
+}
+
+WebStateListSessionCache::CachedSession
+WebStateListSessionCache::GetOpenerIndexesAt(int index) const {
+  WebStateOpener opener = web_state_list_->GetOpenerOfWebStateAt(index);
+  CachedSession opener_indexes;
+  opener_indexes.opener_index =
+      opener.opener ? web_state_list_->GetIndexOfWebState(opener.opener)
+                    : WebStateList::kInvalidIndex;
+  opener_indexes.opener_navigation_index = opener.navigation_index;
+  return opener_indexes;
+}
+
+void WebStateListSessionCache::Invalidate(web::WebState* web_state) {
+  cached_sessions_.erase(web_state);
+}
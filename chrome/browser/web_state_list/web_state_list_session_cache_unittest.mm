@@ -0,0 +1,95 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/chrome/browser/web_state_list/web_state_list_session_cache.h"
+
+#include <memory>
+
+#import "ios/chrome/browser/sessions/session_window_ios.h"
+#import "ios/chrome/browser/web_state_list/fake_web_state_list_delegate.h"
+#import "ios/chrome/browser/web_state_list/web_state_list.h"
+#import "ios/chrome/browser/web_state_list/web_state_opener.h"
+#import "ios/web/public/crw_session_storage.h"
+#import "ios/web/public/test/fakes/fake_navigation_context.h"
+#import "ios/web/public/test/fakes/test_web_state.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+class WebStateListSessionCacheTest : public PlatformTest {
+ protected:
+  WebStateListSessionCacheTest()
+      : web_state_list_(&web_state_list_delegate_),
+        session_cache_(&web_state_list_) {}
+
+  // Appends a WebState opened by |opener| to the WebStateList and returns it.
+  web::TestWebState* AppendWebState(WebStateOpener opener) {
+    auto web_state = std::make_unique<web::TestWebState>();
+    web::TestWebState* web_state_ptr = web_state.get();
+    web_state_list_.InsertWebState(web_state_list_.count(),
+                                   std::move(web_state),
+                                   WebStateList::INSERT_FORCE_INDEX, opener);
+    return web_state_ptr;
+  }
+
+  FakeWebStateListDelegate web_state_list_delegate_;
+  WebStateList web_state_list_;
+  WebStateListSessionCache session_cache_;
+};
+
+// Tests that only the session of the WebState that navigated is built again.
+TEST_F(WebStateListSessionCacheTest, NavigatedWebState) {
+  AppendWebState(WebStateOpener());
+  web::TestWebState* web_state = AppendWebState(WebStateOpener());
+  NSArray<CRWSessionStorage*>* sessions = session_cache_.Serialize().sessions;
+  ASSERT_EQ(2u, sessions.count);
+
+  web::FakeNavigationContext navigation_context;
+  web_state->OnNavigationFinished(&navigation_context);
+
+  NSArray<CRWSessionStorage*>* new_sessions =
+      session_cache_.Serialize().sessions;
+  ASSERT_EQ(2u, new_sessions.count);
+  EXPECT_EQ(sessions[0], new_sessions[0]);
+  EXPECT_NE(sessions[1], new_sessions[1]);
+}
+
+// Tests that the sessions of the WebStates are reused when the WebStates move
+// and that the session of an inserted WebState is built.
+TEST_F(WebStateListSessionCacheTest, MovedAndInsertedWebStates) {
+  AppendWebState(WebStateOpener());
+  AppendWebState(WebStateOpener());
+  NSArray<CRWSessionStorage*>* sessions = session_cache_.Serialize().sessions;
+
+  web_state_list_.MoveWebStateAt(0, 1);
+  AppendWebState(WebStateOpener());
+
+  NSArray<CRWSessionStorage*>* new_sessions =
+      session_cache_.Serialize().sessions;
+  ASSERT_EQ(3u, new_sessions.count);
+  EXPECT_EQ(sessions[1], new_sessions[0]);
+  EXPECT_EQ(sessions[0], new_sessions[1]);
+  EXPECT_FALSE([sessions containsObject:new_sessions[2]]);
+}
+
+// Tests that the session of a WebState is built again when the index of its
+// opener changes.
+TEST_F(WebStateListSessionCacheTest, MovedOpener) {
+  web::TestWebState* opener = AppendWebState(WebStateOpener());
+  AppendWebState(WebStateOpener());
+  AppendWebState(WebStateOpener(opener));
+  NSArray<CRWSessionStorage*>* sessions = session_cache_.Serialize().sessions;
+
+  web_state_list_.MoveWebStateAt(0, 1);
+
+  NSArray<CRWSessionStorage*>* new_sessions =
+      session_cache_.Serialize().sessions;
+  ASSERT_EQ(3u, new_sessions.count);
+  EXPECT_EQ(sessions[1], new_sessions[0]);
+  EXPECT_EQ(sessions[0], new_sessions[1]);
+  EXPECT_NE(sessions[2], new_sessions[2]);
+}
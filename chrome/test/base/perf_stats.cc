@@ -0,0 +1,220 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/test/base/perf_stats.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+// The version of the JSON format, to be incremented on incompatible changes.
+const int kFormatVersion = 1;
+
+// Returns |sorted_samples| without the outliers according to |policy|.
+std::vector<double> RemoveOutliers(std::vector<double> sorted_samples,
+                                   PerfOutlierPolicy policy) {
+  switch (policy) {
+    case PerfOutlierPolicy::kKeepAll:
+      return sorted_samples;
+    case PerfOutlierPolicy::kTrimMinMax:
+      if (sorted_samples.size() > 2) {
+        sorted_samples.pop_back();
+        sorted_samples.erase(sorted_samples.begin());
+      }
+      return sorted_samples;
+    case PerfOutlierPolicy::kTukeyFences: {
+      const double q1 = ComputePercentile(sorted_samples, 25);
+      const double q3 = ComputePercentile(sorted_samples, 75);
+      const double lower_fence = q1 - 1.5 * (q3 - q1);
+      const double upper_fence = q3 + 1.5 * (q3 - q1);
+      std::vector<double> kept_samples;
+      for (double sample : sorted_samples) {
+        if (sample >= lower_fence && sample <= upper_fence)
+          kept_samples.push_back(sample);
+      }
+      return kept_samples;
+    }
+  }
+  NOTREACHED();
+  return sorted_samples;
+}
+
+}  // namespace
+
+const char kPerfResultsJSONSwitch[] = "perf-results-json";
+
+PerfStats ComputePerfStats(std::vector<double> samples,
+                           PerfOutlierPolicy policy) {
+  PerfStats stats;
+  if (samples.empty())
+    return stats;
+  std::sort(samples.begin(), samples.end());
+  samples = RemoveOutliers(std::move(samples), policy);
+  // The samples closest to the quartiles are always within the fences.
+  DCHECK(!samples.empty());
+
+  stats.count = samples.size();
+  stats.min = samples.front();
+  stats.max = samples.back();
+  double sum = 0;
+  for (double sample : samples)
+    sum += sample;
+  stats.mean = sum / stats.count;
+  if (stats.count > 1) {
+    double squared_deviations = 0;
+    for (double sample : samples)
+      squared_deviations += (sample - stats.mean) * (sample - stats.mean);
+    stats.stddev = sqrt(squared_deviations / (stats.count - 1));
+  }
+  stats.p50 = ComputePercentile(samples, 50);
+  stats.p90 = ComputePercentile(samples, 90);
+  stats.p99 = ComputePercentile(samples, 99);
+  return stats;
+}
+
+double ComputePercentile(const std::vector<double>& sorted_samples,
+                         double percentile) {
+  DCHECK(!sorted_samples.empty());
+  DCHECK(percentile >= 0 && percentile <= 100);
+  const double rank = percentile / 100 * (sorted_samples.size() - 1);
+  const size_t lower_index = static_cast<size_t>(floor(rank));
+  const size_t upper_index = static_cast<size_t>(ceil(rank));
+  return sorted_samples[lower_index] +
+         (sorted_samples[upper_index] - sorted_samples[lower_index]) *
+             (rank - lower_index);
+}
+
+const char* PerfOutlierPolicyName(PerfOutlierPolicy policy) {
+  switch (policy) {
+    case PerfOutlierPolicy::kKeepAll:
+      return "keep_all";
+    case PerfOutlierPolicy::kTrimMinMax:
+      return "trim_min_max";
+    case PerfOutlierPolicy::kTukeyFences:
+      return "tukey_fences";
+  }
+  NOTREACHED();
+  return "";
+}
+
+PerfResult::PerfResult() = default;
+
+PerfResult::PerfResult(const PerfResult& other) = default;
+
+PerfResult::~PerfResult() = default;
+
+PerfResult RepeatPerfRuns(const std::string& group,
+                          const std::string& test,
+                          const std::string& unit,
+                          const PerfRunOptions& options,
+                          const base::RepeatingCallback<double(int)>& run) {
+  DCHECK_GE(options.warm_up_runs, 0);
+  DCHECK_GT(options.repeat_count, 0);
+  PerfResult result;
+  result.group = group;
+  result.test = test;
+  result.unit = unit;
+  result.warm_up_runs = options.warm_up_runs;
+  result.outlier_policy = options.outlier_policy;
+  for (int i = 0; i < options.warm_up_runs + options.repeat_count; ++i) {
+    const double value = run.Run(i);
+    if (i >= options.warm_up_runs)
+      result.samples.push_back(value);
+    else if (i == 0)
+      result.first_value = value;
+  }
+  result.stats = ComputePerfStats(result.samples, options.outlier_policy);
+  return result;
+}
+
+void ReportPerfResult(const PerfResult& result) {
+  perf_test::PrintResult(result.group, "", result.test, result.stats.mean,
+                         result.unit, true /* important */);
+  perf_test::PrintResult(result.group, "_p50", result.test, result.stats.p50,
+                         result.unit, false /* important */);
+  perf_test::PrintResult(result.group, "_p90", result.test, result.stats.p90,
+                         result.unit, false /* important */);
+  perf_test::PrintResult(result.group, "_stddev", result.test,
+                         result.stats.stddev, result.unit,
+                         false /* important */);
+
+  PerfResultsWriter* writer = PerfResultsWriter::GetForCommandLine();
+  if (writer)
+    writer->AddResult(result);
+}
+
+PerfResultsWriter::PerfResultsWriter(const base::FilePath& path)
+    : path_(path) {}
+
+PerfResultsWriter::~PerfResultsWriter() = default;
+
+// static
+PerfResultsWriter* PerfResultsWriter::GetForCommandLine() {
+  static base::NoDestructor<std::unique_ptr<PerfResultsWriter>> writer([] {
+    const base::CommandLine* command_line =
+        base::CommandLine::ForCurrentProcess();
+    if (!command_line->HasSwitch(kPerfResultsJSONSwitch))
+      return std::unique_ptr<PerfResultsWriter>();
+    return std::make_unique<PerfResultsWriter>(
+        command_line->GetSwitchValuePath(kPerfResultsJSONSwitch));
+  }());
+  return writer->get();
+}
+
+bool PerfResultsWriter::AddResult(const PerfResult& result) {
+  base::DictionaryValue stats;
+  stats.SetInteger("count", static_cast<int>(result.stats.count));
+  stats.SetDouble("mean", result.stats.mean);
+  stats.SetDouble("stddev", result.stats.stddev);
+  stats.SetDouble("min", result.stats.min);
+  stats.SetDouble("max", result.stats.max);
+  stats.SetDouble("p50", result.stats.p50);
+  stats.SetDouble("p90", result.stats.p90);
+  stats.SetDouble("p99", result.stats.p99);
+
+  base::ListValue samples;
+  for (double sample : result.samples)
+    samples.AppendDouble(sample);
+
+  auto value = std::make_unique<base::DictionaryValue>();
+  value->SetString("group", result.group);
+  value->SetString("test", result.test);
+  value->SetString("unit", result.unit);
+  value->SetInteger("warm_up_runs", result.warm_up_runs);
+  if (result.warm_up_runs > 0)
+    value->SetDouble("first", result.first_value);
+  value->SetString("outlier_policy",
+                   PerfOutlierPolicyName(result.outlier_policy));
+  value->SetKey("stats", std::move(stats));
+  value->SetKey("samples", std::move(samples));
+  results_.Append(std::move(value));
+
+  const std::string json = ToJSON();
+  if (base::WriteFile(path_, json.data(), json.size()) !=
+      static_cast<int>(json.size())) {
+    LOG(ERROR) << "Writing " << path_.value() << " failed.";
+    return false;
+  }
+  return true;
+}
+
+std::string PerfResultsWriter::ToJSON() const {
+  base::DictionaryValue root;
+  root.SetInteger("format_version", kFormatVersion);
+  root.SetKey("results", results_.Clone());
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      root, base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+  return json;
+}
@@ -0,0 +1,139 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_CHROME_TEST_BASE_PERF_STATS_H_
+#define IOS_CHROME_TEST_BASE_PERF_STATS_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/values.h"
+
+// Statistics of the samples of perf tests, the loop taking them, and their
+// JSON output. Does not depend on iOS, so that C++ perf tests can use it on all
+// platforms.
+
+// Switch giving the path of the file the perf results are written to as JSON.
+extern const char kPerfResultsJSONSwitch[];
+
+// How the outliers are removed from the samples before computing statistics.
+enum class PerfOutlierPolicy {
+  // All the samples are kept.
+  kKeepAll,
+  // The smallest and the largest samples are removed, if there are more than
+  // two samples.
+  kTrimMinMax,
+  // The samples outside of [Q1 - 1.5 * IQR, Q3 + 1.5 * IQR] are removed, where
+  // Q1 and Q3 are the first and third quartiles and IQR = Q3 - Q1.
+  kTukeyFences,
+};
+
+// Statistics of a set of samples. The percentiles are interpolated linearly
+// between the closest ranks.
+struct PerfStats {
+  // The number of samples left once the outliers are removed.
+  size_t count = 0;
+  double mean = 0;
+  // The sample standard deviation.
+  double stddev = 0;
+  double min = 0;
+  double max = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+};
+
+// Returns the statistics of |samples| once the outliers are removed according
+// to |policy|. All the fields are zero if |samples| is empty.
+PerfStats ComputePerfStats(std::vector<double> samples,
+                           PerfOutlierPolicy policy);
+
+// Returns the |percentile|th percentile, in [0, 100], of |sorted_samples|,
+// which must not be empty.
+double ComputePercentile(const std::vector<double>& sorted_samples,
+                         double percentile);
+
+// Returns the name of |policy| in the JSON output.
+const char* PerfOutlierPolicyName(PerfOutlierPolicy policy);
+
+// The results of a perf test, as recorded in the JSON output.
+struct PerfResult {
+  PerfResult();
+  PerfResult(const PerfResult& other);
+  ~PerfResult();
+
+  // The name of the group of tests, and of the test in the group.
+  std::string group;
+  std::string test;
+  std::string unit;
+  // The number of runs done before the samples were taken, and the value of
+  // the first of them, if any.
+  int warm_up_runs = 0;
+  double first_value = 0;
+  PerfOutlierPolicy outlier_policy = PerfOutlierPolicy::kKeepAll;
+  // All the samples, including the outliers, in the order they were taken.
+  std::vector<double> samples;
+  PerfStats stats;
+};
+
+// How many times RepeatPerfRuns() runs a perf test, and how its samples are
+// summarized.
+struct PerfRunOptions {
+  // The runs done before the samples are taken, to account for lazy
+  // initialization.
+  int warm_up_runs = 1;
+  // The sampled runs.
+  int repeat_count = 10;
+  PerfOutlierPolicy outlier_policy = PerfOutlierPolicy::kTrimMinMax;
+};
+
+// Calls |run| for the warm-up and the sampled runs described by |options|,
+// passing the index of the run, and returns the result of |test| in |group|.
+// |run| returns the value measured by the run, in |unit|. Only the first
+// warm-up value is kept.
+PerfResult RepeatPerfRuns(const std::string& group,
+                          const std::string& test,
+                          const std::string& unit,
+                          const PerfRunOptions& options,
+                          const base::RepeatingCallback<double(int)>& run);
+
+// Prints the mean of |result| as an important perf result, and its p50, p90
+// and standard deviation as other results. Also adds |result| to the writer
+// returned by PerfResultsWriter::GetForCommandLine(), if any.
+void ReportPerfResult(const PerfResult& result);
+
+// Writes the results of the perf tests run by the process to a JSON file. The
+// file is written again each time a result is added, so that it is complete
+// even if the process is killed afterwards. Results are written in the order
+// they are added, so that two files can be diffed.
+class PerfResultsWriter {
+ public:
+  explicit PerfResultsWriter(const base::FilePath& path);
+  ~PerfResultsWriter();
+
+  // Returns the writer to the file passed with |kPerfResultsJSONSwitch|, or
+  // null if the switch is not present.
+  static PerfResultsWriter* GetForCommandLine();
+
+  // Adds |result| and writes all the results. Returns whether the file was
+  // written.
+  bool AddResult(const PerfResult& result);
+
+  // Returns the JSON written to the file.
+  std::string ToJSON() const;
+
+ private:
+  const base::FilePath path_;
+  base::ListValue results_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfResultsWriter);
+};
+
+#endif  // IOS_CHROME_TEST_BASE_PERF_STATS_H_
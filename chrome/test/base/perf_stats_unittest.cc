@@ -0,0 +1,138 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/chrome/test/base/perf_stats.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+using PerfStatsTest = PlatformTest;
+
+// Tests the statistics of samples without outliers removed.
+TEST_F(PerfStatsTest, KeepAll) {
+  std::vector<double> samples;
+  for (int i = 100; i >= 1; --i)
+    samples.push_back(i);
+  PerfStats stats = ComputePerfStats(samples, PerfOutlierPolicy::kKeepAll);
+  EXPECT_EQ(100U, stats.count);
+  EXPECT_DOUBLE_EQ(50.5, stats.mean);
+  EXPECT_NEAR(29.011, stats.stddev, 0.001);
+  EXPECT_DOUBLE_EQ(1, stats.min);
+  EXPECT_DOUBLE_EQ(100, stats.max);
+  EXPECT_DOUBLE_EQ(50.5, stats.p50);
+  EXPECT_NEAR(90.1, stats.p90, 1e-9);
+  EXPECT_NEAR(99.01, stats.p99, 1e-9);
+}
+
+// Tests that the smallest and largest samples are removed.
+TEST_F(PerfStatsTest, TrimMinMax) {
+  PerfStats stats =
+      ComputePerfStats({5, 1, 3, 100}, PerfOutlierPolicy::kTrimMinMax);
+  EXPECT_EQ(2U, stats.count);
+  EXPECT_DOUBLE_EQ(4, stats.mean);
+  EXPECT_DOUBLE_EQ(3, stats.min);
+  EXPECT_DOUBLE_EQ(5, stats.max);
+
+  // Two samples or less are kept.
+  stats = ComputePerfStats({1, 2}, PerfOutlierPolicy::kTrimMinMax);
+  EXPECT_EQ(2U, stats.count);
+}
+
+// Tests that the samples far from the quartiles are removed.
+TEST_F(PerfStatsTest, TukeyFences) {
+  PerfStats stats = ComputePerfStats({10, 11, 12, 13, 14, 100},
+                                     PerfOutlierPolicy::kTukeyFences);
+  EXPECT_EQ(5U, stats.count);
+  EXPECT_DOUBLE_EQ(14, stats.max);
+  EXPECT_DOUBLE_EQ(12, stats.p50);
+}
+
+// Tests the statistics of a single sample and of no samples.
+TEST_F(PerfStatsTest, FewSamples) {
+  PerfStats stats = ComputePerfStats({7}, PerfOutlierPolicy::kTukeyFences);
+  EXPECT_EQ(1U, stats.count);
+  EXPECT_DOUBLE_EQ(0, stats.stddev);
+  EXPECT_DOUBLE_EQ(7, stats.p99);
+
+  stats = ComputePerfStats({}, PerfOutlierPolicy::kKeepAll);
+  EXPECT_EQ(0U, stats.count);
+}
+
+// Tests that the warm-up runs are not sampled, and that only the first of them
+// is kept.
+TEST_F(PerfStatsTest, RepeatPerfRuns) {
+  PerfRunOptions options;
+  options.warm_up_runs = 2;
+  options.repeat_count = 4;
+  options.outlier_policy = PerfOutlierPolicy::kKeepAll;
+  PerfResult result = RepeatPerfRuns(
+      "Group", "Test", "ms", options,
+      base::BindRepeating([](int index) { return 10.0 * (index + 1); }));
+  EXPECT_EQ("Group", result.group);
+  EXPECT_EQ("Test", result.test);
+  EXPECT_EQ("ms", result.unit);
+  EXPECT_EQ(2, result.warm_up_runs);
+  EXPECT_DOUBLE_EQ(10, result.first_value);
+  EXPECT_EQ(std::vector<double>({30, 40, 50, 60}), result.samples);
+  EXPECT_EQ(PerfOutlierPolicy::kKeepAll, result.outlier_policy);
+  EXPECT_EQ(4U, result.stats.count);
+  EXPECT_DOUBLE_EQ(45, result.stats.mean);
+
+  // The runs are all sampled without warm-up runs.
+  options.warm_up_runs = 0;
+  options.outlier_policy = PerfOutlierPolicy::kTrimMinMax;
+  result = RepeatPerfRuns(
+      "Group", "Test", "ms", options,
+      base::BindRepeating([](int index) { return 10.0 * (index + 1); }));
+  EXPECT_EQ(std::vector<double>({10, 20, 30, 40}), result.samples);
+  EXPECT_EQ(2U, result.stats.count);
+  EXPECT_DOUBLE_EQ(25, result.stats.mean);
+}
+
+// Tests that the results are written as JSON.
+TEST_F(PerfStatsTest, WriteResults) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.GetPath().AppendASCII("results.json");
+  PerfResultsWriter writer(path);
+
+  PerfResult result;
+  result.group = "Group";
+  result.test = "Test";
+  result.unit = "ms";
+  result.warm_up_runs = 1;
+  result.first_value = 10;
+  result.outlier_policy = PerfOutlierPolicy::kKeepAll;
+  result.samples = {2, 1};
+  result.stats = ComputePerfStats(result.samples, result.outlier_policy);
+  ASSERT_TRUE(writer.AddResult(result));
+  result.test = "OtherTest";
+  ASSERT_TRUE(writer.AddResult(result));
+
+  std::string json;
+  ASSERT_TRUE(base::ReadFileToString(path, &json));
+  EXPECT_EQ(writer.ToJSON(), json);
+  std::unique_ptr<base::Value> root = base::JSONReader::Read(json);
+  ASSERT_TRUE(root);
+  EXPECT_EQ(1, root->FindKey("format_version")->GetInt());
+  const base::Value* results = root->FindKey("results");
+  ASSERT_TRUE(results);
+  ASSERT_EQ(2U, results->GetList().size());
+  const base::Value& first_result = results->GetList()[0];
+  EXPECT_EQ("Test", first_result.FindKey("test")->GetString());
+  EXPECT_EQ("keep_all", first_result.FindKey("outlier_policy")->GetString());
+  EXPECT_DOUBLE_EQ(10, first_result.FindKey("first")->GetDouble());
+  EXPECT_DOUBLE_EQ(1.5, first_result.FindPath({"stats", "p50"})->GetDouble());
+  EXPECT_EQ(2U, first_result.FindKey("samples")->GetList().size());
+  EXPECT_EQ("OtherTest", results->GetList()[1].FindKey("test")->GetString());
+}
@@ -9,6 +9,7 @@
 
 #import "base/ios/block_types.h"
 #include "base/time/time.h"
+#include "ios/chrome/test/base/perf_stats.h"
 #import "ios/chrome/test/block_cleanup_test.h"
 #include "ios/web/public/test/scoped_testing_web_client.h"
 #include "ios/web/public/test/test_web_thread_bundle.h"
@@ -38,9 +39,12 @@ class PerfTest : public BlockCleanupTest {
   virtual void LogPerfTiming(std::string testName, base::TimeDelta elapsed);
 
   // Utility method to run a test multiple times.
-  // The first run is counted separately to account for possible lazy
-  // initialization overhead. Subsequent run times are averaged to provide
-  // reliable timings for comparison.
+  // The warm-up runs are not sampled, to account for possible lazy
+  // initialization overhead, and the first of them is reported separately.
+  // The |repeatCount| subsequent runs are sampled. Once the outliers are
+  // removed, their average, p50, p90, p99 and standard deviation are reported.
+  // The samples and statistics are also written as JSON to the file passed
+  // with --perf-results-json, if any.
   virtual void RepeatTimedRuns(std::string testName,
                                TimedActionBlock timedAction,
                                ProceduralBlock postAction);
@@ -49,6 +53,13 @@ class PerfTest : public BlockCleanupTest {
                                ProceduralBlock postAction,
                                int repeatCount);
 
+  // Sets the number of warm-up runs of RepeatTimedRuns. Defaults to 1.
+  void SetWarmUpRuns(int warmUpRuns);
+
+  // Sets how the outliers are removed from the samples of RepeatTimedRuns.
+  // Defaults to removing the minimum and maximum samples.
+  void SetOutlierPolicy(PerfOutlierPolicy outlierPolicy);
+
   // Computes the average time, and, optionally, returns the maximum and
   // minimum times seen.
   static base::TimeDelta CalculateAverage(base::TimeDelta* times,
@@ -69,6 +80,10 @@ class PerfTest : public BlockCleanupTest {
   bool verbose_;
   // Sets number of times to repeat a test when ran with RepeatTimedRuns.
   int repeatCount_;
+  // Number of runs of RepeatTimedRuns which are not sampled.
+  int warmUpRuns_;
+  // How the outliers are removed from the samples of RepeatTimedRuns.
+  PerfOutlierPolicy outlierPolicy_;
   // The threads used for testing.
   web::TestWebThreadBundle thread_bundle_;
   // The WebClient for testing purposes.
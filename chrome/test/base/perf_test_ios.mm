@@ -4,6 +4,7 @@
 
 #include <memory>
 
+#include "base/bind.h"
 #include "base/logging.h"
 #import "ios/chrome/browser/web/chrome_web_client.h"
 #import "ios/chrome/test/base/perf_test_ios.h"
@@ -12,6 +13,26 @@
 #error "This file requires ARC support."
 #endif
 
+namespace {
+
+// Runs |timedAction| and |postAction| for the run at |index|, and returns the
+// time taken by |timedAction| in milliseconds. Logs the time if |verbose|,
+// unless the run is the first warm-up run, which is reported separately.
+double RunTimedAction(TimedActionBlock timedAction,
+                      ProceduralBlock postAction,
+                      bool verbose,
+                      int warmUpRuns,
+                      int index) {
+  const double elapsed = timedAction(index).InMillisecondsF();
+  if (verbose && (index > 0 || warmUpRuns == 0))
+    NSLog(@"%2d: %.3f ms", index, elapsed);
+  if (postAction)
+    postAction();
+  return elapsed;
+}
+
+}  // namespace
+
 PerfTest::PerfTest(std::string testGroup)
     : BlockCleanupTest(),
       testGroup_(testGroup),
@@ -20,6 +41,8 @@ PerfTest::PerfTest(std::string testGroup)
       isWaterfall_(false),
       verbose_(true),
       repeatCount_(10),
+      warmUpRuns_(1),
+      outlierPolicy_(PerfOutlierPolicy::kTrimMinMax),
       web_client_(std::make_unique<ChromeWebClient>()) {}
 PerfTest::PerfTest(std::string testGroup,
                    std::string firstLabel,
@@ -34,6 +57,8 @@ PerfTest::PerfTest(std::string testGroup,
       isWaterfall_(isWaterfall),
       verbose_(verbose),
       repeatCount_(repeat),
+      warmUpRuns_(1),
+      outlierPolicy_(PerfOutlierPolicy::kTrimMinMax),
       web_client_(std::make_unique<ChromeWebClient>()) {}
 
 PerfTest::~PerfTest() {}
@@ -59,36 +84,41 @@ void PerfTest::RepeatTimedRuns(std::string testName,
                                TimedActionBlock timedAction,
                                ProceduralBlock postAction,
                                int repeat) {
-  base::TimeDelta firstElapsed;
-  base::TimeDelta totalElapsed;
-  base::TimeDelta maxElapsed;
-  base::TimeDelta minElapsed = base::TimeDelta::FromSeconds(1000);
-  for (int i = 0; i < repeat + 1; ++i) {
-    base::TimeDelta elapsed = timedAction(i);
-    if (i == 0) {
-      std::string label =
-          firstLabel_.length() ? testName + " " + firstLabel_ : testName;
-      LogPerfTiming(label, elapsed);
-      firstElapsed = elapsed;
-    } else {
-      if (verbose_)
-        NSLog(@"%2d: %.3f ms", i, elapsed.InMillisecondsF());
-      totalElapsed += elapsed;
-      if (elapsed > maxElapsed)
-        maxElapsed = elapsed;
-      if (elapsed < minElapsed)
-        minElapsed = elapsed;
-    }
-    if (postAction)
-      postAction();
+  PerfRunOptions options;
+  options.warm_up_runs = warmUpRuns_;
+  options.repeat_count = repeat;
+  options.outlier_policy = outlierPolicy_;
+  PerfResult result = RepeatPerfRuns(
+      testGroup_, testName, "ms", options,
+      base::BindRepeating(&RunTimedAction, timedAction, postAction, verbose_,
+                          warmUpRuns_));
+  if (warmUpRuns_ > 0) {
+    std::string label =
+        firstLabel_.length() ? testName + " " + firstLabel_ : testName;
+    LogPerfValue(label, result.first_value, "ms");
   }
-  if (repeat > 2) {
-    base::TimeDelta average =
-        (totalElapsed - maxElapsed - minElapsed) / (repeat - 2);
+  if (result.stats.count) {
     std::string label =
         averageLabel_.length() ? testName + " " + averageLabel_ : testName;
-    LogPerfTiming(label, average);
+    LogPerfValue(label, result.stats.mean, "ms");
+    LogPerfValue(testName + " p50", result.stats.p50, "ms");
+    LogPerfValue(testName + " p90", result.stats.p90, "ms");
+    LogPerfValue(testName + " p99", result.stats.p99, "ms");
+    LogPerfValue(testName + " stddev", result.stats.stddev, "ms");
   }
+
+  PerfResultsWriter* writer = PerfResultsWriter::GetForCommandLine();
+  if (writer)
+    writer->AddResult(result);
+}
+
+void PerfTest::SetWarmUpRuns(int warmUpRuns) {
+  DCHECK_GE(warmUpRuns, 0);
+  warmUpRuns_ = warmUpRuns;
+}
+
+void PerfTest::SetOutlierPolicy(PerfOutlierPolicy outlierPolicy) {
+  outlierPolicy_ = outlierPolicy;
 }
 
 // TODO(leng): Replace this with RepeatTimedRuns when we have figured out
@@ -0,0 +1,193 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/buffered_stream_uploader.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+
+namespace net {
+
+namespace {
+
+// Minimum and maximum size of the blocks holding the stream data.
+const int kMinBlockSize = 64 * 1024;
+const int kMaxBlockSize = 16 * kMinBlockSize;  // 1MB
+
+}  // namespace
+
+const int BufferedStreamUploader::kMaxBufferedBytes;
+
+BufferedStreamUploader::BufferedStreamUploader(Delegate* delegate,
+                                               uint64_t size)
+    : UploadDataStream(false, 0),
+      delegate_(delegate),
+      size_(size),
+      last_block_size_(0),
+      next_block_size_(kMinBlockSize),
+      read_block_index_(0),
+      read_offset_(0),
+      appended_bytes_(0),
+      uploaded_bytes_(0),
+      release_uploaded_blocks_(size > kMaxBufferedBytes),
+      has_released_blocks_(false),
+      is_end_of_stream_(false),
+      pending_read_buffer_length_(0),
+      weak_factory_(this) {
+  DCHECK(delegate_);
+  DCHECK_GT(size_, 0U);
+}
+
+BufferedStreamUploader::~BufferedStreamUploader() {}
+
+bool BufferedStreamUploader::CanAppend() const {
+  if (is_end_of_stream_ || appended_bytes_ == size_)
+    return false;
+  return !release_uploaded_blocks_ ||
+         appended_bytes_ - uploaded_bytes_ <
+             static_cast<uint64_t>(kMaxBufferedBytes);
+}
+
+char* BufferedStreamUploader::GetAppendBuffer(int* length) {
+  DCHECK(CanAppend());
+  DCHECK(length);
+
+  if (blocks_.empty() || last_block_size_ == blocks_.back()->size()) {
+    int block_size = static_cast<int>(std::min<uint64_t>(
+        next_block_size_, size_ - appended_bytes_));
+    blocks_.push_back(base::MakeRefCounted<IOBufferWithSize>(block_size));
+    last_block_size_ = 0;
+    next_block_size_ = std::min(2 * next_block_size_, kMaxBlockSize);
+  }
+
+  *length = blocks_.back()->size() - last_block_size_;
+  return blocks_.back()->data() + last_block_size_;
+}
+
+void BufferedStreamUploader::DidAppend(int length) {
+  DCHECK_GE(length, 0);
+  DCHECK(!blocks_.empty());
+  DCHECK_LE(last_block_size_ + length, blocks_.back()->size());
+  if (!length)
+    return;
+
+  last_block_size_ += length;
+  appended_bytes_ += length;
+
+  // Complete the read if the network layer is waiting for data.
+  if (pending_read_buffer_) {
+    scoped_refptr<IOBuffer> buffer = std::move(pending_read_buffer_);
+    int bytes_read = CopyBufferedData(buffer.get(), pending_read_buffer_length_);
+    pending_read_buffer_length_ = 0;
+    OnReadCompleted(bytes_read);
+  }
+}
+
+void BufferedStreamUploader::SetEndOfStream() {
+  is_end_of_stream_ = true;
+
+  // The stream is shorter than the body if a read is still waiting for data.
+  if (pending_read_buffer_) {
+    DLOG(ERROR) << "Stream ended after " << appended_bytes_ << " of " << size_
+                << " bytes.";
+    pending_read_buffer_ = nullptr;
+    pending_read_buffer_length_ = 0;
+    OnReadCompleted(ERR_FAILED);
+  }
+}
+
+int BufferedStreamUploader::CopyBufferedData(IOBuffer* buffer,
+                                             int buffer_length) {
+  const bool could_append = CanAppend();
+
+  int bytes_copied = 0;
+  while (bytes_copied < buffer_length && uploaded_bytes_ < appended_bytes_) {
+    IOBufferWithSize* block = blocks_[read_block_index_].get();
+    int length = std::min(buffer_length - bytes_copied,
+                          GetBlockDataSize(read_block_index_) - read_offset_);
+    memcpy(buffer->data() + bytes_copied, block->data() + read_offset_,
+           length);
+    bytes_copied += length;
+    read_offset_ += length;
+    uploaded_bytes_ += length;
+    if (read_offset_ == block->size()) {
+      ++read_block_index_;
+      read_offset_ = 0;
+    }
+  }
+
+  if (release_uploaded_blocks_) {
+    while (read_block_index_ > 0) {
+      blocks_.pop_front();
+      --read_block_index_;
+      has_released_blocks_ = true;
+    }
+  }
+
+  // The delegate is notified asynchronously, as it may delete this object.
+  if (!could_append && CanAppend()) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&BufferedStreamUploader::NotifyUploadBufferAvailable,
+                       weak_factory_.GetWeakPtr()));
+  }
+  return bytes_copied;
+}
+
+int BufferedStreamUploader::GetBlockDataSize(size_t index) const {
+  DCHECK_LT(index, blocks_.size());
+  return index + 1 == blocks_.size() ? last_block_size_
+                                     : blocks_[index]->size();
+}
+
+void BufferedStreamUploader::NotifyUploadBufferAvailable() {
+  if (CanAppend())
+    delegate_->OnUploadBufferAvailable();
+}
+
+int BufferedStreamUploader::InitInternal(const NetLogWithSource& net_log) {
+  // The body can only be uploaded again if none of it has been released.
+  if (has_released_blocks_)
+    return ERR_UPLOAD_STREAM_REWIND_NOT_SUPPORTED;
+
+  SetSize(size_);
+  read_block_index_ = 0;
+  read_offset_ = 0;
+  uploaded_bytes_ = 0;
+  return OK;
+}
+
+int BufferedStreamUploader::ReadInternal(IOBuffer* buffer, int buffer_length) {
+  DCHECK(buffer);
+  DCHECK_GT(buffer_length, 0);
+  DCHECK(!pending_read_buffer_);
+
+  if (uploaded_bytes_ < appended_bytes_)
+    return CopyBufferedData(buffer, buffer_length);
+
+  if (is_end_of_stream_) {
+    DLOG(ERROR) << "Stream ended after " << appended_bytes_ << " of " << size_
+                << " bytes.";
+    return ERR_FAILED;
+  }
+
+  // Wait for the stream data.
+  pending_read_buffer_ = buffer;
+  pending_read_buffer_length_ = buffer_length;
+  return ERR_IO_PENDING;
+}
+
+void BufferedStreamUploader::ResetInternal() {
+  pending_read_buffer_ = nullptr;
+  pending_read_buffer_length_ = 0;
+}
+
+}  // namespace net
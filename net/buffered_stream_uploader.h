@@ -0,0 +1,128 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_NET_BUFFERED_STREAM_UPLOADER_H_
+#define IOS_NET_BUFFERED_STREAM_UPLOADER_H_
+
+#include <stdint.h>
+
+#include "base/containers/circular_deque.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/upload_data_stream.h"
+
+namespace net {
+class IOBuffer;
+class IOBufferWithSize;
+
+// The BufferedStreamUploader is used to upload the HTTPBodyStream of an iOS
+// NSMutableURLRequest whose length is known. Called on the network thread.
+// The stream data is read directly into a chain of blocks, whose size grows as
+// the upload progresses, and the network layer reads the body from that chain,
+// so the request does not wait for the whole stream to be read. Bodies up to
+// kMaxBufferedBytes are kept until the upload completes and can be rewound.
+// The blocks of larger bodies are released once uploaded, and at most
+// kMaxBufferedBytes are buffered ahead of the network layer, so large bodies
+// are uploaded with bounded memory but cannot be rewound.
+class BufferedStreamUploader : public net::UploadDataStream {
+ public:
+  class Delegate {
+   public:
+    Delegate() {}
+    virtual ~Delegate() {}
+
+    // Called when data can be appended again after CanAppend() returned false.
+    // Never called synchronously from the UploadDataStream interface.
+    virtual void OnUploadBufferAvailable() = 0;
+  };
+
+  // Amount of data buffered ahead of the network layer.
+  static const int kMaxBufferedBytes = 4 * 1024 * 1024;
+
+  // |size| is the length of the body, which must be greater than zero.
+  BufferedStreamUploader(Delegate* delegate, uint64_t size);
+  ~BufferedStreamUploader() override;
+
+  // Returns whether data can be appended. Returns false once the whole body
+  // has been appended, or while too much data is waiting to be uploaded.
+  bool CanAppend() const;
+
+  // Returns the buffer the next stream data must be read into, and sets
+  // |*length| to the size of that buffer. Must only be called if CanAppend()
+  // returns true. The buffer is valid until DidAppend() is called.
+  char* GetAppendBuffer(int* length);
+
+  // Called once |length| bytes have been read into the buffer returned by
+  // GetAppendBuffer().
+  void DidAppend(int length);
+
+  // Called when the end of the stream has been reached. The upload fails if
+  // the stream was shorter than the body.
+  void SetEndOfStream();
+
+  base::WeakPtr<BufferedStreamUploader> GetWeakPtr() {
+    return weak_factory_.GetWeakPtr();
+  }
+
+ private:
+  // Copies the buffered data to |buffer| and returns the number of bytes
+  // copied. Releases the uploaded blocks if the body is too large to be kept.
+  int CopyBufferedData(IOBuffer* buffer, int buffer_length);
+
+  // Returns the number of bytes appended to |blocks_[index]|.
+  int GetBlockDataSize(size_t index) const;
+
+  // Calls OnUploadBufferAvailable() on |delegate_|.
+  void NotifyUploadBufferAvailable();
+
+  // net::UploadDataStream implementation:
+  int InitInternal(const NetLogWithSource& net_log) override;
+  int ReadInternal(IOBuffer* buffer, int buffer_length) override;
+  void ResetInternal() override;
+
+  Delegate* const delegate_;
+
+  // Length of the body.
+  const uint64_t size_;
+
+  // The blocks holding the appended data which has not been released. Only
+  // the last block may not be full.
+  base::circular_deque<scoped_refptr<IOBufferWithSize>> blocks_;
+
+  // Number of bytes appended to the last block of |blocks_|.
+  int last_block_size_;
+
+  // Size of the next block to allocate. Doubled for each block, up to a limit,
+  // so small bodies use small blocks and large bodies few blocks.
+  int next_block_size_;
+
+  // Position of the next data to upload in |blocks_|.
+  size_t read_block_index_;
+  int read_offset_;
+
+  // Total number of bytes appended, and uploaded since the last rewind.
+  uint64_t appended_bytes_;
+  uint64_t uploaded_bytes_;
+
+  // Whether the uploaded blocks are released, and whether any was released.
+  const bool release_uploaded_blocks_;
+  bool has_released_blocks_;
+
+  // Whether the end of the stream has been reached.
+  bool is_end_of_stream_;
+
+  // The network layer buffer of the pending read, and the length of the
+  // buffer.
+  scoped_refptr<IOBuffer> pending_read_buffer_;
+  int pending_read_buffer_length_;
+
+  base::WeakPtrFactory<BufferedStreamUploader> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedStreamUploader);
+};
+
+}  // namespace net
+
+#endif  // IOS_NET_BUFFERED_STREAM_UPLOADER_H_
@@ -0,0 +1,184 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/buffered_stream_uploader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/log/net_log_with_source.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace net {
+
+namespace {
+const int kDefaultIOBufferSize = 1024;
+}
+
+// Delegate counting the OnUploadBufferAvailable() calls.
+class TestBufferedStreamUploaderDelegate
+    : public BufferedStreamUploader::Delegate {
+ public:
+  TestBufferedStreamUploaderDelegate() : buffer_available_count_(0) {}
+  ~TestBufferedStreamUploaderDelegate() override {}
+
+  void OnUploadBufferAvailable() override { ++buffer_available_count_; }
+
+  int buffer_available_count() const { return buffer_available_count_; }
+
+ private:
+  int buffer_available_count_;
+};
+
+class BufferedStreamUploaderTest : public PlatformTest {
+ public:
+  BufferedStreamUploaderTest()
+      : buffer_(base::MakeRefCounted<IOBuffer>(kDefaultIOBufferSize)),
+        callback_count_(0),
+        last_callback_result_(OK) {}
+
+  // Creates an initialized uploader for a body of |size| bytes.
+  void CreateUploader(uint64_t size) {
+    uploader_ = std::make_unique<BufferedStreamUploader>(&delegate_, size);
+    EXPECT_EQ(OK, uploader_->Init(base::BindRepeating([](int) {}),
+                                  NetLogWithSource()));
+  }
+
+  // Appends |data| to the uploader, as read from the stream.
+  void Append(const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+      ASSERT_TRUE(uploader_->CanAppend());
+      int length = 0;
+      char* buffer = uploader_->GetAppendBuffer(&length);
+      ASSERT_GT(length, 0);
+      int append_length =
+          std::min(static_cast<int>(data.size() - offset), length);
+      memcpy(buffer, data.data() + offset, append_length);
+      offset += append_length;
+      uploader_->DidAppend(append_length);
+    }
+  }
+
+  // Reads the body into |buffer_|.
+  int Read() {
+    return uploader_->Read(
+        buffer_.get(), kDefaultIOBufferSize,
+        base::BindRepeating(&BufferedStreamUploaderTest::CompletionCallback,
+                            base::Unretained(this)));
+  }
+
+  void CompletionCallback(int result) {
+    ++callback_count_;
+    last_callback_result_ = result;
+  }
+
+ protected:
+  base::MessageLoop loop_;
+  TestBufferedStreamUploaderDelegate delegate_;
+  std::unique_ptr<BufferedStreamUploader> uploader_;
+  scoped_refptr<IOBuffer> buffer_;
+
+  // Completion callback counter and result of the last callback.
+  int callback_count_;
+  int last_callback_result_;
+};
+
+// Tests that data appended before the network layer reads it is returned
+// directly.
+TEST_F(BufferedStreamUploaderTest, ExternalDataReadyFirst) {
+  const std::string kTestData = "Hello world!";
+  CreateUploader(kTestData.size());
+  Append(kTestData);
+  EXPECT_FALSE(uploader_->CanAppend());
+
+  EXPECT_EQ(static_cast<int>(kTestData.size()), Read());
+  EXPECT_EQ(kTestData, std::string(buffer_->data(), kTestData.size()));
+  EXPECT_TRUE(uploader_->IsEOF());
+  EXPECT_EQ(0, callback_count_);
+}
+
+// Tests that a read waiting for data is completed when data is appended.
+TEST_F(BufferedStreamUploaderTest, InternalReadReadyFirst) {
+  const std::string kTestData = "Hello world!";
+  CreateUploader(2 * kTestData.size());
+
+  EXPECT_EQ(ERR_IO_PENDING, Read());
+  Append(kTestData);
+  EXPECT_EQ(1, callback_count_);
+  EXPECT_EQ(static_cast<int>(kTestData.size()), last_callback_result_);
+  EXPECT_EQ(kTestData, std::string(buffer_->data(), kTestData.size()));
+  EXPECT_FALSE(uploader_->IsEOF());
+
+  EXPECT_EQ(ERR_IO_PENDING, Read());
+  Append(kTestData);
+  EXPECT_EQ(2, callback_count_);
+  EXPECT_TRUE(uploader_->IsEOF());
+}
+
+// Tests that a body which fits in the buffer can be uploaded again.
+TEST_F(BufferedStreamUploaderTest, Rewind) {
+  const std::string kTestData = "Hello world!";
+  CreateUploader(kTestData.size());
+  Append(kTestData);
+  EXPECT_EQ(static_cast<int>(kTestData.size()), Read());
+  EXPECT_TRUE(uploader_->IsEOF());
+
+  EXPECT_EQ(OK, uploader_->Init(base::BindRepeating([](int) {}),
+                                NetLogWithSource()));
+  memset(buffer_->data(), 0, kDefaultIOBufferSize);
+  EXPECT_EQ(static_cast<int>(kTestData.size()), Read());
+  EXPECT_EQ(kTestData, std::string(buffer_->data(), kTestData.size()));
+}
+
+// Tests that the data of a large body is buffered up to a limit, that the
+// delegate is notified once some of it has been uploaded, and that the
+// uploaded data is released.
+TEST_F(BufferedStreamUploaderTest, LargeBody) {
+  const int kMaxBufferedBytes = BufferedStreamUploader::kMaxBufferedBytes;
+  CreateUploader(2 * kMaxBufferedBytes);
+  Append(std::string(kMaxBufferedBytes, 'a'));
+  EXPECT_FALSE(uploader_->CanAppend());
+
+  EXPECT_EQ(kDefaultIOBufferSize, Read());
+  EXPECT_TRUE(uploader_->CanAppend());
+  EXPECT_EQ(0, delegate_.buffer_available_count());
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, delegate_.buffer_available_count());
+
+  // Upload the rest of the first block, which is then released and cannot be
+  // uploaded again.
+  const int kFirstBlockSize = 64 * 1024;
+  for (int i = kDefaultIOBufferSize; i < kFirstBlockSize;
+       i += kDefaultIOBufferSize) {
+    ASSERT_EQ(kDefaultIOBufferSize, Read());
+  }
+  EXPECT_EQ(ERR_UPLOAD_STREAM_REWIND_NOT_SUPPORTED,
+            uploader_->Init(base::BindRepeating([](int) {}),
+                            NetLogWithSource()));
+}
+
+// Tests that the upload fails if the stream is shorter than the body.
+TEST_F(BufferedStreamUploaderTest, StreamTooShort) {
+  const std::string kTestData = "Hello world!";
+  CreateUploader(2 * kTestData.size());
+  Append(kTestData);
+  EXPECT_EQ(static_cast<int>(kTestData.size()), Read());
+
+  EXPECT_EQ(ERR_IO_PENDING, Read());
+  uploader_->SetEndOfStream();
+  EXPECT_EQ(1, callback_count_);
+  EXPECT_EQ(ERR_FAILED, last_callback_result_);
+}
+
+}  // namespace net
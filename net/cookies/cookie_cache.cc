@@ -5,12 +5,27 @@
 #include "ios/net/cookies/cookie_cache.h"
 
 #include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
 
+#include "base/hash.h"
 #include "base/logging.h"
-#include "net/cookies/cookie_options.h"
 
 namespace net {
 
+namespace {
+
+size_t HashString(const std::string& string) {
+  return std::hash<std::string>()(string);
+}
+
+}  // namespace
+
+CookieCache::Entry::Entry() {}
+
+CookieCache::Entry::~Entry() {}
+
 CookieCache::CookieCache() {
 }
 
@@ -22,61 +37,149 @@ bool CookieCache::Update(const GURL& url,
                          const std::vector<net::CanonicalCookie>& new_cookies,
                          std::vector<net::CanonicalCookie>* out_removed_cookies,
                          std::vector<net::CanonicalCookie>* out_added_cookies) {
-  CookieKey key(url, name);
-  CookieSet old_set = cache_[key];
-  CookieSet new_set(new_cookies.begin(), new_cookies.end());
-
-  // Compute the changes and the removals.
-  CookieSet added_cookies;
-  CookieSet removed_cookies;
-  std::set_difference(new_set.begin(), new_set.end(), old_set.begin(),
-                      old_set.end(),
-                      std::inserter(added_cookies, added_cookies.begin()),
-                      CookieCache::CookieAndValueComparator());
-  std::set_difference(old_set.begin(), old_set.end(), new_set.begin(),
-                      new_set.end(),
-                      std::inserter(removed_cookies, removed_cookies.begin()),
-                      CookieCache::CookieAndValueComparator());
-
-  if (added_cookies.empty() && removed_cookies.empty())
-    return false;
-
-  cache_[key] = new_set;
-  if (out_removed_cookies) {
-    out_removed_cookies->insert(out_removed_cookies->end(),
-                                removed_cookies.begin(), removed_cookies.end());
+  // Fingerprint the new cookies and keep the first cookie of each identity.
+  new_fingerprints_.clear();
+  for (size_t index = 0; index < new_cookies.size(); ++index) {
+    new_fingerprints_.push_back(
+        {ComputeFingerprint(new_cookies[index]), index});
   }
-  if (out_added_cookies) {
-    out_added_cookies->insert(out_added_cookies->end(), added_cookies.begin(),
-                              added_cookies.end());
+  auto identity_less = [&new_cookies](const IndexedFingerprint& lhs,
+                                      const IndexedFingerprint& rhs) {
+    return IsIdentityLess(lhs.fingerprint, new_cookies[lhs.index],
+                          rhs.fingerprint, new_cookies[rhs.index]);
+  };
+  std::stable_sort(new_fingerprints_.begin(), new_fingerprints_.end(),
+                   identity_less);
+  // As the fingerprints are sorted, a cookie which does not come after the
+  // previous one has the same identity.
+  new_fingerprints_.erase(
+      std::unique(new_fingerprints_.begin(), new_fingerprints_.end(),
+                  [&identity_less](const IndexedFingerprint& lhs,
+                                   const IndexedFingerprint& rhs) {
+                    return !identity_less(lhs, rhs);
+                  }),
+      new_fingerprints_.end());
+
+  Entry& entry = GetEntry(url, name);
+  const std::vector<Fingerprint>& old_fingerprints = entry.fingerprints;
+  if (old_fingerprints.size() == new_fingerprints_.size()) {
+    bool changed = false;
+    for (size_t index = 0; index < old_fingerprints.size() && !changed;
+         ++index) {
+      const IndexedFingerprint& added = new_fingerprints_[index];
+      const net::CanonicalCookie& new_cookie = new_cookies[added.index];
+      changed = IsIdentityLess(old_fingerprints[index], entry.cookies[index],
+                               added.fingerprint, new_cookie) ||
+                IsIdentityLess(added.fingerprint, new_cookie,
+                               old_fingerprints[index], entry.cookies[index]) ||
+                !HaveSameContents(old_fingerprints[index],
+                                  entry.cookies[index], added.fingerprint,
+                                  new_cookie);
+    }
+    if (!changed)
+      return false;
   }
+
+  // Merge the two sorted sequences. Unchanged cookies are moved from the old
+  // entry; only added and removed cookies are copied.
+  Entry updated_entry;
+  updated_entry.fingerprints.reserve(new_fingerprints_.size());
+  updated_entry.cookies.reserve(new_fingerprints_.size());
+  size_t old_index = 0;
+  size_t new_index = 0;
+  while (old_index < old_fingerprints.size() ||
+         new_index < new_fingerprints_.size()) {
+    bool remove_old = old_index < old_fingerprints.size();
+    bool add_new = new_index < new_fingerprints_.size();
+    if (remove_old && add_new) {
+      const Fingerprint& old_fingerprint = old_fingerprints[old_index];
+      const net::CanonicalCookie& old_cookie = entry.cookies[old_index];
+      const IndexedFingerprint& added = new_fingerprints_[new_index];
+      const net::CanonicalCookie& new_cookie = new_cookies[added.index];
+      if (IsIdentityLess(old_fingerprint, old_cookie, added.fingerprint,
+                         new_cookie)) {
+        add_new = false;
+      } else if (IsIdentityLess(added.fingerprint, new_cookie,
+                                old_fingerprint, old_cookie)) {
+        remove_old = false;
+      } else if (HaveSameContents(old_fingerprint, old_cookie,
+                                  added.fingerprint, new_cookie)) {
+        updated_entry.fingerprints.push_back(old_fingerprint);
+        updated_entry.cookies.push_back(std::move(entry.cookies[old_index]));
+        ++old_index;
+        ++new_index;
+        continue;
+      }
+    }
+
+    if (remove_old) {
+      if (out_removed_cookies)
+        out_removed_cookies->push_back(std::move(entry.cookies[old_index]));
+      ++old_index;
+    }
+    if (add_new) {
+      const IndexedFingerprint& added = new_fingerprints_[new_index];
+      const net::CanonicalCookie& cookie = new_cookies[added.index];
+      updated_entry.fingerprints.push_back(added.fingerprint);
+      updated_entry.cookies.push_back(cookie);
+      if (out_added_cookies)
+        out_added_cookies->push_back(cookie);
+      ++new_index;
+    }
+  }
+
+  entry = std::move(updated_entry);
   return true;
 }
 
-bool CookieCache::CookieComparator::operator()(
-    const net::CanonicalCookie& lhs,
-    const net::CanonicalCookie& rhs) const {
-  if (lhs.Domain() != rhs.Domain())
-    return lhs.Domain() < rhs.Domain();
-  if (lhs.Path() != rhs.Path())
-    return lhs.Path() < rhs.Path();
-  if (lhs.Name() != rhs.Name())
-    return lhs.Name() < rhs.Name();
-  return false;
+// static
+CookieCache::Fingerprint CookieCache::ComputeFingerprint(
+    const net::CanonicalCookie& cookie) {
+  Fingerprint fingerprint;
+  fingerprint.identity =
+      base::HashInts(base::HashInts(HashString(cookie.Domain()),
+                                    HashString(cookie.Path())),
+                     HashString(cookie.Name()));
+  fingerprint.contents = base::HashInts(
+      HashString(cookie.Value()),
+      static_cast<uint64_t>(cookie.ExpiryDate().ToInternalValue()));
+  return fingerprint;
+}
+
+// static
+bool CookieCache::IsIdentityLess(const Fingerprint& lhs_fingerprint,
+                                 const net::CanonicalCookie& lhs,
+                                 const Fingerprint& rhs_fingerprint,
+                                 const net::CanonicalCookie& rhs) {
+  if (lhs_fingerprint.identity != rhs_fingerprint.identity)
+    return lhs_fingerprint.identity < rhs_fingerprint.identity;
+  return std::tie(lhs.Domain(), lhs.Path(), lhs.Name()) <
+         std::tie(rhs.Domain(), rhs.Path(), rhs.Name());
 }
 
-bool CookieCache::CookieAndValueComparator::operator()(
-    const net::CanonicalCookie& lhs,
-    const net::CanonicalCookie& rhs) const {
-  if (lhs.Domain() != rhs.Domain())
-    return lhs.Domain() < rhs.Domain();
-  if (lhs.Path() != rhs.Path())
-    return lhs.Path() < rhs.Path();
-  if (lhs.Name() != rhs.Name())
-    return lhs.Name() < rhs.Name();
-  if (lhs.Value() != rhs.Value())
-    return lhs.Value() < rhs.Value();
-  return false;
+// static
+bool CookieCache::HaveSameContents(const Fingerprint& lhs_fingerprint,
+                                   const net::CanonicalCookie& lhs,
+                                   const Fingerprint& rhs_fingerprint,
+                                   const net::CanonicalCookie& rhs) {
+  return lhs_fingerprint.contents == rhs_fingerprint.contents &&
+         lhs.Value() == rhs.Value() && lhs.ExpiryDate() == rhs.ExpiryDate();
+}
+
+CookieCache::Entry& CookieCache::GetEntry(const GURL& url,
+                                          const std::string& name) {
+  // URLs cannot contain a newline, so this is unambiguous.
+  key_buffer_.assign(url.spec());
+  key_buffer_.push_back('\n');
+  key_buffer_.append(name);
+
+  auto it = entry_indices_.find(key_buffer_);
+  if (it != entry_indices_.end())
+    return entries_[it->second];
+
+  entry_indices_.emplace(key_buffer_, entries_.size());
+  entries_.emplace_back();
+  return entries_.back();
 }
 
 }  // namespace net
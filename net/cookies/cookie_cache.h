@@ -5,10 +5,12 @@
 #ifndef IOS_NET_COOKIES_COOKIE_CACHE_H_
 #define IOS_NET_COOKIES_COOKIE_CACHE_H_
 
-#include <map>
-#include <set>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
-#include <utility>
+#include <unordered_map>
+#include <vector>
 
 #include "base/macros.h"
 #include "net/cookies/canonical_cookie.h"
@@ -21,6 +23,11 @@ namespace net {
 // provides one operation, Update(), which updates the set of cookies for a
 // (url, name) pair and returns whether the new set for that (url, name) pair is
 // different from the old set.
+//
+// Each (url, name) pair is interned to an index into a flat vector of entries.
+// An entry keeps a sorted fingerprint of every cookie next to the cookie
+// itself, so an Update() with an unchanged set only hashes the new cookies and
+// compares them to the cached ones, without copying any cookie.
 class CookieCache {
  public:
   CookieCache();
@@ -33,8 +40,11 @@ class CookieCache {
   // Returns true if the new set is different from the old set, i.e.:
   //  * any cookie in |new_cookies| is not present in the cache
   //  * any cookie in the cache is not present in |new_cookies|
-  //  * any cookie in both |new_cookies| and the cache has changed value
-  // Returns false otherwise.
+  //  * any cookie in both |new_cookies| and the cache has changed value or
+  //    expiry date
+  // Returns false otherwise. Cookies are identified by their (domain, path,
+  // name) and only the first of several cookies with the same identity is
+  // kept.
   //
   // |out_removed_cookies|, if not NULL, will be populated with the cookies that
   // were removed.
@@ -47,28 +57,57 @@ class CookieCache {
               std::vector<net::CanonicalCookie>* out_added_cookies);
 
  private:
-  // Compares two cookies, returning true if |lhs| comes before |rhs| in the
-  // partial ordering defined for CookieSet. This effectively does a
-  // lexicographic comparison of (domain, path, name) tuples for two cookies.
-  struct CookieComparator {
-    bool operator()(const net::CanonicalCookie& lhs,
-                    const net::CanonicalCookie& rhs) const;
+  // Hashes of a cookie. |identity| covers (domain, path, name) and |contents|
+  // covers (value, expiry date). They only order cookies and tell different
+  // cookies apart quickly: cookies with equal hashes are compared field by
+  // field, as the hashes may collide.
+  struct Fingerprint {
+    size_t identity;
+    size_t contents;
+  };
+
+  // The cookies cached for one (url, name) pair, sorted by IsIdentityLess().
+  // |cookies[i]| is the cookie of |fingerprints[i]|.
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    std::vector<Fingerprint> fingerprints;
+    std::vector<net::CanonicalCookie> cookies;
   };
 
-  // Compares two cookies, returning true if |lhs| comes before |rhs| in the
-  // partial ordering defined for CookieSet. This effectively does a
-  // lexicographic comparison of (domain, path, name, value) tuples for two
-  // cookies.
-  struct CookieAndValueComparator {
-    bool operator()(const net::CanonicalCookie& lhs,
-                    const net::CanonicalCookie& rhs) const;
+  // A fingerprint of one of the cookies passed to Update(), and its index in
+  // that vector.
+  struct IndexedFingerprint {
+    Fingerprint fingerprint;
+    size_t index;
   };
 
-  typedef std::set<net::CanonicalCookie, CookieComparator> CookieSet;
-  typedef std::pair<GURL, std::string> CookieKey;
-  typedef std::map<CookieKey, CookieSet> CookieKeyPathMap;
+  static Fingerprint ComputeFingerprint(const net::CanonicalCookie& cookie);
+
+  // Orders cookies by the hash of their identity, then by their identity.
+  static bool IsIdentityLess(const Fingerprint& lhs_fingerprint,
+                             const net::CanonicalCookie& lhs,
+                             const Fingerprint& rhs_fingerprint,
+                             const net::CanonicalCookie& rhs);
+
+  // Returns whether two cookies with the same identity have the same value and
+  // expiry date.
+  static bool HaveSameContents(const Fingerprint& lhs_fingerprint,
+                               const net::CanonicalCookie& lhs,
+                               const Fingerprint& rhs_fingerprint,
+                               const net::CanonicalCookie& rhs);
+
+  // Returns the entry for (|url|, |name|), creating it if needed.
+  Entry& GetEntry(const GURL& url, const std::string& name);
+
+  // Interned (url, name) keys, mapped to their index in |entries_|.
+  std::unordered_map<std::string, size_t> entry_indices_;
+  std::vector<Entry> entries_;
 
-  CookieKeyPathMap cache_;
+  // Scratch buffers reused across Update() calls to avoid allocations.
+  std::string key_buffer_;
+  std::vector<IndexedFingerprint> new_fingerprints_;
 
   DISALLOW_COPY_AND_ASSIGN(CookieCache);
 };
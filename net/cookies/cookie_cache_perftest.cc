@@ -0,0 +1,114 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/cookies/cookie_cache.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "ios/chrome/test/base/perf_stats.h"
+#include "net/cookies/canonical_cookie.h"
+#include "net/cookies/cookie_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Number of Update() calls timed by each run. It is even, so that every run
+// starts from the same cookies.
+const int kIterations = 100;
+
+// Returns |count| cookies named |name| with distinct paths, as a cookie store
+// holding many same-named cookies across a site would return them.
+std::vector<CanonicalCookie> MakeCookies(const GURL& url,
+                                         const std::string& name,
+                                         size_t count) {
+  std::vector<CanonicalCookie> cookies;
+  cookies.reserve(count);
+  for (size_t index = 0; index < count; ++index) {
+    cookies.push_back(CanonicalCookie(
+        name, "value" + base::NumberToString(index), url.host(),
+        "/path" + base::NumberToString(index), base::Time(), base::Time(),
+        base::Time(), false, false, net::CookieSameSite::DEFAULT_MODE,
+        net::COOKIE_PRIORITY_DEFAULT));
+  }
+  return cookies;
+}
+
+// Calls Update() |kIterations| times with the unchanged |cookies| and returns
+// the average time of a call in microseconds.
+double TimeUnchangedUpdates(CookieCache* cache,
+                            const GURL& url,
+                            const std::vector<CanonicalCookie>* cookies,
+                            int run) {
+  base::ElapsedTimer timer;
+  for (int iteration = 0; iteration < kIterations; ++iteration)
+    EXPECT_FALSE(cache->Update(url, "abc", *cookies, nullptr, nullptr));
+  return timer.Elapsed().InMicrosecondsF() / kIterations;
+}
+
+// Calls Update() |kIterations| times alternating between |changed_cookies|
+// and |cookies|, and returns the average time of a call in microseconds.
+double TimeChangedUpdates(CookieCache* cache,
+                          const GURL& url,
+                          const std::vector<CanonicalCookie>* cookies,
+                          const std::vector<CanonicalCookie>* changed_cookies,
+                          int run) {
+  std::vector<CanonicalCookie> removed;
+  std::vector<CanonicalCookie> added;
+  base::ElapsedTimer timer;
+  for (int iteration = 0; iteration < kIterations; ++iteration) {
+    removed.clear();
+    added.clear();
+    EXPECT_TRUE(cache->Update(url, "abc",
+                              iteration % 2 ? *cookies : *changed_cookies,
+                              &removed, &added));
+    EXPECT_EQ(1U, removed.size());
+    EXPECT_EQ(1U, added.size());
+  }
+  return timer.Elapsed().InMicrosecondsF() / kIterations;
+}
+
+// Measures Update() with |cookie_count| cookies when the set is unchanged and
+// when a single cookie changes value.
+void MeasureUpdate(size_t cookie_count) {
+  const GURL url("https://www.example.com/");
+  std::vector<CanonicalCookie> cookies = MakeCookies(url, "abc", cookie_count);
+  std::vector<CanonicalCookie> changed_cookies = cookies;
+  changed_cookies[cookie_count / 2] = CanonicalCookie(
+      "abc", "changed", url.host(), cookies[cookie_count / 2].Path(),
+      base::Time(), base::Time(), base::Time(), false, false,
+      net::CookieSameSite::DEFAULT_MODE, net::COOKIE_PRIORITY_DEFAULT);
+
+  CookieCache cache;
+  ASSERT_TRUE(cache.Update(url, "abc", cookies, nullptr, nullptr));
+
+  const std::string test = base::NumberToString(cookie_count) + " cookies";
+  ReportPerfResult(RepeatPerfRuns(
+      "cookie_cache_update", test + " unchanged", "us", PerfRunOptions(),
+      base::BindRepeating(&TimeUnchangedUpdates, &cache, url, &cookies)));
+  ReportPerfResult(RepeatPerfRuns(
+      "cookie_cache_update", test + " one changed", "us", PerfRunOptions(),
+      base::BindRepeating(&TimeChangedUpdates, &cache, url, &cookies,
+                          &changed_cookies)));
+}
+
+}  // namespace
+
+TEST(CookieCachePerfTest, Update1000Cookies) {
+  MeasureUpdate(1000);
+}
+
+TEST(CookieCachePerfTest, Update10000Cookies) {
+  MeasureUpdate(10000);
+}
+
+}  // namespace net
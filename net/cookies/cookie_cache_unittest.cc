@@ -4,6 +4,7 @@
 
 #include "ios/net/cookies/cookie_cache.h"
 
+#include "base/time/time.h"
 #include "net/cookies/canonical_cookie.h"
 #include "net/cookies/cookie_constants.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -111,6 +112,40 @@ TEST_F(CookieCacheTest, UpdateValueChanged) {
   EXPECT_EQ("ghi", changed[0].Value());
 }
 
+TEST_F(CookieCacheTest, UpdateExpiryChanged) {
+  CookieCache cache;
+  const GURL test_url("http://www.google.com");
+  std::vector<CanonicalCookie> cookies;
+  cookies.push_back(MakeCookie(test_url, "abc", "def"));
+  EXPECT_TRUE(cache.Update(test_url, "abc", cookies, nullptr, nullptr));
+
+  std::vector<net::CanonicalCookie> removed;
+  std::vector<net::CanonicalCookie> changed;
+  cookies[0] = CanonicalCookie(
+      "abc", "def", test_url.host(), test_url.path(), base::Time(),
+      base::Time() + base::TimeDelta::FromDays(1), base::Time(), false, false,
+      net::CookieSameSite::DEFAULT_MODE, net::COOKIE_PRIORITY_DEFAULT);
+  EXPECT_TRUE(cache.Update(test_url, "abc", cookies, &removed, &changed));
+  EXPECT_EQ(1U, removed.size());
+  EXPECT_EQ(1U, changed.size());
+  EXPECT_FALSE(cache.Update(test_url, "abc", cookies, nullptr, nullptr));
+}
+
+TEST_F(CookieCacheTest, UpdateKeepsFirstOfDuplicateCookies) {
+  CookieCache cache;
+  const GURL test_url("http://www.google.com");
+  std::vector<CanonicalCookie> cookies;
+  cookies.push_back(MakeCookie(test_url, "abc", "def"));
+  cookies.push_back(MakeCookie(test_url, "abc", "ghi"));
+  std::vector<net::CanonicalCookie> changed;
+  EXPECT_TRUE(cache.Update(test_url, "abc", cookies, nullptr, &changed));
+  ASSERT_EQ(1U, changed.size());
+  EXPECT_EQ("def", changed[0].Value());
+
+  cookies.pop_back();
+  EXPECT_FALSE(cache.Update(test_url, "abc", cookies, nullptr, nullptr));
+}
+
 TEST_F(CookieCacheTest, UpdateDeletedCookie) {
   CookieCache cache;
   const GURL test_url("http://www.google.com");
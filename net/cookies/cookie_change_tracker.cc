@@ -0,0 +1,83 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/cookies/cookie_change_tracker.h"
+
+#include <utility>
+
+namespace net {
+
+namespace {
+
+// Returns whether |lhs| and |rhs|, two cookies with the same identity, have
+// the same attributes. The last access date is ignored as reading a cookie
+// updates it.
+bool AreCookiesIdentical(const CanonicalCookie& lhs,
+                         const CanonicalCookie& rhs) {
+  return lhs.Value() == rhs.Value() &&
+         lhs.CreationDate() == rhs.CreationDate() &&
+         lhs.ExpiryDate() == rhs.ExpiryDate() &&
+         lhs.IsSecure() == rhs.IsSecure() &&
+         lhs.IsHttpOnly() == rhs.IsHttpOnly() &&
+         lhs.SameSite() == rhs.SameSite() &&
+         lhs.Priority() == rhs.Priority();
+}
+
+}  // namespace
+
+CookieChangeTracker::CookieChangeTracker() = default;
+
+CookieChangeTracker::~CookieChangeTracker() = default;
+
+CookieList CookieChangeTracker::Update(const CookieList& cookies,
+                                       const std::set<std::string>& names,
+                                       base::Time now) {
+  CookieMap new_cookies;
+  for (const auto& cookie : cookies) {
+    if (names.count(cookie.Name()) == 0 || cookie.IsExpired(now))
+      continue;
+    // Only the first of several cookies with the same identity is kept.
+    new_cookies.emplace(
+        CookieKey(cookie.Domain(), cookie.Name(), cookie.Path()), cookie);
+  }
+
+  // Both maps are sorted by identity, so they are diffed in one pass.
+  CookieList changed_cookies;
+  auto old_it = cookies_.begin();
+  auto new_it = new_cookies.begin();
+  while (old_it != cookies_.end() || new_it != new_cookies.end()) {
+    if (new_it == new_cookies.end() ||
+        (old_it != cookies_.end() && old_it->first < new_it->first)) {
+      changed_cookies.push_back(old_it->second);
+      ++old_it;
+    } else if (old_it == cookies_.end() || new_it->first < old_it->first) {
+      changed_cookies.push_back(new_it->second);
+      ++new_it;
+    } else {
+      if (!AreCookiesIdentical(old_it->second, new_it->second)) {
+        changed_cookies.push_back(old_it->second);
+        changed_cookies.push_back(new_it->second);
+      }
+      ++old_it;
+      ++new_it;
+    }
+  }
+
+  cookies_ = std::move(new_cookies);
+  return changed_cookies;
+}
+
+base::Time CookieChangeTracker::GetNextExpiryDate() const {
+  base::Time next_expiry_date;
+  for (const auto& entry : cookies_) {
+    const CanonicalCookie& cookie = entry.second;
+    if (!cookie.IsPersistent())
+      continue;
+    if (next_expiry_date.is_null() || cookie.ExpiryDate() < next_expiry_date)
+      next_expiry_date = cookie.ExpiryDate();
+  }
+  return next_expiry_date;
+}
+
+}  // namespace net
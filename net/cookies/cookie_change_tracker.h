@@ -0,0 +1,53 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_NET_COOKIES_COOKIE_CHANGE_TRACKER_H_
+#define IOS_NET_COOKIES_COOKIE_CHANGE_TRACKER_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "net/cookies/canonical_cookie.h"
+
+namespace net {
+
+// CookieChangeTracker keeps the unexpired cookies of one cookie source that
+// have one of a set of names, and computes which of them changed between two
+// fetches of all the cookies of the source. Cookies are identified by their
+// (domain, name, path) and two cookies with the same identity are equal only
+// if all their attributes are equal.
+class CookieChangeTracker {
+ public:
+  CookieChangeTracker();
+  ~CookieChangeTracker();
+
+  // Replaces the tracked cookies with the cookies of |cookies| that have a
+  // name in |names| and are not expired at |now|. Returns the previous and
+  // the new versions of the cookies that were added, removed or modified.
+  // Cookies that expired since the previous update are returned as removed.
+  CookieList Update(const CookieList& cookies,
+                    const std::set<std::string>& names,
+                    base::Time now);
+
+  // Returns the earliest expiry date of the tracked cookies, or a null time if
+  // none of them expires.
+  base::Time GetNextExpiryDate() const;
+
+ private:
+  // Cookies keyed by (domain, name, path).
+  using CookieKey = std::tuple<std::string, std::string, std::string>;
+  using CookieMap = std::map<CookieKey, CanonicalCookie>;
+
+  CookieMap cookies_;
+
+  DISALLOW_COPY_AND_ASSIGN(CookieChangeTracker);
+};
+
+}  // namespace net
+
+#endif  // IOS_NET_COOKIES_COOKIE_CHANGE_TRACKER_H_
@@ -0,0 +1,151 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/cookies/cookie_change_tracker.h"
+
+#include "base/time/time.h"
+#include "net/cookies/canonical_cookie.h"
+#include "net/cookies/cookie_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace net {
+
+namespace {
+
+const char kName[] = "abc";
+
+CanonicalCookie MakeCookie(const std::string& domain,
+                           const std::string& path,
+                           base::Time creation,
+                           base::Time expiration,
+                           bool httponly,
+                           CookieSameSite same_site) {
+  return CanonicalCookie(kName, "def", domain, path, creation, expiration,
+                         base::Time(), false, httponly, same_site,
+                         COOKIE_PRIORITY_DEFAULT);
+}
+
+CanonicalCookie MakeCookie(const std::string& domain, const std::string& path) {
+  return MakeCookie(domain, path, base::Time(), base::Time(), false,
+                    CookieSameSite::DEFAULT_MODE);
+}
+
+}  // namespace
+
+class CookieChangeTrackerTest : public PlatformTest {
+ protected:
+  CookieChangeTrackerTest() : names_({kName}), now_(base::Time::Now()) {}
+
+  // Updates |tracker_| with |cookies| and returns the changed cookies.
+  CookieList Update(const CookieList& cookies) {
+    return tracker_.Update(cookies, names_, now_);
+  }
+
+  CookieChangeTracker tracker_;
+  const std::set<std::string> names_;
+  const base::Time now_;
+};
+
+// Tests that the cookies are reported as added on the first update and that
+// nothing is reported when they do not change.
+TEST_F(CookieChangeTrackerTest, AddedCookies) {
+  CookieList cookies = {MakeCookie("a.com", "/")};
+  CookieList changed = Update(cookies);
+  ASSERT_EQ(1U, changed.size());
+  EXPECT_EQ("a.com", changed[0].Domain());
+  EXPECT_TRUE(Update(cookies).empty());
+}
+
+// Tests that cookies with other names are ignored.
+TEST_F(CookieChangeTrackerTest, UntrackedNames) {
+  CanonicalCookie cookie("other", "def", "a.com", "/", base::Time(),
+                         base::Time(), base::Time(), false, false,
+                         CookieSameSite::DEFAULT_MODE, COOKIE_PRIORITY_DEFAULT);
+  EXPECT_TRUE(Update({cookie}).empty());
+}
+
+// Tests that cookies with the same name on different domains or paths are
+// tracked separately.
+TEST_F(CookieChangeTrackerTest, SameNameOnDifferentDomainsAndPaths) {
+  Update({MakeCookie("a.com", "/"), MakeCookie("b.com", "/")});
+
+  CookieList changed = Update({MakeCookie("a.com", "/"),
+                               MakeCookie("a.com", "/foo"),
+                               MakeCookie("b.com", "/")});
+  ASSERT_EQ(1U, changed.size());
+  EXPECT_EQ("a.com", changed[0].Domain());
+  EXPECT_EQ("/foo", changed[0].Path());
+
+  changed = Update({MakeCookie("a.com", "/"), MakeCookie("a.com", "/foo")});
+  ASSERT_EQ(1U, changed.size());
+  EXPECT_EQ("b.com", changed[0].Domain());
+}
+
+// Tests that a change of the HttpOnly attribute is reported.
+TEST_F(CookieChangeTrackerTest, HttpOnlyChange) {
+  Update({MakeCookie("a.com", "/")});
+  CookieList changed =
+      Update({MakeCookie("a.com", "/", base::Time(), base::Time(),
+                         /*httponly=*/true, CookieSameSite::DEFAULT_MODE)});
+  ASSERT_EQ(2U, changed.size());
+  EXPECT_FALSE(changed[0].IsHttpOnly());
+  EXPECT_TRUE(changed[1].IsHttpOnly());
+}
+
+// Tests that a change of the SameSite attribute is reported.
+TEST_F(CookieChangeTrackerTest, SameSiteChange) {
+  Update({MakeCookie("a.com", "/")});
+  CookieList changed =
+      Update({MakeCookie("a.com", "/", base::Time(), base::Time(), false,
+                         CookieSameSite::STRICT_MODE)});
+  ASSERT_EQ(2U, changed.size());
+  EXPECT_EQ(CookieSameSite::STRICT_MODE, changed[1].SameSite());
+}
+
+// Tests that a cookie set again with the same attributes is reported, as its
+// creation time changes.
+TEST_F(CookieChangeTrackerTest, CreationTimeChange) {
+  Update({MakeCookie("a.com", "/", now_ - base::TimeDelta::FromMinutes(1),
+                     base::Time(), false, CookieSameSite::DEFAULT_MODE)});
+  CookieList changed =
+      Update({MakeCookie("a.com", "/", now_, base::Time(), false,
+                         CookieSameSite::DEFAULT_MODE)});
+  ASSERT_EQ(2U, changed.size());
+  EXPECT_EQ(now_, changed[1].CreationDate());
+}
+
+// Tests that a cookie that expired since the previous update is reported as
+// removed, even if the source still returns it.
+TEST_F(CookieChangeTrackerTest, ExpiredCookie) {
+  base::Time expiration = now_ + base::TimeDelta::FromMinutes(1);
+  CookieList cookies = {MakeCookie("a.com", "/", base::Time(), expiration,
+                                   false, CookieSameSite::DEFAULT_MODE)};
+  EXPECT_EQ(1U, tracker_.Update(cookies, names_, now_).size());
+
+  CookieList changed = tracker_.Update(cookies, names_, expiration);
+  ASSERT_EQ(1U, changed.size());
+  EXPECT_EQ(expiration, changed[0].ExpiryDate());
+  EXPECT_TRUE(tracker_.Update(cookies, names_, expiration).empty());
+}
+
+// Tests that the next expiry date is the earliest expiry date of the
+// persistent cookies.
+TEST_F(CookieChangeTrackerTest, GetNextExpiryDate) {
+  EXPECT_TRUE(tracker_.GetNextExpiryDate().is_null());
+
+  Update({MakeCookie("a.com", "/")});
+  EXPECT_TRUE(tracker_.GetNextExpiryDate().is_null());
+
+  base::Time expiration = now_ + base::TimeDelta::FromMinutes(1);
+  Update({MakeCookie("a.com", "/"),
+          MakeCookie("b.com", "/", base::Time(),
+                     now_ + base::TimeDelta::FromHours(1), false,
+                     CookieSameSite::DEFAULT_MODE),
+          MakeCookie("c.com", "/", base::Time(), expiration, false,
+                     CookieSameSite::DEFAULT_MODE)});
+  EXPECT_EQ(expiration, tracker_.GetNextExpiryDate());
+}
+
+}  // namespace net
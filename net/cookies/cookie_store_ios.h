@@ -9,6 +9,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -20,7 +21,9 @@
 #include "base/memory/weak_ptr.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "ios/net/cookies/cookie_cache.h"
+#include "ios/net/cookies/cookie_change_tracker.h"
 #import "ios/net/cookies/system_cookie_store.h"
 #include "net/cookies/cookie_change_dispatcher.h"
 #include "net/cookies/cookie_monster.h"
@@ -238,6 +241,31 @@ class CookieStoreIOS : public net::CookieStore,
                               const std::vector<net::CanonicalCookie>& cookies,
                               net::CookieChangeCause cause);
 
+  // Returns the names that have hooks registered.
+  std::set<std::string> GetHookedNames() const;
+
+  // Returns the (url, name) pairs with hooks registered that may be affected
+  // by |changed_cookies|, i.e. whose name is the name of a changed cookie and
+  // whose host matches its domain.
+  std::vector<std::pair<GURL, std::string>> GetHooksAffectedByCookies(
+      const net::CookieList& changed_cookies) const;
+
+  // Restarts |timer| to run |update| when the first cookie tracked by
+  // |tracker| expires, as the stores do not notify expirations.
+  void ScheduleUpdateOnExpiry(const CookieChangeTracker& tracker,
+                              base::OneShotTimer* timer,
+                              void (CookieStoreIOS::*update)());
+
+  // Fetches all the system cookies to update the hooks affected by the
+  // changes since the previous fetch.
+  void UpdateCachesFromSystemStore();
+
+  // Called when the system store returns all its cookies. Updates the cookie
+  // cache of the hooks affected by the changes, querying the system store for
+  // each of them, so a change costs one pass over the cookies plus one query
+  // per affected hook rather than one query per hook.
+  void UpdateCachesFromSystemCookies(NSArray<NSHTTPCookie*>* nscookies);
+
   // Called by this CookieStoreIOS' internal CookieMonster instance when
   // GetAllCookiesForURLAsync() completes. Updates the cookie cache and runs
   // callbacks if the cache changed.
@@ -245,7 +273,15 @@ class CookieStoreIOS : public net::CookieStore,
                         const net::CookieList& cookies,
                         const net::CookieStatusList& excluded_cookies);
 
-  // Fetches new values for all (url, name) pairs that have hooks registered,
+  // Called by this CookieStoreIOS' internal CookieMonster instance when
+  // GetAllCookiesAsync() completes. Fetches new values for the hooks affected
+  // by the changes since the previous call.
+  void GotAllCookiesFromCookieMonster(
+      const net::CookieList& cookies,
+      const net::CookieStatusList& excluded_cookies);
+
+  // Fetches new values for all (url, name) pairs that have hooks registered
+  // and may be affected by the changes since the previous call,
   // asynchronously invoking callbacks if necessary.
   void UpdateCachesFromCookieMonster();
 
@@ -289,6 +325,15 @@ class CookieStoreIOS : public net::CookieStore,
            std::unique_ptr<CookieChangeCallbackList>>
       hook_map_;
 
+  // The cookies of the hooked names of the system store and of the
+  // CookieMonster, as of their last fetch, and the timers updating the caches
+  // when they expire. Each source has its own state, as they hold different
+  // cookies.
+  CookieChangeTracker system_cookie_tracker_;
+  base::OneShotTimer system_expiry_timer_;
+  CookieChangeTracker cookie_monster_tracker_;
+  base::OneShotTimer cookie_monster_expiry_timer_;
+
   base::LinkedList<Subscription> all_subscriptions_;
 
   CookieChangeDispatcherIOS change_dispatcher_;
@@ -7,6 +7,9 @@
 #import <Foundation/Foundation.h>
 #include <stddef.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "base/bind.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
@@ -594,11 +597,7 @@ void CookieStoreIOS::DeleteCookiesMatchingPredicateAsync(
 void CookieStoreIOS::OnSystemCookiesChanged() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
-  for (const auto& hook_map_entry : hook_map_) {
-    std::pair<GURL, std::string> key = hook_map_entry.first;
-    UpdateCacheForCookieFromSystem(key.first, key.second,
-                                   /*run_callbacks=*/true);
-  }
+  UpdateCachesFromSystemStore();
 
   // Do not schedule a flush if one is already scheduled.
   if (!flush_closure_.IsCancelled())
@@ -692,6 +691,76 @@ void CookieStoreIOS::RunCallbacksForCookies(
   }
 }
 
+std::set<std::string> CookieStoreIOS::GetHookedNames() const {
+  std::set<std::string> names;
+  for (const auto& hook_map_entry : hook_map_)
+    names.insert(hook_map_entry.first.second);
+  return names;
+}
+
+std::vector<std::pair<GURL, std::string>>
+CookieStoreIOS::GetHooksAffectedByCookies(
+    const net::CookieList& changed_cookies) const {
+  std::vector<std::pair<GURL, std::string>> affected_hooks;
+  for (const auto& hook_map_entry : hook_map_) {
+    const GURL& gurl = hook_map_entry.first.first;
+    const std::string& name = hook_map_entry.first.second;
+    for (const auto& cookie : changed_cookies) {
+      if (cookie.Name() == name && cookie.IsDomainMatch(gurl.host())) {
+        affected_hooks.push_back(hook_map_entry.first);
+        break;
+      }
+    }
+  }
+  return affected_hooks;
+}
+
+void CookieStoreIOS::ScheduleUpdateOnExpiry(
+    const CookieChangeTracker& tracker,
+    base::OneShotTimer* timer,
+    void (CookieStoreIOS::*update)()) {
+  timer->Stop();
+  base::Time next_expiry_date = tracker.GetNextExpiryDate();
+  if (next_expiry_date.is_null())
+    return;
+  base::TimeDelta delay =
+      std::max(next_expiry_date - base::Time::Now(), base::TimeDelta());
+  timer->Start(FROM_HERE, delay, this, update);
+}
+
+void CookieStoreIOS::UpdateCachesFromSystemStore() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  if (hook_map_.empty())
+    return;
+  system_store_->GetAllCookiesAsync(
+      base::BindOnce(&CookieStoreIOS::UpdateCachesFromSystemCookies,
+                     weak_factory_.GetWeakPtr()));
+}
+
+void CookieStoreIOS::UpdateCachesFromSystemCookies(
+    NSArray<NSHTTPCookie*>* nscookies) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  std::set<std::string> names = GetHookedNames();
+  net::CookieList cookies;
+  for (NSHTTPCookie* nscookie in nscookies) {
+    if (names.count(base::SysNSStringToUTF8(nscookie.name)) == 0)
+      continue;
+    cookies.push_back(CanonicalCookieFromSystemCookie(
+        nscookie, system_store_->GetCookieCreationTime(nscookie)));
+  }
+  net::CookieList changed_cookies =
+      system_cookie_tracker_.Update(cookies, names, base::Time::Now());
+  ScheduleUpdateOnExpiry(system_cookie_tracker_, &system_expiry_timer_,
+                         &CookieStoreIOS::UpdateCachesFromSystemStore);
+
+  // The affected hooks are updated with the cookies the system store would
+  // send with their URL.
+  for (const auto& key : GetHooksAffectedByCookies(changed_cookies)) {
+    UpdateCacheForCookieFromSystem(key.first, key.second,
+                                   /*run_callbacks=*/true);
+  }
+}
+
 void CookieStoreIOS::GotCookieListFor(
     const std::pair<GURL, std::string> key,
     const net::CookieList& cookies,
@@ -711,16 +780,34 @@ void CookieStoreIOS::GotCookieListFor(
   }
 }
 
-void CookieStoreIOS::UpdateCachesFromCookieMonster() {
+void CookieStoreIOS::GotAllCookiesFromCookieMonster(
+    const net::CookieList& cookies,
+    const net::CookieStatusList& excluded_cookies) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
-  for (const auto& hook_map_entry : hook_map_) {
-    std::pair<GURL, std::string> key = hook_map_entry.first;
-    GetCookieListCallback callback = base::BindOnce(
-        &CookieStoreIOS::GotCookieListFor, weak_factory_.GetWeakPtr(), key);
-    cookie_monster_->GetAllCookiesForURLAsync(key.first, std::move(callback));
+  net::CookieList changed_cookies = cookie_monster_tracker_.Update(
+      cookies, GetHookedNames(), base::Time::Now());
+  ScheduleUpdateOnExpiry(cookie_monster_tracker_,
+                         &cookie_monster_expiry_timer_,
+                         &CookieStoreIOS::UpdateCachesFromCookieMonster);
+
+  // The affected hooks are updated with the cookies the CookieMonster would
+  // send with their URL.
+  for (const auto& key : GetHooksAffectedByCookies(changed_cookies)) {
+    cookie_monster_->GetAllCookiesForURLAsync(
+        key.first, base::BindOnce(&CookieStoreIOS::GotCookieListFor,
+                                  weak_factory_.GetWeakPtr(), key));
   }
 }
 
+void CookieStoreIOS::UpdateCachesFromCookieMonster() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  if (hook_map_.empty())
+    return;
+  cookie_monster_->GetAllCookiesAsync(
+      base::BindOnce(&CookieStoreIOS::GotAllCookiesFromCookieMonster,
+                     weak_factory_.GetWeakPtr()));
+}
+
 void CookieStoreIOS::UpdateCachesAfterSet(SetCookiesCallback callback,
                                           bool success) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
@@ -0,0 +1,227 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/net/cookies/cookie_store_ios.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#import "ios/net/cookies/cookie_store_ios_test_util.h"
+#import "ios/net/cookies/in_memory_system_cookie_store.h"
+#include "net/cookies/canonical_cookie.h"
+#include "net/cookies/cookie_options.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "testing/platform_test.h"
+#include "url/gurl.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace net {
+
+namespace {
+
+// Switch naming a file of recorded cookie traffic to replay. Each line is
+// either "set <url> <cookie line>" or "get <url>"; empty lines and lines
+// starting with '#' are ignored. Synthetic traffic is used when the switch is
+// absent.
+const char kTrafficFileSwitch[] = "cookie-traffic-file";
+
+// Switch setting the latency of the in-memory system store, in milliseconds.
+const char kStoreLatencySwitch[] = "cookie-store-latency-ms";
+
+// Number of change observers registered on the store, like the sign-in and
+// sync observers of a signed-in profile.
+const size_t kObserverCount = 24;
+
+// Number of operations of the synthetic traffic.
+const size_t kSyntheticOperationCount = 4000;
+
+struct CookieOperation {
+  bool is_set;
+  GURL url;
+  std::string cookie_line;
+};
+
+std::vector<CookieOperation> BuildSyntheticTraffic() {
+  std::vector<CookieOperation> operations;
+  for (size_t index = 0; index < kSyntheticOperationCount; ++index) {
+    GURL url(base::StringPrintf("https://www%zu.example%zu.com/path%zu",
+                                index % 3, index % 16, index % 5));
+    // Roughly one write for every three reads, as seen while browsing.
+    if (index % 4 == 0) {
+      operations.push_back(
+          {true, url,
+           base::StringPrintf("cookie%zu=value%zu; path=/", index % 40,
+                              index)});
+    } else {
+      operations.push_back({false, url, std::string()});
+    }
+  }
+  return operations;
+}
+
+std::vector<CookieOperation> LoadTraffic() {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  if (!command_line->HasSwitch(kTrafficFileSwitch))
+    return BuildSyntheticTraffic();
+
+  std::string contents;
+  EXPECT_TRUE(base::ReadFileToString(
+      command_line->GetSwitchValuePath(kTrafficFileSwitch), &contents));
+  std::vector<CookieOperation> operations;
+  for (const std::string& line :
+       base::SplitString(contents, "\n", base::TRIM_WHITESPACE,
+                         base::SPLIT_WANT_NONEMPTY)) {
+    if (line[0] == '#')
+      continue;
+    size_t url_start = line.find(' ');
+    size_t url_end = url_start == std::string::npos
+                         ? std::string::npos
+                         : line.find(' ', url_start + 1);
+    std::string verb = line.substr(0, url_start);
+    if (verb == "set" && url_end != std::string::npos) {
+      operations.push_back(
+          {true, GURL(line.substr(url_start + 1, url_end - url_start - 1)),
+           line.substr(url_end + 1)});
+    } else if (verb == "get" && url_start != std::string::npos &&
+               url_end == std::string::npos) {
+      operations.push_back(
+          {false, GURL(line.substr(url_start + 1)), std::string()});
+    } else {
+      ADD_FAILURE() << "Invalid traffic line: " << line;
+    }
+  }
+  return operations;
+}
+
+// Returns the |percentile|th percentile of |samples|, which must be sorted.
+double Percentile(const std::vector<double>& samples, int percentile) {
+  if (samples.empty())
+    return 0;
+  size_t index = (samples.size() - 1) * percentile / 100;
+  return samples[index];
+}
+
+void ReportLatencies(const std::string& operation,
+                     std::vector<double> latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  for (int percentile : {50, 90, 99}) {
+    perf_test::PrintResult("cookie_store_ios", "_" + operation,
+                           base::StringPrintf("p%d", percentile),
+                           Percentile(latencies, percentile), "us",
+                           percentile == 50 /* important */);
+  }
+}
+
+}  // namespace
+
+class CookieStoreIOSPerfTest : public PlatformTest {
+ protected:
+  CookieStoreIOSPerfTest()
+      : scoped_cookie_store_ios_client_(
+            std::make_unique<TestCookieStoreIOSClient>()) {
+    InMemorySystemCookieStore::Options options;
+    int latency_ms = 0;
+    const base::CommandLine* command_line =
+        base::CommandLine::ForCurrentProcess();
+    if (command_line->HasSwitch(kStoreLatencySwitch)) {
+      EXPECT_TRUE(base::StringToInt(
+          command_line->GetSwitchValueASCII(kStoreLatencySwitch),
+          &latency_ms));
+    }
+    options.latency = base::TimeDelta::FromMilliseconds(latency_ms);
+    options.changes_callback =
+        base::BindRepeating(&CookieStoreIOS::NotifySystemCookiesChanged);
+    store_ = std::make_unique<CookieStoreIOS>(
+        std::make_unique<InMemorySystemCookieStore>(options),
+        nullptr /* net_log */);
+  }
+
+  // Runs |operation| and returns its latency in microseconds, from the call
+  // to the completion callback.
+  double RunOperation(const CookieOperation& operation) {
+    CookieOptions options;
+    options.set_include_httponly();
+    base::RunLoop run_loop;
+    base::ElapsedTimer timer;
+    if (operation.is_set) {
+      store_->SetCookieWithOptionsAsync(
+          operation.url, operation.cookie_line, options,
+          base::BindOnce([](base::OnceClosure quit,
+                            bool success) { std::move(quit).Run(); },
+                         run_loop.QuitClosure()));
+    } else {
+      store_->GetCookieListWithOptionsAsync(
+          operation.url, options,
+          base::BindOnce(
+              [](base::OnceClosure quit, const CookieList& cookies,
+                 const CookieStatusList& excluded_cookies) {
+                std::move(quit).Run();
+              },
+              run_loop.QuitClosure()));
+    }
+    run_loop.Run();
+    return timer.Elapsed().InMicrosecondsF();
+  }
+
+  base::MessageLoop loop_;
+  ScopedTestingCookieStoreIOSClient scoped_cookie_store_ios_client_;
+  std::unique_ptr<CookieStoreIOS> store_;
+};
+
+// Replays the traffic through CookieStoreIOS backed by an in-memory system
+// store, with change observers registered, and reports the latency
+// percentiles of each operation and the time spent dispatching changes.
+TEST_F(CookieStoreIOSPerfTest, ReplayTraffic) {
+  std::vector<CookieOperation> operations = LoadTraffic();
+  ASSERT_FALSE(operations.empty());
+
+  std::vector<std::unique_ptr<CookieChangeSubscription>> subscriptions;
+  for (size_t index = 0; index < kObserverCount; ++index) {
+    subscriptions.push_back(store_->GetChangeDispatcher().AddCallbackForCookie(
+        operations[index % operations.size()].url,
+        base::StringPrintf("cookie%zu", index),
+        base::BindRepeating(
+            [](const CanonicalCookie& cookie, CookieChangeCause cause) {})));
+  }
+  base::RunLoop().RunUntilIdle();
+
+  std::vector<double> set_latencies;
+  std::vector<double> get_latencies;
+  std::vector<double> dispatch_latencies;
+  for (const CookieOperation& operation : operations) {
+    double latency = RunOperation(operation);
+    (operation.is_set ? set_latencies : get_latencies).push_back(latency);
+
+    // Let the change notification and the observers run.
+    base::ElapsedTimer dispatch_timer;
+    base::RunLoop().RunUntilIdle();
+    if (operation.is_set)
+      dispatch_latencies.push_back(dispatch_timer.Elapsed().InMicrosecondsF());
+  }
+
+  ReportLatencies("set", std::move(set_latencies));
+  ReportLatencies("get", std::move(get_latencies));
+  ReportLatencies("change_dispatch", std::move(dispatch_latencies));
+}
+
+}  // namespace net
@@ -485,6 +485,32 @@ TEST_F(CookieStoreIOSTest, MultipleNotifies) {
   DeleteSystemCookie(kTestCookieURLBarBar, "abc");
 }
 
+// Tests that hooks are not run for changes to cookies of another domain, and
+// still run for their own domain after such a change.
+TEST_F(CookieStoreIOSTest, NoNotifyOnOtherDomainChange) {
+  std::vector<net::CanonicalCookie> cookies;
+  std::vector<net::CanonicalCookie> other_cookies;
+  std::unique_ptr<net::CookieChangeSubscription> handle =
+      store_->GetChangeDispatcher().AddCallbackForCookie(
+          kTestCookieURLFooBar, "abc",
+          base::Bind(&RecordCookieChanges, &cookies, nullptr));
+  std::unique_ptr<net::CookieChangeSubscription> other_handle =
+      store_->GetChangeDispatcher().AddCallbackForCookie(
+          kTestCookieURLBarBar, "abc",
+          base::Bind(&RecordCookieChanges, &other_cookies, nullptr));
+  SetSystemCookie(kTestCookieURLBarBar, "abc", "def");
+  EXPECT_EQ(0U, cookies.size());
+  EXPECT_EQ(1U, other_cookies.size());
+  SetSystemCookie(kTestCookieURLBarBar, "abc", "ghi");
+  EXPECT_EQ(0U, cookies.size());
+  EXPECT_EQ(3U, other_cookies.size());
+  SetSystemCookie(kTestCookieURLFooBar, "abc", "def");
+  EXPECT_EQ(1U, cookies.size());
+  EXPECT_EQ(3U, other_cookies.size());
+  DeleteSystemCookie(kTestCookieURLFooBar, "abc");
+  DeleteSystemCookie(kTestCookieURLBarBar, "abc");
+}
+
 TEST_F(CookieStoreIOSTest, LessSpecificNestedCookie) {
   std::vector<net::CanonicalCookie> cookies;
   SetSystemCookie(kTestCookieURLFooBaz, "abc", "def");
@@ -0,0 +1,105 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_NET_COOKIES_IN_MEMORY_SYSTEM_COOKIE_STORE_H_
+#define IOS_NET_COOKIES_IN_MEMORY_SYSTEM_COOKIE_STORE_H_
+
+#import <Foundation/Foundation.h>
+
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#import "ios/net/cookies/system_cookie_store.h"
+
+namespace net {
+
+// SystemCookieStore keeping its cookies in a C++ map instead of a system
+// store, so the CookieStoreIOS synchronization paths can be exercised and
+// profiled without NSHTTPCookieStorage or WKHTTPCookieStore. URL matching
+// follows NSHTTPCookieStorage, including treating the cookie path as a plain
+// prefix of the URL path.
+//
+// Callbacks run on the CookieStoreIOSClient task runner after the configured
+// latency, and changes are reported in batches to mimic how the system stores
+// deliver their change notifications.
+class InMemorySystemCookieStore : public SystemCookieStore {
+ public:
+  struct Options {
+    Options();
+    Options(const Options& other);
+    ~Options();
+
+    // Delay before the callback of each operation runs.
+    base::TimeDelta latency;
+
+    // Changes made within this window after a first change are reported with
+    // a single call to |changes_callback|.
+    base::TimeDelta notification_batching_window;
+
+    // Called after the cookies changed, e.g.
+    // CookieStoreIOS::NotifySystemCookiesChanged. May be null.
+    base::RepeatingClosure changes_callback;
+  };
+
+  InMemorySystemCookieStore();
+  explicit InMemorySystemCookieStore(const Options& options);
+  ~InMemorySystemCookieStore() override;
+
+  void set_cookie_accept_policy(NSHTTPCookieAcceptPolicy policy) {
+    cookie_accept_policy_ = policy;
+  }
+
+  // Returns the number of cookies in the store, including expired cookies
+  // that have not been purged yet.
+  size_t cookie_count() const { return cookies_.size(); }
+
+  using SystemCookieStore::SetCookieAsync;
+
+  // SystemCookieStore implementation.
+  void GetCookiesForURLAsync(const GURL& url,
+                             SystemCookieCallbackForCookies callback) override;
+  void GetAllCookiesAsync(SystemCookieCallbackForCookies callback) override;
+  void DeleteCookieAsync(NSHTTPCookie* cookie,
+                         SystemCookieCallback callback) override;
+  void SetCookieAsync(NSHTTPCookie* cookie,
+                      const base::Time* optional_creation_time,
+                      SystemCookieCallback callback) override;
+  void ClearStoreAsync(SystemCookieCallback callback) override;
+  NSHTTPCookieAcceptPolicy GetCookieAcceptPolicy() override;
+
+ private:
+  // Cookies are unique by (domain, path, name).
+  using CookieKey = std::tuple<std::string, std::string, std::string>;
+
+  static CookieKey KeyForCookie(NSHTTPCookie* cookie);
+
+  // Returns the unexpired cookies, sorted as per RFC6265. If |url| is not
+  // null, only returns the cookies that would be sent with a request for it.
+  NSArray<NSHTTPCookie*>* GetSortedCookies(const GURL* url);
+
+  // Posts |callback| with the configured latency.
+  void RunCallback(base::OnceClosure callback);
+
+  // Schedules a change notification unless one is already pending.
+  void OnCookiesChanged();
+  void NotifyCookiesChanged();
+
+  const Options options_;
+  NSHTTPCookieAcceptPolicy cookie_accept_policy_;
+  std::map<CookieKey, NSHTTPCookie*> cookies_;
+  bool notification_pending_;
+
+  base::WeakPtrFactory<InMemorySystemCookieStore> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(InMemorySystemCookieStore);
+};
+
+}  // namespace net
+
+#endif  // IOS_NET_COOKIES_IN_MEMORY_SYSTEM_COOKIE_STORE_H_
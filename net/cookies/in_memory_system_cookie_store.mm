@@ -0,0 +1,178 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/net/cookies/in_memory_system_cookie_store.h"
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/strings/string_util.h"
+#include "base/strings/sys_string_conversions.h"
+#import "ios/net/cookies/cookie_creation_time_manager.h"
+#import "ios/net/cookies/cookie_store_ios_client.h"
+#include "url/gurl.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace net {
+
+namespace {
+
+// Returns whether |cookie| would be sent with a request for |url|, following
+// NSHTTPCookieStorage: the cookie domain matches the host or one of its
+// parent domains, and the cookie path is a prefix of the URL path.
+bool IsCookieSentWithURL(NSHTTPCookie* cookie, const GURL& url) {
+  std::string domain = base::SysNSStringToUTF8(cookie.domain);
+  if (!domain.empty() && domain[0] == '.')
+    domain.erase(0, 1);
+  const std::string host = url.host();
+  if (host != domain &&
+      !base::EndsWith(host, "." + domain, base::CompareCase::SENSITIVE)) {
+    return false;
+  }
+  if (!base::StartsWith(url.path(), base::SysNSStringToUTF8(cookie.path),
+                        base::CompareCase::SENSITIVE)) {
+    return false;
+  }
+  return !cookie.secure || url.SchemeIsCryptographic();
+}
+
+bool IsCookieExpired(NSHTTPCookie* cookie, NSDate* now) {
+  return cookie.expiresDate &&
+         [cookie.expiresDate compare:now] != NSOrderedDescending;
+}
+
+}  // namespace
+
+InMemorySystemCookieStore::Options::Options() = default;
+
+InMemorySystemCookieStore::Options::Options(const Options& other) = default;
+
+InMemorySystemCookieStore::Options::~Options() = default;
+
+InMemorySystemCookieStore::InMemorySystemCookieStore()
+    : InMemorySystemCookieStore(Options()) {}
+
+InMemorySystemCookieStore::InMemorySystemCookieStore(const Options& options)
+    : options_(options),
+      cookie_accept_policy_(NSHTTPCookieAcceptPolicyAlways),
+      notification_pending_(false),
+      weak_factory_(this) {}
+
+InMemorySystemCookieStore::~InMemorySystemCookieStore() = default;
+
+#pragma mark -
+#pragma mark SystemCookieStore methods
+
+void InMemorySystemCookieStore::GetCookiesForURLAsync(
+    const GURL& url,
+    SystemCookieCallbackForCookies callback) {
+  RunCallback(base::BindOnce(std::move(callback), GetSortedCookies(&url)));
+}
+
+void InMemorySystemCookieStore::GetAllCookiesAsync(
+    SystemCookieCallbackForCookies callback) {
+  RunCallback(base::BindOnce(std::move(callback), GetSortedCookies(nullptr)));
+}
+
+void InMemorySystemCookieStore::DeleteCookieAsync(
+    NSHTTPCookie* cookie,
+    SystemCookieCallback callback) {
+  auto it = cookies_.find(KeyForCookie(cookie));
+  if (it != cookies_.end()) {
+    creation_time_manager_->DeleteCreationTime(it->second);
+    cookies_.erase(it);
+    OnCookiesChanged();
+  }
+  RunCallback(std::move(callback));
+}
+
+void InMemorySystemCookieStore::SetCookieAsync(
+    NSHTTPCookie* cookie,
+    const base::Time* optional_creation_time,
+    SystemCookieCallback callback) {
+  if (cookie_accept_policy_ != NSHTTPCookieAcceptPolicyNever) {
+    NSHTTPCookie*& stored_cookie = cookies_[KeyForCookie(cookie)];
+    if (stored_cookie)
+      creation_time_manager_->DeleteCreationTime(stored_cookie);
+    stored_cookie = cookie;
+
+    base::Time cookie_time = base::Time::Now();
+    if (optional_creation_time && !optional_creation_time->is_null())
+      cookie_time = *optional_creation_time;
+    creation_time_manager_->SetCreationTime(
+        cookie, creation_time_manager_->MakeUniqueCreationTime(cookie_time));
+    OnCookiesChanged();
+  }
+  RunCallback(std::move(callback));
+}
+
+void InMemorySystemCookieStore::ClearStoreAsync(SystemCookieCallback callback) {
+  if (!cookies_.empty()) {
+    cookies_.clear();
+    creation_time_manager_->Clear();
+    OnCookiesChanged();
+  }
+  RunCallback(std::move(callback));
+}
+
+NSHTTPCookieAcceptPolicy InMemorySystemCookieStore::GetCookieAcceptPolicy() {
+  return cookie_accept_policy_;
+}
+
+#pragma mark private methods
+
+// static
+InMemorySystemCookieStore::CookieKey InMemorySystemCookieStore::KeyForCookie(
+    NSHTTPCookie* cookie) {
+  return CookieKey(base::SysNSStringToUTF8(cookie.domain),
+                   base::SysNSStringToUTF8(cookie.path),
+                   base::SysNSStringToUTF8(cookie.name));
+}
+
+NSArray<NSHTTPCookie*>* InMemorySystemCookieStore::GetSortedCookies(
+    const GURL* url) {
+  NSDate* now = [NSDate date];
+  NSMutableArray<NSHTTPCookie*>* cookies = [NSMutableArray array];
+  for (auto it = cookies_.begin(); it != cookies_.end();) {
+    NSHTTPCookie* cookie = it->second;
+    // Expired cookies are purged lazily, as the system stores do.
+    if (IsCookieExpired(cookie, now)) {
+      creation_time_manager_->DeleteCreationTime(cookie);
+      it = cookies_.erase(it);
+      continue;
+    }
+    if (!url || IsCookieSentWithURL(cookie, *url))
+      [cookies addObject:cookie];
+    ++it;
+  }
+  return [cookies sortedArrayUsingFunction:CompareCookies
+                                   context:creation_time_manager_.get()];
+}
+
+void InMemorySystemCookieStore::RunCallback(base::OnceClosure callback) {
+  if (callback.is_null())
+    return;
+  GetCookieStoreIOSClient()->GetTaskRunner()->PostDelayedTask(
+      FROM_HERE, std::move(callback), options_.latency);
+}
+
+void InMemorySystemCookieStore::OnCookiesChanged() {
+  if (options_.changes_callback.is_null() || notification_pending_)
+    return;
+  notification_pending_ = true;
+  GetCookieStoreIOSClient()->GetTaskRunner()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&InMemorySystemCookieStore::NotifyCookiesChanged,
+                     weak_factory_.GetWeakPtr()),
+      options_.notification_batching_window);
+}
+
+void InMemorySystemCookieStore::NotifyCookiesChanged() {
+  notification_pending_ = false;
+  options_.changes_callback.Run();
+}
+
+}  // namespace net
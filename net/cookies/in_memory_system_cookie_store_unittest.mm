@@ -0,0 +1,159 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/net/cookies/in_memory_system_cookie_store.h"
+
+#import <Foundation/Foundation.h>
+
+#include <memory>
+
+#include "base/bind.h"
+#include "base/run_loop.h"
+#include "base/test/scoped_task_environment.h"
+#include "ios/net/cookies/system_cookie_store_unittest_template.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace net {
+
+// Test class that conforms to SystemCookieStoreTestDelegate to exercise
+// InMemorySystemCookieStore.
+class InMemorySystemCookieStoreTestDelegate {
+ public:
+  InMemorySystemCookieStoreTestDelegate()
+      : scoped_cookie_store_ios_client_(
+            std::make_unique<TestCookieStoreIOSClient>()),
+        store_(std::make_unique<InMemorySystemCookieStore>()) {
+    // Like the system stores, start with the policy of the shared storage.
+    store_->set_cookie_accept_policy(
+        [NSHTTPCookieStorage sharedHTTPCookieStorage].cookieAcceptPolicy);
+  }
+
+  bool IsTestEnabled() { return true; }
+
+  bool IsCookieSet(NSHTTPCookie* system_cookie, NSURL* url) {
+    __block NSHTTPCookie* result_cookie = nil;
+    store_->GetCookiesForURLAsync(
+        GURLWithNSURL(url),
+        base::BindOnce(^(NSArray<NSHTTPCookie*>* cookies) {
+          for (NSHTTPCookie* cookie in cookies) {
+            if ([cookie.name isEqualToString:system_cookie.name]) {
+              result_cookie = cookie;
+              break;
+            }
+          }
+        }));
+    base::RunLoop().RunUntilIdle();
+    return [result_cookie.value isEqualToString:system_cookie.value];
+  }
+
+  void ClearCookies() {
+    store_->ClearStoreAsync(SystemCookieStore::SystemCookieCallback());
+    EXPECT_EQ(0u, store_->cookie_count());
+  }
+
+  int CookiesCount() { return store_->cookie_count(); }
+
+  void SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicy policy) {
+    store_->set_cookie_accept_policy(policy);
+  }
+
+  SystemCookieStore* GetCookieStore() { return store_.get(); }
+
+ private:
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  ScopedTestingCookieStoreIOSClient scoped_cookie_store_ios_client_;
+  std::unique_ptr<InMemorySystemCookieStore> store_;
+};
+
+INSTANTIATE_TYPED_TEST_SUITE_P(InMemorySystemCookieStore,
+                               SystemCookieStoreTest,
+                               InMemorySystemCookieStoreTestDelegate);
+
+class InMemorySystemCookieStoreTest : public PlatformTest {
+ protected:
+  InMemorySystemCookieStoreTest()
+      : scoped_task_environment_(
+            base::test::ScopedTaskEnvironment::MainThreadType::MOCK_TIME),
+        scoped_cookie_store_ios_client_(
+            std::make_unique<TestCookieStoreIOSClient>()) {}
+
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  ScopedTestingCookieStoreIOSClient scoped_cookie_store_ios_client_;
+};
+
+// Tests that changes made within the batching window are reported once, and
+// that callbacks run after the configured latency.
+TEST_F(InMemorySystemCookieStoreTest, BatchesNotificationsAndDelaysCallbacks) {
+  int notification_count = 0;
+  InMemorySystemCookieStore::Options options;
+  options.latency = base::TimeDelta::FromMilliseconds(5);
+  options.notification_batching_window = base::TimeDelta::FromMilliseconds(50);
+  options.changes_callback = base::BindRepeating(
+      [](int* notification_count) { ++*notification_count; },
+      &notification_count);
+  InMemorySystemCookieStore store(options);
+
+  NSURL* url = [NSURL URLWithString:@"http://foo.google.com/bar"];
+  bool set_done = false;
+  store.SetCookieAsync(CreateCookie(@"a", @"b", url),
+                       base::BindOnce([](bool* done) { *done = true; },
+                                      &set_done));
+  store.SetCookieAsync(CreateCookie(@"c", @"d", url),
+                       SystemCookieStore::SystemCookieCallback());
+  EXPECT_FALSE(set_done);
+
+  scoped_task_environment_.FastForwardBy(
+      base::TimeDelta::FromMilliseconds(5));
+  EXPECT_TRUE(set_done);
+  EXPECT_EQ(0, notification_count);
+
+  scoped_task_environment_.FastForwardBy(
+      base::TimeDelta::FromMilliseconds(45));
+  EXPECT_EQ(1, notification_count);
+
+  store.ClearStoreAsync(SystemCookieStore::SystemCookieCallback());
+  scoped_task_environment_.FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(2, notification_count);
+}
+
+// Tests that cookies are matched to URLs like NSHTTPCookieStorage does.
+TEST_F(InMemorySystemCookieStoreTest, GetCookiesForURL) {
+  InMemorySystemCookieStore store;
+  store.SetCookieAsync(
+      [NSHTTPCookie cookieWithProperties:@{
+        NSHTTPCookiePath : @"/foo",
+        NSHTTPCookieName : @"path",
+        NSHTTPCookieValue : @"v",
+        NSHTTPCookieDomain : @".google.com",
+      }],
+      SystemCookieStore::SystemCookieCallback());
+  store.SetCookieAsync(
+      [NSHTTPCookie cookieWithProperties:@{
+        NSHTTPCookiePath : @"/",
+        NSHTTPCookieName : @"secure",
+        NSHTTPCookieValue : @"v",
+        NSHTTPCookieDomain : @"www.google.com",
+        NSHTTPCookieSecure : @"TRUE",
+      }],
+      SystemCookieStore::SystemCookieCallback());
+
+  auto count_cookies = [&store](const GURL& url) {
+    __block NSUInteger count = 0;
+    store.GetCookiesForURLAsync(
+        url, base::BindOnce(^(NSArray<NSHTTPCookie*>* cookies) {
+          count = cookies.count;
+        }));
+    base::RunLoop().RunUntilIdle();
+    return count;
+  };
+  EXPECT_EQ(1u, count_cookies(GURL("http://www.google.com/foobar")));
+  EXPECT_EQ(2u, count_cookies(GURL("https://www.google.com/foo")));
+  EXPECT_EQ(0u, count_cookies(GURL("http://www.google.com/")));
+  EXPECT_EQ(0u, count_cookies(GURL("https://www.example.com/foo")));
+}
+
+}  // namespace net
@@ -54,6 +54,10 @@ class NSHTTPSystemCookieStoreTestDelegate {
 
   int CookiesCount() { return shared_store_.cookies.count; }
 
+  void SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicy policy) {
+    shared_store_.cookieAcceptPolicy = policy;
+  }
+
   SystemCookieStore* GetCookieStore() { return store_.get(); }
 
  private:
@@ -121,6 +121,9 @@ void SetCookieInStoreWithNoCallback(NSHTTPCookie* cookie,
 //     Deletes all cookies in the internal cookie store.
 //   int CookiesCount()
 //     Returns the number of cookies set in the internal cookie store.
+//   SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicy policy)
+//     Sets the cookie accept policy the store should report. The store must
+//     initially report the policy of the shared NSHTTPCookieStorage.
 template <typename SystemCookieStoreTestDelegate>
 class SystemCookieStoreTest : public PlatformTest {
  public:
@@ -150,6 +153,11 @@ class SystemCookieStoreTest : public PlatformTest {
   // Returns the number of cookies set in the |delegate_| cookie store.
   int CookiesCount() { return delegate_.CookiesCount(); }
 
+  // Sets the cookie accept policy of the |delegate_| cookie store.
+  void SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicy policy) {
+    delegate_.SetCookieAcceptPolicy(policy);
+  }
+
  protected:
   NSURL* test_cookie_url1_;
   NSURL* test_cookie_url2_;
@@ -285,12 +293,10 @@ TYPED_TEST_P(SystemCookieStoreTest, GetCookieAcceptPolicy) {
   SystemCookieStore* cookie_store = this->GetCookieStore();
   EXPECT_EQ([NSHTTPCookieStorage sharedHTTPCookieStorage].cookieAcceptPolicy,
             cookie_store->GetCookieAcceptPolicy());
-  [NSHTTPCookieStorage sharedHTTPCookieStorage].cookieAcceptPolicy =
-      NSHTTPCookieAcceptPolicyNever;
+  this->SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicyNever);
   EXPECT_EQ(NSHTTPCookieAcceptPolicyNever,
             cookie_store->GetCookieAcceptPolicy());
-  [NSHTTPCookieStorage sharedHTTPCookieStorage].cookieAcceptPolicy =
-      NSHTTPCookieAcceptPolicyAlways;
+  this->SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicyAlways);
   EXPECT_EQ(NSHTTPCookieAcceptPolicyAlways,
             cookie_store->GetCookieAcceptPolicy());
 }
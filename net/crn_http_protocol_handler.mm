@@ -18,9 +18,11 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/strings/utf_string_conversions.h"
+#include "ios/net/buffered_stream_uploader.h"
 #include "ios/net/chunked_data_stream_uploader.h"
 #import "ios/net/clients/crn_network_client_protocol.h"
 #import "ios/net/crn_http_protocol_handler_proxy_with_client_thread.h"
@@ -145,6 +147,7 @@ class HttpProtocolHandlerCore
     : public base::RefCountedThreadSafe<HttpProtocolHandlerCore,
                                         HttpProtocolHandlerCore>,
       public URLRequest::Delegate,
+      public BufferedStreamUploader::Delegate,
       public ChunkedDataStreamUploader::Delegate {
  public:
   explicit HttpProtocolHandlerCore(NSURLRequest* request);
@@ -171,6 +174,9 @@ class HttpProtocolHandlerCore
   void OnResponseStarted(URLRequest* request, int net_error) override;
   void OnReadCompleted(URLRequest* request, int bytes_read) override;
 
+  // BufferedStreamUploader::Delegate method:
+  void OnUploadBufferAvailable() override;
+
   // ChunkedDataStreamUploader::Delegate method:
   int OnRead(char* buffer, int buffer_length) override;
 
@@ -203,6 +209,9 @@ class HttpProtocolHandlerCore
   void HostStateCallback(bool carryOn);
   void StartReading();
   void AllocateReadBuffer(int last_read_data_size);
+  // Reads the available data of |stream| into the buffer of
+  // |buffered_uploader_|, or keeps |stream| pending while that buffer is full.
+  void AppendStreamData(NSInputStream* stream);
 
   base::ThreadChecker thread_checker_;
 
@@ -215,14 +224,14 @@ class HttpProtocolHandlerCore
   NSURLSessionTask* task_;
   // Stream delegate to read the HTTPBodyStream.
   CRWHTTPStreamDelegate* stream_delegate_;
-  // Vector of readers used to accumulate a POST data stream.
-  std::vector<std::unique_ptr<UploadElementReader>> post_data_readers_;
-
   // This cannot be a scoped pointer because it must be deleted on the IO
   // thread.
   URLRequest* net_request_;
 
-  // It is a weak pointer because the owner of the uploader is the URLRequest.
+  // They are weak pointers because the owner of the uploader is the URLRequest.
+  // At most one of them is set, depending on whether the length of the
+  // HTTPBodyStream is known.
+  base::WeakPtr<BufferedStreamUploader> buffered_uploader_;
   base::WeakPtr<ChunkedDataStreamUploader> chunked_uploader_;
 
   // The stream has data to upload.
@@ -276,17 +285,8 @@ void HttpProtocolHandlerCore::HandleStreamEvent(NSStream* stream,
         chunked_uploader_->UploadWhenReady(true);
         break;
       }
-
-      if (!post_data_readers_.empty()) {
-        // NOTE: This call will result in |post_data_readers_| being cleared,
-        // which is the desired behavior.
-        net_request_->set_upload(std::make_unique<ElementsUploadDataStream>(
-            std::move(post_data_readers_), 0));
-        DCHECK(post_data_readers_.empty());
-      }
-      net_request_->Start();
-      if (tracker_)
-        tracker_->StartRequest(net_request_);
+      if (buffered_uploader_)
+        buffered_uploader_->SetEndOfStream();
       break;
     case NSStreamEventHasBytesAvailable: {
       if (chunked_uploader_) {
@@ -296,21 +296,8 @@ void HttpProtocolHandlerCore::HandleStreamEvent(NSStream* stream,
         break;
       }
 
-      NSInteger length;
-      // TODO(crbug.com/738025): Dynamically change the size of the read buffer
-      // to improve the read (POST) performance, see AllocateReadBuffer(), &
-      // avoid unnecessary data copy.
-      length = [base::mac::ObjCCastStrict<NSInputStream>(stream)
-               read:reinterpret_cast<unsigned char*>(read_buffer_.get())
-          maxLength:read_buffer_size_];
-      if (length > 0) {
-        std::vector<char> owned_data(read_buffer_.get(),
-                                     read_buffer_.get() + length);
-        post_data_readers_.push_back(
-            std::make_unique<UploadOwnedBytesElementReader>(&owned_data));
-      } else if (length < 0) {  // Error
-        StopRequestWithError(stream.streamError.code, ERR_FAILED);
-      }
+      if (buffered_uploader_)
+        AppendStreamData(base::mac::ObjCCastStrict<NSInputStream>(stream));
       break;
     }
     case NSStreamEventNone:
@@ -731,16 +718,29 @@ void HttpProtocolHandlerCore::Start(id<CRNNetworkClientProtocol> base_client) {
                             forMode:NSDefaultRunLoopMode];
     [input_stream open];
 
-    if (net_request_->extra_request_headers().HasHeader(
-            HttpRequestHeaders::kContentLength)) {
-      // The request will be started when the stream is fully read.
-      return;
+    std::string content_length;
+    uint64_t body_length = 0;
+    if (net_request_->extra_request_headers().GetHeader(
+            HttpRequestHeaders::kContentLength, &content_length) &&
+        base::StringToUint64(content_length, &body_length)) {
+      // The body is uploaded while the stream is being read.
+      if (body_length > 0) {
+        std::unique_ptr<BufferedStreamUploader> uploader =
+            std::make_unique<BufferedStreamUploader>(this, body_length);
+        buffered_uploader_ = uploader->GetWeakPtr();
+        net_request_->set_upload(std::move(uploader));
+      } else {
+        StopListeningStream(input_stream);
+      }
+    } else {
+      // The length of the body is unknown, upload it in chunks.
+      net_request_->RemoveRequestHeaderByName(
+          HttpRequestHeaders::kContentLength);
+      std::unique_ptr<ChunkedDataStreamUploader> uploader =
+          std::make_unique<ChunkedDataStreamUploader>(this);
+      chunked_uploader_ = uploader->GetWeakPtr();
+      net_request_->set_upload(std::move(uploader));
     }
-
-    std::unique_ptr<ChunkedDataStreamUploader> uploader =
-        std::make_unique<ChunkedDataStreamUploader>(this);
-    chunked_uploader_ = uploader->GetWeakPtr();
-    net_request_->set_upload(std::move(uploader));
   } else if ([request_ HTTPBody]) {
     NSData* body = [request_ HTTPBody];
     const NSUInteger body_length = [body length];
@@ -876,6 +876,37 @@ void HttpProtocolHandlerCore::StripPostSpecificHeaders(
       HttpRequestHeaders::kOrigin)];
 }
 
+void HttpProtocolHandlerCore::AppendStreamData(NSInputStream* stream) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK(buffered_uploader_);
+  pending_stream_ = nil;
+  if (!buffered_uploader_->CanAppend()) {
+    // The stream is read again once the network layer has uploaded some of
+    // the buffered data.
+    pending_stream_ = stream;
+    return;
+  }
+
+  int buffer_length = 0;
+  char* buffer = buffered_uploader_->GetAppendBuffer(&buffer_length);
+  NSInteger length = [stream read:reinterpret_cast<unsigned char*>(buffer)
+                        maxLength:buffer_length];
+  if (length < 0) {  // Error
+    StopRequestWithError(stream.streamError.code, ERR_FAILED);
+    return;
+  }
+  buffered_uploader_->DidAppend(length);
+}
+
+void HttpProtocolHandlerCore::OnUploadBufferAvailable() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  NSInputStream* stream = pending_stream_;
+  // NSInputStream read() blocks the thread until there is at least one byte
+  // available, so check the status before calling it.
+  if (stream && buffered_uploader_ && [stream hasBytesAvailable])
+    AppendStreamData(stream);
+}
+
 int HttpProtocolHandlerCore::OnRead(char* buffer, int buffer_length) {
   int bytes_read = 0;
   if (pending_stream_) {
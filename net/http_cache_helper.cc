@@ -4,12 +4,14 @@
 
 #include "ios/net/http_cache_helper.h"
 
+#include <map>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/callback.h"
 #include "base/location.h"
+#include "base/no_destructor.h"
 #include "base/task_runner.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "net/disk_cache/disk_cache.h"
@@ -23,6 +25,24 @@
 
 namespace {
 
+// The modification count of each HTTP cache which was modified. Only used on
+// the IO thread.
+struct HttpCacheModificationCounts {
+  uint64_t last_count = 0;
+  std::map<const net::HttpCache*, uint64_t> counts;
+};
+
+HttpCacheModificationCounts& GetHttpCacheModificationCounts() {
+  static base::NoDestructor<HttpCacheModificationCounts> counts;
+  return *counts;
+}
+
+// Returns the HTTP cache of |context|, or null if it has none.
+const net::HttpCache* GetHttpCache(const net::URLRequestContext* context) {
+  net::HttpTransactionFactory* factory = context->http_transaction_factory();
+  return factory ? factory->GetCache() : nullptr;
+}
+
 // Posts |callback| on |task_runner|.
 void PostCallback(const scoped_refptr<base::TaskRunner>& task_runner,
                   const net::CompletionCallback& callback,
@@ -30,8 +50,20 @@ void PostCallback(const scoped_refptr<base::TaskRunner>& task_runner,
   task_runner->PostTask(FROM_HERE, base::BindOnce(callback, error));
 }
 
+// Records that the cache of |getter| was cleared and posts |callback| on
+// |task_runner|.
+void OnHttpCacheDoomed(
+    const scoped_refptr<net::URLRequestContextGetter>& getter,
+    const scoped_refptr<base::TaskRunner>& task_runner,
+    const net::CompletionCallback& callback,
+    int error) {
+  net::NotifyHttpCacheModified(getter->GetURLRequestContext());
+  PostCallback(task_runner, callback, error);
+}
+
 // Clears the disk_cache::Backend on the IO thread and deletes |backend|.
 void DoomHttpCache(std::unique_ptr<disk_cache::Backend*> backend,
+                   const scoped_refptr<net::URLRequestContextGetter>& getter,
                    const scoped_refptr<base::TaskRunner>& client_task_runner,
                    const base::Time& delete_begin,
                    const base::Time& delete_end,
@@ -39,13 +71,13 @@ void DoomHttpCache(std::unique_ptr<disk_cache::Backend*> backend,
                    int error) {
   // |*backend| may be null in case of error.
   if (*backend) {
-    const int rv = (*backend)->DoomEntriesBetween(
-        delete_begin, delete_end,
-        base::Bind(&PostCallback, client_task_runner, callback));
+    const net::CompletionCallback doomed_callback = base::Bind(
+        &OnHttpCacheDoomed, getter, client_task_runner, callback);
+    const int rv = (*backend)->DoomEntriesBetween(delete_begin, delete_end,
+                                                  doomed_callback);
     // DoomEntriesBetween does not invoke callback unless rv is ERR_IO_PENDING.
-    if (rv != net::ERR_IO_PENDING) {
-      client_task_runner->PostTask(FROM_HERE, base::BindOnce(callback, rv));
-    }
+    if (rv != net::ERR_IO_PENDING)
+      doomed_callback.Run(rv);
   } else {
     client_task_runner->PostTask(FROM_HERE, base::BindOnce(callback, error));
   }
@@ -71,7 +103,7 @@ void ClearHttpCacheOnIOThread(
       new disk_cache::Backend*(nullptr));
   disk_cache::Backend** backend_ptr = backend.get();
   net::CompletionCallback doom_callback =
-      base::Bind(&DoomHttpCache, base::Passed(std::move(backend)),
+      base::Bind(&DoomHttpCache, base::Passed(std::move(backend)), getter,
                  client_task_runner, delete_begin, delete_end, callback);
 
   const int rv = http_cache->GetBackend(backend_ptr, doom_callback);
@@ -98,4 +130,21 @@ void ClearHttpCache(const scoped_refptr<net::URLRequestContextGetter>& getter,
                                 delete_begin, delete_end, callback));
 }
 
+void NotifyHttpCacheModified(const net::URLRequestContext* context) {
+  const net::HttpCache* http_cache = GetHttpCache(context);
+  if (!http_cache)
+    return;
+  HttpCacheModificationCounts& counts = GetHttpCacheModificationCounts();
+  counts.counts[http_cache] = ++counts.last_count;
+}
+
+uint64_t GetHttpCacheModificationCount(const net::URLRequestContext* context) {
+  const net::HttpCache* http_cache = GetHttpCache(context);
+  if (!http_cache)
+    return 0;
+  const auto& counts = GetHttpCacheModificationCounts().counts;
+  auto it = counts.find(http_cache);
+  return it == counts.end() ? 0 : it->second;
+}
+
 }  // namespace net
@@ -5,6 +5,8 @@
 #ifndef IOS_NET_HTTP_CACHE_HELPER_H_
 #define IOS_NET_HTTP_CACHE_HELPER_H_
 
+#include <stdint.h>
+
 #include "base/callback_forward.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/completion_callback.h"
@@ -14,6 +16,7 @@ class TaskRunner;
 }
 
 namespace net {
+class URLRequestContext;
 class URLRequestContextGetter;
 
 // Clears the HTTP cache and calls |closure| back.
@@ -23,6 +26,15 @@ void ClearHttpCache(const scoped_refptr<net::URLRequestContextGetter>& getter,
                     const base::Time& delete_end,
                     const net::CompletionCallback& callback);
 
+// Records that the HTTP cache of |context| may have been modified, e.g. because
+// a request using it completed. Must be called on the IO thread.
+void NotifyHttpCacheModified(const net::URLRequestContext* context);
+
+// Returns a value which changes every time NotifyHttpCacheModified() is called
+// for the HTTP cache of |context|, or when the cache is cleared by
+// ClearHttpCache(). Must be called on the IO thread.
+uint64_t GetHttpCacheModificationCount(const net::URLRequestContext* context);
+
 }  // namespace net
 
 #endif  // IOS_NET_HTTP_CACHE_HELPER_H_
@@ -7,7 +7,12 @@
 
 #include <stddef.h>
 
+#include <deque>
+#include <utility>
+#include <vector>
+
 #include "base/macros.h"
+#include "ios/third_party/blink/src/html_character_scanner.h"
 #include "ios/third_party/blink/src/html_tokenizer_adapter.h"
 
 namespace WebCore {
@@ -16,49 +21,108 @@ const LChar kEndOfFileMarker = 0;
 
 // CharacterProvider provides input characters to WebCore::HTMLTokenizer.
 // It replaces WebCore::SegmentedString (which sits ontop of WTF::String).
+//
+// The input is either one complete buffer owned by the caller (setContents())
+// or a stream of chunks appended as they arrive (appendContents()). When a
+// stream runs out of input before finish() is called, HTMLTokenizer returns
+// without a token and resumes in the same state once more input is appended.
 class CharacterProvider {
 public:
     CharacterProvider()
         : _totalBytes(0)
         , _remainingBytes(0)
+        , _queuedBytes(0)
         , _singleBytePtr(nullptr)
         , _doubleBytePtr(nullptr)
+        , _currentSegment(0)
         , _littleEndian(false)
+        , _streaming(false)
+        , _finished(false)
     {
     }
 
     void setContents(const LChar* str, size_t numberOfBytes)
     {
+        clear();
         _totalBytes = numberOfBytes;
         _remainingBytes = numberOfBytes;
         _singleBytePtr = str;
-        _doubleBytePtr = nullptr;
-        _littleEndian = false;
     }
 
     void setContents(const UChar* str, size_t numberOfBytes)
     {
+        clear();
         _totalBytes = numberOfBytes;
         _remainingBytes = numberOfBytes;
-        _singleBytePtr = nullptr;
         _doubleBytePtr = str;
-        _littleEndian = false;
+    }
+
+    // Appends a chunk of a streamed document. The provider takes ownership of
+    // the characters and releases them once they have been tokenized.
+    void appendContents(std::vector<LChar> chunk)
+    {
+        Segment segment;
+        segment.singleBytes = std::move(chunk);
+        appendSegment(std::move(segment));
+    }
+
+    void appendContents(std::vector<UChar> chunk)
+    {
+        Segment segment;
+        segment.doubleBytes = std::move(chunk);
+        appendSegment(std::move(segment));
+    }
+
+    // Signals that no more chunks will be appended.
+    void finish()
+    {
+        ASSERT(_streaming);
+        _finished = true;
+    }
+
+    // Whether all of the input has been provided, i.e. the characters not yet
+    // consumed are all that is left of the document.
+    bool isComplete() const
+    {
+        return !_streaming || _finished;
+    }
+
+    // Releases the chunks that have been consumed. Called by the tokenizer
+    // once no token refers to them anymore.
+    void releaseConsumedSegments()
+    {
+        if (!_remainingBytes) {
+            _segments.clear();
+            _currentSegment = 0;
+            _singleBytePtr = nullptr;
+            _doubleBytePtr = nullptr;
+            return;
+        }
+        while (_currentSegment) {
+            _segments.pop_front();
+            --_currentSegment;
+        }
     }
 
     void clear()
     {
         _totalBytes = 0;
         _remainingBytes = 0;
+        _queuedBytes = 0;
         _singleBytePtr = nullptr;
         _doubleBytePtr = nullptr;
+        _segments.clear();
+        _currentSegment = 0;
         _littleEndian = false;
+        _streaming = false;
+        _finished = false;
     }
 
     bool startsWith(const LChar* str,
                     size_t byteCount,
                     bool caseInsensitive = false) const
     {
-        if (!str || byteCount > _remainingBytes)
+        if (!str || byteCount > remainingBytes())
             return false;
 
         for (size_t index = 0; index < byteCount; ++index) {
@@ -96,19 +160,74 @@ public:
         advanceBytePointer();
     }
 
+    // Advances past every character that is neither |first| nor |second|,
+    // starting with the current one and stopping at the end of the current
+    // chunk. The last character of the input is never skipped so that end of
+    // file is still seen by the caller. Returns the number of characters
+    // skipped.
+    size_t skipUntil(LChar first, LChar second)
+    {
+        if (remainingBytes() < 2)
+            return 0;
+
+        const size_t limit = _queuedBytes ? _remainingBytes : _remainingBytes - 1;
+        size_t skipped = 0;
+        if (_singleBytePtr) {
+            // Byte swapping single byte input never yields |first| or
+            // |second|, so leave that case to the per-character path.
+            if (_littleEndian)
+                return 0;
+            skipped = findFirstOf(_singleBytePtr, limit, first, second);
+            _singleBytePtr += skipped;
+        } else {
+            DCHECK(_doubleBytePtr);
+            UChar firstCharacter = first;
+            UChar secondCharacter = second;
+            if (_littleEndian) {
+                firstCharacter = ByteSwap(firstCharacter);
+                secondCharacter = ByteSwap(secondCharacter);
+            }
+            skipped = findFirstOf(_doubleBytePtr, limit, firstCharacter,
+                                  secondCharacter);
+            _doubleBytePtr += skipped;
+        }
+        _remainingBytes -= skipped;
+        if (!_remainingBytes)
+            moveToNextSegment();
+        return skipped;
+    }
+
+    // Return the address of the current character when it is stored
+    // unmodified in an 8-bit or native-endian 16-bit buffer respectively, and
+    // null otherwise. At most one of the two is non-null.
+    inline const LChar* currentSingleBytePosition() const
+    {
+        if (!_remainingBytes || _littleEndian)
+            return nullptr;
+        return _singleBytePtr;
+    }
+
+    inline const UChar* currentDoubleBytePosition() const
+    {
+        if (!_remainingBytes || _littleEndian)
+            return nullptr;
+        return _doubleBytePtr;
+    }
+
     inline bool isEmpty() const
     {
+        // The current chunk is only exhausted when nothing is queued after it.
         return !_remainingBytes;
     }
 
     inline size_t remainingBytes() const
     {
-        return _remainingBytes;
+        return _remainingBytes + _queuedBytes;
     }
 
     inline size_t bytesProvided() const
     {
-        return _totalBytes - _remainingBytes;
+        return _totalBytes - remainingBytes();
     }
 
     inline void setLittleEndian()
@@ -117,11 +236,67 @@ public:
     }
 
 private:
+    // A chunk of streamed input, stored in whichever width it was provided.
+    struct Segment {
+        size_t size() const
+        {
+            return singleBytes.size() + doubleBytes.size();
+        }
+
+        std::vector<LChar> singleBytes;
+        std::vector<UChar> doubleBytes;
+    };
+
+    void appendSegment(Segment segment)
+    {
+        ASSERT(!_finished);
+        ASSERT(_streaming || !_totalBytes);
+        _streaming = true;
+
+        const size_t size = segment.size();
+        if (!size)
+            return;
+
+        _totalBytes += size;
+        _segments.push_back(std::move(segment));
+        if (_remainingBytes) {
+            _queuedBytes += size;
+            return;
+        }
+
+        // Everything before this chunk has been consumed, continue with it.
+        _currentSegment = _segments.size() - 1;
+        startSegment();
+    }
+
+    void startSegment()
+    {
+        const Segment& segment = _segments[_currentSegment];
+        _singleBytePtr =
+            segment.singleBytes.empty() ? nullptr : segment.singleBytes.data();
+        _doubleBytePtr =
+            segment.doubleBytes.empty() ? nullptr : segment.doubleBytes.data();
+        _remainingBytes = segment.size();
+    }
+
+    void moveToNextSegment()
+    {
+        ASSERT(!_remainingBytes);
+        if (!_queuedBytes)
+            return;
+
+        ++_currentSegment;
+        startSegment();
+        _queuedBytes -= _remainingBytes;
+    }
+
     void advanceBytePointer()
     {
         --_remainingBytes;
-        if (!_remainingBytes)
+        if (!_remainingBytes) {
+            moveToNextSegment();
             return;
+        }
 
         if (_singleBytePtr)
             ++_singleBytePtr;
@@ -133,11 +308,13 @@ private:
 
     UChar characterAtIndex(size_t index) const
     {
-        if (!_remainingBytes) {
+        if (index >= _remainingBytes) {
             // There is a quirk in the blink implementation wherein the empty state
             // is not set on the source until next() has been called when
             // _remainingBytes is zero. In this case, return kEndOfFileMarker.
-            return kEndOfFileMarker;
+            if (!_queuedBytes)
+                return kEndOfFileMarker;
+            return queuedCharacterAtIndex(index - _remainingBytes);
         }
 
         ASSERT(_singleBytePtr || _doubleBytePtr);
@@ -154,12 +331,41 @@ private:
         return character;
     }
 
+    // Returns the character |index| positions after the end of the current
+    // chunk, for lookahead across chunk boundaries.
+    UChar queuedCharacterAtIndex(size_t index) const
+    {
+        for (size_t segmentIndex = _currentSegment + 1;
+             segmentIndex < _segments.size(); ++segmentIndex) {
+            const Segment& segment = _segments[segmentIndex];
+            if (index >= segment.size()) {
+                index -= segment.size();
+                continue;
+            }
+            UChar character = segment.singleBytes.empty()
+                ? segment.doubleBytes[index]
+                : segment.singleBytes[index];
+            if (_littleEndian)
+                character = ByteSwap(character);
+            return character;
+        }
+        return kEndOfFileMarker;
+    }
+
 private:
     size_t _totalBytes;
+    // Characters left in the current chunk, and in the chunks queued after it.
     size_t _remainingBytes;
+    size_t _queuedBytes;
     const LChar* _singleBytePtr;
     const UChar* _doubleBytePtr;
+    // Streamed chunks. Chunks before |_currentSegment| have been consumed but
+    // may still be referenced by the token in progress.
+    std::deque<Segment> _segments;
+    size_t _currentSegment;
     bool _littleEndian;
+    bool _streaming;
+    bool _finished;
 
     DISALLOW_COPY_AND_ASSIGN(CharacterProvider);
 };
@@ -0,0 +1,131 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_character_provider.h"
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace WebCore {
+
+namespace {
+
+// Returns the characters of |string| as a chunk.
+std::vector<LChar> Chunk(const std::string& string) {
+  return std::vector<LChar>(string.begin(), string.end());
+}
+
+}  // namespace
+
+// Tests that the characters of successive chunks are read in order, skipping
+// empty chunks.
+TEST(HTMLCharacterProviderTest, ReadsAcrossChunks) {
+  CharacterProvider provider;
+  provider.appendContents(Chunk("ab"));
+  provider.appendContents(Chunk(""));
+  provider.appendContents(std::vector<UChar>({'c', 'd'}));
+  EXPECT_EQ(4U, provider.remainingBytes());
+
+  EXPECT_EQ('a', provider.currentCharacter());
+  EXPECT_EQ('b', provider.nextCharacter());
+  EXPECT_EQ('c', provider.nextCharacter());
+  EXPECT_EQ(2U, provider.bytesProvided());
+  EXPECT_EQ('d', provider.nextCharacter());
+  provider.next();
+  EXPECT_TRUE(provider.isEmpty());
+  EXPECT_EQ(kEndOfFileMarker, provider.currentCharacter());
+
+  // Reading continues with the next chunk once the previous ones are
+  // exhausted.
+  provider.appendContents(Chunk("e"));
+  EXPECT_FALSE(provider.isEmpty());
+  EXPECT_EQ('e', provider.currentCharacter());
+}
+
+// Tests that lookahead reads into the queued chunks.
+TEST(HTMLCharacterProviderTest, StartsWithAcrossChunks) {
+  CharacterProvider provider;
+  provider.appendContents(Chunk("<!DO"));
+  provider.appendContents(Chunk("C"));
+  provider.appendContents(Chunk("type html>"));
+  provider.next();
+  provider.next();
+
+  const LChar doctype[] = "doctype";
+  EXPECT_TRUE(provider.startsWith(doctype, 7, /*caseInsensitive=*/true));
+  EXPECT_FALSE(provider.startsWith(doctype, 7));
+
+  // Lookahead past the end of the input received so far fails.
+  const LChar doctype_html[] = "DOCtype html> ";
+  EXPECT_FALSE(provider.startsWith(doctype_html, 14));
+}
+
+// Tests that skipUntil() stops at the end of a chunk and continues in the next
+// one.
+TEST(HTMLCharacterProviderTest, SkipUntilStopsAtChunkEnd) {
+  CharacterProvider provider;
+  provider.appendContents(Chunk("abcdefghijklmnopqrstuvwxyz"));
+  provider.appendContents(Chunk("ab<c"));
+
+  EXPECT_EQ(26U, provider.skipUntil('<', '\0'));
+  EXPECT_EQ('a', provider.currentCharacter());
+  EXPECT_EQ(2U, provider.skipUntil('<', '\0'));
+  EXPECT_EQ('<', provider.currentCharacter());
+  EXPECT_EQ(0U, provider.skipUntil('<', '\0'));
+}
+
+// Tests that skipUntil() does not skip the last character of the input, which
+// may be the end of file marker.
+TEST(HTMLCharacterProviderTest, SkipUntilKeepsLastCharacter) {
+  const LChar characters[] = "abcdefghijklmnopqrstuvwxyz";
+  CharacterProvider provider;
+  provider.setContents(characters, 26);
+  EXPECT_EQ(25U, provider.skipUntil('<', '\0'));
+  EXPECT_EQ('z', provider.currentCharacter());
+  EXPECT_EQ(0U, provider.skipUntil('<', '\0'));
+
+  CharacterProvider streamed_provider;
+  streamed_provider.appendContents(Chunk("abcdefghijklmnopqrstuvwxyz"));
+  EXPECT_EQ(25U, streamed_provider.skipUntil('<', '\0'));
+  EXPECT_EQ('z', streamed_provider.currentCharacter());
+}
+
+// Tests that a stream is complete only once finish() is called.
+TEST(HTMLCharacterProviderTest, IsComplete) {
+  CharacterProvider provider;
+  EXPECT_TRUE(provider.isComplete());
+
+  provider.appendContents(Chunk("a"));
+  EXPECT_FALSE(provider.isComplete());
+  provider.finish();
+  EXPECT_TRUE(provider.isComplete());
+
+  provider.clear();
+  const LChar characters[] = "a";
+  provider.setContents(characters, 1);
+  EXPECT_TRUE(provider.isComplete());
+}
+
+// Tests that releasing the consumed chunks keeps the current position.
+TEST(HTMLCharacterProviderTest, ReleaseConsumedSegments) {
+  CharacterProvider provider;
+  provider.appendContents(Chunk("ab"));
+  provider.appendContents(Chunk("cd"));
+  provider.next();
+  provider.next();
+  provider.releaseConsumedSegments();
+  EXPECT_EQ('c', provider.currentCharacter());
+  EXPECT_EQ('d', provider.nextCharacter());
+  EXPECT_EQ(3U, provider.bytesProvided());
+
+  provider.next();
+  provider.releaseConsumedSegments();
+  EXPECT_TRUE(provider.isEmpty());
+  provider.appendContents(Chunk("e"));
+  EXPECT_EQ('e', provider.currentCharacter());
+}
+
+}  // namespace WebCore
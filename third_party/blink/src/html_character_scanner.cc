@@ -0,0 +1,102 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_character_scanner.h"
+
+#include "base/bits.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#define HTML_SCANNER_USE_SSE2 1
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#define HTML_SCANNER_USE_NEON 1
+#endif
+
+namespace WebCore {
+
+#if defined(HTML_SCANNER_USE_SSE2) || defined(HTML_SCANNER_USE_NEON)
+namespace {
+// Number of bytes examined by one vector comparison.
+const size_t kVectorSize = 16;
+const size_t kUCharsPerVector = kVectorSize / sizeof(UChar);
+}
+#endif
+
+size_t findFirstOf(const LChar* characters,
+                   size_t length,
+                   LChar first,
+                   LChar second)
+{
+    size_t index = 0;
+#if defined(HTML_SCANNER_USE_SSE2)
+    const __m128i firstVector = _mm_set1_epi8(static_cast<char>(first));
+    const __m128i secondVector = _mm_set1_epi8(static_cast<char>(second));
+    for (; index + kVectorSize <= length; index += kVectorSize) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(characters + index));
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, firstVector),
+                                       _mm_cmpeq_epi8(chunk, secondVector));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+        if (mask)
+            return index + base::bits::CountTrailingZeroBits(mask);
+    }
+#elif defined(HTML_SCANNER_USE_NEON)
+    const uint8x16_t firstVector = vdupq_n_u8(first);
+    const uint8x16_t secondVector = vdupq_n_u8(second);
+    for (; index + kVectorSize <= length; index += kVectorSize) {
+        uint8x16_t chunk = vld1q_u8(characters + index);
+        uint8x16_t matches = vorrq_u8(vceqq_u8(chunk, firstVector),
+                                      vceqq_u8(chunk, secondVector));
+        if (vmaxvq_u8(matches)) {
+            return index + findFirstOfScalar(characters + index, kVectorSize,
+                                             first, second);
+        }
+    }
+#endif
+    return index + findFirstOfScalar(characters + index, length - index,
+                                     first, second);
+}
+
+size_t findFirstOf(const UChar* characters,
+                   size_t length,
+                   UChar first,
+                   UChar second)
+{
+    size_t index = 0;
+#if defined(HTML_SCANNER_USE_SSE2)
+    const __m128i firstVector = _mm_set1_epi16(static_cast<short>(first));
+    const __m128i secondVector = _mm_set1_epi16(static_cast<short>(second));
+    for (; index + kUCharsPerVector <= length;
+         index += kUCharsPerVector) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(characters + index));
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi16(chunk, firstVector),
+                                       _mm_cmpeq_epi16(chunk, secondVector));
+        // Each matching 16-bit lane sets two adjacent bits in the mask.
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+        if (mask)
+            return index + base::bits::CountTrailingZeroBits(mask) / 2;
+    }
+#elif defined(HTML_SCANNER_USE_NEON)
+    const uint16x8_t firstVector = vdupq_n_u16(first);
+    const uint16x8_t secondVector = vdupq_n_u16(second);
+    for (; index + kUCharsPerVector <= length;
+         index += kUCharsPerVector) {
+        uint16x8_t chunk = vld1q_u16(characters + index);
+        uint16x8_t matches = vorrq_u16(vceqq_u16(chunk, firstVector),
+                                       vceqq_u16(chunk, secondVector));
+        if (vmaxvq_u16(matches)) {
+            return index + findFirstOfScalar(characters + index,
+                                             kUCharsPerVector, first,
+                                             second);
+        }
+    }
+#endif
+    return index + findFirstOfScalar(characters + index, length - index,
+                                     first, second);
+}
+
+}
@@ -0,0 +1,44 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_THIRD_PARTY_BLINK_SRC_HTML_CHARACTER_SCANNER_H_
+#define IOS_THIRD_PARTY_BLINK_SRC_HTML_CHARACTER_SCANNER_H_
+
+#include <stddef.h>
+
+#include "ios/third_party/blink/src/html_tokenizer_adapter.h"
+
+namespace WebCore {
+
+// Returns the index of the first character in |characters| equal to |first|
+// or |second|, or |length| if there is no such character. Uses SSE2 or NEON
+// when available, which lets the tokenizer move through long runs of text
+// without inspecting them one character at a time.
+size_t findFirstOf(const LChar* characters,
+                   size_t length,
+                   LChar first,
+                   LChar second);
+size_t findFirstOf(const UChar* characters,
+                   size_t length,
+                   UChar first,
+                   UChar second);
+
+// Portable implementations of findFirstOf(), used for the tail of the input
+// and on CPUs without vector support. Exposed for benchmarking.
+template <typename CharType>
+inline size_t findFirstOfScalar(const CharType* characters,
+                                size_t length,
+                                CharType first,
+                                CharType second)
+{
+    for (size_t index = 0; index < length; ++index) {
+        if (characters[index] == first || characters[index] == second)
+            return index;
+    }
+    return length;
+}
+
+}
+
+#endif // IOS_THIRD_PARTY_BLINK_SRC_HTML_CHARACTER_SCANNER_H_
@@ -0,0 +1,89 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_character_scanner.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace WebCore {
+
+namespace {
+
+// Longest input scanned by the tests: three vectors of 8-bit characters and a
+// partial one, or six vectors of 16-bit characters and a partial one.
+const size_t kMaxLength = 53;
+
+// Number of starting positions tried within a vector, so that the vector loads
+// are made at every alignment.
+const size_t kMaxOffset = 16;
+
+// Expects findFirstOf() to find |target| at every position of every input of up
+// to kMaxLength |filler| characters, and to find nothing when |target| is only
+// right after the end of the input.
+template <typename CharType>
+void ExpectFindsEveryPosition(CharType filler, CharType target) {
+  const CharType first = '<';
+  const CharType second = '\0';
+  std::vector<CharType> buffer(kMaxOffset + kMaxLength + 1, filler);
+  for (size_t offset = 0; offset < kMaxOffset; ++offset) {
+    const CharType* characters = buffer.data() + offset;
+    for (size_t length = 0; length <= kMaxLength; ++length) {
+      for (size_t position = 0; position < length; ++position) {
+        buffer[offset + position] = target;
+        EXPECT_EQ(position, findFirstOf(characters, length, first, second))
+            << "offset " << offset << ", length " << length;
+        buffer[offset + position] = filler;
+      }
+
+      buffer[offset + length] = target;
+      EXPECT_EQ(length, findFirstOf(characters, length, first, second))
+          << "offset " << offset << ", length " << length;
+      buffer[offset + length] = filler;
+    }
+  }
+}
+
+}  // namespace
+
+// Tests that both characters are found at any position of 8-bit input, whether
+// they are in a whole vector or in the partial vector at the end.
+TEST(HTMLCharacterScannerTest, SingleByteFindsEveryPosition) {
+  ExpectFindsEveryPosition<LChar>('a', '<');
+  ExpectFindsEveryPosition<LChar>('a', '\0');
+}
+
+// Tests that both characters are found at any position of 16-bit input, whether
+// they are in a whole vector or in the partial vector at the end.
+TEST(HTMLCharacterScannerTest, DoubleByteFindsEveryPosition) {
+  ExpectFindsEveryPosition<UChar>('a', '<');
+  ExpectFindsEveryPosition<UChar>('a', '\0');
+}
+
+// Tests that 16-bit characters are compared as a whole, not byte per byte.
+TEST(HTMLCharacterScannerTest, DoubleByteComparesWholeCharacters) {
+  ExpectFindsEveryPosition<UChar>(0x013C, '<');
+  ExpectFindsEveryPosition<UChar>(0x3C00, '<');
+  ExpectFindsEveryPosition<UChar>(0x0100, '\0');
+}
+
+// Tests that the first occurrence of either character is returned.
+TEST(HTMLCharacterScannerTest, ReturnsFirstOfEitherCharacter) {
+  const LChar single_bytes[] = "abcdefghijklmnopqrs\0uvw<yz";
+  const size_t single_byte_length = sizeof(single_bytes) - 1;
+  EXPECT_EQ(19U, findFirstOf(single_bytes, single_byte_length, '<', '\0'));
+  EXPECT_EQ(19U, findFirstOf(single_bytes, single_byte_length, '\0', '<'));
+  EXPECT_EQ(2U, findFirstOf(single_bytes, single_byte_length, 'c', '<'));
+
+  std::vector<UChar> double_bytes(single_bytes,
+                                  single_bytes + single_byte_length);
+  EXPECT_EQ(19U, findFirstOf(double_bytes.data(), double_bytes.size(),
+                             static_cast<UChar>('<'),
+                             static_cast<UChar>('\0')));
+  EXPECT_EQ(2U, findFirstOf(double_bytes.data(), double_bytes.size(),
+                            static_cast<UChar>('c'), static_cast<UChar>('<')));
+}
+
+}  // namespace WebCore
@@ -101,6 +101,8 @@ private:
             // a number of specific character values are parse errors and should be replaced
             // by the replacement character. We suspect this is a problem with the spec as doing
             // that filtering breaks surrogate pair handling and causes us not to match Minefield.
+            if (m_nextInputCharacter == '\0' && mightBeEndOfFileMarker(source))
+                return false;
             if (m_nextInputCharacter == '\0' && !shouldTreatNullAsEndOfFileMarker(source)) {
                 if (m_tokenizer->shouldSkipNullCharacters()) {
                     source.next();
@@ -120,6 +122,13 @@ private:
         return source.remainingBytes() == 1;
     }
 
+    // A NUL ending the input received so far on a stream that is not finished
+    // can only be classified once more input arrives.
+    bool mightBeEndOfFileMarker(CharacterProvider& source) const
+    {
+        return source.remainingBytes() == 1 && !source.isComplete();
+    }
+
     Tokenizer* m_tokenizer;
 
     // http://www.whatwg.org/specs/web-apps/current-work/#next-input-character
@@ -27,19 +27,30 @@
 
 #include "ios/third_party/blink/src/html_token.h"
 
-namespace {
-size_t kDefaultDataSize = 256;
-}
-
 namespace WebCore {
 
 HTMLToken::HTMLToken()
     : m_type(Uninitialized)
+    , m_singleByteName(nullptr)
+    , m_doubleByteName(nullptr)
+    , m_nameLength(0)
+    , m_nameIsOwned(false)
 {
-  m_data.reserve(kDefaultDataSize);
 }
 
 HTMLToken::~HTMLToken()
 {
 }
+
+void HTMLToken::materializeName()
+{
+    ASSERT(!m_nameIsOwned);
+    ASSERT(m_data.empty());
+    m_data.reserve(m_nameLength + 1);
+    for (size_t index = 0; index < m_nameLength; ++index)
+        m_data.push_back(nameCharacterAt(index));
+    m_singleByteName = nullptr;
+    m_doubleByteName = nullptr;
+    m_nameIsOwned = true;
+}
 }
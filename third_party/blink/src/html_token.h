@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "ios/third_party/blink/src/html_character_provider.h"
 #include "ios/third_party/blink/src/html_tokenizer_adapter.h"
 
 namespace WebCore {
@@ -52,7 +53,7 @@ public:
     void clear()
     {
         m_type = Uninitialized;
-        m_data.clear();
+        clearName();
     }
 
     Type type() const { return m_type; }
@@ -63,21 +64,50 @@ public:
         m_type = EndOfFile;
     }
 
-    void appendToName(LChar character)
+    // Appends |character|, read at the current position of |source|, to the
+    // name. As long as every character comes unmodified from contiguous
+    // input, the name is only a span into the input buffer. It is copied into
+    // owned storage the first time a character was rewritten, e.g. by case
+    // folding or by the input stream preprocessor.
+    void appendToName(LChar character, const CharacterProvider& source)
     {
         ASSERT(m_type == StartTag || m_type == EndTag || m_type == DOCTYPE);
         ASSERT(character);
+        if (!m_nameIsOwned && extendNameSpan(character, source))
+            return;
+        if (!m_nameIsOwned)
+            materializeName();
         m_data.push_back(character);
+        ++m_nameLength;
     }
 
-    bool nameEquals(const LChar* name, size_t length)
+    size_t nameLength() const { return m_nameLength; }
+
+    LChar nameCharacterAt(size_t index) const
+    {
+        ASSERT(index < m_nameLength);
+        if (m_nameIsOwned)
+            return m_data[index];
+        if (m_singleByteName)
+            return m_singleByteName[index];
+        return static_cast<LChar>(m_doubleByteName[index]);
+    }
+
+    // Whether the name had to be copied out of the input buffer.
+    bool nameIsOwned() const { return m_nameIsOwned; }
+
+    // Whether the name is a span into the input, which must then outlive
+    // the token.
+    bool nameReferencesInput() const { return m_nameLength && !m_nameIsOwned; }
+
+    bool nameEquals(const LChar* name, size_t length) const
     {
         ASSERT(m_type == StartTag || m_type == EndTag || m_type == DOCTYPE);
-        if (length != m_data.size())
+        if (length != m_nameLength)
             return false;
 
         for (size_t index = 0; index < length; ++index) {
-            if (m_data.at(index) != name[index])
+            if (nameCharacterAt(index) != name[index])
                 return false;
         }
 
@@ -94,21 +124,21 @@ public:
 
     /* Start/End Tag Tokens */
 
-    void beginStartTag(LChar character)
+    void beginStartTag(LChar character, const CharacterProvider& source)
     {
         ASSERT(character);
         ASSERT(m_type == Uninitialized);
         m_type = StartTag;
 
-        m_data.push_back(character);
+        appendToName(character, source);
     }
 
-    void beginEndTag(LChar character)
+    void beginEndTag(LChar character, const CharacterProvider& source)
     {
         ASSERT(m_type == Uninitialized);
         m_type = EndTag;
 
-        m_data.push_back(character);
+        appendToName(character, source);
     }
 
     /* Character Tokens */
@@ -130,7 +160,57 @@ public:
     }
 
 private:
+    // Extends the name span with the current character of |source| if it is
+    // |character| and directly follows the span. Returns false otherwise.
+    bool extendNameSpan(LChar character, const CharacterProvider& source)
+    {
+        if (source.currentCharacter() != character)
+            return false;
+
+        const LChar* singleBytePosition = source.currentSingleBytePosition();
+        const UChar* doubleBytePosition = source.currentDoubleBytePosition();
+        if (!m_nameLength) {
+            if (!singleBytePosition && !doubleBytePosition)
+                return false;
+            m_singleByteName = singleBytePosition;
+            m_doubleByteName = doubleBytePosition;
+        } else if (singleBytePosition) {
+            // The span cannot continue in input of another width.
+            if (!m_singleByteName
+                || singleBytePosition != m_singleByteName + m_nameLength)
+                return false;
+        } else if (doubleBytePosition) {
+            if (!m_doubleByteName
+                || doubleBytePosition != m_doubleByteName + m_nameLength)
+                return false;
+        } else {
+            return false;
+        }
+        ++m_nameLength;
+        return true;
+    }
+
+    // Copies the current name span into |m_data|.
+    void materializeName();
+
+    void clearName()
+    {
+        m_singleByteName = nullptr;
+        m_doubleByteName = nullptr;
+        m_nameLength = 0;
+        m_nameIsOwned = false;
+        m_data.clear();
+    }
+
     Type m_type;
+
+    // The name is either a span of |m_nameLength| characters in the input
+    // buffer, starting at |m_singleByteName| or |m_doubleByteName|, or is
+    // stored in |m_data| when |m_nameIsOwned|.
+    const LChar* m_singleByteName;
+    const UChar* m_doubleByteName;
+    size_t m_nameLength;
+    bool m_nameIsOwned;
     std::vector<LChar> m_data;
 
     DISALLOW_COPY_AND_ASSIGN(HTMLToken);
@@ -40,6 +40,7 @@ HTMLTokenizer::HTMLTokenizer()
     : m_state(HTMLTokenizer::DataState)
     , m_token(nullptr)
     , m_additionalAllowedCharacter('\0')
+    , m_bulkScanningEnabled(true)
     , m_inputStreamPreprocessor(this)
 {
 }
@@ -53,6 +54,7 @@ void HTMLTokenizer::reset()
     m_state = HTMLTokenizer::DataState;
     m_token = 0;
     m_additionalAllowedCharacter = '\0';
+    m_inputStreamPreprocessor.reset();
 }
 
 bool HTMLTokenizer::flushBufferedEndTag(CharacterProvider& source)
@@ -84,6 +86,11 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
     ASSERT(!m_token || m_token == &token || token.type() == HTMLToken::Uninitialized);
     m_token = &token;
 
+    // Chunks of streamed input already tokenized can go, unless the name of
+    // the token in progress still points into them.
+    if (!token.nameReferencesInput())
+        source.releaseConsumedSegments();
+
     if (source.isEmpty() || !m_inputStreamPreprocessor.peek(source))
         return haveBufferedCharacterToken();
     UChar cc = m_inputStreamPreprocessor.nextInputCharacter();
@@ -102,6 +109,8 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
             return emitEndOfFile(source);
         else {
             m_token->ensureIsCharacterToken();
+            if (skipCharactersUntil(source, '<', '\0'))
+                HTML_SWITCH_TO(DataState);
             HTML_ADVANCE_TO(DataState);
         }
     }
@@ -113,10 +122,10 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
         else if (cc == '/')
             HTML_ADVANCE_TO(EndTagOpenState);
         else if (isASCIIUpper(cc)) {
-            m_token->beginStartTag(toLowerCase(cc));
+            m_token->beginStartTag(toLowerCase(cc), source);
             HTML_ADVANCE_TO(TagNameState);
         } else if (isASCIILower(cc)) {
-            m_token->beginStartTag(cc);
+            m_token->beginStartTag(cc, source);
             HTML_ADVANCE_TO(TagNameState);
         } else if (cc == '?') {
             parseError();
@@ -134,10 +143,10 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
 
     HTML_BEGIN_STATE(EndTagOpenState) {
         if (isASCIIUpper(cc)) {
-            m_token->beginEndTag(static_cast<LChar>(toLowerCase(cc)));
+            m_token->beginEndTag(static_cast<LChar>(toLowerCase(cc)), source);
             HTML_ADVANCE_TO(TagNameState);
         } else if (isASCIILower(cc)) {
-            m_token->beginEndTag(static_cast<LChar>(cc));
+            m_token->beginEndTag(static_cast<LChar>(cc), source);
             HTML_ADVANCE_TO(TagNameState);
         } else if (cc == '>') {
             parseError();
@@ -161,13 +170,13 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
         else if (cc == '>')
             return emitAndResumeIn(source, HTMLTokenizer::DataState);
         else if (isASCIIUpper(cc)) {
-            m_token->appendToName(toLowerCase(cc));
+            m_token->appendToName(toLowerCase(cc), source);
             HTML_ADVANCE_TO(TagNameState);
         } else if (cc == kEndOfFileMarker) {
             parseError();
             HTML_RECONSUME_IN(DataState);
         } else {
-            m_token->appendToName(cc);
+            m_token->appendToName(cc, source);
             HTML_ADVANCE_TO(TagNameState);
         }
     }
@@ -267,6 +276,8 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
             parseError();
             HTML_RECONSUME_IN(DataState);
         } else {
+            if (skipCharactersUntil(source, '"', '\0'))
+                HTML_SWITCH_TO(AttributeValueDoubleQuotedState);
             HTML_ADVANCE_TO(AttributeValueDoubleQuotedState);
         }
     }
@@ -279,6 +290,8 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
             parseError();
             HTML_RECONSUME_IN(DataState);
         } else {
+            if (skipCharactersUntil(source, '\'', '\0'))
+                HTML_SWITCH_TO(AttributeValueSingleQuotedState);
             HTML_ADVANCE_TO(AttributeValueSingleQuotedState);
         }
     }
@@ -407,6 +420,8 @@ bool HTMLTokenizer::nextToken(CharacterProvider& source, HTMLToken& token)
             parseError();
             return emitAndReconsumeIn(source, HTMLTokenizer::DataState);
         } else {
+            if (skipCharactersUntil(source, '-', '\0'))
+                HTML_SWITCH_TO(CommentState);
             HTML_ADVANCE_TO(CommentState);
         }
     }
@@ -90,12 +90,19 @@ public:
 
     // This function returns true if it emits a token. Otherwise, callers
     // must provide the same (in progress) token on the next call (unless
-    // they call reset() first).
+    // they call reset() first). When streaming, a false return with input
+    // still incomplete means more chunks must be appended to |source|; the
+    // tokenizer then resumes in the state it stopped in.
     bool nextToken(CharacterProvider&, HTMLToken&);
 
     State state() const { return m_state; }
     void setState(State state) { m_state = state; }
 
+    // When enabled (the default), runs of characters that cannot change the
+    // tokenizer state are skipped with a vectorized scan instead of being
+    // consumed one at a time.
+    void setBulkScanningEnabled(bool enabled) { m_bulkScanningEnabled = enabled; }
+
     inline bool shouldSkipNullCharacters() const
     {
         return m_state == HTMLTokenizer::DataState;
@@ -130,6 +137,21 @@ private:
         return true;
     }
 
+    // Skips in bulk to the next |first| or |second| in |source|. Returns false
+    // if no characters were skipped, in which case the caller must advance
+    // normally.
+    inline bool skipCharactersUntil(CharacterProvider& source,
+                                    LChar first,
+                                    LChar second)
+    {
+        if (!m_bulkScanningEnabled || !source.skipUntil(first, second))
+            return false;
+        // The skipped characters were consumed without the preprocessor, so
+        // any pending CR/LF collapsing no longer applies.
+        m_inputStreamPreprocessor.reset();
+        return true;
+    }
+
     // Return whether we need to emit a character token before dealing with
     // the buffered end tag.
     inline bool flushBufferedEndTag(CharacterProvider&);
@@ -148,6 +170,8 @@ private:
     // http://www.whatwg.org/specs/web-apps/current-work/#additional-allowed-character
     LChar m_additionalAllowedCharacter;
 
+    bool m_bulkScanningEnabled;
+
     // http://www.whatwg.org/specs/web-apps/current-work/#preprocessing-the-input-stream
     InputStreamPreprocessor<HTMLTokenizer> m_inputStreamPreprocessor;
 
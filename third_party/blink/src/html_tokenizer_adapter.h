@@ -10,12 +10,19 @@
 
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/macros.h"
 
 #define ASSERT(x) DCHECK(x)
 #define ASSERT_NOT_REACHED NOTREACHED
 
 #define notImplemented()
 
+// Declares |name| as a static LChar string and |name|Length as its length.
+#define DEFINE_STATIC_LOCAL_STRING(name, arguments)                      \
+  static const WebCore::LChar* name =                                    \
+      reinterpret_cast<const WebCore::LChar*>(arguments);                \
+  static const size_t name##Length = (arraysize(arguments) - 1);
+
 namespace WebCore {
 typedef uint16_t UChar;
 typedef uint8_t LChar;
@@ -0,0 +1,156 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_tokenizer_batch.h"
+
+#include <utility>
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/no_destructor.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task/post_task.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/threading/thread_local_storage.h"
+#include "ios/third_party/blink/src/html_character_provider.h"
+#include "ios/third_party/blink/src/html_token.h"
+#include "ios/third_party/blink/src/html_tokenizer.h"
+
+namespace html_tokenizer {
+
+namespace {
+
+// Tokenizer state owned by one thread and reused for every document it
+// tokenizes. The token keeps the capacity of its name storage across
+// documents, so copied names rarely allocate once the thread is warm.
+struct Workspace {
+  WebCore::CharacterProvider provider;
+  WebCore::HTMLTokenizer tokenizer;
+  WebCore::HTMLToken token;
+};
+
+void DeleteWorkspace(void* workspace) {
+  delete static_cast<Workspace*>(workspace);
+}
+
+Workspace* GetWorkspaceForCurrentThread() {
+  static base::NoDestructor<base::ThreadLocalStorage::Slot> slot(
+      &DeleteWorkspace);
+  Workspace* workspace = static_cast<Workspace*>(slot->Get());
+  if (!workspace) {
+    workspace = new Workspace();
+    slot->Set(workspace);
+  }
+  return workspace;
+}
+
+// State shared by the tasks of one batch. Each task only writes the entry of
+// |counts| for its own document, and |counts| is only read once all tasks
+// are done.
+struct Batch : public base::RefCountedThreadSafe<Batch> {
+  Batch(std::vector<std::string> documents, TokenCallback token_callback)
+      : documents(std::move(documents)),
+        counts(this->documents.size()),
+        token_callback(std::move(token_callback)) {}
+
+  const std::vector<std::string> documents;
+  std::vector<DocumentTokenCounts> counts;
+  const TokenCallback token_callback;
+
+ private:
+  friend class base::RefCountedThreadSafe<Batch>;
+  ~Batch() = default;
+};
+
+void TokenizeDocumentInBatch(scoped_refptr<Batch> batch,
+                             size_t document_index,
+                             base::OnceClosure done) {
+  batch->counts[document_index] = TokenizeDocumentOnCurrentThread(
+      batch->documents[document_index], document_index,
+      batch->token_callback);
+  std::move(done).Run();
+}
+
+void CompleteBatch(scoped_refptr<Batch> batch,
+                   BatchCompletionCallback completion) {
+  std::move(completion).Run(std::move(batch->counts));
+}
+
+}  // namespace
+
+void TokenizeDocuments(std::vector<std::string> documents,
+                       const base::TaskTraits& traits,
+                       TokenCallback token_callback,
+                       BatchCompletionCallback completion) {
+  auto batch = base::MakeRefCounted<Batch>(std::move(documents),
+                                           std::move(token_callback));
+
+  // The last task to finish reports the result back to this sequence.
+  base::OnceClosure reply = base::BindOnce(&CompleteBatch, batch,
+                                           std::move(completion));
+  base::RepeatingClosure done = base::BarrierClosure(
+      static_cast<int>(batch->documents.size()),
+      base::BindOnce(base::IgnoreResult(&base::TaskRunner::PostTask),
+                     base::SequencedTaskRunnerHandle::Get(), FROM_HERE,
+                     std::move(reply)));
+
+  for (size_t index = 0; index < batch->documents.size(); ++index) {
+    base::PostTaskWithTraits(
+        FROM_HERE, traits,
+        base::BindOnce(&TokenizeDocumentInBatch, batch, index, done));
+  }
+}
+
+DocumentTokenCounts TokenizeDocumentOnCurrentThread(
+    const std::string& document,
+    size_t document_index,
+    const TokenCallback& token_callback) {
+  Workspace* workspace = GetWorkspaceForCurrentThread();
+  workspace->provider.setContents(
+      reinterpret_cast<const WebCore::LChar*>(document.data()),
+      document.size());
+  workspace->tokenizer.reset();
+  workspace->token.clear();
+
+  DocumentTokenCounts counts;
+  WebCore::HTMLToken& token = workspace->token;
+  while (workspace->tokenizer.nextToken(workspace->provider, token)) {
+    switch (token.type()) {
+      case WebCore::HTMLToken::Uninitialized:
+        NOTREACHED();
+        break;
+      case WebCore::HTMLToken::DOCTYPE:
+        ++counts.doctypes;
+        break;
+      case WebCore::HTMLToken::StartTag:
+        ++counts.start_tags;
+        break;
+      case WebCore::HTMLToken::EndTag:
+        ++counts.end_tags;
+        break;
+      case WebCore::HTMLToken::Comment:
+        ++counts.comments;
+        break;
+      case WebCore::HTMLToken::Character:
+        ++counts.character_runs;
+        break;
+      case WebCore::HTMLToken::EndOfFile:
+        break;
+    }
+    if (token.type() == WebCore::HTMLToken::EndOfFile)
+      break;
+    if (token.type() != WebCore::HTMLToken::Character && token_callback)
+      token_callback.Run(document_index, token);
+    token.clear();
+  }
+
+  // Do not keep pointers into |document| past this call.
+  token.clear();
+  workspace->provider.clear();
+  return counts;
+}
+
+}  // namespace html_tokenizer
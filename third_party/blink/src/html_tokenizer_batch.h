@@ -0,0 +1,61 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_THIRD_PARTY_BLINK_SRC_HTML_TOKENIZER_BATCH_H_
+#define IOS_THIRD_PARTY_BLINK_SRC_HTML_TOKENIZER_BATCH_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/task/task_traits.h"
+
+namespace WebCore {
+class HTMLToken;
+}
+
+namespace html_tokenizer {
+
+// Number of tokens of each type found in a document.
+struct DocumentTokenCounts {
+  size_t doctypes = 0;
+  size_t start_tags = 0;
+  size_t end_tags = 0;
+  size_t comments = 0;
+  size_t character_runs = 0;
+};
+
+// Called on a worker thread for every token of the document at
+// |document_index|, except character tokens. Must be thread-safe.
+using TokenCallback =
+    base::RepeatingCallback<void(size_t document_index,
+                                 const WebCore::HTMLToken& token)>;
+
+// Called on the calling sequence once every document of a batch has been
+// tokenized. |counts| is indexed like the documents.
+using BatchCompletionCallback =
+    base::OnceCallback<void(std::vector<DocumentTokenCounts> counts)>;
+
+// Tokenizes |documents| in parallel on the task scheduler, e.g. to re-index
+// every offline reading list page. Each worker thread reuses one tokenizer,
+// token and character provider for all the documents it handles, so the
+// names copied out of the input go to storage that is kept for the lifetime
+// of the thread. |token_callback| may be null. Must be called on a sequence.
+void TokenizeDocuments(std::vector<std::string> documents,
+                       const base::TaskTraits& traits,
+                       TokenCallback token_callback,
+                       BatchCompletionCallback completion);
+
+// Tokenizes |document| synchronously with the calling thread's reusable
+// tokenizer. Exposed for benchmarks.
+DocumentTokenCounts TokenizeDocumentOnCurrentThread(
+    const std::string& document,
+    size_t document_index,
+    const TokenCallback& token_callback);
+
+}  // namespace html_tokenizer
+
+#endif  // IOS_THIRD_PARTY_BLINK_SRC_HTML_TOKENIZER_BATCH_H_
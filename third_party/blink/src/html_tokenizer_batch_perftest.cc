@@ -0,0 +1,112 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_tokenizer_batch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/task/task_scheduler/scheduler_worker_pool_params.h"
+#include "base/task/task_scheduler/task_scheduler.h"
+#include "base/timer/elapsed_timer.h"
+#include "ios/chrome/test/base/perf_stats.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace html_tokenizer {
+
+namespace {
+
+// Number of documents in the benchmark batch, and the size of each.
+const size_t kDocumentCount = 256;
+const size_t kDocumentSize = 256 * 1024;
+
+// Number of times the batch is tokenized for each thread count, once it was
+// tokenized as a warm-up.
+const int kRepeatCount = 5;
+
+const double kBytesPerMegabyte = 1024.0 * 1024.0;
+
+// Builds a document of about |kDocumentSize| bytes resembling a distilled
+// article.
+std::string BuildDocument(size_t seed) {
+  std::string document = "<!DOCTYPE html><html><body>";
+  while (document.size() < kDocumentSize) {
+    base::StringAppendF(
+        &document,
+        "<p class=\"para\" id='p%zu'>Lorem ipsum dolor sit amet, consectetur "
+        "adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore "
+        "magna aliqua.<!-- %zu --> <a href=\"https://example.com/\">link</a>"
+        "</p>\n",
+        seed, document.size());
+  }
+  document += "</body></html>";
+  document.push_back('\0');
+  return document;
+}
+
+// Tokenizes |documents| with a task scheduler of |thread_count| workers and
+// returns the throughput in MB/s.
+double TokenizeWithThreads(const std::vector<std::string>* documents,
+                           int thread_count,
+                           int run) {
+  base::MessageLoop message_loop;
+  base::TaskScheduler::Create("HTMLTokenizerBatchPerfTest");
+  base::SchedulerWorkerPoolParams pool_params(thread_count,
+                                              base::TimeDelta::Max());
+  base::TaskScheduler::GetInstance()->Start(
+      base::TaskScheduler::InitParams(pool_params, pool_params));
+
+  size_t total_bytes = 0;
+  for (const std::string& document : *documents)
+    total_bytes += document.size();
+  std::vector<std::string> batch = *documents;
+  base::RunLoop run_loop;
+  base::ElapsedTimer timer;
+  TokenizeDocuments(
+      std::move(batch), {base::TaskPriority::USER_VISIBLE}, TokenCallback(),
+      base::BindOnce(
+          [](base::OnceClosure quit, std::vector<DocumentTokenCounts> counts) {
+            EXPECT_EQ(kDocumentCount, counts.size());
+            std::move(quit).Run();
+          },
+          run_loop.QuitClosure()));
+  run_loop.Run();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  base::TaskScheduler::GetInstance()->JoinForTesting();
+  base::TaskScheduler::SetInstance(nullptr);
+  return total_bytes / kBytesPerMegabyte / elapsed.InSecondsF();
+}
+
+}  // namespace
+
+// Reports batch tokenization throughput for 1, 2, 4... worker threads, up to
+// the number of cores.
+TEST(HTMLTokenizerBatchPerfTest, ScalesWithCoreCount) {
+  std::vector<std::string> documents;
+  for (size_t index = 0; index < kDocumentCount; ++index)
+    documents.push_back(BuildDocument(index));
+
+  const int core_count = base::SysInfo::NumberOfProcessors();
+  int thread_count = 1;
+  while (true) {
+    PerfRunOptions options;
+    options.repeat_count = kRepeatCount;
+    ReportPerfResult(RepeatPerfRuns(
+        "html_tokenizer_batch", base::StringPrintf("%d threads", thread_count),
+        "MB/s", options,
+        base::BindRepeating(&TokenizeWithThreads, &documents, thread_count)));
+    if (thread_count == core_count)
+      break;
+    thread_count = std::min(thread_count * 2, core_count);
+  }
+}
+
+}  // namespace html_tokenizer
@@ -0,0 +1,128 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_tokenizer_batch.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/run_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/test/scoped_task_environment.h"
+#include "ios/third_party/blink/src/html_token.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace html_tokenizer {
+
+namespace {
+
+const char kDocument[] =
+    "<!DOCTYPE html><html><body><!-- comment --><p class=\"x\">Text</p>"
+    "<BR></body></html>";
+
+// Returns |document| with the end of file marker the tokenizer expects.
+std::string WithEndOfFile(const std::string& document) {
+  return std::string(document.c_str(), document.size() + 1);
+}
+
+// Records the names of the tags reported to the token callback.
+class TagNameRecorder {
+ public:
+  void OnToken(size_t document_index, const WebCore::HTMLToken& token) {
+    if (token.type() != WebCore::HTMLToken::StartTag)
+      return;
+    std::string name;
+    for (size_t index = 0; index < token.nameLength(); ++index)
+      name.push_back(static_cast<char>(token.nameCharacterAt(index)));
+    base::AutoLock auto_lock(lock_);
+    names_.insert(std::to_string(document_index) + ":" + name);
+  }
+
+  std::set<std::string> names() {
+    base::AutoLock auto_lock(lock_);
+    return names_;
+  }
+
+ private:
+  base::Lock lock_;
+  std::set<std::string> names_;
+};
+
+}  // namespace
+
+class HTMLTokenizerBatchTest : public testing::Test {
+ protected:
+  // Tokenizes |documents| and waits for the result.
+  std::vector<DocumentTokenCounts> Tokenize(
+      std::vector<std::string> documents,
+      TokenCallback token_callback) {
+    std::vector<DocumentTokenCounts> result;
+    base::RunLoop run_loop;
+    TokenizeDocuments(
+        std::move(documents), {base::TaskPriority::USER_VISIBLE},
+        std::move(token_callback),
+        base::BindOnce(
+            [](std::vector<DocumentTokenCounts>* result,
+               base::OnceClosure quit,
+               std::vector<DocumentTokenCounts> counts) {
+              *result = std::move(counts);
+              std::move(quit).Run();
+            },
+            &result, run_loop.QuitClosure()));
+    run_loop.Run();
+    return result;
+  }
+
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+};
+
+// Tests that every document of a batch is tokenized and reported in order.
+TEST_F(HTMLTokenizerBatchTest, CountsTokensOfEachDocument) {
+  std::vector<std::string> documents;
+  documents.push_back(WithEndOfFile(kDocument));
+  documents.push_back(WithEndOfFile("plain text"));
+  documents.push_back(WithEndOfFile("<a><b></b></a>"));
+
+  std::vector<DocumentTokenCounts> counts =
+      Tokenize(std::move(documents), TokenCallback());
+  ASSERT_EQ(3U, counts.size());
+
+  EXPECT_EQ(1U, counts[0].doctypes);
+  EXPECT_EQ(4U, counts[0].start_tags);
+  EXPECT_EQ(3U, counts[0].end_tags);
+  EXPECT_EQ(1U, counts[0].comments);
+  EXPECT_EQ(1U, counts[0].character_runs);
+
+  EXPECT_EQ(0U, counts[1].start_tags);
+  EXPECT_EQ(1U, counts[1].character_runs);
+
+  EXPECT_EQ(2U, counts[2].start_tags);
+  EXPECT_EQ(2U, counts[2].end_tags);
+}
+
+// Tests that tokens are passed to the callback with their document index,
+// including names that had to be lowercased.
+TEST_F(HTMLTokenizerBatchTest, ReportsTokens) {
+  std::vector<std::string> documents;
+  documents.push_back(WithEndOfFile(kDocument));
+  documents.push_back(WithEndOfFile("<DIV>"));
+
+  TagNameRecorder recorder;
+  Tokenize(std::move(documents),
+           base::BindRepeating(&TagNameRecorder::OnToken,
+                               base::Unretained(&recorder)));
+
+  std::set<std::string> expected = {"0:html", "0:body", "0:p", "0:br",
+                                    "1:div"};
+  EXPECT_EQ(expected, recorder.names());
+}
+
+// Tests that an empty batch completes.
+TEST_F(HTMLTokenizerBatchTest, EmptyBatch) {
+  EXPECT_TRUE(Tokenize(std::vector<std::string>(), TokenCallback()).empty());
+}
+
+}  // namespace html_tokenizer
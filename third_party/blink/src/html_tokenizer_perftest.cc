@@ -0,0 +1,302 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "ios/chrome/test/base/perf_stats.h"
+#include "ios/third_party/blink/src/html_character_provider.h"
+#include "ios/third_party/blink/src/html_character_scanner.h"
+#include "ios/third_party/blink/src/html_token.h"
+#include "ios/third_party/blink/src/html_tokenizer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+// Switch naming a directory of saved pages to use as the benchmark corpus.
+// Every file in the directory is tokenized. A synthetic document is used when
+// the switch is absent.
+const char kCorpusDirSwitch[] = "html-corpus-dir";
+
+// Number of times the corpus is tokenized for each measurement, once it was
+// tokenized as a warm-up.
+const int kRepeatCount = 20;
+
+const double kBytesPerMegabyte = 1024.0 * 1024.0;
+
+// Builds a document of roughly |size| bytes that mixes long text runs,
+// attributes and comments, approximating an article page.
+std::string BuildSyntheticDocument(size_t size) {
+  std::string document = "<!DOCTYPE html><html><head><title>Title</title>";
+  int paragraph = 0;
+  while (document.size() < size) {
+    base::StringAppendF(
+        &document,
+        "<div class=\"paragraph p%d\" data-index='%d'><!-- paragraph %d -->"
+        "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+        "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim "
+        "ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut "
+        "aliquip ex ea commodo consequat.\r\nDuis aute irure dolor in "
+        "reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla "
+        "pariatur. <a href=\"https://example.com/%d\">link</a></p></div>\n",
+        paragraph, paragraph, paragraph, paragraph);
+    ++paragraph;
+  }
+  document += "</body></html>";
+  return document;
+}
+
+std::vector<std::string> LoadCorpus() {
+  std::vector<std::string> corpus;
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  if (command_line->HasSwitch(kCorpusDirSwitch)) {
+    base::FileEnumerator enumerator(
+        command_line->GetSwitchValuePath(kCorpusDirSwitch),
+        false /* recursive */, base::FileEnumerator::FILES);
+    for (base::FilePath path = enumerator.Next(); !path.empty();
+         path = enumerator.Next()) {
+      std::string contents;
+      if (base::ReadFileToString(path, &contents) && !contents.empty())
+        corpus.push_back(std::move(contents));
+    }
+  }
+  if (corpus.empty())
+    corpus.push_back(BuildSyntheticDocument(4 * 1024 * 1024));
+  return corpus;
+}
+
+// Tokenizes |length| characters at |characters| and returns the number of
+// tokens emitted.
+template <typename CharType>
+size_t Tokenize(const CharType* characters,
+                size_t length,
+                bool bulk_scanning) {
+  WebCore::CharacterProvider provider;
+  provider.setContents(characters, length);
+  WebCore::HTMLTokenizer tokenizer;
+  tokenizer.setBulkScanningEnabled(bulk_scanning);
+  WebCore::HTMLToken token;
+  size_t token_count = 0;
+  while (tokenizer.nextToken(provider, token)) {
+    ++token_count;
+    if (token.type() == WebCore::HTMLToken::EndOfFile)
+      break;
+    token.clear();
+  }
+  return token_count;
+}
+
+// Tokenizes |document| fed to the tokenizer in chunks of |chunk_size| bytes,
+// the way network reads deliver it. Returns the number of tokens emitted,
+// ignoring character tokens since those are split at chunk boundaries.
+size_t TokenizeInChunks(const std::string& document, size_t chunk_size) {
+  WebCore::CharacterProvider provider;
+  WebCore::HTMLTokenizer tokenizer;
+  WebCore::HTMLToken token;
+  size_t token_count = 0;
+  size_t position = 0;
+  while (true) {
+    if (tokenizer.nextToken(provider, token)) {
+      if (token.type() == WebCore::HTMLToken::EndOfFile)
+        break;
+      if (token.type() != WebCore::HTMLToken::Character)
+        ++token_count;
+      token.clear();
+      continue;
+    }
+    if (position == document.size()) {
+      if (provider.isComplete())
+        break;
+      provider.finish();
+      continue;
+    }
+    size_t length = std::min(chunk_size, document.size() - position);
+    provider.appendContents(std::vector<WebCore::LChar>(
+        document.begin() + position, document.begin() + position + length));
+    position += length;
+  }
+  return token_count;
+}
+
+// Tokenizes every document of |corpus| in chunks of |chunk_size| bytes and
+// returns the number of tokens emitted, ignoring character tokens.
+size_t TokenizeCorpusInChunks(const std::vector<std::string>* corpus,
+                              size_t chunk_size) {
+  size_t token_count = 0;
+  for (const std::string& document : *corpus)
+    token_count += TokenizeInChunks(document, chunk_size);
+  return token_count;
+}
+
+// Scans every document of |corpus| for '<' and NUL, with the vectorized scan if
+// |vectorized|, and returns the number of matches.
+size_t ScanCorpus(const std::vector<std::string>* corpus, bool vectorized) {
+  size_t matches = 0;
+  for (const std::string& document : *corpus) {
+    const WebCore::LChar* characters =
+        reinterpret_cast<const WebCore::LChar*>(document.data());
+    size_t remaining = document.size();
+    while (remaining) {
+      size_t index =
+          vectorized ? WebCore::findFirstOf(characters, remaining, '<', '\0')
+                     : WebCore::findFirstOfScalar<WebCore::LChar>(
+                           characters, remaining, '<', '\0');
+      if (index == remaining)
+        break;
+      ++matches;
+      characters += index + 1;
+      remaining -= index + 1;
+    }
+  }
+  return matches;
+}
+
+class HTMLTokenizerPerfTest : public testing::Test {
+ protected:
+  HTMLTokenizerPerfTest() : corpus_(LoadCorpus()), corpus_bytes_(0) {
+    for (const std::string& document : corpus_) {
+      corpus_bytes_ += document.size();
+      wide_corpus_.push_back(std::vector<WebCore::UChar>(document.begin(),
+                                                         document.end()));
+    }
+  }
+
+  // Tokenizes the whole corpus |kRepeatCount| times and reports the
+  // throughput as |test|. Returns the number of tokens of one pass.
+  size_t MeasureTokenizer(bool wide, bool bulk_scanning,
+                          const std::string& test) {
+    return MeasureThroughput(
+        test, base::BindRepeating(&HTMLTokenizerPerfTest::TokenizeCorpus,
+                                  base::Unretained(this), wide,
+                                  bulk_scanning));
+  }
+
+  // Tokenizes the whole corpus once and returns the number of tokens.
+  size_t TokenizeCorpus(bool wide, bool bulk_scanning) {
+    size_t token_count = 0;
+    for (size_t index = 0; index < corpus_.size(); ++index) {
+      if (wide) {
+        const std::vector<WebCore::UChar>& document = wide_corpus_[index];
+        token_count +=
+            Tokenize(document.data(), document.size(), bulk_scanning);
+      } else {
+        const std::string& document = corpus_[index];
+        token_count += Tokenize(
+            reinterpret_cast<const WebCore::LChar*>(document.data()),
+            document.size(), bulk_scanning);
+      }
+    }
+    return token_count;
+  }
+
+  // Runs |tokenize_corpus|, which tokenizes the whole corpus and returns the
+  // number of tokens, |kRepeatCount| times after a warm-up run. Reports the
+  // throughput as |test| and returns the number of tokens of the last run.
+  size_t MeasureThroughput(
+      const std::string& test,
+      const base::RepeatingCallback<size_t()>& tokenize_corpus) {
+    size_t token_count = 0;
+    PerfRunOptions options;
+    options.repeat_count = kRepeatCount;
+    ReportPerfResult(RepeatPerfRuns(
+        "html_tokenizer", test, "MB/s", options,
+        base::BindRepeating(
+            [](const base::RepeatingCallback<size_t()>& tokenize_corpus,
+               double megabytes, size_t* token_count, int run) {
+              base::ElapsedTimer timer;
+              *token_count = tokenize_corpus.Run();
+              return megabytes / timer.Elapsed().InSecondsF();
+            },
+            tokenize_corpus, corpus_bytes_ / kBytesPerMegabyte,
+            &token_count)));
+    return token_count;
+  }
+
+  std::vector<std::string> corpus_;
+  std::vector<std::vector<WebCore::UChar>> wide_corpus_;
+  size_t corpus_bytes_;
+};
+
+// Compares tokenizing 8-bit input one character at a time against tokenizing
+// it with bulk scanning, and checks both produce the same tokens.
+TEST_F(HTMLTokenizerPerfTest, SingleByteThroughput) {
+  size_t scalar_tokens = MeasureTokenizer(false, false, "8-bit per-character");
+  size_t bulk_tokens = MeasureTokenizer(false, true, "8-bit bulk scanning");
+  EXPECT_EQ(scalar_tokens, bulk_tokens);
+}
+
+// Same as above for 16-bit input.
+TEST_F(HTMLTokenizerPerfTest, DoubleByteThroughput) {
+  size_t scalar_tokens = MeasureTokenizer(true, false, "16-bit per-character");
+  size_t bulk_tokens = MeasureTokenizer(true, true, "16-bit bulk scanning");
+  EXPECT_EQ(scalar_tokens, bulk_tokens);
+}
+
+// Measures tokenizing input delivered in 16 KB chunks, and checks it yields
+// the same tags, comments and doctypes as the whole document.
+TEST_F(HTMLTokenizerPerfTest, ChunkedThroughput) {
+  const size_t kChunkSize = 16 * 1024;
+  size_t chunked_tokens = MeasureThroughput(
+      "8-bit 16 KB chunks",
+      base::BindRepeating(&TokenizeCorpusInChunks, &corpus_, kChunkSize));
+
+  size_t whole_tokens = 0;
+  for (const std::string& document : corpus_)
+    whole_tokens += TokenizeInChunks(document, document.size());
+  EXPECT_EQ(whole_tokens, chunked_tokens);
+}
+
+// Reports how many tag names had to be copied out of the input buffer. Names
+// are only copied when the tokenizer rewrites characters, e.g. when folding
+// upper case tag names.
+TEST_F(HTMLTokenizerPerfTest, OwnedTagNames) {
+  size_t tag_count = 0;
+  size_t owned_count = 0;
+  for (const std::string& document : corpus_) {
+    WebCore::CharacterProvider provider;
+    provider.setContents(
+        reinterpret_cast<const WebCore::LChar*>(document.data()),
+        document.size());
+    WebCore::HTMLTokenizer tokenizer;
+    WebCore::HTMLToken token;
+    while (tokenizer.nextToken(provider, token)) {
+      if (token.type() == WebCore::HTMLToken::EndOfFile)
+        break;
+      if (token.type() == WebCore::HTMLToken::StartTag ||
+          token.type() == WebCore::HTMLToken::EndTag) {
+        ++tag_count;
+        if (token.nameIsOwned())
+          ++owned_count;
+      }
+      token.clear();
+    }
+  }
+  ASSERT_LT(0u, tag_count);
+  perf_test::PrintResult("html_tokenizer", "", "owned tag names",
+                         100.0 * owned_count / tag_count, "%",
+                         true /* important */);
+}
+
+// Measures the raw scan for '<' over the corpus, without the tokenizer.
+TEST_F(HTMLTokenizerPerfTest, ScannerThroughput) {
+  size_t scalar_matches = MeasureThroughput(
+      "scan scalar", base::BindRepeating(&ScanCorpus, &corpus_, false));
+  size_t vector_matches = MeasureThroughput(
+      "scan vectorized", base::BindRepeating(&ScanCorpus, &corpus_, true));
+  EXPECT_EQ(scalar_matches, vector_matches);
+}
+
+}  // namespace
@@ -0,0 +1,210 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/third_party/blink/src/html_tokenizer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ios/third_party/blink/src/html_character_provider.h"
+#include "ios/third_party/blink/src/html_token.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace WebCore {
+
+namespace {
+
+// Documents with long runs of text for the bulk scan, and markup whose
+// lookahead ('--', 'doctype', 'public', 'system') can span chunks. They end
+// with the end of file marker the tokenizer expects.
+const char kDocument[] =
+    "<!DOCTYPE html PUBLIC \"-//W3C//DTD HTML 4.01//EN\" "
+    "\"http://www.w3.org/TR/html4/strict.dtd\"><html><head><title>A title"
+    "</title></head><body><!-- a comment --><p class=\"x\">A run of text that "
+    "is long enough to span several vectors of the scanner.</p><BR>"
+    "<img src='a.png'/><!doctype html SYSTEM \"about:legacy-compat\"></body>"
+    "</html>";
+const char kDocumentWithNul[] = "<p>a\0b</p>";
+
+// Returns |document| with the end of file marker.
+std::string WithEndOfFile(const char* document, size_t length) {
+  return std::string(document, length) + '\0';
+}
+
+// Returns a description of |token|, with the name of tags.
+std::string DescribeToken(const HTMLToken& token) {
+  std::string name;
+  if (token.type() == HTMLToken::StartTag ||
+      token.type() == HTMLToken::EndTag) {
+    for (size_t index = 0; index < token.nameLength(); ++index)
+      name.push_back(static_cast<char>(token.nameCharacterAt(index)));
+  }
+  switch (token.type()) {
+    case HTMLToken::Uninitialized:
+      return "uninitialized";
+    case HTMLToken::DOCTYPE:
+      return "<!doctype>";
+    case HTMLToken::StartTag:
+      return "<" + name + ">";
+    case HTMLToken::EndTag:
+      return "</" + name + ">";
+    case HTMLToken::Comment:
+      return "<!---->";
+    case HTMLToken::Character:
+      return "#text";
+    case HTMLToken::EndOfFile:
+      return "#eof";
+  }
+  return std::string();
+}
+
+// Appends the description of |token| to |tokens|. Consecutive character
+// tokens are merged, as a streamed document splits them at chunk boundaries.
+void AppendToken(const HTMLToken& token, std::vector<std::string>* tokens) {
+  std::string description = DescribeToken(token);
+  if (token.type() == HTMLToken::Character && !tokens->empty() &&
+      tokens->back() == description) {
+    return;
+  }
+  tokens->push_back(description);
+}
+
+// Tokenizes |document| provided as a single buffer of |CharType|.
+template <typename CharType>
+std::vector<std::string> Tokenize(const std::string& document,
+                                  bool bulk_scanning) {
+  std::vector<CharType> characters(document.begin(), document.end());
+  CharacterProvider provider;
+  provider.setContents(characters.data(), characters.size());
+  HTMLTokenizer tokenizer;
+  tokenizer.setBulkScanningEnabled(bulk_scanning);
+  HTMLToken token;
+  std::vector<std::string> tokens;
+  while (tokenizer.nextToken(provider, token)) {
+    AppendToken(token, &tokens);
+    if (token.type() == HTMLToken::EndOfFile)
+      break;
+    token.clear();
+  }
+  return tokens;
+}
+
+// Tokenizes |document| provided as a stream of chunks of |chunk_size|
+// |CharType|, appending a chunk whenever the tokenizer runs out of input.
+template <typename CharType>
+std::vector<std::string> TokenizeInChunks(const std::string& document,
+                                          size_t chunk_size,
+                                          bool bulk_scanning) {
+  CharacterProvider provider;
+  HTMLTokenizer tokenizer;
+  tokenizer.setBulkScanningEnabled(bulk_scanning);
+  HTMLToken token;
+  std::vector<std::string> tokens;
+  size_t position = 0;
+  while (true) {
+    if (tokenizer.nextToken(provider, token)) {
+      AppendToken(token, &tokens);
+      if (token.type() == HTMLToken::EndOfFile)
+        break;
+      token.clear();
+      continue;
+    }
+    if (position == document.size()) {
+      if (provider.isComplete())
+        break;
+      provider.finish();
+      continue;
+    }
+    size_t length = std::min(chunk_size, document.size() - position);
+    provider.appendContents(
+        std::vector<CharType>(document.begin() + position,
+                              document.begin() + position + length));
+    position += length;
+  }
+  return tokens;
+}
+
+// Expects |document| to yield the same tokens in chunks of every size as in a
+// single buffer.
+template <typename CharType>
+void ExpectSameTokensInChunks(const std::string& document) {
+  for (bool bulk_scanning : {false, true}) {
+    const std::vector<std::string> expected =
+        Tokenize<CharType>(document, bulk_scanning);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ("#eof", expected.back());
+    for (size_t chunk_size = 1; chunk_size <= document.size(); ++chunk_size) {
+      EXPECT_EQ(expected, TokenizeInChunks<CharType>(document, chunk_size,
+                                                     bulk_scanning))
+          << "chunk size " << chunk_size << ", bulk scanning "
+          << bulk_scanning;
+    }
+  }
+}
+
+}  // namespace
+
+// Tests that a document tokenized as a stream of 8-bit chunks yields the same
+// tokens as in a single buffer, wherever the chunk boundaries fall.
+TEST(HTMLTokenizerTest, SingleByteChunks) {
+  ExpectSameTokensInChunks<LChar>(
+      WithEndOfFile(kDocument, sizeof(kDocument) - 1));
+}
+
+// Tests that a document tokenized as a stream of 16-bit chunks yields the same
+// tokens as in a single buffer, wherever the chunk boundaries fall.
+TEST(HTMLTokenizerTest, DoubleByteChunks) {
+  ExpectSameTokensInChunks<UChar>(
+      WithEndOfFile(kDocument, sizeof(kDocument) - 1));
+}
+
+// Tests the tokens of the document, so that the comparisons above do not pass
+// on tokens that are wrong in both cases.
+TEST(HTMLTokenizerTest, Tokens) {
+  const std::vector<std::string> expected = {
+      "<!doctype>", "<html>",  "<head>", "<title>",    "#text",
+      "</title>",   "</head>", "<body>", "<!---->",    "<p>",
+      "#text",      "</p>",    "<br>",   "<img>",      "<!doctype>",
+      "</body>",    "</html>", "#eof"};
+  EXPECT_EQ(expected,
+            Tokenize<LChar>(WithEndOfFile(kDocument, sizeof(kDocument) - 1),
+                            /*bulk_scanning=*/true));
+}
+
+// Tests that a NUL character ending a chunk is not taken for the end of file
+// marker when the stream is not finished.
+TEST(HTMLTokenizerTest, NulAtEndOfChunk) {
+  const std::string document =
+      WithEndOfFile(kDocumentWithNul, sizeof(kDocumentWithNul) - 1);
+  ExpectSameTokensInChunks<LChar>(document);
+
+  const std::vector<std::string> expected = {"<p>", "#text", "</p>", "#eof"};
+  EXPECT_EQ(expected, TokenizeInChunks<LChar>(document, /*chunk_size=*/5,
+                                              /*bulk_scanning=*/true));
+}
+
+// Tests that a tag name which continues in a chunk of another width is copied
+// into the token rather than extended as a span of the input.
+TEST(HTMLTokenizerTest, NameAcrossChunksOfDifferentWidths) {
+  for (bool single_byte_first : {false, true}) {
+    CharacterProvider provider;
+    if (single_byte_first) {
+      provider.appendContents(std::vector<LChar>({'<', 'a', 'b'}));
+      provider.appendContents(std::vector<UChar>({'c', 'd', '>', '\0'}));
+    } else {
+      provider.appendContents(std::vector<UChar>({'<', 'a', 'b'}));
+      provider.appendContents(std::vector<LChar>({'c', 'd', '>', '\0'}));
+    }
+    provider.finish();
+
+    HTMLTokenizer tokenizer;
+    HTMLToken token;
+    ASSERT_TRUE(tokenizer.nextToken(provider, token));
+    EXPECT_EQ("<abcd>", DescribeToken(token));
+    EXPECT_TRUE(token.nameIsOwned());
+  }
+}
+
+}  // namespace WebCore
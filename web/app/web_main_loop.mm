@@ -27,6 +27,7 @@
 #import "ios/web/public/web_client.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/service_manager_context.h"
+#import "ios/web/web_state/js/page_script_util.h"
 #include "ios/web/web_sub_thread.h"
 #include "ios/web/web_thread_impl.h"
 #include "ios/web/webui/url_data_manager_ios.h"
@@ -218,6 +219,11 @@ void WebMainLoop::InitializeMainThread() {
 int WebMainLoop::WebThreadsStarted() {
   cookie_notification_bridge_.reset(new CookieNotificationBridge);
   service_manager_context_ = std::make_unique<ServiceManagerContext>();
+  // Read the page scripts before the first web view needs them, so that the UI
+  // thread does not block on the file reads.
+  base::PostTaskWithTraits(
+      FROM_HERE, {base::MayBlock(), base::TaskPriority::USER_VISIBLE},
+      base::BindOnce(&PreloadPageScripts));
   return result_code_;
 }
 
@@ -0,0 +1,103 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_WEB_DOWNLOAD_DOWNLOAD_DATA_WRITER_H_
+#define IOS_WEB_DOWNLOAD_DOWNLOAD_DATA_WRITER_H_
+
+#import <Foundation/Foundation.h>
+
+#include <vector>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+
+namespace net {
+class DrainableIOBuffer;
+class URLFetcherResponseWriter;
+}  // namespace net
+
+namespace web {
+
+// Writes the data received by a download task to a URLFetcherResponseWriter.
+// A single received NSData is passed to the response writer without being
+// copied. The data received while a write is in progress is queued, and the
+// queued chunks are coalesced into a single write once that write completes,
+// so a slow response writer (e.g. a file writer) gets a few large sequential
+// writes instead of one write per network chunk.
+class DownloadDataWriter {
+ public:
+  // Amount of received data which can wait to be written before Write()
+  // callbacks are delayed.
+  static const NSUInteger kMaxUnwrittenBytes = 4 * 1024 * 1024;
+
+  // |writer| must be initialized and must outlive this object.
+  explicit DownloadDataWriter(net::URLFetcherResponseWriter* writer);
+  ~DownloadDataWriter();
+
+  // Queues |data| for writing. |callback| is called once less than
+  // kMaxUnwrittenBytes are waiting to be written, which the caller should wait
+  // for before passing more data. |callback| may be called synchronously, and
+  // is called when this object is destroyed if it has not been called yet.
+  void Write(NSData* data, base::OnceClosure callback);
+
+  // Calls |callback| once all the queued data has been written, with net::OK
+  // or the error returned by the response writer. |callback| may be called
+  // synchronously.
+  void Flush(base::OnceCallback<void(int)> callback);
+
+  // Number of bytes passed to the response writer which were written.
+  int64_t bytes_written() const { return bytes_written_; }
+
+ private:
+  // Writes the queued data until a write is pending or the queue is empty.
+  void WriteQueuedData();
+
+  // Called when a pending write of the response writer has completed.
+  void OnWriteCompleted(int result);
+
+  // Updates the state after the response writer has written |result| bytes of
+  // |write_buffer_|, or has failed with |result| error.
+  void DidWrite(int result);
+
+  // Returns a buffer with the queued data and clears the queue. A single
+  // contiguous NSData is wrapped without being copied.
+  scoped_refptr<net::DrainableIOBuffer> TakeQueuedData();
+
+  // Runs the Write() callbacks if the queue is short enough, and the Flush()
+  // callback if all the data has been written. May delete this object.
+  void RunCallbacks();
+
+  // Weak reference to the writer the data is written to.
+  net::URLFetcherResponseWriter* writer_ = nullptr;
+
+  // Received data waiting for |write_buffer_| to be written.
+  NSMutableArray<NSData*>* queued_data_ = nil;
+
+  // Buffer being written. Null if no write is in progress.
+  scoped_refptr<net::DrainableIOBuffer> write_buffer_;
+
+  // Size of the data queued or being written.
+  NSUInteger unwritten_bytes_ = 0;
+  int64_t bytes_written_ = 0;
+
+  // Error returned by the response writer. When set, the received data is
+  // dropped.
+  int error_ = 0;
+
+  std::vector<base::OnceClosure> write_callbacks_;
+  base::OnceCallback<void(int)> flush_callback_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  base::WeakPtrFactory<DownloadDataWriter> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(DownloadDataWriter);
+};
+
+}  // namespace web
+
+#endif  // IOS_WEB_DOWNLOAD_DOWNLOAD_DATA_WRITER_H_
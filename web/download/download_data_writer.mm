@@ -0,0 +1,171 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/web/download/download_data_writer.h"
+
+#include <string.h>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/url_request/url_fetcher_response_writer.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace {
+
+// IOBuffer which points to a byte range of NSData and keeps the NSData alive,
+// so the received data can be written without being copied.
+class NSDataIOBuffer : public net::WrappedIOBuffer {
+ public:
+  NSDataIOBuffer(NSData* data, const void* bytes)
+      : net::WrappedIOBuffer(static_cast<const char*>(bytes)), data_(data) {}
+
+ private:
+  ~NSDataIOBuffer() override = default;
+
+  NSData* data_ = nil;
+
+  DISALLOW_COPY_AND_ASSIGN(NSDataIOBuffer);
+};
+
+}  // namespace
+
+namespace web {
+
+const NSUInteger DownloadDataWriter::kMaxUnwrittenBytes;
+
+DownloadDataWriter::DownloadDataWriter(net::URLFetcherResponseWriter* writer)
+    : writer_(writer),
+      queued_data_([[NSMutableArray alloc] init]),
+      weak_factory_(this) {
+  DCHECK(writer_);
+}
+
+DownloadDataWriter::~DownloadDataWriter() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // The callers may be blocked until their data is written.
+  for (base::OnceClosure& callback : write_callbacks_)
+    std::move(callback).Run();
+}
+
+void DownloadDataWriter::Write(NSData* data, base::OnceClosure callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (error_ != net::OK || !data.length) {
+    std::move(callback).Run();
+    return;
+  }
+
+  [queued_data_ addObject:data];
+  unwritten_bytes_ += data.length;
+  write_callbacks_.push_back(std::move(callback));
+  if (write_buffer_) {
+    RunCallbacks();
+  } else {
+    WriteQueuedData();
+  }
+}
+
+void DownloadDataWriter::Flush(base::OnceCallback<void(int)> callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(!flush_callback_);
+  flush_callback_ = std::move(callback);
+  RunCallbacks();
+}
+
+void DownloadDataWriter::WriteQueuedData() {
+  while (error_ == net::OK && (write_buffer_ || queued_data_.count)) {
+    if (!write_buffer_)
+      write_buffer_ = TakeQueuedData();
+    int result = writer_->Write(
+        write_buffer_.get(), write_buffer_->BytesRemaining(),
+        base::BindOnce(&DownloadDataWriter::OnWriteCompleted,
+                       weak_factory_.GetWeakPtr()));
+    if (result == net::ERR_IO_PENDING)
+      break;
+    DidWrite(result);
+  }
+  RunCallbacks();
+}
+
+void DownloadDataWriter::OnWriteCompleted(int result) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DidWrite(result);
+  WriteQueuedData();
+}
+
+void DownloadDataWriter::DidWrite(int result) {
+  DCHECK(write_buffer_);
+  if (result <= 0) {
+    error_ = result ? result : net::ERR_FAILED;
+    write_buffer_ = nullptr;
+    [queued_data_ removeAllObjects];
+    unwritten_bytes_ = 0;
+    return;
+  }
+
+  bytes_written_ += result;
+  unwritten_bytes_ -= result;
+  write_buffer_->DidConsume(result);
+  if (!write_buffer_->BytesRemaining())
+    write_buffer_ = nullptr;
+}
+
+scoped_refptr<net::DrainableIOBuffer> DownloadDataWriter::TakeQueuedData() {
+  DCHECK(queued_data_.count);
+  NSUInteger size = 0;
+  for (NSData* data in queued_data_)
+    size += data.length;
+
+  scoped_refptr<net::IOBuffer> buffer;
+  if (queued_data_.count == 1) {
+    // NSData is usually contiguous, in which case it can be wrapped. The bytes
+    // of a discontiguous NSData are coalesced below.
+    NSData* data = queued_data_.firstObject;
+    __block const void* contiguous_bytes = nullptr;
+    [data enumerateByteRangesUsingBlock:^(const void* bytes, NSRange range,
+                                          BOOL* stop) {
+      contiguous_bytes = range.length == size ? bytes : nullptr;
+      *stop = YES;
+    }];
+    if (contiguous_bytes)
+      buffer = base::MakeRefCounted<NSDataIOBuffer>(data, contiguous_bytes);
+  }
+
+  if (!buffer) {
+    buffer = base::MakeRefCounted<net::IOBuffer>(size);
+    __block char* destination = buffer->data();
+    for (NSData* data in queued_data_) {
+      [data enumerateByteRangesUsingBlock:^(const void* bytes, NSRange range,
+                                            BOOL*) {
+        memcpy(destination, bytes, range.length);
+        destination += range.length;
+      }];
+    }
+  }
+
+  [queued_data_ removeAllObjects];
+  return base::MakeRefCounted<net::DrainableIOBuffer>(buffer.get(), size);
+}
+
+void DownloadDataWriter::RunCallbacks() {
+  // The callbacks are moved out first, as they may delete this object.
+  std::vector<base::OnceClosure> write_callbacks;
+  if (unwritten_bytes_ < kMaxUnwrittenBytes)
+    write_callbacks.swap(write_callbacks_);
+  base::OnceCallback<void(int)> flush_callback;
+  if (!unwritten_bytes_)
+    flush_callback = std::move(flush_callback_);
+  int error = error_;
+
+  for (base::OnceClosure& callback : write_callbacks)
+    std::move(callback).Run();
+  if (flush_callback)
+    std::move(flush_callback).Run(error);
+}
+
+}  // namespace web
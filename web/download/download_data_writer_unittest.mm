@@ -0,0 +1,210 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/web/download/download_data_writer.h"
+
+#include <limits.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/url_request/url_fetcher_response_writer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace web {
+
+namespace {
+
+// Response writer which records the written data. Completes the writes
+// asynchronously if |async_| is set.
+class FakeResponseWriter : public net::URLFetcherResponseWriter {
+ public:
+  FakeResponseWriter() = default;
+
+  // net::URLFetcherResponseWriter overrides:
+  int Initialize(net::CompletionOnceCallback callback) override {
+    return net::OK;
+  }
+  int Write(net::IOBuffer* buffer,
+            int num_bytes,
+            net::CompletionOnceCallback callback) override {
+    write_pointers_.push_back(buffer->data());
+    int result = write_error_;
+    if (result == net::OK) {
+      result = std::min(num_bytes, max_write_size_);
+      data_.append(buffer->data(), result);
+    }
+    if (!async_)
+      return result;
+    pending_result_ = result;
+    pending_callback_ = std::move(callback);
+    return net::ERR_IO_PENDING;
+  }
+  int Finish(int net_error, net::CompletionOnceCallback callback) override {
+    return net::OK;
+  }
+
+  // Completes the pending asynchronous write.
+  void CompletePendingWrite() {
+    ASSERT_FALSE(pending_callback_.is_null());
+    std::move(pending_callback_).Run(pending_result_);
+  }
+
+  bool has_pending_write() const { return !pending_callback_.is_null(); }
+
+  // Pointers to the data of the buffers passed to Write().
+  std::vector<const char*> write_pointers_;
+  // Written data.
+  std::string data_;
+
+  bool async_ = false;
+  int max_write_size_ = INT_MAX;
+  int write_error_ = net::OK;
+
+ private:
+  int pending_result_ = net::OK;
+  net::CompletionOnceCallback pending_callback_;
+};
+
+}  // namespace
+
+// Test fixture for testing DownloadDataWriter class.
+class DownloadDataWriterTest : public PlatformTest {
+ protected:
+  DownloadDataWriterTest()
+      : data_writer_(std::make_unique<DownloadDataWriter>(&writer_)) {}
+
+  // Writes |data| and increments |write_callback_count_| when the Write()
+  // callback is called.
+  void Write(NSData* data) {
+    int* write_callback_count = &write_callback_count_;
+    data_writer_->Write(data, base::BindOnce(^{
+                          ++*write_callback_count;
+                        }));
+  }
+
+  // Returns NSData with the given null terminated C-string.
+  NSData* DataWithString(const char data_str[]) {
+    return [NSData dataWithBytes:data_str length:strlen(data_str)];
+  }
+
+  // Flushes the writer. |flush_result_| is set to the result once all the
+  // data is written.
+  void Flush() {
+    flush_result_ = net::ERR_IO_PENDING;
+    int* flush_result = &flush_result_;
+    data_writer_->Flush(base::BindOnce(^(int result) {
+      *flush_result = result;
+    }));
+  }
+
+  FakeResponseWriter writer_;
+  std::unique_ptr<DownloadDataWriter> data_writer_;
+  int write_callback_count_ = 0;
+  int flush_result_ = net::ERR_IO_PENDING;
+};
+
+// Tests that the received data is written without being copied.
+TEST_F(DownloadDataWriterTest, WriteWithoutCopying) {
+  NSData* data = DataWithString("foo");
+  Write(data);
+  EXPECT_EQ(1, write_callback_count_);
+  ASSERT_EQ(1U, writer_.write_pointers_.size());
+  EXPECT_EQ(data.bytes, writer_.write_pointers_[0]);
+  EXPECT_EQ("foo", writer_.data_);
+  EXPECT_EQ(3, data_writer_->bytes_written());
+
+  Flush();
+  EXPECT_EQ(net::OK, flush_result_);
+}
+
+// Tests that the data received while a write is in progress is coalesced into
+// a single write.
+TEST_F(DownloadDataWriterTest, CoalesceWrites) {
+  writer_.async_ = true;
+  Write(DataWithString("foo"));
+  Write(DataWithString("bar"));
+  Write(DataWithString("buzz"));
+  EXPECT_EQ(3, write_callback_count_);
+  EXPECT_EQ(1U, writer_.write_pointers_.size());
+  Flush();
+  EXPECT_EQ(net::ERR_IO_PENDING, flush_result_);
+
+  writer_.CompletePendingWrite();
+  EXPECT_EQ(2U, writer_.write_pointers_.size());
+  EXPECT_EQ("foobarbuzz", writer_.data_);
+  EXPECT_EQ(3, data_writer_->bytes_written());
+  EXPECT_EQ(net::ERR_IO_PENDING, flush_result_);
+
+  writer_.CompletePendingWrite();
+  EXPECT_EQ(10, data_writer_->bytes_written());
+  EXPECT_EQ(net::OK, flush_result_);
+}
+
+// Tests that the data is entirely written when the response writer writes
+// only a part of the buffer.
+TEST_F(DownloadDataWriterTest, PartialWrites) {
+  writer_.max_write_size_ = 2;
+  Write(DataWithString("foobar"));
+  EXPECT_EQ(3U, writer_.write_pointers_.size());
+  EXPECT_EQ("foobar", writer_.data_);
+  EXPECT_EQ(6, data_writer_->bytes_written());
+
+  Flush();
+  EXPECT_EQ(net::OK, flush_result_);
+}
+
+// Tests that the received data is dropped once the response writer has failed.
+TEST_F(DownloadDataWriterTest, WriteError) {
+  writer_.write_error_ = net::ERR_FILE_NO_SPACE;
+  Write(DataWithString("foo"));
+  Flush();
+  EXPECT_EQ(net::ERR_FILE_NO_SPACE, flush_result_);
+
+  Write(DataWithString("bar"));
+  EXPECT_EQ(2, write_callback_count_);
+  EXPECT_EQ(1U, writer_.write_pointers_.size());
+  EXPECT_EQ(0, data_writer_->bytes_written());
+}
+
+// Tests that Write() callbacks are delayed while too much data is waiting to
+// be written.
+TEST_F(DownloadDataWriterTest, WaitForQueuedData) {
+  writer_.async_ = true;
+  Write(DataWithString("foo"));
+  Write([NSMutableData dataWithLength:DownloadDataWriter::kMaxUnwrittenBytes]);
+  EXPECT_EQ(1, write_callback_count_);
+
+  // The large data is still being written.
+  writer_.CompletePendingWrite();
+  EXPECT_EQ(1, write_callback_count_);
+
+  writer_.CompletePendingWrite();
+  EXPECT_EQ(2, write_callback_count_);
+  EXPECT_FALSE(writer_.has_pending_write());
+}
+
+// Tests that the delayed Write() callbacks are called when DownloadDataWriter
+// is destroyed.
+TEST_F(DownloadDataWriterTest, Destruction) {
+  writer_.async_ = true;
+  Write(DataWithString("foo"));
+  Write([NSMutableData dataWithLength:DownloadDataWriter::kMaxUnwrittenBytes]);
+  EXPECT_EQ(1, write_callback_count_);
+
+  data_writer_.reset();
+  EXPECT_EQ(2, write_callback_count_);
+}
+
+}  // namespace web
@@ -12,6 +12,8 @@
 #import "ios/web/public/download/download_task.h"
 #include "url/gurl.h"
 
+@class NSHTTPURLResponse;
+@class NSURLResponse;
 @class NSURLSession;
 
 namespace net {
@@ -20,11 +22,14 @@ class URLFetcherResponseWriter;
 
 namespace web {
 
+class DownloadDataWriter;
 class DownloadTaskObserver;
 class WebState;
 
 // Implements DownloadTask interface. Uses background NSURLSession as
-// implementation.
+// implementation. A download interrupted by a connection loss or by the app
+// suspension is resumed with a range request if the server supports it and the
+// content has not changed since it was partially downloaded.
 class DownloadTaskImpl : public DownloadTask {
  public:
   class Delegate {
@@ -102,6 +107,29 @@ class DownloadTaskImpl : public DownloadTask {
   // NSURLSession does not support data URLs.
   void StartDataUrlParsing();
 
+  // Stores the validators of |response| which allow resuming the download.
+  void UpdateResumeValidators(NSHTTPURLResponse* response);
+
+  // Returns true if the download can be resumed after a session task has
+  // completed. |is_current_task| is false if the completed session task is not
+  // |session_task_| anymore (e.g. if the download was cancelled).
+  bool CanResume(bool is_current_task) const;
+
+  // Resumes the download by requesting the content which has not been written
+  // yet.
+  void Resume();
+
+  // Called when the response for the session task was received. Calls
+  // |completion_handler| once the response can be received. Resets the writer
+  // if the server has sent the whole content to a resume request.
+  void OnResponseReceived(
+      NSURLResponse* response,
+      void (^completion_handler)(NSURLSessionResponseDisposition));
+
+  // Called when the session task has completed and the received data has been
+  // written, with |write_error| if the writer has failed.
+  void OnSessionTaskCompleted(bool is_current_task, int write_error);
+
   // Called when download task was updated.
   void OnDownloadUpdated();
 
@@ -118,6 +146,8 @@ class DownloadTaskImpl : public DownloadTask {
   // Back up corresponding public methods of DownloadTask interface.
   State state_ = State::kNotStarted;
   std::unique_ptr<net::URLFetcherResponseWriter> writer_;
+  // Writes the received data to |writer_|.
+  std::unique_ptr<DownloadDataWriter> data_writer_;
   GURL original_url_;
   int error_code_ = 0;
   int http_code_ = -1;
@@ -131,6 +161,15 @@ class DownloadTaskImpl : public DownloadTask {
   NSString* identifier_ = nil;
   bool has_performed_background_download_ = false;
 
+  // Validators of the downloaded content, which are sent with the range
+  // request when the download is resumed. Persist across resumes.
+  std::string etag_;
+  std::string last_modified_;
+  bool accepts_ranges_ = false;
+  // Number of bytes written before the current session task was started.
+  int64_t resume_offset_ = 0;
+  int resume_attempts_ = 0;
+
   const WebState* web_state_ = nullptr;
   Delegate* delegate_ = nullptr;
   NSURLSession* session_ = nil;
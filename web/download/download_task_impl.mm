@@ -7,9 +7,14 @@
 #import <Foundation/Foundation.h>
 #import <WebKit/WebKit.h>
 
+#include <inttypes.h>
+
 #include "base/bind.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/task/post_task.h"
+#import "ios/web/download/download_data_writer.h"
 #import "ios/web/net/cookies/wk_cookie_util.h"
 #include "ios/web/public/browser_state.h"
 #import "ios/web/public/download/download_task_observer.h"
@@ -22,6 +27,9 @@
 #include "net/base/io_buffer.h"
 #import "net/base/mac/url_conversions.h"
 #include "net/base/net_errors.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_status_code.h"
 #include "net/url_request/url_fetcher_response_writer.h"
 #include "url/url_constants.h"
 
@@ -38,9 +46,16 @@ namespace {
 using PropertiesBlock = void (^)(NSURLSessionTask*,
                                  NSError*,
                                  bool terminal_callback);
-// Writes buffer and calls |completionHandler| when done.
-using DataBlock = void (^)(scoped_refptr<net::IOBufferWithSize> buffer,
-                           void (^completionHandler)());
+// Writes |data| and calls |completionHandler| when more data can be received.
+using DataBlock = void (^)(NSData* data, void (^completionHandler)());
+// Decides whether |response| should be received, and calls |completionHandler|
+// with the decision.
+using ResponseBlock =
+    void (^)(NSURLResponse* response,
+             void (^completionHandler)(NSURLSessionResponseDisposition));
+
+// Maximum number of times an interrupted download is resumed.
+const int kMaxResumeAttempts = 5;
 
 // Translates an CFNetwork error code to a net error code. Returns 0 if |error|
 // is nil.
@@ -54,15 +69,9 @@ int GetNetErrorCodeFromNSError(NSError* error, NSURL* url) {
   return error_code;
 }
 
-// Creates a new buffer from raw |data| and |size|.
-scoped_refptr<net::IOBufferWithSize> GetBuffer(const void* data, size_t size) {
-  auto buffer = base::MakeRefCounted<net::IOBufferWithSize>(size);
-  memcpy(buffer->data(), data, size);
-  return buffer;
-}
-
 // Percent complete for the given NSURLSessionTask within [0..100] range.
-int GetTaskPercentComplete(NSURLSessionTask* task) {
+// |resume_offset| is the number of bytes received before |task| was started.
+int GetTaskPercentComplete(NSURLSessionTask* task, int64_t resume_offset) {
   DCHECK(task);
   if (!task.countOfBytesExpectedToReceive) {
     return 100;
@@ -71,7 +80,35 @@ int GetTaskPercentComplete(NSURLSessionTask* task) {
     return -1;
   }
   DCHECK_GE(task.countOfBytesExpectedToReceive, task.countOfBytesReceived);
-  return 100.0 * task.countOfBytesReceived / task.countOfBytesExpectedToReceive;
+  return 100.0 * (resume_offset + task.countOfBytesReceived) /
+         (resume_offset + task.countOfBytesExpectedToReceive);
+}
+
+// Returns the value of |response| header with the given |name|, or an empty
+// string. Header names are case insensitive.
+std::string GetHeaderValue(NSHTTPURLResponse* response, NSString* name) {
+  for (NSString* key in response.allHeaderFields) {
+    if ([key caseInsensitiveCompare:name] == NSOrderedSame)
+      return base::SysNSStringToUTF8(response.allHeaderFields[key]);
+  }
+  return std::string();
+}
+
+// Returns true if a download which has failed with |error_code| may succeed if
+// it is resumed right away, which is the case when the connection was lost or
+// when the background session was disconnected while the app was suspended.
+bool IsResumableError(int error_code) {
+  switch (error_code) {
+    case net::ERR_CONNECTION_ABORTED:
+    case net::ERR_CONNECTION_CLOSED:
+    case net::ERR_CONNECTION_RESET:
+    case net::ERR_CONNECTION_TIMED_OUT:
+    case net::ERR_NETWORK_CHANGED:
+    case net::ERR_TIMED_OUT:
+      return true;
+    default:
+      return false;
+  }
 }
 
 }  // namespace
@@ -88,9 +125,13 @@ int GetTaskPercentComplete(NSURLSessionTask* task) {
 // Called when DownloadTaskImpl should write a chunk of downloaded data.
 @property(nonatomic, readonly) DataBlock dataBlock;
 
+// Called when DownloadTaskImpl should decide whether to receive a response.
+@property(nonatomic, readonly) ResponseBlock responseBlock;
+
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithPropertiesBlock:(PropertiesBlock)propertiesBlock
                               dataBlock:(DataBlock)dataBlock
+                          responseBlock:(ResponseBlock)responseBlock
     NS_DESIGNATED_INITIALIZER;
 @end
 
@@ -98,14 +139,18 @@ int GetTaskPercentComplete(NSURLSessionTask* task) {
 
 @synthesize propertiesBlock = _propertiesBlock;
 @synthesize dataBlock = _dataBlock;
+@synthesize responseBlock = _responseBlock;
 
 - (instancetype)initWithPropertiesBlock:(PropertiesBlock)propertiesBlock
-                              dataBlock:(DataBlock)dataBlock {
+                              dataBlock:(DataBlock)dataBlock
+                          responseBlock:(ResponseBlock)responseBlock {
   DCHECK(propertiesBlock);
   DCHECK(dataBlock);
+  DCHECK(responseBlock);
   if ((self = [super init])) {
     _propertiesBlock = propertiesBlock;
     _dataBlock = dataBlock;
+    _responseBlock = responseBlock;
   }
   return self;
 }
@@ -125,26 +170,23 @@ int GetTaskPercentComplete(NSURLSessionTask* task) {
 - (void)URLSession:(NSURLSession*)session
           dataTask:(NSURLSessionDataTask*)task
     didReceiveData:(NSData*)data {
-  // Block this background queue until the the data is written.
+  // Block this background queue until the the data is accepted by the writer.
+  // |data| is passed to the writer as is, so it is not copied.
   dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
   __weak CRWURLSessionDelegate* weakSelf = self;
-  using Bytes = const void* _Nonnull;
-  [data enumerateByteRangesUsingBlock:^(Bytes bytes, NSRange range, BOOL*) {
-    auto buffer = GetBuffer(bytes, range.length);
-    base::PostTaskWithTraits(FROM_HERE, {WebThread::UI}, base::BindOnce(^{
-                               CRWURLSessionDelegate* strongSelf = weakSelf;
-                               if (!strongSelf.dataBlock) {
-                                 dispatch_semaphore_signal(semaphore);
-                                 return;
-                               }
-                               strongSelf.dataBlock(std::move(buffer), ^{
-                                 // Data was written to disk, unblock queue to
-                                 // read the next chunk of downloaded data.
-                                 dispatch_semaphore_signal(semaphore);
-                               });
-                             }));
-    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
-  }];
+  base::PostTaskWithTraits(FROM_HERE, {WebThread::UI}, base::BindOnce(^{
+                             CRWURLSessionDelegate* strongSelf = weakSelf;
+                             if (!strongSelf.dataBlock) {
+                               dispatch_semaphore_signal(semaphore);
+                               return;
+                             }
+                             strongSelf.dataBlock(data, ^{
+                               // Writer can accept more data, unblock queue to
+                               // read the next chunk of downloaded data.
+                               dispatch_semaphore_signal(semaphore);
+                             });
+                           }));
+  dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
   base::PostTaskWithTraits(FROM_HERE, {WebThread::UI}, base::BindOnce(^{
                              CRWURLSessionDelegate* strongSelf = weakSelf;
                              if (strongSelf.propertiesBlock)
@@ -153,6 +195,23 @@ int GetTaskPercentComplete(NSURLSessionTask* task) {
                            }));
 }
 
+- (void)URLSession:(NSURLSession*)session
+              dataTask:(NSURLSessionDataTask*)task
+    didReceiveResponse:(NSURLResponse*)response
+     completionHandler:
+         (void (^)(NSURLSessionResponseDisposition))completionHandler {
+  __weak CRWURLSessionDelegate* weakSelf = self;
+  base::PostTaskWithTraits(FROM_HERE, {WebThread::UI}, base::BindOnce(^{
+                             CRWURLSessionDelegate* strongSelf = weakSelf;
+                             if (!strongSelf.responseBlock) {
+                               completionHandler(NSURLSessionResponseCancel);
+                               return;
+                             }
+                             strongSelf.responseBlock(response,
+                                                      completionHandler);
+                           }));
+}
+
 - (void)URLSession:(NSURLSession*)session
     didReceiveChallenge:(NSURLAuthenticationChallenge*)challenge
       completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition,
@@ -228,8 +287,14 @@ void DownloadTaskImpl::Start(
   DCHECK_CURRENTLY_ON(web::WebThread::UI);
   DCHECK_NE(state_, State::kInProgress);
   writer_ = std::move(writer);
+  data_writer_ = std::make_unique<DownloadDataWriter>(writer_.get());
   percent_complete_ = 0;
   received_bytes_ = 0;
+  etag_.clear();
+  last_modified_.clear();
+  accepts_ranges_ = false;
+  resume_offset_ = 0;
+  resume_attempts_ = 0;
   state_ = State::kInProgress;
 
   if (original_url_.SchemeIs(url::kDataScheme)) {
@@ -352,20 +417,26 @@ NSURLSession* DownloadTaskImpl::CreateSession(NSString* identifier,
 
         error_code_ =
             GetNetErrorCodeFromNSError(error, task.currentRequest.URL);
-        percent_complete_ = GetTaskPercentComplete(task);
-        received_bytes_ = task.countOfBytesReceived;
+        percent_complete_ = GetTaskPercentComplete(task, resume_offset_);
+        received_bytes_ = resume_offset_ + task.countOfBytesReceived;
         if (total_bytes_ == -1 || task.countOfBytesExpectedToReceive) {
           // countOfBytesExpectedToReceive can be 0 if the device is offline.
           // In that case total_bytes_ should remain unchanged if the total
           // bytes count is already known.
-          total_bytes_ = task.countOfBytesExpectedToReceive;
+          total_bytes_ = task.countOfBytesExpectedToReceive == -1
+                             ? -1
+                             : resume_offset_ +
+                                   task.countOfBytesExpectedToReceive;
         }
         if (task.response.MIMEType) {
           mime_type_ = base::SysNSStringToUTF8(task.response.MIMEType);
         }
         if ([task.response isKindOfClass:[NSHTTPURLResponse class]]) {
-          http_code_ =
-              static_cast<NSHTTPURLResponse*>(task.response).statusCode;
+          NSHTTPURLResponse* response =
+              static_cast<NSHTTPURLResponse*>(task.response);
+          http_code_ = response.statusCode;
+          if (terminal_callback)
+            UpdateResumeValidators(response);
         }
 
         if (!terminal_callback) {
@@ -374,25 +445,29 @@ NSURLSession* DownloadTaskImpl::CreateSession(NSString* identifier,
           return;
         }
 
-        // Download has finished, so finalize the writer and signal completion.
-        auto callback = base::Bind(&DownloadTaskImpl::OnDownloadFinished,
-                                   weak_factory_.GetWeakPtr());
-        if (writer_->Finish(error_code_, callback) != net::ERR_IO_PENDING) {
-          OnDownloadFinished(error_code_);
-        }
+        // Session task has finished, so write the remaining data before
+        // resuming the download or finalizing the writer.
+        data_writer_->Flush(
+            base::BindOnce(&DownloadTaskImpl::OnSessionTaskCompleted,
+                           weak_factory_.GetWeakPtr(), task == session_task_));
       }
-      dataBlock:^(scoped_refptr<net::IOBufferWithSize> buffer,
-                  void (^completion_handler)()) {
+      dataBlock:^(NSData* data, void (^completion_handler)()) {
         if (weak_this.get()) {
-          net::CompletionCallback callback = base::BindRepeating(^(int) {
-            completion_handler();
-          });
-          if (writer_->Write(buffer.get(), buffer->size(), callback) ==
-              net::ERR_IO_PENDING) {
-            return;
-          }
+          data_writer_->Write(data, base::BindOnce(^{
+                                completion_handler();
+                              }));
+          return;
         }
         completion_handler();
+      }
+      responseBlock:^(NSURLResponse* response,
+                      void (^completion_handler)(
+                          NSURLSessionResponseDisposition)) {
+        if (!weak_this.get()) {
+          completion_handler(NSURLSessionResponseCancel);
+          return;
+        }
+        OnResponseReceived(response, completion_handler);
       }];
   return delegate_->CreateSession(identifier, cookies, session_delegate,
                                   /*queue=*/nil);
@@ -459,6 +534,121 @@ void DownloadTaskImpl::StartDataUrlParsing() {
   }
 }
 
+void DownloadTaskImpl::UpdateResumeValidators(NSHTTPURLResponse* response) {
+  // Resumed downloads keep the validators of the original response, unless
+  // the server has sent the whole content again.
+  if (response.statusCode == net::HTTP_PARTIAL_CONTENT)
+    return;
+
+  etag_.clear();
+  last_modified_.clear();
+  accepts_ranges_ = false;
+  if (response.statusCode != net::HTTP_OK)
+    return;
+
+  // Weak entity tags can not be used in If-Range header.
+  std::string etag = GetHeaderValue(response, @"ETag");
+  if (!base::StartsWith(etag, "W/", base::CompareCase::SENSITIVE))
+    etag_ = etag;
+  last_modified_ = GetHeaderValue(response, @"Last-Modified");
+  accepts_ranges_ = GetHeaderValue(response, @"Accept-Ranges") == "bytes";
+}
+
+bool DownloadTaskImpl::CanResume(bool is_current_task) const {
+  return is_current_task && state_ == State::kInProgress &&
+         IsResumableError(error_code_) && accepts_ranges_ &&
+         (!etag_.empty() || !last_modified_.empty()) &&
+         data_writer_->bytes_written() > 0 &&
+         resume_attempts_ < kMaxResumeAttempts;
+}
+
+void DownloadTaskImpl::Resume() {
+  DCHECK(CanResume(/*is_current_task=*/true));
+  ++resume_attempts_;
+  resume_offset_ = data_writer_->bytes_written();
+  error_code_ = 0;
+
+  // Ask for the remaining content only if the content has not changed since
+  // it was partially downloaded, and for the whole content otherwise.
+  NSMutableURLRequest* request = [NSMutableURLRequest
+      requestWithURL:net::NSURLWithGURL(GetOriginalUrl())];
+  std::string range =
+      net::HttpByteRange::RightUnbounded(resume_offset_).GetHeaderValue();
+  [request setValue:base::SysUTF8ToNSString(range)
+      forHTTPHeaderField:@(net::HttpRequestHeaders::kRange)];
+  [request setValue:base::SysUTF8ToNSString(etag_.empty() ? last_modified_
+                                                          : etag_)
+      forHTTPHeaderField:@(net::HttpRequestHeaders::kIfRange)];
+
+  session_task_ = [session_ dataTaskWithRequest:request];
+  [session_task_ resume];
+  OnDownloadUpdated();
+}
+
+void DownloadTaskImpl::OnResponseReceived(
+    NSURLResponse* response,
+    void (^completion_handler)(NSURLSessionResponseDisposition)) {
+  DCHECK_CURRENTLY_ON(web::WebThread::UI);
+  if (!resume_offset_) {
+    completion_handler(NSURLSessionResponseAllow);
+    return;
+  }
+
+  NSHTTPURLResponse* http_response =
+      [response isKindOfClass:[NSHTTPURLResponse class]]
+          ? static_cast<NSHTTPURLResponse*>(response)
+          : nil;
+  if (http_response.statusCode == net::HTTP_PARTIAL_CONTENT) {
+    // The remaining content is expected to start right after the written
+    // data.
+    std::string content_range =
+        GetHeaderValue(http_response, @"Content-Range");
+    std::string expected_start =
+        base::StringPrintf("bytes %" PRId64 "-", resume_offset_);
+    completion_handler(
+        base::StartsWith(content_range, expected_start,
+                         base::CompareCase::INSENSITIVE_ASCII)
+            ? NSURLSessionResponseAllow
+            : NSURLSessionResponseCancel);
+    return;
+  }
+  if (http_response.statusCode != net::HTTP_OK) {
+    // The response is an error, e.g. because the content is no longer
+    // available, so the download fails.
+    completion_handler(NSURLSessionResponseCancel);
+    return;
+  }
+
+  // The server has sent the whole content, so the written data is discarded.
+  resume_offset_ = 0;
+  data_writer_ = std::make_unique<DownloadDataWriter>(writer_.get());
+  void (^on_writer_initialized)(int) = ^(int error_code) {
+    completion_handler(error_code == net::OK ? NSURLSessionResponseAllow
+                                             : NSURLSessionResponseCancel);
+  };
+  int result = writer_->Initialize(base::BindOnce(on_writer_initialized));
+  if (result != net::ERR_IO_PENDING)
+    on_writer_initialized(result);
+}
+
+void DownloadTaskImpl::OnSessionTaskCompleted(bool is_current_task,
+                                              int write_error) {
+  DCHECK_CURRENTLY_ON(web::WebThread::UI);
+  if (write_error != net::OK) {
+    error_code_ = write_error;
+  } else if (CanResume(is_current_task)) {
+    Resume();
+    return;
+  }
+
+  // Download has finished, so finalize the writer and signal completion.
+  auto callback = base::Bind(&DownloadTaskImpl::OnDownloadFinished,
+                             weak_factory_.GetWeakPtr());
+  if (writer_->Finish(error_code_, callback) != net::ERR_IO_PENDING) {
+    OnDownloadFinished(error_code_);
+  }
+}
+
 void DownloadTaskImpl::OnDownloadUpdated() {
   for (auto& observer : observers_)
     observer.OnDownloadUpdated(this);
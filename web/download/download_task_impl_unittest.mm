@@ -28,6 +28,7 @@
 #include "testing/gtest_mac.h"
 #include "testing/platform_test.h"
 #import "third_party/ocmock/OCMock/OCMock.h"
+#import "third_party/ocmock/gtest_support.h"
 #include "url/gurl.h"
 
 #if !defined(__has_feature) || !__has_feature(objc_arc)
@@ -47,6 +48,15 @@ const char kUrl[] = "chromium://download.test/";
 const char kContentDisposition[] = "attachment; filename=file.test";
 const char kMimeType[] = "application/pdf";
 
+// Returns HTTP response for |kUrl| with the given |status_code| and |headers|.
+NSHTTPURLResponse* CreateHttpResponse(NSInteger status_code,
+                                      NSDictionary* headers) {
+  return [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@(kUrl)]
+                                     statusCode:status_code
+                                    HTTPVersion:nil
+                                   headerFields:headers];
+}
+
 class MockDownloadTaskObserver : public DownloadTaskObserver {
  public:
   MOCK_METHOD1(OnDownloadUpdated, void(DownloadTask* task));
@@ -202,6 +212,49 @@ class DownloadTaskImplTest : public PlatformTest {
     task_->RemoveObserver(&callback_waiter);
   }
 
+  // Calls URLSession:dataTask:didReceiveResponse:completionHandler: callback
+  // with NSURLSessionTask.response and returns the disposition passed to the
+  // completion handler.
+  NSURLSessionResponseDisposition SimulateResponse(
+      CRWFakeNSURLSessionTask* session_task) {
+    __block bool completion_handler_called = false;
+    __block NSURLSessionResponseDisposition result = NSURLSessionResponseCancel;
+    dispatch_async(session_delegate_callbacks_queue_, ^{
+      [session_delegate() URLSession:session()
+                            dataTask:session_task
+                  didReceiveResponse:session_task.response
+                   completionHandler:^(
+                       NSURLSessionResponseDisposition disposition) {
+                     result = disposition;
+                     completion_handler_called = true;
+                   }];
+    });
+    EXPECT_TRUE(WaitUntilConditionOrTimeout(kWaitForDownloadTimeout, ^{
+      base::RunLoop().RunUntilIdle();
+      return completion_handler_called;
+    }));
+    return result;
+  }
+
+  // Expects the download to be resumed with a range request for the content
+  // starting at |offset| and validated with |validator|. Returns
+  // NSURLSessionDataTask fake for the range request.
+  CRWFakeNSURLSessionTask* ExpectResume(int64_t offset, NSString* validator) {
+    NSURL* url = [NSURL URLWithString:@(kUrl)];
+    CRWFakeNSURLSessionTask* session_task =
+        [[CRWFakeNSURLSessionTask alloc] initWithURL:url];
+    NSString* range = [NSString stringWithFormat:@"bytes=%lld-", offset];
+    id request_arg = [OCMArg checkWithBlock:^BOOL(NSURLRequest* request) {
+      return [request.URL isEqual:url] &&
+             [[request valueForHTTPHeaderField:@"Range"] isEqual:range] &&
+             [[request valueForHTTPHeaderField:@"If-Range"]
+                 isEqual:validator];
+    }];
+    OCMExpect([task_delegate_.session() dataTaskWithRequest:request_arg])
+        .andReturn(session_task);
+    return session_task;
+  }
+
   // Sets NSURLSessionTask.state to NSURLSessionTaskStateCompleted and calls
   // URLSession:dataTask:didCompleteWithError: callback.
   void SimulateDownloadCompletion(CRWFakeNSURLSessionTask* session_task,
@@ -541,6 +594,153 @@ TEST_F(DownloadTaskImplTest, FailureInTheMiddle) {
   EXPECT_CALL(task_delegate_, OnTaskDestroyed(task_.get()));
 }
 
+// Tests resuming the download with a range request after the connection was
+// lost.
+TEST_F(DownloadTaskImplTest, ResumeAfterConnectionLoss) {
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  CRWFakeNSURLSessionTask* session_task = Start();
+  ASSERT_TRUE(session_task);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // The first part of the response has arrived.
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  const char kData1[] = "foo";
+  const char kData2[] = "buzz";
+  int64_t kData1Size = strlen(kData1);
+  int64_t kData2Size = strlen(kData2);
+  session_task.countOfBytesExpectedToReceive = kData1Size + kData2Size;
+  session_task.response = CreateHttpResponse(
+      200, @{@"ETag" : @"\"tag\"", @"Accept-Ranges" : @"bytes"});
+  SimulateDataDownload(session_task, kData1);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // The connection was lost, so the download is resumed.
+  CRWFakeNSURLSessionTask* resumed_task =
+      ExpectResume(kData1Size, @"\"tag\"");
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  NSError* error = [NSError errorWithDomain:NSURLErrorDomain
+                                       code:NSURLErrorNetworkConnectionLost
+                                   userInfo:nil];
+  SimulateDownloadCompletion(session_task, error);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  EXPECT_OCMOCK_VERIFY(task_delegate_.session());
+  EXPECT_EQ(NSURLSessionTaskStateRunning, resumed_task.state);
+  EXPECT_EQ(DownloadTask::State::kInProgress, task_->GetState());
+  EXPECT_FALSE(task_->IsDone());
+  EXPECT_EQ(0, task_->GetErrorCode());
+
+  // The rest of the content has arrived.
+  resumed_task.response = CreateHttpResponse(
+      206, @{@"Content-Range" : @"bytes 3-6/7", @"ETag" : @"\"tag\""});
+  EXPECT_EQ(NSURLSessionResponseAllow, SimulateResponse(resumed_task));
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  resumed_task.countOfBytesExpectedToReceive = kData2Size;
+  SimulateDataDownload(resumed_task, kData2);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  EXPECT_EQ(kData1Size + kData2Size, task_->GetTotalBytes());
+  EXPECT_EQ(kData1Size + kData2Size, task_->GetReceivedBytes());
+  EXPECT_EQ(100, task_->GetPercentComplete());
+
+  // Download has finished.
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  SimulateDownloadCompletion(resumed_task);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  ASSERT_TRUE(WaitUntilConditionOrTimeout(kWaitForDownloadTimeout, ^{
+    return task_->IsDone();
+  }));
+  EXPECT_EQ(DownloadTask::State::kComplete, task_->GetState());
+  EXPECT_EQ(0, task_->GetErrorCode());
+  EXPECT_EQ(std::string(kData1) + kData2,
+            task_->GetResponseWriter()->AsStringWriter()->data());
+
+  EXPECT_CALL(task_delegate_, OnTaskDestroyed(task_.get()));
+}
+
+// Tests that the partially downloaded content is discarded if the server sends
+// the whole content in response to the range request, because the content has
+// changed.
+TEST_F(DownloadTaskImplTest, ResumeAfterContentChange) {
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  CRWFakeNSURLSessionTask* session_task = Start();
+  ASSERT_TRUE(session_task);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // A part of the response has arrived.
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  const char kOldData[] = "foo";
+  session_task.countOfBytesExpectedToReceive = strlen(kOldData) + 10;
+  NSString* kLastModified = @"Wed, 21 Oct 2015 07:28:00 GMT";
+  session_task.response = CreateHttpResponse(
+      200, @{@"Last-Modified" : kLastModified, @"Accept-Ranges" : @"bytes"});
+  SimulateDataDownload(session_task, kOldData);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // The connection was lost, so the download is resumed.
+  CRWFakeNSURLSessionTask* resumed_task =
+      ExpectResume(strlen(kOldData), kLastModified);
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  NSError* error = [NSError errorWithDomain:NSURLErrorDomain
+                                       code:NSURLErrorNetworkConnectionLost
+                                   userInfo:nil];
+  SimulateDownloadCompletion(session_task, error);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  EXPECT_OCMOCK_VERIFY(task_delegate_.session());
+
+  // The content has changed, so the server has sent all of it.
+  resumed_task.response = CreateHttpResponse(200, @{});
+  EXPECT_EQ(NSURLSessionResponseAllow, SimulateResponse(resumed_task));
+  EXPECT_EQ("", task_->GetResponseWriter()->AsStringWriter()->data());
+
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  const char kNewData[] = "buzz";
+  int64_t kNewDataSize = strlen(kNewData);
+  resumed_task.countOfBytesExpectedToReceive = kNewDataSize;
+  SimulateDataDownload(resumed_task, kNewData);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  EXPECT_EQ(kNewDataSize, task_->GetTotalBytes());
+  EXPECT_EQ(kNewDataSize, task_->GetReceivedBytes());
+  EXPECT_EQ(kNewData, task_->GetResponseWriter()->AsStringWriter()->data());
+
+  EXPECT_CALL(task_delegate_, OnTaskDestroyed(task_.get()));
+}
+
+// Tests that the download fails if the server responds to the range request
+// with an error.
+TEST_F(DownloadTaskImplTest, ResumeFailsOnErrorResponse) {
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  CRWFakeNSURLSessionTask* session_task = Start();
+  ASSERT_TRUE(session_task);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // A part of the response has arrived.
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  const char kData[] = "foo";
+  session_task.countOfBytesExpectedToReceive = strlen(kData) + 10;
+  session_task.response = CreateHttpResponse(
+      200, @{@"ETag" : @"\"tag\"", @"Accept-Ranges" : @"bytes"});
+  SimulateDataDownload(session_task, kData);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+
+  // The connection was lost, so the download is resumed.
+  CRWFakeNSURLSessionTask* resumed_task =
+      ExpectResume(strlen(kData), @"\"tag\"");
+  EXPECT_CALL(task_observer_, OnDownloadUpdated(task_.get()));
+  NSError* error = [NSError errorWithDomain:NSURLErrorDomain
+                                       code:NSURLErrorNetworkConnectionLost
+                                   userInfo:nil];
+  SimulateDownloadCompletion(session_task, error);
+  testing::Mock::VerifyAndClearExpectations(&task_observer_);
+  EXPECT_OCMOCK_VERIFY(task_delegate_.session());
+
+  // The content is no longer available, so the resumed task is cancelled and
+  // the written data is kept.
+  resumed_task.response = CreateHttpResponse(404, @{});
+  EXPECT_EQ(NSURLSessionResponseCancel, SimulateResponse(resumed_task));
+  EXPECT_EQ(kData, task_->GetResponseWriter()->AsStringWriter()->data());
+
+  EXPECT_CALL(task_delegate_, OnTaskDestroyed(task_.get()));
+}
+
 // Tests that CreateSession is called with the correct cookies from the cookie
 // store.
 TEST_F(DownloadTaskImplTest, Cookie) {
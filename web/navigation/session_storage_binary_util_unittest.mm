@@ -0,0 +1,126 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/web/public/session_storage_binary_util.h"
+
+#include <memory>
+
+#include "base/strings/sys_string_conversions.h"
+#import "ios/web/navigation/navigation_item_storage_test_util.h"
+#import "ios/web/navigation/serializable_user_data_manager_impl.h"
+#import "ios/web/public/crw_navigation_item_storage.h"
+#import "ios/web/public/crw_session_certificate_policy_cache_storage.h"
+#import "ios/web/public/crw_session_storage.h"
+#include "net/cert/x509_certificate.h"
+#include "net/test/cert_test_util.h"
+#include "net/test/test_data_directory.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#import "testing/gtest_mac.h"
+#include "testing/platform_test.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace web {
+
+class SessionStorageBinaryUtilTest : public PlatformTest {
+ protected:
+  SessionStorageBinaryUtilTest()
+      : session_storage_([[CRWSessionStorage alloc] init]) {
+    session_storage_.hasOpener = YES;
+    session_storage_.lastCommittedItemIndex = 1;
+    session_storage_.previousItemIndex = 0;
+
+    CRWNavigationItemStorage* first_item =
+        [[CRWNavigationItemStorage alloc] init];
+    first_item.virtualURL = GURL("http://init.test");
+    first_item.timestamp = base::Time::Now();
+    first_item.title = base::SysNSStringToUTF16(@"Title");
+    first_item.userAgentType = UserAgentType::DESKTOP;
+    CRWNavigationItemStorage* second_item =
+        [[CRWNavigationItemStorage alloc] init];
+    second_item.virtualURL = GURL("http://post.test");
+    second_item.referrer =
+        Referrer(GURL("http://init.test"), ReferrerPolicyOrigin);
+    second_item.displayState =
+        PageDisplayState(CGPointMake(0, 100), UIEdgeInsetsMake(64, 0, 0, 0),
+                         0.5, 2.0, 1.0);
+    second_item.POSTData =
+        [@"Test data" dataUsingEncoding:NSUTF8StringEncoding];
+    second_item.HTTPRequestHeaders = @{@"HeaderKey" : @"HeaderValue"};
+    second_item.shouldSkipRepostFormConfirmation = YES;
+    session_storage_.itemStorages = @[ first_item, second_item ];
+
+    scoped_refptr<net::X509Certificate> certificate =
+        net::ImportCertFromFile(net::GetTestCertsDirectory(), "ok_cert.pem");
+    session_storage_.certPolicyCacheStorage =
+        [[CRWSessionCertificatePolicyCacheStorage alloc] init];
+    session_storage_.certPolicyCacheStorage.certificateStorages =
+        [NSSet setWithObject:[[CRWSessionCertificateStorage alloc]
+                                 initWithCertificate:certificate
+                                                host:"init.test"
+                                              status:net::CERT_STATUS_INVALID]];
+
+    [session_storage_
+        setSerializableUserData:std::make_unique<SerializableUserDataImpl>(
+                                    @{@"key" : @"value"})];
+  }
+
+  CRWSessionStorage* session_storage_;
+};
+
+// Tests that a CRWSessionStorage converted to its binary representation and
+// back is unchanged.
+TEST_F(SessionStorageBinaryUtilTest, RoundTrip) {
+  std::vector<binary_session::WindowData> windows(1);
+  windows[0].tabs.push_back(TabDataFromSessionStorage(session_storage_));
+  std::string data = binary_session::EncodeSession(windows);
+  std::unique_ptr<binary_session::SessionReader> reader =
+      binary_session::SessionReader::FromBuffer(data.data(), data.size());
+  ASSERT_TRUE(reader);
+  binary_session::TabData tab;
+  ASSERT_TRUE(reader->ReadTab(0, 0, &tab));
+  CRWSessionStorage* storage = SessionStorageFromTabData(tab);
+
+  EXPECT_EQ(session_storage_.hasOpener, storage.hasOpener);
+  EXPECT_EQ(session_storage_.lastCommittedItemIndex,
+            storage.lastCommittedItemIndex);
+  EXPECT_EQ(session_storage_.previousItemIndex, storage.previousItemIndex);
+  ASSERT_EQ(session_storage_.itemStorages.count, storage.itemStorages.count);
+  for (NSUInteger index = 0; index < storage.itemStorages.count; ++index) {
+    EXPECT_TRUE(ItemStoragesAreEqual(session_storage_.itemStorages[index],
+                                     storage.itemStorages[index]));
+  }
+
+  ASSERT_EQ(1U, storage.certPolicyCacheStorage.certificateStorages.count);
+  CRWSessionCertificateStorage* certificate =
+      [storage.certPolicyCacheStorage.certificateStorages anyObject];
+  CRWSessionCertificateStorage* expected_certificate =
+      [session_storage_.certPolicyCacheStorage.certificateStorages anyObject];
+  EXPECT_TRUE(certificate.certificate->EqualsIncludingChain(
+      expected_certificate.certificate));
+  EXPECT_EQ(expected_certificate.host, certificate.host);
+  EXPECT_EQ(expected_certificate.status, certificate.status);
+
+  ASSERT_TRUE(storage.userData);
+  EXPECT_NSEQ(@{@"key" : @"value"},
+              static_cast<SerializableUserDataImpl*>(storage.userData)->data());
+}
+
+// Tests that a tab without user data is converted to a CRWSessionStorage with
+// empty user data.
+TEST_F(SessionStorageBinaryUtilTest, EmptyTab) {
+  CRWSessionStorage* storage =
+      SessionStorageFromTabData(binary_session::TabData());
+  EXPECT_FALSE(storage.hasOpener);
+  EXPECT_EQ(-1, storage.lastCommittedItemIndex);
+  EXPECT_EQ(0U, storage.itemStorages.count);
+  EXPECT_EQ(0U, storage.certPolicyCacheStorage.certificateStorages.count);
+  ASSERT_TRUE(storage.userData);
+  EXPECT_NSEQ(@{},
+              static_cast<SerializableUserDataImpl*>(storage.userData)->data());
+}
+
+}  // namespace web
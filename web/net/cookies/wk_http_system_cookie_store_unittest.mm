@@ -95,6 +95,12 @@ class API_AVAILABLE(ios(11.0)) WKHTTPSystemCookieStoreTestDelegate {
     return cookies_count;
   }
 
+  // WKHTTPSystemCookieStore reports the policy of the shared
+  // NSHTTPCookieStorage.
+  void SetCookieAcceptPolicy(NSHTTPCookieAcceptPolicy policy) {
+    [NSHTTPCookieStorage sharedHTTPCookieStorage].cookieAcceptPolicy = policy;
+  }
+
   SystemCookieStore* GetCookieStore() { return store_.get(); }
 
  private:
@@ -16,6 +16,7 @@
 #include "base/callback_forward.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #import "ios/net/request_tracker.h"
 #include "ios/web/public/web_thread.h"
 #include "net/cert/cert_status_flags.h"
@@ -59,11 +60,11 @@ struct PageCounts {
   uint64_t unfinished_no_estimate;
   // Total bytes count dowloaded for unfinished requests of unknown size.
   uint64_t unfinished_no_estimate_bytes_done;
-  // Count of unfinished requests with an estimated size.
+  // Total expected bytes count of unfinished requests with an estimated size.
   uint64_t unfinished_estimated_bytes_left;
   // Total bytes count dowloaded for unfinished requests with an estimated size.
   uint64_t unfinished_estimate_bytes_done;
-  // Size of the request with the most bytes on the page.
+  // Size of the request with the most bytes seen on the page.
   uint64_t largest_byte_size_known;
 };
 
@@ -178,6 +179,9 @@ class RequestTrackerImpl
 
   void SetCertificatePolicyCacheForTest(web::CertificatePolicyCache* cache);
 
+  // Returns the current state of the page. Must be called on the IO thread.
+  PageCounts GetPageCountsForTest() { return page_counts_; }
+
 #pragma mark Accessors used by internal classes and network clients.
   int identifier() { return identifier_; }
   bool has_mixed_content() { return has_mixed_content_; }
@@ -228,13 +232,24 @@ class RequestTrackerImpl
 
   // Called when something has changed (network load progress or SSL status)
   // that the consumer should know about. Notifications are asynchronous and
-  // batched.
+  // coalesced, so that the consumer is notified at most once per frame.
   void Notify();
 
-  // If no other notifications are pending, notifies the consumer of SSL status
-  // and load progress.
+  // Notifies the consumer of SSL status and load progress.
   void StackNotification();
 
+  // Adds the contribution of |counts| to |page_counts_|.
+  void AddToPageCounts(const TrackerCounts* counts);
+
+  // Removes the contribution of |counts| from |page_counts_|. Must be called
+  // before |counts| changes, and followed by AddToPageCounts() after the
+  // change.
+  void RemoveFromPageCounts(const TrackerCounts* counts);
+
+  // Recomputes |page_counts_| from |counts_|, which resets
+  // |page_counts_.largest_byte_size_known|.
+  void RecomputePageCounts();
+
   // If the counts is for a request currently waiting for the user to approve it
   // will reevaluate the approval.
   void EvaluateSSLCallbackForCounts(TrackerCounts* counts);
@@ -276,9 +291,6 @@ class RequestTrackerImpl
   void PostBlock(id caller, void (^block)(id), web::WebThread::ID thread);
 
 #pragma mark Other internal methods.
-  // Returns the current state of the page.
-  PageCounts pageCounts();
-
   // Like description, but cannot be called from any thread. It must be called
   // only from the IO thread.
   NSString* UnsafeDescription();
@@ -292,12 +304,17 @@ class RequestTrackerImpl
   std::map<const void*, TrackerCounts*> counts_by_request_;
   // A list of all the TrackerCounts, including the finished ones.
   std::vector<std::unique_ptr<TrackerCounts>> counts_;
+  // The sum of the states of the requests in |counts_|, updated as they
+  // change so that estimating the progress does not iterate over |counts_|.
+  PageCounts page_counts_;
   // The system shall never allow the page load estimate to go back.
   float previous_estimate_;
   // Index of the first request to consider for building the estimation.
   unsigned int estimate_start_index_;
-  // How many notifications are currently queued, to avoid notifying too often.
-  int notification_depth_;
+  // Whether a notification is scheduled, to avoid notifying too often.
+  bool notification_pending_;
+  // When the consumer was last notified.
+  base::TimeTicks last_notification_time_;
   // Set to |YES| if the page has mixed content
   bool has_mixed_content_;
   // Set to true if between TrimToURL and StopPageLoad.
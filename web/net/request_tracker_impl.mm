@@ -8,6 +8,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/logging.h"
@@ -30,6 +32,9 @@
 
 namespace {
 
+// Minimum delay between two notifications, about one frame at 60Hz. The
+// network stack reports progress far more often than it can be displayed.
+const int kMinNotificationIntervalMs = 16;
 
 // A map of all RequestTrackerImpls for tabs that are:
 // * Currently open
@@ -321,6 +326,7 @@ void RequestTrackerImpl::StartRequest(net::URLRequest* request) {
   auto counts =
       std::make_unique<TrackerCounts>(GURLByRemovingRefFromGURL(url), request);
   counts_by_request_[request] = counts.get();
+  AddToPageCounts(counts.get());
   counts_.push_back(std::move(counts));
   if (page_url_.SchemeIsCryptographic() && !url.SchemeIsCryptographic())
     has_mixed_content_ = true;
@@ -333,12 +339,14 @@ void RequestTrackerImpl::CaptureExpectedLength(const net::URLRequest* request,
   if (counts_by_request_.count(request)) {
     TrackerCounts* counts = counts_by_request_[request];
     DCHECK(!counts->done);
+    RemoveFromPageCounts(counts);
     if (length < counts->processed) {
       // Something is wrong with the estimate. Ignore it.
       counts->expected_length = 0;
     } else {
       counts->expected_length = length;
     }
+    AddToPageCounts(counts);
     Notify();
   }
 }
@@ -352,12 +360,14 @@ void RequestTrackerImpl::CaptureReceivedBytes(const net::URLRequest* request,
     const net::SSLInfo& ssl_info = request->ssl_info();
     if (ssl_info.is_valid())
       counts->ssl_info = ssl_info;
+    RemoveFromPageCounts(counts);
     counts->processed += byte_count;
     if (counts->expected_length > 0 &&
         counts->expected_length < counts->processed) {
       // Something is wrong with the estimate, it is too low. Ignore it.
       counts->expected_length = 0;
     }
+    AddToPageCounts(counts);
     Notify();
   }
 }
@@ -380,7 +390,9 @@ void RequestTrackerImpl::StopRedirectedRequest(net::URLRequest* request) {
     const net::SSLInfo& ssl_info = request->ssl_info();
     if (ssl_info.is_valid())
       counts->ssl_info = ssl_info;
+    RemoveFromPageCounts(counts);
     counts->done = true;
+    AddToPageCounts(counts);
     counts_by_request_.erase(request);
   }
 }
@@ -458,7 +470,7 @@ RequestTrackerImpl::RequestTrackerImpl(
     net::URLRequestContextGetter* context_getter)
     : previous_estimate_(0.0f),  // Not active by default.
       estimate_start_index_(0),
-      notification_depth_(0),
+      notification_pending_(false),
       has_mixed_content_(false),
       is_loading_(false),
       new_estimate_round_(true),
@@ -520,26 +532,82 @@ void RequestTrackerImpl::Notify() {
   DCHECK_CURRENTLY_ON(web::WebThread::IO);
   if (is_closing_)
     return;
-  // Notify() is called asynchronously, it runs later on the same
-  // thread. This is used to collate notifications together, avoiding
-  // blanketing the UI with a stream of information.
-  notification_depth_ += 1;
-  base::PostTaskWithTraits(
+  // There is no point in scheduling a notification if there is another one
+  // already scheduled, as it will report this change too.
+  if (notification_pending_)
+    return;
+  notification_pending_ = true;
+
+  // The notification runs later on the same thread, and no sooner than one
+  // frame after the previous one. This is used to collate notifications
+  // together, avoiding blanketing the UI with a stream of information.
+  base::TimeDelta delay =
+      last_notification_time_ +
+      base::TimeDelta::FromMilliseconds(kMinNotificationIntervalMs) -
+      base::TimeTicks::Now();
+  base::PostDelayedTaskWithTraits(
       FROM_HERE, {web::WebThread::IO},
-      base::Bind(&RequestTrackerImpl::StackNotification, this));
+      base::Bind(&RequestTrackerImpl::StackNotification, this),
+      std::max(delay, base::TimeDelta()));
 }
 
 void RequestTrackerImpl::StackNotification() {
   DCHECK_CURRENTLY_ON(web::WebThread::IO);
+  notification_pending_ = false;
   if (is_closing_)
     return;
+  last_notification_time_ = base::TimeTicks::Now();
+}
 
-  // There is no point in sending the notification if there is another one
-  // already queued. This queue is processing very lightweight changes and
-  // should be exhausted very easily.
-  --notification_depth_;
-  if (notification_depth_)
-    return;
+void RequestTrackerImpl::AddToPageCounts(const TrackerCounts* counts) {
+  DCHECK_CURRENTLY_ON(web::WebThread::IO);
+  if (counts->done) {
+    uint64_t size = counts->processed;
+    page_counts_.finished += 1;
+    page_counts_.finished_bytes += size;
+    page_counts_.largest_byte_size_known =
+        std::max(page_counts_.largest_byte_size_known, size);
+  } else {
+    page_counts_.unfinished += 1;
+    if (counts->expected_length) {
+      uint64_t size = counts->expected_length;
+      page_counts_.unfinished_estimate_bytes_done += counts->processed;
+      page_counts_.unfinished_estimated_bytes_left += size;
+      page_counts_.largest_byte_size_known =
+          std::max(page_counts_.largest_byte_size_known, size);
+    } else {
+      page_counts_.unfinished_no_estimate += 1;
+      page_counts_.unfinished_no_estimate_bytes_done += counts->processed;
+    }
+  }
+}
+
+void RequestTrackerImpl::RemoveFromPageCounts(const TrackerCounts* counts) {
+  DCHECK_CURRENTLY_ON(web::WebThread::IO);
+  // |largest_byte_size_known| is left unchanged: it is the largest size seen
+  // on the page, not only the largest size of the current requests.
+  if (counts->done) {
+    DCHECK_GT(page_counts_.finished, 0U);
+    page_counts_.finished -= 1;
+    page_counts_.finished_bytes -= counts->processed;
+  } else {
+    DCHECK_GT(page_counts_.unfinished, 0U);
+    page_counts_.unfinished -= 1;
+    if (counts->expected_length) {
+      page_counts_.unfinished_estimate_bytes_done -= counts->processed;
+      page_counts_.unfinished_estimated_bytes_left -= counts->expected_length;
+    } else {
+      page_counts_.unfinished_no_estimate -= 1;
+      page_counts_.unfinished_no_estimate_bytes_done -= counts->processed;
+    }
+  }
+}
+
+void RequestTrackerImpl::RecomputePageCounts() {
+  DCHECK_CURRENTLY_ON(web::WebThread::IO);
+  page_counts_ = PageCounts();
+  for (const auto& tracker_count : counts_)
+    AddToPageCounts(tracker_count.get());
 }
 
 void RequestTrackerImpl::EvaluateSSLCallbackForCounts(TrackerCounts* counts) {
@@ -628,50 +696,22 @@ void RequestTrackerImpl::ReevaluateCallbacksForAllCounts() {
 void RequestTrackerImpl::CancelRequestForCounts(TrackerCounts* counts) {
   DCHECK_CURRENTLY_ON(web::WebThread::IO);
   // Cancel the request.
-  counts->done = true;
+  if (!counts->done) {
+    RemoveFromPageCounts(counts);
+    counts->done = true;
+    AddToPageCounts(counts);
+  }
   counts_by_request_.erase(counts->request);
   counts->ssl_callback.Run(NO);
   counts->ssl_callback = base::DoNothing();
   Notify();
 }
 
-PageCounts RequestTrackerImpl::pageCounts() {
-  DCHECK_GE(counts_.size(), estimate_start_index_);
-
-  PageCounts page_counts;
-
-  for (const auto& tracker_count : counts_) {
-    if (tracker_count->done) {
-      uint64_t size = tracker_count->processed;
-      page_counts.finished += 1;
-      page_counts.finished_bytes += size;
-      if (page_counts.largest_byte_size_known < size) {
-        page_counts.largest_byte_size_known = size;
-      }
-    } else {
-      page_counts.unfinished += 1;
-      if (tracker_count->expected_length) {
-        uint64_t size = tracker_count->expected_length;
-        page_counts.unfinished_estimate_bytes_done += tracker_count->processed;
-        page_counts.unfinished_estimated_bytes_left += size;
-        if (page_counts.largest_byte_size_known < size) {
-          page_counts.largest_byte_size_known = size;
-        }
-      } else {
-        page_counts.unfinished_no_estimate += 1;
-        page_counts.unfinished_no_estimate_bytes_done +=
-            tracker_count->processed;
-      }
-    }
-  }
-
-  return page_counts;
-}
-
 float RequestTrackerImpl::EstimatedProgress() {
   DCHECK_CURRENTLY_ON(web::WebThread::IO);
 
-  const PageCounts page_counts = pageCounts();
+  DCHECK_GE(counts_.size(), estimate_start_index_);
+  const PageCounts& page_counts = page_counts_;
 
   // Nothing in progress and the last time was the same.
   if (!page_counts.unfinished && previous_estimate_ == 0.0f)
@@ -833,6 +873,8 @@ void RequestTrackerImpl::TrimToURL(const GURL& full_url, id user_info) {
     }
     it = counts_.erase(it);
   }
+  // The trimmed requests are no longer part of the page.
+  RecomputePageCounts();
 
   has_mixed_content_ = new_url_has_mixed_content;
   page_url_ = url;
@@ -280,6 +280,47 @@ TEST_F(RequestTrackerTest, OnePageOneBigImage) {
   EndPage(request_group_id_, GetURL(0));
 }
 
+// Tests that the state of the page is updated as its requests progress.
+TEST_F(RequestTrackerTest, PageCounts) {
+  TrimRequest(request_group_id_, GetURL(0));
+  base::RunLoop().RunUntilIdle();
+  tracker_->StartRequest(GetRequest(0));
+  tracker_->StartRequest(GetRequest(1));
+  tracker_->CaptureReceivedBytes(GetRequest(0), 10);
+  tracker_->CaptureExpectedLength(GetRequest(1), 100);
+  tracker_->CaptureReceivedBytes(GetRequest(1), 40);
+
+  web::PageCounts counts = tracker_->GetPageCountsForTest();
+  EXPECT_EQ(0U, counts.finished);
+  EXPECT_EQ(2U, counts.unfinished);
+  EXPECT_EQ(1U, counts.unfinished_no_estimate);
+  EXPECT_EQ(10U, counts.unfinished_no_estimate_bytes_done);
+  EXPECT_EQ(100U, counts.unfinished_estimated_bytes_left);
+  EXPECT_EQ(40U, counts.unfinished_estimate_bytes_done);
+  EXPECT_EQ(100U, counts.largest_byte_size_known);
+
+  tracker_->StopRequest(GetRequest(0));
+  tracker_->StopRequest(GetRequest(1));
+  counts = tracker_->GetPageCountsForTest();
+  EXPECT_EQ(2U, counts.finished);
+  EXPECT_EQ(50U, counts.finished_bytes);
+  EXPECT_EQ(0U, counts.unfinished);
+  EXPECT_EQ(0U, counts.unfinished_no_estimate);
+  EXPECT_EQ(0U, counts.unfinished_no_estimate_bytes_done);
+  EXPECT_EQ(0U, counts.unfinished_estimated_bytes_left);
+  EXPECT_EQ(0U, counts.unfinished_estimate_bytes_done);
+  EXPECT_EQ(100U, counts.largest_byte_size_known);
+
+  // Loading another page forgets the requests of the previous one.
+  TrimRequest(request_group_id_, GetURL(2));
+  base::RunLoop().RunUntilIdle();
+  counts = tracker_->GetPageCountsForTest();
+  EXPECT_EQ(0U, counts.finished);
+  EXPECT_EQ(0U, counts.finished_bytes);
+  EXPECT_EQ(0U, counts.largest_byte_size_known);
+  EndPage(request_group_id_, GetURL(2));
+}
+
 TEST_F(RequestTrackerTest, TwoPagesPostStart) {
   tracker_->StartRequest(GetRequest(0));
 
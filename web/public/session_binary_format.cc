@@ -0,0 +1,526 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/public/session_binary_format.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/sys_byteorder.h"
+
+namespace web {
+namespace binary_session {
+
+const uint32_t kCurrentVersion = 1;
+
+namespace {
+
+// A binary session starts with |kMagic|, followed by the version of the format
+// and the size of the index of the tabs. The index contains, for each window,
+// its selected index and the offset and size of the data of its tabs. The data
+// of the tabs follows the index, and their offsets are relative to the end of
+// the index. All the integers are little-endian, whatever the endianness of
+// the device which wrote the session.
+const char kMagic[] = {'C', 'r', 'S', 'e', 's', 's', 'B', 'n'};
+const size_t kVersionOffset = sizeof(kMagic);
+const size_t kIndexSizeOffset = kVersionOffset + sizeof(uint32_t);
+const size_t kIndexOffset = kIndexSizeOffset + sizeof(uint32_t);
+
+// Appends values to a string in the encoding of the format. Lengths and counts
+// are written as uint32_t, strings as their length followed by their
+// characters, and doubles as their IEEE 754 representation.
+class Writer {
+ public:
+  explicit Writer(std::string* output) : output_(output) {}
+
+  void WriteBool(bool value) { output_->push_back(value ? 1 : 0); }
+
+  void WriteUInt32(uint32_t value) {
+    value = base::ByteSwapToLE32(value);
+    output_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void WriteUInt64(uint64_t value) {
+    value = base::ByteSwapToLE64(value);
+    output_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void WriteInt(int value) {
+    WriteUInt32(static_cast<uint32_t>(base::checked_cast<int32_t>(value)));
+  }
+
+  void WriteInt64(int64_t value) { WriteUInt64(static_cast<uint64_t>(value)); }
+
+  void WriteDouble(double value) {
+    uint64_t bits = 0;
+    static_assert(sizeof(bits) == sizeof(value), "Unexpected double size");
+    memcpy(&bits, &value, sizeof(bits));
+    WriteUInt64(bits);
+  }
+
+  void WriteLength(size_t length) {
+    WriteUInt32(base::checked_cast<uint32_t>(length));
+  }
+
+  void WriteString(const std::string& value) {
+    WriteLength(value.size());
+    output_->append(value);
+  }
+
+  void WriteString16(const base::string16& value) {
+    WriteLength(value.size());
+    for (base::char16 character : value) {
+      uint16_t code_unit = base::ByteSwapToLE16(character);
+      output_->append(reinterpret_cast<const char*>(&code_unit),
+                      sizeof(code_unit));
+    }
+  }
+
+ private:
+  std::string* output_;
+
+  DISALLOW_COPY_AND_ASSIGN(Writer);
+};
+
+// Reads the values appended by Writer from a buffer. Each method returns false
+// instead of reading past the end of the buffer.
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t size) : data_(data), remaining_(size) {}
+
+  bool ReadBool(bool* value) {
+    uint8_t byte = 0;
+    if (!ReadBytes(&byte, sizeof(byte)) || byte > 1)
+      return false;
+    *value = byte == 1;
+    return true;
+  }
+
+  bool ReadUInt32(uint32_t* value) {
+    if (!ReadBytes(value, sizeof(*value)))
+      return false;
+    *value = base::ByteSwapToLE32(*value);
+    return true;
+  }
+
+  bool ReadUInt64(uint64_t* value) {
+    if (!ReadBytes(value, sizeof(*value)))
+      return false;
+    *value = base::ByteSwapToLE64(*value);
+    return true;
+  }
+
+  bool ReadInt(int* value) {
+    uint32_t bits = 0;
+    if (!ReadUInt32(&bits))
+      return false;
+    *value = static_cast<int32_t>(bits);
+    return true;
+  }
+
+  bool ReadInt64(int64_t* value) {
+    uint64_t bits = 0;
+    if (!ReadUInt64(&bits))
+      return false;
+    *value = static_cast<int64_t>(bits);
+    return true;
+  }
+
+  bool ReadDouble(double* value) {
+    uint64_t bits = 0;
+    if (!ReadUInt64(&bits))
+      return false;
+    memcpy(value, &bits, sizeof(*value));
+    return true;
+  }
+
+  // Reads a length or a count. As every element takes at least one byte, a
+  // length larger than the rest of the buffer is rejected.
+  bool ReadLength(size_t* length) {
+    uint32_t value = 0;
+    if (!ReadUInt32(&value) || value > remaining_)
+      return false;
+    *length = value;
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    size_t length = 0;
+    if (!ReadLength(&length))
+      return false;
+    value->assign(reinterpret_cast<const char*>(data_), length);
+    Skip(length);
+    return true;
+  }
+
+  bool ReadString16(base::string16* value) {
+    size_t length = 0;
+    if (!ReadLength(&length) || length > remaining_ / sizeof(uint16_t))
+      return false;
+    value->resize(length);
+    for (size_t index = 0; index < length; ++index) {
+      uint16_t code_unit = 0;
+      ReadBytes(&code_unit, sizeof(code_unit));
+      (*value)[index] = base::ByteSwapToLE16(code_unit);
+    }
+    return true;
+  }
+
+ private:
+  bool ReadBytes(void* output, size_t size) {
+    if (size > remaining_)
+      return false;
+    memcpy(output, data_, size);
+    Skip(size);
+    return true;
+  }
+
+  void Skip(size_t size) {
+    DCHECK_LE(size, remaining_);
+    data_ += size;
+    remaining_ -= size;
+  }
+
+  const uint8_t* data_;
+  size_t remaining_;
+
+  DISALLOW_COPY_AND_ASSIGN(Reader);
+};
+
+void WriteDisplayState(const DisplayStateData& state, Writer* writer) {
+  writer->WriteDouble(state.content_offset_x);
+  writer->WriteDouble(state.content_offset_y);
+  writer->WriteDouble(state.content_inset_top);
+  writer->WriteDouble(state.content_inset_left);
+  writer->WriteDouble(state.content_inset_bottom);
+  writer->WriteDouble(state.content_inset_right);
+  writer->WriteDouble(state.minimum_zoom_scale);
+  writer->WriteDouble(state.maximum_zoom_scale);
+  writer->WriteDouble(state.zoom_scale);
+}
+
+bool ReadDisplayState(Reader* reader, DisplayStateData* state) {
+  return reader->ReadDouble(&state->content_offset_x) &&
+         reader->ReadDouble(&state->content_offset_y) &&
+         reader->ReadDouble(&state->content_inset_top) &&
+         reader->ReadDouble(&state->content_inset_left) &&
+         reader->ReadDouble(&state->content_inset_bottom) &&
+         reader->ReadDouble(&state->content_inset_right) &&
+         reader->ReadDouble(&state->minimum_zoom_scale) &&
+         reader->ReadDouble(&state->maximum_zoom_scale) &&
+         reader->ReadDouble(&state->zoom_scale);
+}
+
+void WriteItem(const NavigationItemData& item, Writer* writer) {
+  writer->WriteString(item.virtual_url);
+  writer->WriteString(item.referrer_url);
+  writer->WriteInt(item.referrer_policy);
+  writer->WriteInt64(item.timestamp);
+  writer->WriteString16(item.title);
+  WriteDisplayState(item.display_state, writer);
+  writer->WriteBool(item.should_skip_repost_form_confirmation);
+  writer->WriteInt(item.user_agent_type);
+  writer->WriteBool(item.has_post_data);
+  writer->WriteString(item.post_data);
+  writer->WriteLength(item.http_request_headers.size());
+  for (const auto& header : item.http_request_headers) {
+    writer->WriteString(header.first);
+    writer->WriteString(header.second);
+  }
+}
+
+bool ReadItem(Reader* reader, NavigationItemData* item) {
+  size_t header_count = 0;
+  if (!reader->ReadString(&item->virtual_url) ||
+      !reader->ReadString(&item->referrer_url) ||
+      !reader->ReadInt(&item->referrer_policy) ||
+      !reader->ReadInt64(&item->timestamp) ||
+      !reader->ReadString16(&item->title) ||
+      !ReadDisplayState(reader, &item->display_state) ||
+      !reader->ReadBool(&item->should_skip_repost_form_confirmation) ||
+      !reader->ReadInt(&item->user_agent_type) ||
+      !reader->ReadBool(&item->has_post_data) ||
+      !reader->ReadString(&item->post_data) ||
+      !reader->ReadLength(&header_count)) {
+    return false;
+  }
+  for (size_t index = 0; index < header_count; ++index) {
+    std::pair<std::string, std::string> header;
+    if (!reader->ReadString(&header.first) ||
+        !reader->ReadString(&header.second)) {
+      return false;
+    }
+    item->http_request_headers.push_back(std::move(header));
+  }
+  return true;
+}
+
+void WriteTab(const TabData& tab, Writer* writer) {
+  writer->WriteBool(tab.has_opener);
+  writer->WriteInt(tab.last_committed_item_index);
+  writer->WriteInt(tab.previous_item_index);
+  writer->WriteLength(tab.items.size());
+  for (const NavigationItemData& item : tab.items)
+    WriteItem(item, writer);
+  writer->WriteLength(tab.certificate_policies.size());
+  for (const CertificatePolicyData& policy : tab.certificate_policies) {
+    writer->WriteString(policy.certificate);
+    writer->WriteString(policy.host);
+    writer->WriteUInt32(policy.status);
+  }
+  writer->WriteString(tab.user_data);
+}
+
+bool ReadTabFromBuffer(const uint8_t* data, size_t size, TabData* tab) {
+  Reader reader(data, size);
+  size_t item_count = 0;
+  if (!reader.ReadBool(&tab->has_opener) ||
+      !reader.ReadInt(&tab->last_committed_item_index) ||
+      !reader.ReadInt(&tab->previous_item_index) ||
+      !reader.ReadLength(&item_count)) {
+    return false;
+  }
+  // Counts are not used to reserve memory, so that a corrupted count only
+  // fails when the missing items are read.
+  for (size_t index = 0; index < item_count; ++index) {
+    NavigationItemData item;
+    if (!ReadItem(&reader, &item))
+      return false;
+    tab->items.push_back(std::move(item));
+  }
+
+  size_t policy_count = 0;
+  if (!reader.ReadLength(&policy_count))
+    return false;
+  for (size_t index = 0; index < policy_count; ++index) {
+    CertificatePolicyData policy;
+    if (!reader.ReadString(&policy.certificate) ||
+        !reader.ReadString(&policy.host) ||
+        !reader.ReadUInt32(&policy.status)) {
+      return false;
+    }
+    tab->certificate_policies.push_back(std::move(policy));
+  }
+  return reader.ReadString(&tab->user_data);
+}
+
+}  // namespace
+
+DisplayStateData::DisplayStateData()
+    : content_offset_x(NAN),
+      content_offset_y(NAN),
+      content_inset_top(NAN),
+      content_inset_left(NAN),
+      content_inset_bottom(NAN),
+      content_inset_right(NAN),
+      minimum_zoom_scale(NAN),
+      maximum_zoom_scale(NAN),
+      zoom_scale(NAN) {}
+
+NavigationItemData::NavigationItemData()
+    : referrer_policy(0),
+      timestamp(0),
+      should_skip_repost_form_confirmation(false),
+      user_agent_type(0),
+      has_post_data(false) {}
+
+NavigationItemData::NavigationItemData(const NavigationItemData& other) =
+    default;
+
+NavigationItemData::NavigationItemData(NavigationItemData&& other) = default;
+
+NavigationItemData::~NavigationItemData() = default;
+
+NavigationItemData& NavigationItemData::operator=(
+    const NavigationItemData& other) = default;
+
+NavigationItemData& NavigationItemData::operator=(
+    NavigationItemData&& other) = default;
+
+TabData::TabData()
+    : has_opener(false),
+      last_committed_item_index(-1),
+      previous_item_index(-1) {}
+
+TabData::TabData(const TabData& other) = default;
+
+TabData::TabData(TabData&& other) = default;
+
+TabData::~TabData() = default;
+
+TabData& TabData::operator=(const TabData& other) = default;
+
+TabData& TabData::operator=(TabData&& other) = default;
+
+WindowData::WindowData() : selected_index(-1) {}
+
+WindowData::WindowData(const WindowData& other) = default;
+
+WindowData::WindowData(WindowData&& other) = default;
+
+WindowData::~WindowData() = default;
+
+WindowData& WindowData::operator=(const WindowData& other) = default;
+
+WindowData& WindowData::operator=(WindowData&& other) = default;
+
+std::string EncodeSession(const std::vector<WindowData>& windows) {
+  std::string index;
+  std::string tabs;
+  Writer index_writer(&index);
+  Writer tabs_writer(&tabs);
+  index_writer.WriteLength(windows.size());
+  for (const WindowData& window : windows) {
+    index_writer.WriteInt(window.selected_index);
+    index_writer.WriteLength(window.tabs.size());
+    for (const TabData& tab : window.tabs) {
+      size_t tab_offset = tabs.size();
+      WriteTab(tab, &tabs_writer);
+      index_writer.WriteUInt64(tab_offset);
+      index_writer.WriteLength(tabs.size() - tab_offset);
+    }
+  }
+
+  std::string output(kMagic, sizeof(kMagic));
+  Writer header_writer(&output);
+  header_writer.WriteUInt32(kCurrentVersion);
+  header_writer.WriteLength(index.size());
+  output.append(index);
+  output.append(tabs);
+  return output;
+}
+
+bool HasBinarySessionHeader(const void* data, size_t size) {
+  return size >= kIndexOffset && !memcmp(data, kMagic, sizeof(kMagic));
+}
+
+SessionReader::WindowEntry::WindowEntry() : selected_index(-1) {}
+
+SessionReader::WindowEntry::WindowEntry(const WindowEntry& other) = default;
+
+SessionReader::WindowEntry::WindowEntry(WindowEntry&& other) = default;
+
+SessionReader::WindowEntry::~WindowEntry() = default;
+
+SessionReader::SessionReader(const uint8_t* data, size_t size)
+    : data_(data), size_(size), version_(0) {}
+
+SessionReader::~SessionReader() = default;
+
+// static
+std::unique_ptr<SessionReader> SessionReader::OpenFile(
+    const base::FilePath& path) {
+  std::unique_ptr<SessionReader> reader(new SessionReader(nullptr, 0));
+  if (!reader->file_.Initialize(path))
+    return nullptr;
+  reader->data_ = reader->file_.data();
+  reader->size_ = reader->file_.length();
+  if (!reader->ReadIndex())
+    return nullptr;
+  return reader;
+}
+
+// static
+std::unique_ptr<SessionReader> SessionReader::FromBuffer(const void* data,
+                                                         size_t size) {
+  std::unique_ptr<SessionReader> reader(
+      new SessionReader(static_cast<const uint8_t*>(data), size));
+  if (!reader->ReadIndex())
+    return nullptr;
+  return reader;
+}
+
+size_t SessionReader::GetWindowCount() const {
+  return windows_.size();
+}
+
+size_t SessionReader::GetTabCount(size_t window_index) const {
+  DCHECK_LT(window_index, windows_.size());
+  return windows_[window_index].tabs.size();
+}
+
+int SessionReader::GetSelectedIndex(size_t window_index) const {
+  DCHECK_LT(window_index, windows_.size());
+  return windows_[window_index].selected_index;
+}
+
+bool SessionReader::ReadTab(size_t window_index,
+                            size_t tab_index,
+                            TabData* tab) const {
+  DCHECK_LT(tab_index, GetTabCount(window_index));
+  const TabEntry& entry = windows_[window_index].tabs[tab_index];
+  *tab = TabData();
+  return ReadTabFromBuffer(data_ + entry.offset, entry.size, tab);
+}
+
+bool SessionReader::ReadSession(std::vector<WindowData>* windows) const {
+  windows->clear();
+  windows->resize(windows_.size());
+  for (size_t window_index = 0; window_index < windows_.size();
+       ++window_index) {
+    WindowData& window = (*windows)[window_index];
+    window.selected_index = windows_[window_index].selected_index;
+    window.tabs.resize(windows_[window_index].tabs.size());
+    for (size_t tab_index = 0; tab_index < window.tabs.size(); ++tab_index) {
+      if (!ReadTab(window_index, tab_index, &window.tabs[tab_index]))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool SessionReader::ReadIndex() {
+  if (!data_ || !HasBinarySessionHeader(data_, size_))
+    return false;
+
+  Reader header(data_ + kVersionOffset, kIndexOffset - kVersionOffset);
+  uint32_t index_size = 0;
+  if (!header.ReadUInt32(&version_) || !header.ReadUInt32(&index_size))
+    return false;
+  if (version_ == 0 || version_ > kCurrentVersion) {
+    DLOG(WARNING) << "Unsupported binary session version: " << version_;
+    return false;
+  }
+
+  if (index_size > size_ - kIndexOffset)
+    return false;
+  const size_t tabs_offset = kIndexOffset + index_size;
+  const size_t tabs_size = size_ - tabs_offset;
+
+  Reader index(data_ + kIndexOffset, index_size);
+  size_t window_count = 0;
+  if (!index.ReadLength(&window_count))
+    return false;
+  for (size_t window_index = 0; window_index < window_count; ++window_index) {
+    WindowEntry window;
+    size_t tab_count = 0;
+    if (!index.ReadInt(&window.selected_index) ||
+        !index.ReadLength(&tab_count)) {
+      return false;
+    }
+    if (window.selected_index < -1 ||
+        (window.selected_index >= 0 &&
+         static_cast<size_t>(window.selected_index) >= tab_count)) {
+      return false;
+    }
+    for (size_t tab_index = 0; tab_index < tab_count; ++tab_index) {
+      uint64_t offset = 0;
+      uint32_t size = 0;
+      if (!index.ReadUInt64(&offset) || !index.ReadUInt32(&size))
+        return false;
+      if (offset > tabs_size || size > tabs_size - offset)
+        return false;
+      TabEntry entry = {tabs_offset + static_cast<size_t>(offset), size};
+      window.tabs.push_back(entry);
+    }
+    windows_.push_back(std::move(window));
+  }
+  return true;
+}
+
+}  // namespace binary_session
+}  // namespace web
@@ -0,0 +1,214 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_WEB_PUBLIC_SESSION_BINARY_FORMAT_H_
+#define IOS_WEB_PUBLIC_SESSION_BINARY_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
+#include "base/strings/string16.h"
+
+namespace base {
+class FilePath;
+}
+
+// A portable binary encoding of a session, i.e. of the content of the
+// CRWSessionStorage of the tabs of one or more windows. Unlike the archives
+// produced by NSKeyedArchiver, a binary session can be read lazily: the file
+// starts with an index of the tabs, and each tab is decoded only when it is
+// requested, from a memory-mapped file. Integers are stored in little-endian,
+// so that a session can be read on a device of any endianness.
+//
+// This file only depends on //base so that the format can be tested on every
+// platform. The conversion from and to CRWSessionStorage is implemented in
+// session_storage_binary_util.h.
+namespace web {
+namespace binary_session {
+
+// Version of the format written by EncodeSession(). Readers reject files with
+// a newer version. New fields must be appended at the end of the data of a
+// tab and only read if the version of the file is recent enough.
+extern const uint32_t kCurrentVersion;
+
+// The state of the scroll view of a page, as in web::PageDisplayState. The
+// values are NAN when unknown.
+struct DisplayStateData {
+  DisplayStateData();
+
+  double content_offset_x;
+  double content_offset_y;
+  double content_inset_top;
+  double content_inset_left;
+  double content_inset_bottom;
+  double content_inset_right;
+  double minimum_zoom_scale;
+  double maximum_zoom_scale;
+  double zoom_scale;
+};
+
+// The persisted properties of a navigation item, as in
+// CRWNavigationItemStorage.
+struct NavigationItemData {
+  NavigationItemData();
+  NavigationItemData(const NavigationItemData& other);
+  NavigationItemData(NavigationItemData&& other);
+  ~NavigationItemData();
+
+  NavigationItemData& operator=(const NavigationItemData& other);
+  NavigationItemData& operator=(NavigationItemData&& other);
+
+  std::string virtual_url;
+  std::string referrer_url;
+  int referrer_policy;
+  // Internal value of the base::Time of the last navigation to the item.
+  int64_t timestamp;
+  base::string16 title;
+  DisplayStateData display_state;
+  bool should_skip_repost_form_confirmation;
+  // Value of the web::UserAgentType of the item.
+  int user_agent_type;
+  // Whether the item has POST data, which may be empty.
+  bool has_post_data;
+  std::string post_data;
+  std::vector<std::pair<std::string, std::string>> http_request_headers;
+};
+
+// A certificate allowed by the user, as in CRWSessionCertificateStorage.
+struct CertificatePolicyData {
+  // The DER encoding of the certificate.
+  std::string certificate;
+  std::string host;
+  uint32_t status;
+};
+
+// The persisted state of a tab, as in CRWSessionStorage.
+struct TabData {
+  TabData();
+  TabData(const TabData& other);
+  TabData(TabData&& other);
+  ~TabData();
+
+  TabData& operator=(const TabData& other);
+  TabData& operator=(TabData&& other);
+
+  bool has_opener;
+  int last_committed_item_index;
+  int previous_item_index;
+  std::vector<NavigationItemData> items;
+  std::vector<CertificatePolicyData> certificate_policies;
+  // The serialized web::SerializableUserData of the tab. Its encoding is
+  // opaque to this format.
+  std::string user_data;
+};
+
+// The tabs of a window, as in SessionWindowIOS.
+struct WindowData {
+  WindowData();
+  WindowData(const WindowData& other);
+  WindowData(WindowData&& other);
+  ~WindowData();
+
+  WindowData& operator=(const WindowData& other);
+  WindowData& operator=(WindowData&& other);
+
+  // Index of the selected tab, or -1 if there is none.
+  int selected_index;
+  std::vector<TabData> tabs;
+};
+
+// Returns the binary encoding of a session made of |windows|.
+std::string EncodeSession(const std::vector<WindowData>& windows);
+
+// Returns whether the |size| bytes at |data| start like a binary session.
+// Used to tell binary sessions from other formats without decoding them.
+bool HasBinarySessionHeader(const void* data, size_t size);
+
+// Reads a binary session. The index of the tabs is decoded when the reader is
+// created, and the tabs are decoded when they are read. Validates the data it
+// reads, so that a corrupted file cannot cause out-of-bounds accesses.
+class SessionReader {
+ public:
+  ~SessionReader();
+
+  // Returns a reader for the session stored in the file at |path|, which is
+  // memory-mapped until the reader is destroyed. Returns null if the file
+  // cannot be mapped, or is not a binary session of a supported version.
+  static std::unique_ptr<SessionReader> OpenFile(const base::FilePath& path);
+
+  // Returns a reader for the session stored in the |size| bytes at |data|,
+  // which must outlive the reader. Returns null if the data is not a binary
+  // session of a supported version.
+  static std::unique_ptr<SessionReader> FromBuffer(const void* data,
+                                                   size_t size);
+
+  // Returns the version of the format of the session.
+  uint32_t version() const { return version_; }
+
+  // Returns the number of windows of the session.
+  size_t GetWindowCount() const;
+
+  // Returns the number of tabs of the window at |window_index|.
+  size_t GetTabCount(size_t window_index) const;
+
+  // Returns the index of the selected tab of the window at |window_index|, or
+  // -1 if there is none.
+  int GetSelectedIndex(size_t window_index) const;
+
+  // Decodes the tab at |tab_index| in the window at |window_index| into
+  // |tab|. Returns false if the data of the tab is corrupted.
+  bool ReadTab(size_t window_index, size_t tab_index, TabData* tab) const;
+
+  // Decodes the whole session into |windows|. Returns false if the data of a
+  // tab is corrupted.
+  bool ReadSession(std::vector<WindowData>* windows) const;
+
+ private:
+  // Location of the data of a tab in the buffer.
+  struct TabEntry {
+    size_t offset;
+    size_t size;
+  };
+
+  // The index of the tabs of a window.
+  struct WindowEntry {
+    WindowEntry();
+    WindowEntry(const WindowEntry& other);
+    WindowEntry(WindowEntry&& other);
+    ~WindowEntry();
+
+    int selected_index;
+    std::vector<TabEntry> tabs;
+  };
+
+  SessionReader(const uint8_t* data, size_t size);
+
+  // Decodes the version and the index of the tabs. Returns false if they are
+  // corrupted or if the version is not supported.
+  bool ReadIndex();
+
+  // The mapped file, if the reader was created with OpenFile().
+  base::MemoryMappedFile file_;
+
+  // The encoded session.
+  const uint8_t* data_;
+  size_t size_;
+
+  uint32_t version_;
+  std::vector<WindowEntry> windows_;
+
+  DISALLOW_COPY_AND_ASSIGN(SessionReader);
+};
+
+}  // namespace binary_session
+}  // namespace web
+
+#endif  // IOS_WEB_PUBLIC_SESSION_BINARY_FORMAT_H_
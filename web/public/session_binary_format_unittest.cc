@@ -0,0 +1,255 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/public/session_binary_format.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace web {
+namespace binary_session {
+
+namespace {
+
+// Returns a tab with |item_count| items, all of whose fields are set.
+TabData CreateTab(int item_count) {
+  TabData tab;
+  tab.has_opener = true;
+  tab.last_committed_item_index = item_count - 1;
+  tab.previous_item_index = item_count - 2;
+  for (int index = 0; index < item_count; ++index) {
+    NavigationItemData item;
+    item.virtual_url = base::StringPrintf("https://www.test.com/%d", index);
+    item.referrer_url = "https://www.referrer.com/";
+    item.referrer_policy = 2;
+    item.timestamp = 1000 + index;
+    item.title = base::ASCIIToUTF16(base::StringPrintf("Title %d", index));
+    item.display_state.content_offset_x = 1.5;
+    item.display_state.content_offset_y = index;
+    item.display_state.content_inset_top = 64;
+    item.display_state.content_inset_left = 0;
+    item.display_state.content_inset_bottom = 0;
+    item.display_state.content_inset_right = 0;
+    item.display_state.minimum_zoom_scale = 0.5;
+    item.display_state.maximum_zoom_scale = 4;
+    item.display_state.zoom_scale = 1;
+    item.should_skip_repost_form_confirmation = index % 2;
+    item.user_agent_type = 2;
+    item.has_post_data = true;
+    item.post_data = std::string("a=1\0b=2", 7);
+    item.http_request_headers.push_back({"Content-Type", "text/plain"});
+    tab.items.push_back(item);
+  }
+  CertificatePolicyData policy;
+  policy.certificate = std::string("\x30\x82\x00\x01", 4);
+  policy.host = "www.test.com";
+  policy.status = 0x20;
+  tab.certificate_policies.push_back(policy);
+  tab.user_data = "user data";
+  return tab;
+}
+
+// Returns the little-endian uint32_t at |offset| in |data|.
+uint32_t ReadLittleEndianUInt32(const std::string& data, size_t offset) {
+  uint32_t value = 0;
+  for (size_t byte = 0; byte < sizeof(value); ++byte)
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data[offset + byte]))
+             << (8 * byte);
+  return value;
+}
+
+// Writes |value| as a little-endian uint32_t at |offset| in |data|.
+void WriteLittleEndianUInt32(uint32_t value, size_t offset, std::string* data) {
+  for (size_t byte = 0; byte < sizeof(value); ++byte)
+    (*data)[offset + byte] = static_cast<char>(value >> (8 * byte));
+}
+
+void ExpectEqualTabs(const TabData& expected, const TabData& actual) {
+  EXPECT_EQ(expected.has_opener, actual.has_opener);
+  EXPECT_EQ(expected.last_committed_item_index,
+            actual.last_committed_item_index);
+  EXPECT_EQ(expected.previous_item_index, actual.previous_item_index);
+  ASSERT_EQ(expected.items.size(), actual.items.size());
+  for (size_t index = 0; index < expected.items.size(); ++index) {
+    const NavigationItemData& expected_item = expected.items[index];
+    const NavigationItemData& actual_item = actual.items[index];
+    EXPECT_EQ(expected_item.virtual_url, actual_item.virtual_url);
+    EXPECT_EQ(expected_item.referrer_url, actual_item.referrer_url);
+    EXPECT_EQ(expected_item.referrer_policy, actual_item.referrer_policy);
+    EXPECT_EQ(expected_item.timestamp, actual_item.timestamp);
+    EXPECT_EQ(expected_item.title, actual_item.title);
+    EXPECT_EQ(expected_item.display_state.content_offset_x,
+              actual_item.display_state.content_offset_x);
+    EXPECT_EQ(expected_item.display_state.content_offset_y,
+              actual_item.display_state.content_offset_y);
+    EXPECT_EQ(expected_item.display_state.content_inset_top,
+              actual_item.display_state.content_inset_top);
+    EXPECT_EQ(expected_item.display_state.zoom_scale,
+              actual_item.display_state.zoom_scale);
+    EXPECT_EQ(expected_item.should_skip_repost_form_confirmation,
+              actual_item.should_skip_repost_form_confirmation);
+    EXPECT_EQ(expected_item.user_agent_type, actual_item.user_agent_type);
+    EXPECT_EQ(expected_item.has_post_data, actual_item.has_post_data);
+    EXPECT_EQ(expected_item.post_data, actual_item.post_data);
+    EXPECT_EQ(expected_item.http_request_headers,
+              actual_item.http_request_headers);
+  }
+  ASSERT_EQ(expected.certificate_policies.size(),
+            actual.certificate_policies.size());
+  for (size_t index = 0; index < expected.certificate_policies.size();
+       ++index) {
+    EXPECT_EQ(expected.certificate_policies[index].certificate,
+              actual.certificate_policies[index].certificate);
+    EXPECT_EQ(expected.certificate_policies[index].host,
+              actual.certificate_policies[index].host);
+    EXPECT_EQ(expected.certificate_policies[index].status,
+              actual.certificate_policies[index].status);
+  }
+  EXPECT_EQ(expected.user_data, actual.user_data);
+}
+
+}  // namespace
+
+class SessionBinaryFormatTest : public PlatformTest {
+ protected:
+  SessionBinaryFormatTest() {
+    WindowData first_window;
+    first_window.selected_index = 1;
+    first_window.tabs.push_back(CreateTab(3));
+    first_window.tabs.push_back(CreateTab(1));
+    windows_.push_back(first_window);
+
+    WindowData second_window;
+    second_window.tabs.push_back(TabData());
+    windows_.push_back(second_window);
+
+    windows_.push_back(WindowData());
+  }
+
+  std::vector<WindowData> windows_;
+};
+
+// Tests that the integers are encoded in little-endian, whatever the
+// endianness of the device.
+TEST_F(SessionBinaryFormatTest, LittleEndianEncoding) {
+  WindowData window;
+  window.selected_index = -1;
+  std::string data = EncodeSession({window});
+  const char kExpected[] =
+      "CrSessBn"
+      "\x01\x00\x00\x00"   // Version.
+      "\x0C\x00\x00\x00"   // Size of the index.
+      "\x01\x00\x00\x00"   // Window count.
+      "\xFF\xFF\xFF\xFF"   // Selected index.
+      "\x00\x00\x00\x00";  // Tab count.
+  EXPECT_EQ(std::string(kExpected, sizeof(kExpected) - 1), data);
+}
+
+// Tests that a session is read back as it was encoded.
+TEST_F(SessionBinaryFormatTest, EncodeAndRead) {
+  std::string data = EncodeSession(windows_);
+  EXPECT_TRUE(HasBinarySessionHeader(data.data(), data.size()));
+
+  std::unique_ptr<SessionReader> reader =
+      SessionReader::FromBuffer(data.data(), data.size());
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(kCurrentVersion, reader->version());
+  ASSERT_EQ(3U, reader->GetWindowCount());
+  EXPECT_EQ(2U, reader->GetTabCount(0));
+  EXPECT_EQ(1, reader->GetSelectedIndex(0));
+  EXPECT_EQ(1U, reader->GetTabCount(1));
+  EXPECT_EQ(-1, reader->GetSelectedIndex(1));
+  EXPECT_EQ(0U, reader->GetTabCount(2));
+
+  std::vector<WindowData> windows;
+  ASSERT_TRUE(reader->ReadSession(&windows));
+  ASSERT_EQ(windows_.size(), windows.size());
+  for (size_t window = 0; window < windows.size(); ++window) {
+    EXPECT_EQ(windows_[window].selected_index, windows[window].selected_index);
+    ASSERT_EQ(windows_[window].tabs.size(), windows[window].tabs.size());
+    for (size_t tab = 0; tab < windows[window].tabs.size(); ++tab)
+      ExpectEqualTabs(windows_[window].tabs[tab], windows[window].tabs[tab]);
+  }
+}
+
+// Tests that the tabs of a session stored in a file are read individually.
+TEST_F(SessionBinaryFormatTest, ReadTabFromFile) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.GetPath().AppendASCII("session.bin");
+  std::string data = EncodeSession(windows_);
+  ASSERT_EQ(static_cast<int>(data.size()),
+            base::WriteFile(path, data.data(), data.size()));
+
+  std::unique_ptr<SessionReader> reader = SessionReader::OpenFile(path);
+  ASSERT_TRUE(reader);
+  TabData tab;
+  ASSERT_TRUE(reader->ReadTab(0, 1, &tab));
+  ExpectEqualTabs(windows_[0].tabs[1], tab);
+  ASSERT_TRUE(reader->ReadTab(0, 0, &tab));
+  ExpectEqualTabs(windows_[0].tabs[0], tab);
+}
+
+// Tests that data in another format is not read.
+TEST_F(SessionBinaryFormatTest, RejectOtherFormats) {
+  const char kPlist[] = "bplist00";
+  EXPECT_FALSE(HasBinarySessionHeader(kPlist, sizeof(kPlist)));
+  EXPECT_FALSE(SessionReader::FromBuffer(kPlist, sizeof(kPlist)));
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  EXPECT_FALSE(
+      SessionReader::OpenFile(temp_dir.GetPath().AppendASCII("missing")));
+}
+
+// Tests that a session written by a newer version of the format is not read.
+TEST_F(SessionBinaryFormatTest, RejectNewerVersion) {
+  std::string data = EncodeSession(windows_);
+  WriteLittleEndianUInt32(kCurrentVersion + 1, 8, &data);
+  EXPECT_TRUE(HasBinarySessionHeader(data.data(), data.size()));
+  EXPECT_FALSE(SessionReader::FromBuffer(data.data(), data.size()));
+}
+
+// Tests that truncated sessions are rejected without reading out of bounds.
+TEST_F(SessionBinaryFormatTest, RejectTruncatedData) {
+  std::string data = EncodeSession(windows_);
+  for (size_t size = 0; size < data.size(); ++size) {
+    std::string truncated = data.substr(0, size);
+    EXPECT_FALSE(SessionReader::FromBuffer(truncated.data(), truncated.size()))
+        << size;
+  }
+}
+
+// Tests that a corrupted tab fails to read without preventing to read the
+// other tabs.
+TEST_F(SessionBinaryFormatTest, ReadAroundCorruptedTab) {
+  std::string data = EncodeSession(windows_);
+  uint32_t index_size = ReadLittleEndianUInt32(data, 12);
+  // Makes the item count of the first tab, which follows a bool and two ints,
+  // exceed the data of the tab.
+  WriteLittleEndianUInt32(0xFFFFFFFF, 16 + index_size + 9, &data);
+
+  std::unique_ptr<SessionReader> reader =
+      SessionReader::FromBuffer(data.data(), data.size());
+  ASSERT_TRUE(reader);
+  TabData tab;
+  EXPECT_FALSE(reader->ReadTab(0, 0, &tab));
+  ASSERT_TRUE(reader->ReadTab(0, 1, &tab));
+  ExpectEqualTabs(windows_[0].tabs[1], tab);
+  std::vector<WindowData> windows;
+  EXPECT_FALSE(reader->ReadSession(&windows));
+}
+
+}  // namespace binary_session
+}  // namespace web
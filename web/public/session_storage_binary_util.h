@@ -0,0 +1,27 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_WEB_PUBLIC_SESSION_STORAGE_BINARY_UTIL_H_
+#define IOS_WEB_PUBLIC_SESSION_STORAGE_BINARY_UTIL_H_
+
+#import <Foundation/Foundation.h>
+
+#include "ios/web/public/session_binary_format.h"
+
+@class CRWSessionStorage;
+
+namespace web {
+
+// Returns the binary representation of |storage|.
+binary_session::TabData TabDataFromSessionStorage(CRWSessionStorage* storage);
+
+// Returns the CRWSessionStorage represented by |tab|. Certificate policies
+// whose certificate cannot be parsed are dropped. As with NSKeyedUnarchiver,
+// an exception is raised if the user data of |tab| is not a valid archive.
+CRWSessionStorage* SessionStorageFromTabData(
+    const binary_session::TabData& tab);
+
+}  // namespace web
+
+#endif  // IOS_WEB_PUBLIC_SESSION_STORAGE_BINARY_UTIL_H_
@@ -0,0 +1,188 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/web/public/session_storage_binary_util.h"
+
+#include <memory>
+
+#include "base/mac/foundation_util.h"
+#include "base/strings/sys_string_conversions.h"
+#import "ios/web/public/crw_navigation_item_storage.h"
+#import "ios/web/public/crw_session_certificate_policy_cache_storage.h"
+#import "ios/web/public/crw_session_storage.h"
+#import "ios/web/public/serializable_user_data_manager.h"
+#include "net/cert/x509_certificate.h"
+#include "net/cert/x509_util.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace web {
+
+namespace {
+
+binary_session::DisplayStateData DisplayStateDataFromPageDisplayState(
+    const PageDisplayState& state) {
+  binary_session::DisplayStateData data;
+  const CGPoint& offset = state.scroll_state().content_offset();
+  const UIEdgeInsets& inset = state.scroll_state().content_inset();
+  data.content_offset_x = offset.x;
+  data.content_offset_y = offset.y;
+  data.content_inset_top = inset.top;
+  data.content_inset_left = inset.left;
+  data.content_inset_bottom = inset.bottom;
+  data.content_inset_right = inset.right;
+  data.minimum_zoom_scale = state.zoom_state().minimum_zoom_scale();
+  data.maximum_zoom_scale = state.zoom_state().maximum_zoom_scale();
+  data.zoom_scale = state.zoom_state().zoom_scale();
+  return data;
+}
+
+PageDisplayState PageDisplayStateFromDisplayStateData(
+    const binary_session::DisplayStateData& data) {
+  return PageDisplayState(
+      CGPointMake(data.content_offset_x, data.content_offset_y),
+      UIEdgeInsetsMake(data.content_inset_top, data.content_inset_left,
+                       data.content_inset_bottom, data.content_inset_right),
+      data.minimum_zoom_scale, data.maximum_zoom_scale, data.zoom_scale);
+}
+
+binary_session::NavigationItemData ItemDataFromItemStorage(
+    CRWNavigationItemStorage* storage) {
+  binary_session::NavigationItemData item;
+  item.virtual_url = storage.virtualURL.spec();
+  item.referrer_url = storage.referrer.url.spec();
+  item.referrer_policy = storage.referrer.policy;
+  item.timestamp = storage.timestamp.ToInternalValue();
+  item.title = storage.title;
+  item.display_state =
+      DisplayStateDataFromPageDisplayState(storage.displayState);
+  item.should_skip_repost_form_confirmation =
+      storage.shouldSkipRepostFormConfirmation;
+  item.user_agent_type = static_cast<int>(storage.userAgentType);
+  if (storage.POSTData) {
+    item.has_post_data = true;
+    item.post_data.assign(static_cast<const char*>(storage.POSTData.bytes),
+                          storage.POSTData.length);
+  }
+  for (NSString* name in storage.HTTPRequestHeaders) {
+    NSString* value =
+        base::mac::ObjCCast<NSString>(storage.HTTPRequestHeaders[name]);
+    if (value) {
+      item.http_request_headers.emplace_back(base::SysNSStringToUTF8(name),
+                                             base::SysNSStringToUTF8(value));
+    }
+  }
+  return item;
+}
+
+CRWNavigationItemStorage* ItemStorageFromItemData(
+    const binary_session::NavigationItemData& item) {
+  CRWNavigationItemStorage* storage = [[CRWNavigationItemStorage alloc] init];
+  storage.virtualURL = GURL(item.virtual_url);
+  storage.referrer =
+      Referrer(GURL(item.referrer_url),
+               static_cast<ReferrerPolicy>(item.referrer_policy));
+  storage.timestamp = base::Time::FromInternalValue(item.timestamp);
+  storage.title = item.title;
+  storage.displayState =
+      PageDisplayStateFromDisplayStateData(item.display_state);
+  storage.shouldSkipRepostFormConfirmation =
+      item.should_skip_repost_form_confirmation;
+  storage.userAgentType = static_cast<UserAgentType>(item.user_agent_type);
+  if (item.has_post_data) {
+    storage.POSTData = [NSData dataWithBytes:item.post_data.data()
+                                      length:item.post_data.size()];
+  }
+  if (!item.http_request_headers.empty()) {
+    NSMutableDictionary* headers = [NSMutableDictionary
+        dictionaryWithCapacity:item.http_request_headers.size()];
+    for (const auto& header : item.http_request_headers) {
+      headers[base::SysUTF8ToNSString(header.first)] =
+          base::SysUTF8ToNSString(header.second);
+    }
+    storage.HTTPRequestHeaders = headers;
+  }
+  return storage;
+}
+
+}  // namespace
+
+binary_session::TabData TabDataFromSessionStorage(CRWSessionStorage* storage) {
+  binary_session::TabData tab;
+  tab.has_opener = storage.hasOpener;
+  tab.last_committed_item_index = storage.lastCommittedItemIndex;
+  tab.previous_item_index = storage.previousItemIndex;
+  for (CRWNavigationItemStorage* item in storage.itemStorages)
+    tab.items.push_back(ItemDataFromItemStorage(item));
+
+  for (CRWSessionCertificateStorage* certificate in storage
+           .certPolicyCacheStorage.certificateStorages) {
+    binary_session::CertificatePolicyData policy;
+    base::StringPiece der = net::x509_util::CryptoBufferAsStringPiece(
+        certificate.certificate->cert_buffer());
+    der.CopyToString(&policy.certificate);
+    policy.host = certificate.host;
+    policy.status = certificate.status;
+    tab.certificate_policies.push_back(std::move(policy));
+  }
+
+  if (storage.userData) {
+    NSMutableData* data = [[NSMutableData alloc] init];
+    NSKeyedArchiver* archiver =
+        [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+    storage.userData->Encode(archiver);
+    [archiver finishEncoding];
+    tab.user_data.assign(static_cast<const char*>(data.bytes), data.length);
+  }
+  return tab;
+}
+
+CRWSessionStorage* SessionStorageFromTabData(
+    const binary_session::TabData& tab) {
+  CRWSessionStorage* storage = [[CRWSessionStorage alloc] init];
+  storage.hasOpener = tab.has_opener;
+  storage.lastCommittedItemIndex = tab.last_committed_item_index;
+  storage.previousItemIndex = tab.previous_item_index;
+
+  NSMutableArray* items = [NSMutableArray arrayWithCapacity:tab.items.size()];
+  for (const binary_session::NavigationItemData& item : tab.items)
+    [items addObject:ItemStorageFromItemData(item)];
+  storage.itemStorages = items;
+
+  NSMutableSet* certificates =
+      [NSMutableSet setWithCapacity:tab.certificate_policies.size()];
+  for (const binary_session::CertificatePolicyData& policy :
+       tab.certificate_policies) {
+    scoped_refptr<net::X509Certificate> certificate =
+        net::X509Certificate::CreateFromBytes(policy.certificate.data(),
+                                              policy.certificate.size());
+    if (!certificate || policy.host.empty())
+      continue;
+    [certificates addObject:[[CRWSessionCertificateStorage alloc]
+                                initWithCertificate:certificate
+                                               host:policy.host
+                                             status:policy.status]];
+  }
+  storage.certPolicyCacheStorage =
+      [[CRWSessionCertificatePolicyCacheStorage alloc] init];
+  storage.certPolicyCacheStorage.certificateStorages = certificates;
+
+  // As when decoding a CRWSessionStorage, the user data is never null.
+  std::unique_ptr<SerializableUserData> user_data =
+      SerializableUserData::Create();
+  if (!tab.user_data.empty()) {
+    NSData* data = [NSData dataWithBytes:tab.user_data.data()
+                                  length:tab.user_data.size()];
+    NSKeyedUnarchiver* unarchiver =
+        [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+    user_data->Decode(unarchiver);
+    [unarchiver finishDecoding];
+  }
+  [storage setSerializableUserData:std::move(user_data)];
+  return storage;
+}
+
+}  // namespace web
@@ -57,4 +57,10 @@ bool FakeWebFrame::CallJavaScriptFunction(
   return CallJavaScriptFunction(name, parameters);
 }
 
+bool FakeWebFrame::CallJavaScriptFunctions(std::vector<FunctionCall> calls) {
+  for (const FunctionCall& call : calls)
+    CallJavaScriptFunction(call.name, call.parameters);
+  return false;
+}
+
 }  // namespace web
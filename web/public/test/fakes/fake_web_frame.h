@@ -31,6 +31,10 @@ class FakeWebFrame : public WebFrame {
       const std::vector<base::Value>& parameters,
       base::OnceCallback<void(const base::Value*)> callback,
       base::TimeDelta timeout) override;
+  // This method will not call JavaScript and immediately return false. The
+  // last call of |calls| is recorded as the last JavaScript call. No callback
+  // will be called.
+  bool CallJavaScriptFunctions(std::vector<FunctionCall> calls) override;
   std::string last_javascript_call() { return last_javascript_call_; }
 
  private:
@@ -44,6 +44,8 @@ class TestWebState : public WebState {
   void Stop() override {}
   const NavigationManager* GetNavigationManager() const override;
   NavigationManager* GetNavigationManager() override;
+  bool IsRealized() const override;
+  void ForceRealized() override;
   const SessionCertificatePolicyCache* GetSessionCertificatePolicyCache()
       const override;
   SessionCertificatePolicyCache* GetSessionCertificatePolicyCache() override;
@@ -99,6 +101,9 @@ class TestWebState : public WebState {
   void SetView(UIView* view);
   void SetIsCrashed(bool value);
   void SetIsEvicted(bool value);
+  // Makes the WebState unrealized until ForceRealized() is called or its
+  // NavigationManager is accessed.
+  void SetIsUnrealized();
   void SetWebViewProxy(CRWWebViewProxyType web_view_proxy);
   void ClearLastExecutedJavascript();
   void CreateWebFramesManager();
@@ -133,6 +138,7 @@ class TestWebState : public WebState {
   bool is_crashed_;
   bool is_evicted_;
   bool has_opener_;
+  mutable bool is_realized_;
   GURL url_;
   base::string16 title_;
   base::string16 last_executed_javascript_;
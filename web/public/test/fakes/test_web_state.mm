@@ -41,6 +41,7 @@ TestWebState::TestWebState()
       is_crashed_(false),
       is_evicted_(false),
       has_opener_(false),
+      is_realized_(true),
       trust_level_(kAbsolute),
       content_is_html_(true),
       web_view_proxy_(nil) {}
@@ -91,13 +92,23 @@ void TestWebState::WasHidden() {
 }
 
 const NavigationManager* TestWebState::GetNavigationManager() const {
+  is_realized_ = true;
   return navigation_manager_.get();
 }
 
 NavigationManager* TestWebState::GetNavigationManager() {
+  is_realized_ = true;
   return navigation_manager_.get();
 }
 
+bool TestWebState::IsRealized() const {
+  return is_realized_;
+}
+
+void TestWebState::ForceRealized() {
+  is_realized_ = true;
+}
+
 const SessionCertificatePolicyCache*
 TestWebState::GetSessionCertificatePolicyCache() const {
   return nullptr;
@@ -310,6 +321,10 @@ void TestWebState::SetVisibleURL(const GURL& url) {
   url_ = url;
 }
 
+void TestWebState::SetIsUnrealized() {
+  is_realized_ = false;
+}
+
 void TestWebState::SetTrustLevel(URLVerificationTrustLevel trust_level) {
   trust_level_ = trust_level;
 }
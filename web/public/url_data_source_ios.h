@@ -70,6 +70,18 @@ class URLDataSourceIOS {
   // Returns true if responses from this URLDataSourceIOS can be cached.
   virtual bool AllowCaching() const;
 
+  // Returns true if GetMimeType() and StartDataRequest() can be called on the
+  // IO thread for |path|, in which case StartDataRequest() must run its
+  // callback on the IO thread too. Such requests are served without any round
+  // trip to the UI thread. The default is false.
+  virtual bool ShouldServeOnIOThread(const std::string& path) const;
+
+  // Returns true if the response for |path| does not change for the lifetime
+  // of this URLDataSourceIOS. Unless AllowCaching() returns false, such
+  // responses are kept in a memory cache on the IO thread and the following
+  // requests for |path| are served from that cache. The default is false.
+  virtual bool IsStaticResource(const std::string& path) const;
+
   // By default, "object-src 'none';" is added to CSP. Override to change this.
   virtual std::string GetContentSecurityPolicyObjectSrc() const;
 
@@ -0,0 +1,27 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/public/web_state/web_frame.h"
+
+namespace web {
+
+WebFrame::FunctionCall::FunctionCall(std::string name,
+                                     std::vector<base::Value> parameters)
+    : name(std::move(name)), parameters(std::move(parameters)) {}
+
+WebFrame::FunctionCall::FunctionCall(
+    std::string name,
+    std::vector<base::Value> parameters,
+    base::OnceCallback<void(const base::Value*)> callback,
+    base::TimeDelta timeout)
+    : name(std::move(name)),
+      parameters(std::move(parameters)),
+      callback(std::move(callback)),
+      timeout(timeout) {}
+
+WebFrame::FunctionCall::FunctionCall(FunctionCall&& other) = default;
+
+WebFrame::FunctionCall::~FunctionCall() = default;
+
+}  // namespace web
@@ -6,16 +6,15 @@
 #define IOS_WEB_PUBLIC_WEB_STATE_WEB_FRAME_H_
 
 #include <string>
+#include <vector>
 
+#include "base/callback.h"
 #include "base/macros.h"
 #include "base/supports_user_data.h"
 #include "base/time/time.h"
+#include "base/values.h"
 #include "url/gurl.h"
 
-namespace base {
-class Value;
-}
-
 namespace web {
 
 class WebFrame : public base::SupportsUserData {
@@ -61,6 +60,34 @@ class WebFrame : public base::SupportsUserData {
       base::OnceCallback<void(const base::Value*)> callback,
       base::TimeDelta timeout) = 0;
 
+  // A call of the JavaScript function |name| with |parameters|, as passed to
+  // |CallJavaScriptFunctions|. If |callback| is set, it is called with the
+  // value returned by the function, or with nullptr once |timeout| is reached.
+  struct FunctionCall {
+    FunctionCall(std::string name, std::vector<base::Value> parameters);
+    FunctionCall(std::string name,
+                 std::vector<base::Value> parameters,
+                 base::OnceCallback<void(const base::Value*)> callback,
+                 base::TimeDelta timeout);
+    FunctionCall(FunctionCall&& other);
+    ~FunctionCall();
+
+    std::string name;
+    std::vector<base::Value> parameters;
+    base::OnceCallback<void(const base::Value*)> callback;
+    base::TimeDelta timeout;
+  };
+
+  // Calls the JavaScript functions of |calls| in order, in the same condition
+  // as the CallJavaScriptFunction functions. Callers making several calls into
+  // the same frame should prefer this method: when the frame is messaged with
+  // encryption, all the calls are encrypted into a single message, which is
+  // sent before this method returns, and their results are sent back in a
+  // single reply. Returns false if the calls could
+  // not be requested. Always returns false if |CanCallJavaScriptFunction| is
+  // false.
+  virtual bool CallJavaScriptFunctions(std::vector<FunctionCall> calls) = 0;
+
   ~WebFrame() override {}
 
  protected:
@@ -70,6 +70,10 @@ class WebState : public base::SupportsUserData {
     // clicking a link with a blank target.  Used to determine whether the
     // WebState is allowed to be closed via window.close().
     bool created_with_opener;
+
+    // Whether a WebState created from a serialized session defers restoring
+    // the session until it is first needed. See IsRealized().
+    bool restore_session_lazily;
   };
 
   // Parameters for the OpenURL() method.
@@ -135,10 +139,25 @@ class WebState : public base::SupportsUserData {
   virtual void Stop() = 0;
 
   // Gets the NavigationManager associated with this WebState. Can never return
-  // null.
+  // null. Realizes the WebState.
   virtual const NavigationManager* GetNavigationManager() const = 0;
   virtual NavigationManager* GetNavigationManager() = 0;
 
+  // Returns whether the WebState restored its session. A WebState created
+  // from a serialized session with |restore_session_lazily| is unrealized: it
+  // only keeps the serialized session, from which it answers GetTitle(),
+  // GetVisibleURL(), GetLastCommittedURL() and BuildSessionStorage(). It
+  // restores the session, i.e. becomes realized, when ForceRealized() is
+  // called or when anything else requires its navigation history, such as
+  // accessing its NavigationManager or its view, or loading a page. The
+  // certificate policies of the session are added to the BrowserState's
+  // CertificatePolicyCache when it is realized.
+  virtual bool IsRealized() const = 0;
+
+  // Restores the session of an unrealized WebState. Does nothing if the
+  // WebState is realized.
+  virtual void ForceRealized() = 0;
+
   // Gets the SessionCertificatePolicyCache for this WebState.  Can never return
   // null.
   virtual const SessionCertificatePolicyCache*
@@ -35,6 +35,13 @@ struct NonNestable {};
 // in the order they were posted, regardless of the TaskRunners they were
 // posted via.
 //
+// Tasks posted with a higher base::TaskPriority run first, unless a lower
+// priority task has waited for too long. Tasks posted without a priority are
+// USER_BLOCKING; use base::TaskPriority::BEST_EFFORT for work that can wait,
+// e.g. metrics:
+//     base::PostTaskWithTraits(
+//         FROM_HERE, {WebThread::UI, base::TaskPriority::BEST_EFFORT}, task);
+//
 // See //base/task/post_task.h for more detailed documentation.
 //
 // Posting to a WebThread must only be done after it was initialized (ref.
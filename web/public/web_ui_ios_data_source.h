@@ -56,6 +56,11 @@ class WebUIIOSDataSource : public base::SupportsUserData {
   // The following map to methods on URLDataSource. See the documentation there.
   virtual void DisableDenyXFrameOptions() = 0;
   virtual void UseGzip() = 0;
+
+  // Serves the requests of this source on the IO thread. Only for sources
+  // whose strings and resources are all added before Add() is called, as the
+  // source is then read from the IO thread.
+  virtual void ServeOnIOThread() = 0;
 };
 
 }  // namespace web
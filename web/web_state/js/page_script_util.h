@@ -13,9 +13,20 @@ namespace web {
 class BrowserState;
 
 // Returns an autoreleased string containing the JavaScript loaded from a
-// bundled resource file with the given name (excluding extension).
+// bundled resource file with the given name (excluding extension). The file is
+// only read the first time, and the content is then cached for the lifetime of
+// the process. Can be called from any thread.
 NSString* GetPageScript(NSString* script_file_name);
 
+// Reads the bundled scripts the document start and end scripts are assembled
+// from, so that they are cached before the first web view is created. Blocks,
+// so must be called on a background thread.
+void PreloadPageScripts();
+
+// The document start and end scripts are assembled once and cached for the
+// lifetime of the process. They are assembled again if the scripts returned by
+// the WebClient change.
+
 // Returns an autoreleased string containing the JavaScript to be injected into
 // the main frame of the web view as early as possible.
 NSString* GetDocumentStartScriptForMainFrame(BrowserState* browser_state);
@@ -7,7 +7,10 @@
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/mac/bundle_locations.h"
+#include "base/macros.h"
+#include "base/no_destructor.h"
 #include "base/strings/sys_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "ios/web/public/browser_state.h"
 #import "ios/web/public/web_client.h"
 
@@ -51,11 +54,17 @@ NSString* EscapedQuotedString(NSString* string) {
   ;
 }
 
-}  // namespace
-
-namespace web {
-
-NSString* GetPageScript(NSString* script_file_name) {
+// The names of the bundled scripts the document start and end scripts are
+// assembled from.
+NSString* const kMainFrameWebBundle = @"main_frame_web_bundle";
+NSString* const kNavigationBundle = @"nav_bundle";
+NSString* const kAllFramesWebBundle = @"all_frames_web_bundle";
+NSString* const kAllFramesDocumentEndWebBundle =
+    @"all_frames_document_end_web_bundle";
+
+// Reads the script bundled in the resource file |script_file_name|.js. The
+// file is mapped in memory rather than read into an intermediate buffer.
+NSString* ReadPageScript(NSString* script_file_name) {
   DCHECK(script_file_name);
   NSString* path =
       [base::mac::FrameworkBundle() pathForResource:script_file_name
@@ -63,33 +72,119 @@ NSString* GetPageScript(NSString* script_file_name) {
   DCHECK(path) << "Script file not found: "
                << base::SysNSStringToUTF8(script_file_name) << ".js";
   NSError* error = nil;
-  NSString* content = [NSString stringWithContentsOfFile:path
-                                                encoding:NSUTF8StringEncoding
-                                                   error:&error];
+  NSData* data = [NSData dataWithContentsOfFile:path
+                                        options:NSDataReadingMappedIfSafe
+                                          error:&error];
   DCHECK(!error) << "Error fetching script: "
                  << base::SysNSStringToUTF8(error.description);
+  NSString* content = [[NSString alloc] initWithData:data
+                                            encoding:NSUTF8StringEncoding];
   DCHECK(content);
   return content;
 }
 
+// Per-process cache of the bundled scripts, which never change, and of the
+// assembled document start and end scripts, which only change when the
+// embedder's scripts change. Can be used from any thread.
+class PageScriptCache {
+ public:
+  PageScriptCache()
+      : scripts_([NSMutableDictionary dictionary]),
+        assembled_scripts_([NSMutableDictionary dictionary]),
+        assembled_script_inputs_([NSMutableDictionary dictionary]) {}
+
+  static PageScriptCache* GetInstance() {
+    static base::NoDestructor<PageScriptCache> instance;
+    return instance.get();
+  }
+
+  // Returns the script bundled in |script_file_name|.js, read on first use.
+  NSString* GetScript(NSString* script_file_name) {
+    base::AutoLock lock(lock_);
+    NSString* script = scripts_[script_file_name];
+    if (!script) {
+      script = ReadPageScript(script_file_name);
+      scripts_[script_file_name] = script;
+    }
+    return script;
+  }
+
+  // Returns the script stored under |key| if it was assembled from |input|.
+  // Otherwise returns the script returned by |assemble|, and stores it under
+  // |key| with |input|.
+  NSString* GetAssembledScript(NSString* key,
+                               NSString* input,
+                               NSString* (^assemble)()) {
+    {
+      base::AutoLock lock(lock_);
+      NSString* cached_input = assembled_script_inputs_[key];
+      if (cached_input &&
+          (cached_input == input || [cached_input isEqualToString:input])) {
+        return assembled_scripts_[key];
+      }
+    }
+    // |assemble| reads the bundled scripts, so it must not be called with
+    // |lock_| held.
+    NSString* script = assemble();
+    base::AutoLock lock(lock_);
+    assembled_scripts_[key] = script;
+    assembled_script_inputs_[key] = [input copy];
+    return script;
+  }
+
+ private:
+  base::Lock lock_;
+  // The bundled scripts, by file name.
+  NSMutableDictionary<NSString*, NSString*>* scripts_;
+  // The assembled scripts and the input they were assembled from, by key.
+  NSMutableDictionary<NSString*, NSString*>* assembled_scripts_;
+  NSMutableDictionary<NSString*, NSString*>* assembled_script_inputs_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageScriptCache);
+};
+
+}  // namespace
+
+namespace web {
+
+NSString* GetPageScript(NSString* script_file_name) {
+  DCHECK(script_file_name);
+  return PageScriptCache::GetInstance()->GetScript(script_file_name);
+}
+
+void PreloadPageScripts() {
+  PageScriptCache* cache = PageScriptCache::GetInstance();
+  for (NSString* script_file_name :
+       @[ kAllFramesWebBundle, kMainFrameWebBundle, kNavigationBundle,
+          kAllFramesDocumentEndWebBundle ]) {
+    cache->GetScript(script_file_name);
+  }
+}
+
 NSString* GetDocumentStartScriptForMainFrame(BrowserState* browser_state) {
   DCHECK(GetWebClient());
   NSString* embedder_page_script =
       GetWebClient()->GetDocumentStartScriptForMainFrame(browser_state);
   DCHECK(embedder_page_script);
 
-  NSString* web_bundle = GetPageScript(@"main_frame_web_bundle");
-
   // The WKBackForwardList based navigation manager doesn't need to inject
   // JavaScript to intercept navigation calls.
-  if (!GetWebClient()->IsSlimNavigationManagerEnabled()) {
-    web_bundle = [NSString
-        stringWithFormat:@"%@; %@", web_bundle, GetPageScript(@"nav_bundle")];
-  }
-
-  NSString* script =
-      [NSString stringWithFormat:@"%@; %@", web_bundle, embedder_page_script];
-  return MakeScriptInjectableOnce(@"start_main_frame", script);
+  const bool inject_navigation_bundle =
+      !GetWebClient()->IsSlimNavigationManagerEnabled();
+  NSString* key = inject_navigation_bundle ? @"start_main_frame_with_nav"
+                                           : @"start_main_frame";
+  return PageScriptCache::GetInstance()->GetAssembledScript(
+      key, embedder_page_script, ^{
+        NSString* web_bundle = GetPageScript(kMainFrameWebBundle);
+        if (inject_navigation_bundle) {
+          web_bundle =
+              [NSString stringWithFormat:@"%@; %@", web_bundle,
+                                         GetPageScript(kNavigationBundle)];
+        }
+        NSString* script = [NSString
+            stringWithFormat:@"%@; %@", web_bundle, embedder_page_script];
+        return MakeScriptInjectableOnce(@"start_main_frame", script);
+      });
 }
 
 NSString* GetDocumentStartScriptForAllFrames(BrowserState* browser_state) {
@@ -97,22 +192,26 @@ NSString* GetDocumentStartScriptForAllFrames(BrowserState* browser_state) {
   NSString* embedder_page_script =
       GetWebClient()->GetDocumentStartScriptForAllFrames(browser_state);
   DCHECK(embedder_page_script);
-  NSString* web_bundle = GetPageScript(@"all_frames_web_bundle");
-  NSString* script =
-      [NSString stringWithFormat:@"%@; %@", web_bundle, embedder_page_script];
-  return MakeScriptInjectableOnce(@"start_all_frames", script);
+  return PageScriptCache::GetInstance()->GetAssembledScript(
+      @"start_all_frames", embedder_page_script, ^{
+        NSString* script = [NSString
+            stringWithFormat:@"%@; %@", GetPageScript(kAllFramesWebBundle),
+                             embedder_page_script];
+        return MakeScriptInjectableOnce(@"start_all_frames", script);
+      });
 }
 
 NSString* GetDocumentEndScriptForAllFrames(BrowserState* browser_state) {
   NSString* plugin_not_supported_text =
       base::SysUTF16ToNSString(GetWebClient()->GetPluginNotSupportedText());
-
-  NSString* script = [GetPageScript(@"all_frames_document_end_web_bundle")
-      stringByReplacingOccurrencesOfString:@"$(PLUGIN_NOT_SUPPORTED_TEXT)"
-                                withString:EscapedQuotedString(
-                                               plugin_not_supported_text)];
-
-  return MakeScriptInjectableOnce(@"end_all_frames", script);
+  return PageScriptCache::GetInstance()->GetAssembledScript(
+      @"end_all_frames", plugin_not_supported_text, ^{
+        NSString* escaped_text = EscapedQuotedString(plugin_not_supported_text);
+        NSString* script = [GetPageScript(kAllFramesDocumentEndWebBundle)
+            stringByReplacingOccurrencesOfString:@"$(PLUGIN_NOT_SUPPORTED_TEXT)"
+                                      withString:escaped_text];
+        return MakeScriptInjectableOnce(@"end_all_frames", script);
+      });
 }
 
 }  // namespace web
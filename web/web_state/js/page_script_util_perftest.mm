@@ -0,0 +1,96 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#import "ios/web/web_state/js/page_script_util.h"
+
+#import <WebKit/WebKit.h>
+
+#include <memory>
+
+#include "base/ios/block_types.h"
+#include "base/timer/elapsed_timer.h"
+#import "ios/web/public/test/fakes/test_web_client.h"
+#include "ios/web/public/test/web_test.h"
+#import "ios/web/public/web_view_creation_util.h"
+#import "ios/web/web_state/ui/wk_web_view_configuration_provider.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace web {
+
+namespace {
+
+// Number of times each measured operation is repeated.
+const int kRepeatCount = 20;
+
+}  // namespace
+
+// Measures the cost of assembling the page scripts and of creating the web
+// views the scripts are injected into.
+class PageScriptUtilPerfTest : public WebTest {
+ protected:
+  PageScriptUtilPerfTest() : WebTest(std::make_unique<TestWebClient>()) {}
+
+  // Returns the time taken by |block|, in milliseconds.
+  double Measure(ProceduralBlock block) {
+    base::ElapsedTimer timer;
+    block();
+    return timer.Elapsed().InMillisecondsF();
+  }
+
+  // Returns the average time taken by |block| over |kRepeatCount| runs, in
+  // milliseconds.
+  double MeasureAverage(ProceduralBlock block) {
+    double total = 0;
+    for (int i = 0; i < kRepeatCount; ++i)
+      total += Measure(block);
+    return total / kRepeatCount;
+  }
+
+  // Builds the document start and end scripts.
+  void GetDocumentScripts() {
+    GetDocumentStartScriptForAllFrames(GetBrowserState());
+    GetDocumentStartScriptForMainFrame(GetBrowserState());
+    GetDocumentEndScriptForAllFrames(GetBrowserState());
+  }
+};
+
+// Reports the time taken to get the page scripts the first time, when they are
+// read and assembled, and then from the cache. Also reports the time taken to
+// create a web view with a new configuration, which includes the creation of
+// the user scripts, as when a browser state's configuration is purged.
+TEST_F(PageScriptUtilPerfTest, WebViewCreation) {
+  perf_test::PrintResult("page_scripts", "", "first", Measure(^{
+                           GetDocumentScripts();
+                         }),
+                         "ms", true /* important */);
+  perf_test::PrintResult("page_scripts", "", "cached", MeasureAverage(^{
+                           GetDocumentScripts();
+                         }),
+                         "ms", true /* important */);
+
+  WKWebViewConfigurationProvider& config_provider =
+      WKWebViewConfigurationProvider::FromBrowserState(GetBrowserState());
+  perf_test::PrintResult("web_view_creation", "", "new_configuration",
+                         MeasureAverage(^{
+                           config_provider.Purge();
+                           WKWebView* web_view =
+                               BuildWKWebView(CGRectZero, GetBrowserState());
+                           EXPECT_TRUE(web_view);
+                         }),
+                         "ms", true /* important */);
+  perf_test::PrintResult("web_view_creation", "", "cached_configuration",
+                         MeasureAverage(^{
+                           WKWebView* web_view =
+                               BuildWKWebView(CGRectZero, GetBrowserState());
+                           EXPECT_TRUE(web_view);
+                         }),
+                         "ms", true /* important */);
+}
+
+}  // namespace web
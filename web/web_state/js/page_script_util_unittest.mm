@@ -55,5 +55,21 @@ TEST_F(PageScriptUtilTest, WKEmbedderScript) {
               test::ExecuteJavaScript(web_view, @"typeof __gCrEmbedder"));
 }
 
+// Tests that the document start script is only assembled again when the
+// embedder's script changes.
+TEST_F(PageScriptUtilTest, DocumentStartScriptCache) {
+  GetWebClient()->SetEarlyPageScript(@"__gCrEmbedder = 1;");
+  NSString* script = GetDocumentStartScriptForMainFrame(GetBrowserState());
+  EXPECT_EQ(script, GetDocumentStartScriptForMainFrame(GetBrowserState()));
+
+  GetWebClient()->SetEarlyPageScript(@"__gCrEmbedder = 2;");
+  NSString* updated_script =
+      GetDocumentStartScriptForMainFrame(GetBrowserState());
+  EXPECT_NE(NSNotFound,
+            [updated_script rangeOfString:@"__gCrEmbedder = 2;"].location);
+  EXPECT_EQ(NSNotFound,
+            [updated_script rangeOfString:@"__gCrEmbedder = 1;"].location);
+}
+
 }  // namespace
 }  // namespace web
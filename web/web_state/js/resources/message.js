@@ -228,6 +228,56 @@ var replyWithResult_ = function(messageId, result) {
   __gCrWeb.message.invokeOnHost(response);
 };
 
+/**
+ * Sends the return values of the calls of a batched message to the native
+ * application in a single reply.
+ * @param {!Array<!Object>} replies The replies to send. Each reply has the
+ *                          'messageId' of its call and an optional 'result'.
+ */
+var replyWithResults_ = function(replies) {
+  var replyCommand = 'frameMessaging_' +
+      __gCrWeb.message['getFrameId']() + '.reply';
+  __gCrWeb.message.invokeOnHost({
+    'command': replyCommand,
+    'replies': replies
+  });
+};
+
+/**
+ * Executes the function call described by |callDict| if it is valid.
+ * @param {!Object} callDict The call with 'messageId', 'functionName',
+ *                  'parameters' and 'replyWithResult' keys.
+ * @return {?Object} The reply to send for the call, null if the call is
+ *         invalid or does not need a reply.
+ */
+var executeCall_ = function(callDict) {
+  // Verify that message id is valid.
+  if (!callDict || !Number.isInteger(callDict['messageId']) ||
+      callDict['messageId'] <= lastReceivedMessageId_) {
+    return null;
+  }
+
+  // Check that a function name and parameters are specified.
+  if (typeof callDict['functionName'] !== 'string' ||
+      callDict['functionName'].length < 1 ||
+      !Array.isArray(callDict['parameters'])) {
+    return null;
+  }
+
+  lastReceivedMessageId_ = callDict['messageId'];
+  var result =
+      callGCrWebFunction_(callDict['functionName'], callDict['parameters']);
+  if (typeof callDict['replyWithResult'] !== 'boolean' ||
+      !callDict['replyWithResult']) {
+    return null;
+  }
+  var reply = {'messageId': callDict['messageId']};
+  if (typeof result !== 'undefined') {
+    reply['result'] = result;
+  }
+  return reply;
+};
+
 /**
  * Executes |functionName| on __gCrWeb with the given |parameters|.
  * @param {!string} functionPath The function to execute on __gCrWeb. Components
@@ -251,7 +301,10 @@ var callGCrWebFunction_ = function(functionPath, parameters) {
 }
 
 /**
- * Decrypts and executes the function specified in |payload|.
+ * Decrypts and executes the function specified in |payload|. The payload is
+ * either a single call, or an object whose 'calls' list holds the calls sent
+ * together by the native code for this frame, which are executed in order and
+ * replied to at once.
  * @param {!string} payload The encrypted message payload.
  * @param {!string} iv The initialization vector used to encrypt the |payload|.
  */
@@ -281,25 +334,24 @@ var executeMessage_ = function(payload, iv) {
           String.fromCharCode.apply(null, new Uint8Array(decrypted));
       var callDict = JSON.parse(callJSON);
 
-      // Verify that message id is valid.
-      if (!Number.isInteger(callDict['messageId']) ||
-          callDict['messageId'] <= lastReceivedMessageId_) {
+      if (!Array.isArray(callDict['calls'])) {
+        var reply = executeCall_(callDict);
+        if (reply) {
+          replyWithResult_(reply['messageId'], reply['result']);
+        }
         return;
       }
 
-      // Check that a function name and parameters are specified.
-      if (typeof callDict['functionName'] !== 'string' ||
-          callDict['functionName'].length < 1 ||
-          !Array.isArray(callDict['parameters'])) {
-        return;
+      var replies = [];
+      var calls = callDict['calls'];
+      for (var i = 0; i < calls.length; i++) {
+        var callReply = executeCall_(calls[i]);
+        if (callReply) {
+          replies.push(callReply);
+        }
       }
-
-      lastReceivedMessageId_ = callDict['messageId'];
-      var result =
-          callGCrWebFunction_(callDict['functionName'], callDict['parameters']);
-      if (typeof callDict['replyWithResult'] === 'boolean' &&
-          callDict['replyWithResult']) {
-        replyWithResult_(callDict['messageId'], result);
+      if (replies.length) {
+        replyWithResults_(replies);
       }
     });
   });
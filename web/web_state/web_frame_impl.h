@@ -9,6 +9,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/cancelable_callback.h"
 #include "base/macros.h"
@@ -55,6 +56,8 @@ class WebFrameImpl : public WebFrame, public web::WebStateObserver {
       base::OnceCallback<void(const base::Value*)> callback,
       base::TimeDelta timeout) override;
 
+  bool CallJavaScriptFunctions(std::vector<FunctionCall> calls) override;
+
   // WebStateObserver implementation
   void WebStateDestroyed(web::WebState* web_state) override;
 
@@ -67,6 +70,23 @@ class WebFrameImpl : public WebFrame, public web::WebStateObserver {
                               const std::vector<base::Value>& parameters,
                               bool reply_with_result);
 
+  // Returns the message describing the call of the JavaScript function |name|
+  // with |parameters|, as expected by __gCrWeb.message.routeMessage.
+  base::Value CreateCallMessage(const std::string& name,
+                                const std::vector<base::Value>& parameters,
+                                int message_id,
+                                bool reply_with_result);
+
+  // Encrypts |message| and passes it to __gCrWeb.message.routeMessage.
+  // Returns false if |message| could not be encrypted.
+  bool SendEncryptedMessage(const base::Value& message);
+
+  // Stores |callback| as the completion of the request with id |message_id|
+  // and schedules its cancellation after |timeout|.
+  void AddPendingRequest(int message_id,
+                         base::OnceCallback<void(const base::Value*)> callback,
+                         base::TimeDelta timeout);
+
   // Detaches the receiver from the associated  WebState.
   void DetachFromWebState();
   // Returns the script command name to use for this WebFrame.
@@ -113,8 +133,13 @@ class WebFrameImpl : public WebFrame, public web::WebStateObserver {
   // |pending_requests_|.
   void CancelPendingRequests();
 
+  // Completes the request of the call described by |reply|, which holds the
+  // message ID and result of the call. Returns false if |reply| is invalid.
+  bool HandleReply(const base::Value& reply);
+
   // Handles message from JavaScript with result of executing the function
-  // specified in CallJavaScriptFunction.
+  // specified in CallJavaScriptFunction, or with the results of the calls of
+  // a batched message.
   bool OnJavaScriptReply(web::WebState* web_state,
                          const base::DictionaryValue& command,
                          const GURL& page_url,
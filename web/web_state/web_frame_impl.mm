@@ -102,13 +102,25 @@ bool WebFrameImpl::CallJavaScriptFunction(
                                      reply_with_result);
   }
 
-  base::DictionaryValue message;
+  return SendEncryptedMessage(
+      CreateCallMessage(name, parameters, message_id, reply_with_result));
+}
+
+base::Value WebFrameImpl::CreateCallMessage(
+    const std::string& name,
+    const std::vector<base::Value>& parameters,
+    int message_id,
+    bool reply_with_result) {
+  base::Value message(base::Value::Type::DICTIONARY);
   message.SetKey("messageId", base::Value(message_id));
   message.SetKey("replyWithResult", base::Value(reply_with_result));
   message.SetKey("functionName", base::Value(name));
   base::ListValue parameters_value(parameters);
   message.SetKey("parameters", std::move(parameters_value));
+  return message;
+}
 
+bool WebFrameImpl::SendEncryptedMessage(const base::Value& message) {
   std::string json;
   base::JSONWriter::Write(message, &json);
 
@@ -137,6 +149,21 @@ bool WebFrameImpl::CallJavaScriptFunction(
   return true;
 }
 
+void WebFrameImpl::AddPendingRequest(
+    int message_id,
+    base::OnceCallback<void(const base::Value*)> callback,
+    base::TimeDelta timeout) {
+  auto timeout_callback = std::make_unique<TimeoutCallback>(base::BindOnce(
+      &WebFrameImpl::CancelRequest, base::Unretained(this), message_id));
+  auto callbacks = std::make_unique<struct RequestCallbacks>(
+      std::move(callback), std::move(timeout_callback));
+  pending_requests_[message_id] = std::move(callbacks);
+
+  base::PostDelayedTaskWithTraits(
+      FROM_HERE, {web::WebThread::UI},
+      pending_requests_[message_id]->timeout_callback->callback(), timeout);
+}
+
 bool WebFrameImpl::CallJavaScriptFunction(
     const std::string& name,
     const std::vector<base::Value>& parameters) {
@@ -149,16 +176,8 @@ bool WebFrameImpl::CallJavaScriptFunction(
     base::OnceCallback<void(const base::Value*)> callback,
     base::TimeDelta timeout) {
   int message_id = next_message_id_;
+  AddPendingRequest(message_id, std::move(callback), timeout);
 
-  auto timeout_callback = std::make_unique<TimeoutCallback>(base::BindOnce(
-      &WebFrameImpl::CancelRequest, base::Unretained(this), message_id));
-  auto callbacks = std::make_unique<struct RequestCallbacks>(
-      std::move(callback), std::move(timeout_callback));
-  pending_requests_[message_id] = std::move(callbacks);
-
-  base::PostDelayedTaskWithTraits(
-      FROM_HERE, {web::WebThread::UI},
-      pending_requests_[message_id]->timeout_callback->callback(), timeout);
   bool called =
       CallJavaScriptFunction(name, parameters, /*reply_with_result=*/true);
   if (!called) {
@@ -171,6 +190,54 @@ bool WebFrameImpl::CallJavaScriptFunction(
   return called;
 }
 
+bool WebFrameImpl::CallJavaScriptFunctions(std::vector<FunctionCall> calls) {
+  if (!CanCallJavaScriptFunction()) {
+    return false;
+  }
+
+  // Without an encryption key, each function is evaluated directly.
+  if (!frame_key_) {
+    bool called = true;
+    for (FunctionCall& call : calls) {
+      if (call.callback) {
+        called = CallJavaScriptFunction(call.name, call.parameters,
+                                        std::move(call.callback),
+                                        call.timeout) &&
+                 called;
+      } else {
+        called = CallJavaScriptFunction(call.name, call.parameters) && called;
+      }
+    }
+    return called;
+  }
+
+  std::vector<int> reply_message_ids;
+  base::Value::ListStorage messages;
+  for (FunctionCall& call : calls) {
+    int message_id = next_message_id_;
+    next_message_id_++;
+
+    bool reply_with_result = !call.callback.is_null();
+    if (reply_with_result) {
+      AddPendingRequest(message_id, std::move(call.callback), call.timeout);
+      reply_message_ids.push_back(message_id);
+    }
+    messages.push_back(CreateCallMessage(call.name, call.parameters,
+                                         message_id, reply_with_result));
+  }
+
+  base::Value batch(base::Value::Type::DICTIONARY);
+  batch.SetKey("calls", base::Value(std::move(messages)));
+  if (!SendEncryptedMessage(batch)) {
+    // Remove callbacks if the call failed.
+    for (int message_id : reply_message_ids) {
+      pending_requests_.erase(message_id);
+    }
+    return false;
+  }
+  return true;
+}
+
 bool WebFrameImpl::ExecuteJavaScriptFunction(
     const std::string& name,
     const std::vector<base::Value>& parameters,
@@ -229,6 +296,28 @@ void WebFrameImpl::CancelPendingRequests() {
   pending_requests_.clear();
 }
 
+bool WebFrameImpl::HandleReply(const base::Value& reply) {
+  const base::Value* message_id_value = reply.FindKey("messageId");
+  if (!message_id_value || !message_id_value->is_double()) {
+    return false;
+  }
+
+  int message_id = static_cast<int>(message_id_value->GetDouble());
+
+  auto request = pending_requests_.find(message_id);
+  if (request == pending_requests_.end()) {
+    return false;
+  }
+
+  auto callbacks = std::move(request->second);
+  pending_requests_.erase(request);
+  callbacks->timeout_callback->Cancel();
+  const base::Value* result = reply.FindKey("result");
+  std::move(callbacks->completion).Run(result);
+
+  return true;
+}
+
 bool WebFrameImpl::OnJavaScriptReply(web::WebState* web_state,
                                      const base::DictionaryValue& command_json,
                                      const GURL& page_url,
@@ -236,7 +325,7 @@ bool WebFrameImpl::OnJavaScriptReply(web::WebState* web_state,
                                      bool is_main_frame,
                                      WebFrame* sender_frame) {
   auto* command = command_json.FindKey("command");
-  if (!command || !command->is_string() || !command_json.HasKey("messageId")) {
+  if (!command || !command->is_string()) {
     NOTREACHED();
     return false;
   }
@@ -247,27 +336,27 @@ bool WebFrameImpl::OnJavaScriptReply(web::WebState* web_state,
     return false;
   }
 
-  auto* message_id_value = command_json.FindKey("messageId");
-  if (!message_id_value->is_double()) {
-    NOTREACHED();
-    return false;
+  const base::Value* replies =
+      command_json.FindKeyOfType("replies", base::Value::Type::LIST);
+  if (!replies) {
+    if (!HandleReply(command_json)) {
+      NOTREACHED();
+      return false;
+    }
+    return true;
   }
 
-  int message_id = static_cast<int>(message_id_value->GetDouble());
-
-  auto request = pending_requests_.find(message_id);
-  if (request == pending_requests_.end()) {
-    NOTREACHED();
-    return false;
+  // The completion callbacks may destroy the receiver.
+  base::WeakPtr<WebFrameImpl> weak_frame = weak_ptr_factory_.GetWeakPtr();
+  bool handled = true;
+  for (const base::Value& reply : replies->GetList()) {
+    if (!weak_frame) {
+      break;
+    }
+    handled = HandleReply(reply) && handled;
   }
-
-  auto callbacks = std::move(request->second);
-  pending_requests_.erase(request);
-  callbacks->timeout_callback->Cancel();
-  const base::Value* result = command_json.FindKey("result");
-  std::move(callbacks->completion).Run(result);
-
-  return true;
+  DCHECK(handled);
+  return handled;
 }
 
 void WebFrameImpl::DetachFromWebState() {
@@ -10,6 +10,7 @@
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #import "base/strings/sys_string_conversions.h"
+#include "base/strings/utf_string_conversions.h"
 #include "base/test/ios/wait_util.h"
 #include "base/values.h"
 #include "crypto/aead.h"
@@ -338,6 +339,87 @@ TEST_F(WebFrameImplTest, CallJavaScriptFunctionRespondWithResult) {
   EXPECT_TRUE(decrypted_respond_with_result);
 }
 
+// Tests that |CallJavaScriptFunctions| encrypts the calls into a single message
+// which is sent before it returns.
+TEST_F(WebFrameImplTest, CallJavaScriptFunctions) {
+  std::unique_ptr<SymmetricKey> key = CreateKey();
+  const std::string key_string = key->key();
+  const int initial_message_id = 11;
+
+  TestWebState test_web_state;
+  GURL security_origin;
+  WebFrameImpl web_frame(kFrameId, /*is_main_frame=*/false, security_origin,
+                         &test_web_state);
+  web_frame.SetEncryptionKey(std::move(key));
+  web_frame.SetNextMessageId(initial_message_id);
+
+  std::vector<WebFrameImpl::FunctionCall> calls;
+  calls.emplace_back("function1", std::vector<base::Value>());
+  calls.emplace_back("function2", std::vector<base::Value>(),
+                     base::BindOnce(^(const base::Value* value){
+                     }),
+                     base::TimeDelta::FromSeconds(5));
+  EXPECT_TRUE(web_frame.CallJavaScriptFunctions(std::move(calls)));
+
+  NSString* last_script =
+      base::SysUTF16ToNSString(test_web_state.GetLastExecutedJavascript());
+  RouteMessageParameters params = ParametersFromFunctionCallString(last_script);
+
+  std::string decoded_ciphertext;
+  EXPECT_TRUE(
+      base::Base64Decode(base::SysNSStringToUTF8(params.encoded_function_json),
+                         &decoded_ciphertext));
+  std::string decoded_iv;
+  EXPECT_TRUE(base::Base64Decode(base::SysNSStringToUTF8(params.encoded_iv),
+                                 &decoded_iv));
+
+  crypto::Aead aead(crypto::Aead::AES_256_GCM);
+  aead.Init(&key_string);
+  std::string plaintext;
+  EXPECT_TRUE(aead.Open(decoded_ciphertext, decoded_iv,
+                        /*additional_data=*/nullptr, &plaintext));
+
+  std::unique_ptr<base::Value> parsed_result(
+      base::JSONReader::ReadDeprecated(plaintext, false));
+  ASSERT_TRUE(parsed_result.get());
+  const base::Value* sent_calls =
+      parsed_result->FindKeyOfType("calls", base::Value::Type::LIST);
+  ASSERT_TRUE(sent_calls);
+  ASSERT_EQ(2U, sent_calls->GetList().size());
+
+  const base::Value& call1 = sent_calls->GetList()[0];
+  EXPECT_EQ(initial_message_id, call1.FindKey("messageId")->GetInt());
+  EXPECT_EQ("function1", call1.FindKey("functionName")->GetString());
+  EXPECT_FALSE(call1.FindKey("replyWithResult")->GetBool());
+
+  const base::Value& call2 = sent_calls->GetList()[1];
+  EXPECT_EQ(initial_message_id + 1, call2.FindKey("messageId")->GetInt());
+  EXPECT_EQ("function2", call2.FindKey("functionName")->GetString());
+  EXPECT_TRUE(call2.FindKey("replyWithResult")->GetBool());
+}
+
+// Tests that |CallJavaScriptFunction| sends the message before it returns, so
+// that it is evaluated before the scripts executed afterwards.
+TEST_F(WebFrameImplTest, CallJavaScriptFunctionKeepsOrder) {
+  TestWebState test_web_state;
+  GURL security_origin;
+  WebFrameImpl web_frame(kFrameId, /*is_main_frame=*/false, security_origin,
+                         &test_web_state);
+  web_frame.SetEncryptionKey(CreateKey());
+
+  std::vector<base::Value> function_params;
+  EXPECT_TRUE(
+      web_frame.CallJavaScriptFunction("functionName", function_params));
+  NSString* last_script =
+      base::SysUTF16ToNSString(test_web_state.GetLastExecutedJavascript());
+  EXPECT_TRUE([last_script hasPrefix:@"__gCrWeb.message.routeMessage"]);
+
+  test_web_state.ExecuteJavaScript(base::UTF8ToUTF16("script"));
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(base::UTF8ToUTF16("script"),
+            test_web_state.GetLastExecutedJavascript());
+}
+
 // Tests that the WebFrame properly creates JavaScript for the main frame when
 // there is no encryption key.
 TEST_F(WebFrameImplTest, CallJavaScriptFunctionMainFrameWithoutKey) {
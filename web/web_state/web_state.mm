@@ -11,7 +11,9 @@
 namespace web {
 
 WebState::CreateParams::CreateParams(web::BrowserState* browser_state)
-    : browser_state(browser_state), created_with_opener(false) {}
+    : browser_state(browser_state),
+      created_with_opener(false),
+      restore_session_lazily(false) {}
 
 WebState::CreateParams::~CreateParams() {}
 
@@ -46,6 +46,7 @@ class BrowserState;
 struct ContextMenuParams;
 struct FaviconURL;
 class NavigationContextImpl;
+class NavigationItemImpl;
 class NavigationManager;
 class SessionCertificatePolicyCacheImpl;
 class WebInterstitialImpl;
@@ -193,6 +194,8 @@ class WebStateImpl : public WebState, public NavigationManagerDelegate {
   void Stop() override;
   const NavigationManager* GetNavigationManager() const override;
   NavigationManager* GetNavigationManager() override;
+  bool IsRealized() const override;
+  void ForceRealized() override;
   const SessionCertificatePolicyCache* GetSessionCertificatePolicyCache()
       const override;
   SessionCertificatePolicyCache* GetSessionCertificatePolicyCache() override;
@@ -315,6 +318,9 @@ class WebStateImpl : public WebState, public NavigationManagerDelegate {
   // Restores session history into the navigation manager.
   void RestoreSessionStorage(CRWSessionStorage* session_storage);
 
+  // Realizes the WebState from const methods that need its session.
+  void ForceRealizedFromConstMethod() const;
+
   // Delegate, not owned by this object.
   WebStateDelegate* delegate_;
 
@@ -376,6 +382,15 @@ class WebStateImpl : public WebState, public NavigationManagerDelegate {
   // the WKWebView. This is reset in OnNavigationItemCommitted().
   CRWSessionStorage* restored_session_storage_;
 
+  // The session to restore when the WebState is realized, nil if the WebState
+  // is realized. See WebState::IsRealized().
+  CRWSessionStorage* unrealized_session_storage_;
+
+  // The last committed item of |unrealized_session_storage_|, used to answer
+  // title and URL queries without realizing the WebState. Null if the
+  // WebState is realized or if the session has no committed item.
+  std::unique_ptr<NavigationItemImpl> unrealized_last_committed_item_;
+
   // Favicons URLs received in OnFaviconUrlUpdated.
   // WebStateObserver:FaviconUrlUpdated must be called for same-document
   // navigations, so this cache will be used to avoid running expensive favicon
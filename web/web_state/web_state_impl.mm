@@ -17,15 +17,18 @@
 #import "ios/web/navigation/crw_session_controller.h"
 #import "ios/web/navigation/legacy_navigation_manager_impl.h"
 #import "ios/web/navigation/navigation_item_impl.h"
+#import "ios/web/navigation/navigation_item_storage_builder.h"
 #import "ios/web/navigation/session_storage_builder.h"
 #import "ios/web/navigation/wk_based_navigation_manager_impl.h"
 #import "ios/web/navigation/wk_navigation_util.h"
 #include "ios/web/public/browser_state.h"
+#include "ios/web/public/certificate_policy_cache.h"
 #import "ios/web/public/crw_navigation_item_storage.h"
 #import "ios/web/public/crw_session_storage.h"
 #include "ios/web/public/favicon_url.h"
 #import "ios/web/public/java_script_dialog_presenter.h"
 #import "ios/web/public/navigation_item.h"
+#import "ios/web/public/serializable_user_data_manager.h"
 #include "ios/web/public/url_util.h"
 #import "ios/web/public/web_client.h"
 #import "ios/web/public/web_state/context_menu_params.h"
@@ -55,6 +58,25 @@
 
 namespace web {
 
+namespace {
+
+// Returns a copy of |session_storage| with |user_data| as serializable user
+// data.
+CRWSessionStorage* CopySessionStorage(
+    CRWSessionStorage* session_storage,
+    std::unique_ptr<SerializableUserData> user_data) {
+  CRWSessionStorage* copy = [[CRWSessionStorage alloc] init];
+  copy.hasOpener = session_storage.hasOpener;
+  copy.lastCommittedItemIndex = session_storage.lastCommittedItemIndex;
+  copy.previousItemIndex = session_storage.previousItemIndex;
+  copy.itemStorages = session_storage.itemStorages;
+  copy.certPolicyCacheStorage = session_storage.certPolicyCacheStorage;
+  [copy setSerializableUserData:std::move(user_data)];
+  return copy;
+}
+
+}  // namespace
+
 /* static */
 std::unique_ptr<WebState> WebState::Create(const CreateParams& params) {
   std::unique_ptr<WebStateImpl> web_state(new WebStateImpl(params));
@@ -83,7 +105,8 @@ WebStateImpl::WebStateImpl(const CreateParams& params,
       is_being_destroyed_(false),
       web_controller_(nil),
       interstitial_(nullptr),
-      created_with_opener_(params.created_with_opener) {
+      created_with_opener_(params.created_with_opener),
+      unrealized_session_storage_(nil) {
   if (web::GetWebClient()->IsSlimNavigationManagerEnabled()) {
     navigation_manager_ = std::make_unique<WKBasedNavigationManagerImpl>();
   } else {
@@ -98,7 +121,23 @@ WebStateImpl::WebStateImpl(const CreateParams& params,
 
   // Restore session history last because WKBasedNavigationManagerImpl relies on
   // CRWWebController to restore history into the web view.
-  if (session_storage) {
+  if (session_storage && params.restore_session_lazily) {
+    // Only restore what is needed to identify the WebState in its WebStateList
+    // and to display it in the tab switcher. The session is restored when the
+    // WebState is realized.
+    unrealized_session_storage_ = session_storage;
+    created_with_opener_ = session_storage.hasOpener;
+    SerializableUserDataManager::FromWebState(this)->AddSerializableUserData(
+        session_storage.userData);
+    NSInteger index = session_storage.lastCommittedItemIndex;
+    if (index >= 0 &&
+        static_cast<NSUInteger>(index) < session_storage.itemStorages.count) {
+      NavigationItemStorageBuilder item_storage_builder;
+      unrealized_last_committed_item_ =
+          item_storage_builder.BuildNavigationItemImpl(
+              session_storage.itemStorages[index]);
+    }
+  } else if (session_storage) {
     RestoreSessionStorage(session_storage);
   } else {
     certificate_policy_cache_ =
@@ -276,20 +315,24 @@ void WebStateImpl::OnFaviconUrlUpdated(
 }
 
 NavigationManagerImpl& WebStateImpl::GetNavigationManagerImpl() {
+  ForceRealized();
   return *navigation_manager_;
 }
 
 const NavigationManagerImpl& WebStateImpl::GetNavigationManagerImpl() const {
+  ForceRealizedFromConstMethod();
   return *navigation_manager_;
 }
 
 const SessionCertificatePolicyCacheImpl&
 WebStateImpl::GetSessionCertificatePolicyCacheImpl() const {
+  ForceRealizedFromConstMethod();
   return *certificate_policy_cache_;
 }
 
 SessionCertificatePolicyCacheImpl&
 WebStateImpl::GetSessionCertificatePolicyCacheImpl() {
+  ForceRealized();
   return *certificate_policy_cache_;
 }
 
@@ -322,6 +365,11 @@ const base::string16& WebStateImpl::GetTitle() const {
   // TODO(stuartmorgan): Implement the NavigationManager logic necessary to
   // match the WebContents implementation of this method.
   DCHECK(Configured());
+  if (unrealized_session_storage_) {
+    return unrealized_last_committed_item_
+               ? unrealized_last_committed_item_->GetTitleForDisplay()
+               : empty_string16_;
+  }
   web::NavigationItem* item = navigation_manager_->GetLastCommittedItem();
   if (web::GetWebClient()->IsSlimNavigationManagerEnabled()) {
     // Display title for the visible item makes more sense. Only do this in
@@ -563,6 +611,7 @@ void WebStateImpl::SetWebUsageEnabled(bool enabled) {
 }
 
 UIView* WebStateImpl::GetView() {
+  ForceRealized();
   return [web_controller_ view];
 }
 
@@ -612,6 +661,32 @@ NavigationManager* WebStateImpl::GetNavigationManager() {
   return &GetNavigationManagerImpl();
 }
 
+bool WebStateImpl::IsRealized() const {
+  return !unrealized_session_storage_;
+}
+
+void WebStateImpl::ForceRealized() {
+  if (!unrealized_session_storage_)
+    return;
+
+  // Reset the unrealized state first as restoring the session accesses the
+  // navigation manager.
+  CRWSessionStorage* session_storage = unrealized_session_storage_;
+  unrealized_session_storage_ = nil;
+  unrealized_last_committed_item_.reset();
+
+  // The serializable user data was restored on creation and may have been
+  // updated since, do not overwrite it.
+  RestoreSessionStorage(CopySessionStorage(
+      session_storage, SerializableUserDataManager::FromWebState(this)
+                           ->CreateSerializableUserData()));
+
+  // The certificate policies of the session were not added to the
+  // BrowserState's cache when the WebState was created.
+  certificate_policy_cache_->UpdateCertificatePolicyCache(
+      BrowserState::GetCertificatePolicyCache(GetBrowserState()));
+}
+
 const SessionCertificatePolicyCache*
 WebStateImpl::GetSessionCertificatePolicyCache() const {
   return &GetSessionCertificatePolicyCacheImpl();
@@ -623,6 +698,11 @@ WebStateImpl::GetSessionCertificatePolicyCache() {
 }
 
 CRWSessionStorage* WebStateImpl::BuildSessionStorage() {
+  if (unrealized_session_storage_) {
+    return CopySessionStorage(unrealized_session_storage_,
+                              SerializableUserDataManager::FromWebState(this)
+                                  ->CreateSerializableUserData());
+  }
   [web_controller_ recordStateInHistory];
   if (web::GetWebClient()->IsSlimNavigationManagerEnabled() &&
       restored_session_storage_)
@@ -675,16 +755,27 @@ bool WebStateImpl::ContentIsHTML() const {
 }
 
 const GURL& WebStateImpl::GetVisibleURL() const {
+  if (unrealized_session_storage_) {
+    return unrealized_last_committed_item_
+               ? unrealized_last_committed_item_->GetVirtualURL()
+               : GURL::EmptyGURL();
+  }
   web::NavigationItem* item = navigation_manager_->GetVisibleItem();
   return item ? item->GetVirtualURL() : GURL::EmptyGURL();
 }
 
 const GURL& WebStateImpl::GetLastCommittedURL() const {
+  if (unrealized_session_storage_) {
+    return unrealized_last_committed_item_
+               ? unrealized_last_committed_item_->GetVirtualURL()
+               : GURL::EmptyGURL();
+  }
   web::NavigationItem* item = navigation_manager_->GetLastCommittedItem();
   return item ? item->GetVirtualURL() : GURL::EmptyGURL();
 }
 
 GURL WebStateImpl::GetCurrentURL(URLVerificationTrustLevel* trust_level) const {
+  ForceRealizedFromConstMethod();
   GURL result = [web_controller_ currentURLWithTrustLevel:trust_level];
 
   web::NavigationItem* item = navigation_manager_->GetLastCommittedItem();
@@ -892,6 +983,12 @@ void WebStateImpl::RemoveWebView() {
   return [web_controller_ removeWebView];
 }
 
+void WebStateImpl::ForceRealizedFromConstMethod() const {
+  // Realizing the WebState does not change the state observable through its
+  // const methods, so it is safe to do it from them.
+  const_cast<WebStateImpl*>(this)->ForceRealized();
+}
+
 void WebStateImpl::RestoreSessionStorage(CRWSessionStorage* session_storage) {
   // Session storage restore is asynchronous with WKBasedNavigationManager
   // because it involves a page load in WKWebView. Temporarily cache the
@@ -938,6 +938,41 @@ TEST_P(WebStateImplTest, NoUncommittedRestoreSession) {
   EXPECT_EQ(GURL::EmptyGURL(), web_state_->GetVisibleURL());
 }
 
+// Tests that a WebState created with |restore_session_lazily| answers title,
+// URL and session storage queries from the session it was created with, and
+// restores it when its NavigationManager is accessed.
+TEST_P(WebStateImplTest, RestoreSessionLazily) {
+  GURL url("http://test.com");
+  CRWSessionStorage* session_storage = [[CRWSessionStorage alloc] init];
+  session_storage.hasOpener = YES;
+  session_storage.lastCommittedItemIndex = 0;
+  CRWNavigationItemStorage* item_storage =
+      [[CRWNavigationItemStorage alloc] init];
+  item_storage.title = base::SysNSStringToUTF16(@"Title");
+  item_storage.virtualURL = url;
+  session_storage.itemStorages = @[ item_storage ];
+
+  web::WebState::CreateParams params(GetBrowserState());
+  params.restore_session_lazily = true;
+  WebStateImpl web_state(params, session_storage);
+
+  EXPECT_FALSE(web_state.IsRealized());
+  EXPECT_TRUE(web_state.HasOpener());
+  EXPECT_NSEQ(@"Title", base::SysUTF16ToNSString(web_state.GetTitle()));
+  EXPECT_EQ(url, web_state.GetVisibleURL());
+  EXPECT_EQ(url, web_state.GetLastCommittedURL());
+  CRWSessionStorage* extracted_session_storage =
+      web_state.BuildSessionStorage();
+  EXPECT_EQ(0, extracted_session_storage.lastCommittedItemIndex);
+  EXPECT_EQ(1U, extracted_session_storage.itemStorages.count);
+  EXPECT_FALSE(web_state.IsRealized());
+
+  ASSERT_TRUE(web_state.GetNavigationManager());
+  EXPECT_TRUE(web_state.IsRealized());
+  EXPECT_NSEQ(@"Title", base::SysUTF16ToNSString(web_state.GetTitle()));
+  EXPECT_EQ(url, web_state.GetVisibleURL());
+}
+
 // Tests showing and clearing interstitial when NavigationManager is
 // empty.
 TEST_P(WebStateImplTest, ShowAndClearInterstitialWithNoCommittedItems) {
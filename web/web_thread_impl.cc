@@ -4,8 +4,10 @@
 
 #include "ios/web/web_thread_impl.h"
 
+#include <atomic>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/atomicops.h"
 #include "base/bind.h"
@@ -13,14 +15,17 @@
 #include "base/compiler_specific.h"
 #include "base/lazy_instance.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/task/post_task.h"
 #include "base/task/task_executor.h"
+#include "base/task/task_traits.h"
 #include "base/time/time.h"
 #include "ios/web/public/web_task_traits.h"
 #include "ios/web/public/web_thread_delegate.h"
+#include "ios/web/web_thread_task_queues.h"
 
 namespace web {
 
@@ -30,21 +35,22 @@ namespace {
 // with WebThread.
 class WebThreadTaskRunner : public base::SingleThreadTaskRunner {
  public:
-  explicit WebThreadTaskRunner(WebThread::ID identifier) : id_(identifier) {}
+  WebThreadTaskRunner(WebThread::ID identifier, base::TaskPriority priority)
+      : id_(identifier), priority_(priority) {}
 
   // SingleThreadTaskRunner implementation.
   bool PostDelayedTask(const base::Location& from_here,
                        base::OnceClosure task,
                        base::TimeDelta delay) override {
-    return base::PostDelayedTaskWithTraits(from_here, {id_}, std::move(task),
-                                           delay);
+    return base::PostDelayedTaskWithTraits(from_here, {id_, priority_},
+                                           std::move(task), delay);
   }
 
   bool PostNonNestableDelayedTask(const base::Location& from_here,
                                   base::OnceClosure task,
                                   base::TimeDelta delay) override {
-    return base::PostDelayedTaskWithTraits(from_here, {id_, NonNestable()},
-                                           std::move(task), delay);
+    return base::PostDelayedTaskWithTraits(
+        from_here, {id_, priority_, NonNestable()}, std::move(task), delay);
   }
 
   bool RunsTasksInCurrentSequence() const override {
@@ -56,19 +62,39 @@ class WebThreadTaskRunner : public base::SingleThreadTaskRunner {
 
  private:
   WebThread::ID id_;
+  base::TaskPriority priority_;
   DISALLOW_COPY_AND_ASSIGN(WebThreadTaskRunner);
 };
 
+// Priority of the tasks posted without an explicit priority. It matches the
+// priority the tasks had before WebThreads ran priority queues, so that only
+// the tasks explicitly posted with a lower priority are deferred.
+constexpr base::TaskPriority kDefaultPriority =
+    base::TaskPriority::USER_BLOCKING;
+
+constexpr int kPriorityCount =
+    static_cast<int>(base::TaskPriority::HIGHEST) + 1;
+
 // A separate helper is used just for the task runners, in order to avoid
 // needing to initialize the globals to create a task runner.
 struct WebThreadTaskRunners {
   WebThreadTaskRunners() {
     for (int i = 0; i < WebThread::ID_COUNT; ++i) {
-      task_runners[i] = new WebThreadTaskRunner(static_cast<WebThread::ID>(i));
+      for (int j = 0; j < kPriorityCount; ++j) {
+        task_runners[i][j] =
+            new WebThreadTaskRunner(static_cast<WebThread::ID>(i),
+                                    static_cast<base::TaskPriority>(j));
+      }
     }
   }
 
-  scoped_refptr<base::SingleThreadTaskRunner> task_runners[WebThread::ID_COUNT];
+  scoped_refptr<base::SingleThreadTaskRunner> Get(WebThread::ID identifier,
+                                                  base::TaskPriority priority) {
+    return task_runners[identifier][static_cast<int>(priority)];
+  }
+
+  scoped_refptr<base::SingleThreadTaskRunner>
+      task_runners[WebThread::ID_COUNT][kPriorityCount];
 };
 
 base::LazyInstance<WebThreadTaskRunners>::Leaky g_task_runners =
@@ -84,66 +110,81 @@ enum WebThreadState {
   SHUTDOWN,
 };
 
+// The state of the WebThreads is read without locking when posting tasks, as
+// posts from every thread would otherwise contend on a single lock. Each state
+// transition is published RCU-style: the task runner and task queues of a
+// WebThread::ID are published before its state switches to RUNNING, and stay
+// published and alive after it switches to SHUTDOWN, so that a racing post
+// reaches a task runner which drops the task. They are never released, as a
+// racing post may still be using them: ResetGlobalsForTesting() unpublishes
+// them and moves them to the retired arrays.
 struct WebThreadGlobals {
   WebThreadGlobals() {
+    for (int i = 0; i < WebThread::ID_COUNT; ++i) {
+      published_task_runners[i].store(nullptr, std::memory_order_relaxed);
+      published_task_queues[i].store(nullptr, std::memory_order_relaxed);
+      states[i].store(WebThreadState::UNINITIALIZED, std::memory_order_relaxed);
+    }
   }
 
-  // This lock protects |threads| and |states|. Do not read or modify those
-  // arrays without holding this lock. Do not block while holding this lock.
+  // This lock serializes the state transitions and protects |task_runners|
+  // and |task_queues|. It is not needed to read the published arrays. Do not
+  // block while holding this lock.
   base::Lock lock;
 
-  // This array is protected by |lock|. This array is filled as WebThreadImpls
-  // are constructed and depopulated when they are destructed.
+  // These arrays are protected by |lock|. They hold the references to the task
+  // runner and the task queues of each WebThread::ID, and are filled as
+  // WebThreadImpls are constructed.
   scoped_refptr<base::SingleThreadTaskRunner>
       task_runners[WebThread::ID_COUNT] GUARDED_BY(lock);
-
-  // This array is protected by |lock|. Holds the state of each WebThread::ID.
-  WebThreadState states[WebThread::ID_COUNT] GUARDED_BY(lock) = {};
+  scoped_refptr<WebThreadTaskQueues>
+      task_queues[WebThread::ID_COUNT] GUARDED_BY(lock);
+
+  // Lock-free copies of |task_runners| and |task_queues|.
+  std::atomic<base::SingleThreadTaskRunner*>
+      published_task_runners[WebThread::ID_COUNT];
+  std::atomic<WebThreadTaskQueues*> published_task_queues[WebThread::ID_COUNT];
+
+  // The task runners and task queues unpublished by ResetGlobalsForTesting(),
+  // kept alive for the posts that loaded them before.
+  std::vector<scoped_refptr<base::SingleThreadTaskRunner>>
+      retired_task_runners GUARDED_BY(lock);
+  std::vector<scoped_refptr<WebThreadTaskQueues>> retired_task_queues
+      GUARDED_BY(lock);
+
+  // Holds the state of each WebThread::ID. Stored with release semantics after
+  // the published arrays are updated, so loading it with acquire semantics
+  // makes them visible.
+  std::atomic<WebThreadState> states[WebThread::ID_COUNT];
 };
 
 base::LazyInstance<WebThreadGlobals>::Leaky g_globals =
     LAZY_INSTANCE_INITIALIZER;
 
 bool PostTaskHelper(WebThread::ID identifier,
+                    base::TaskPriority priority,
                     const base::Location& from_here,
                     base::OnceClosure task,
                     base::TimeDelta delay,
-                    bool nestable) NO_THREAD_SAFETY_ANALYSIS {
+                    bool nestable) {
   DCHECK_GE(identifier, 0);
   DCHECK_LT(identifier, WebThread::ID_COUNT);
-  // Optimization: to avoid unnecessary locks, we listed the ID enumeration in
-  // order of lifetime.  So no need to lock if we know that the target thread
-  // outlives current thread.
-  // Note: since the array is so small, ok to loop instead of creating a map,
-  // which would require a lock because std::map isn't thread safe, defeating
-  // the whole purpose of this optimization.
-  WebThread::ID current_thread = WebThread::ID_COUNT;
-  bool target_thread_outlives_current =
-      WebThread::GetCurrentThreadIdentifier(&current_thread) &&
-      current_thread >= identifier;
 
   WebThreadGlobals& globals = g_globals.Get();
-  if (!target_thread_outlives_current)
-    globals.lock.Acquire();
-
-  const bool accepting_tasks =
-      globals.states[identifier] == WebThreadState::RUNNING;
-  if (accepting_tasks) {
-    base::SingleThreadTaskRunner* task_runner =
-        globals.task_runners[identifier].get();
-    DCHECK(task_runner);
-    if (nestable) {
-      task_runner->PostDelayedTask(from_here, std::move(task), delay);
-    } else {
-      task_runner->PostNonNestableDelayedTask(from_here, std::move(task),
-                                              delay);
-    }
+  if (globals.states[identifier].load(std::memory_order_acquire) !=
+      WebThreadState::RUNNING) {
+    return false;
   }
 
-  if (!target_thread_outlives_current)
-    globals.lock.Release();
-
-  return accepting_tasks;
+  // ResetGlobalsForTesting() may unpublish the queues after the state was
+  // checked, so the pointer is loaded once and may be null. Retired queues
+  // are kept alive, so a non-null pointer stays valid.
+  WebThreadTaskQueues* task_queues =
+      globals.published_task_queues[identifier].load(std::memory_order_acquire);
+  if (!task_queues)
+    return false;
+  return task_queues->PostDelayedTask(priority, from_here, std::move(task),
+                                      delay, nestable);
 }
 
 class WebThreadTaskExecutor : public base::TaskExecutor {
@@ -157,18 +198,21 @@ class WebThreadTaskExecutor : public base::TaskExecutor {
                                  base::OnceClosure task,
                                  base::TimeDelta delay) override {
     return PostTaskHelper(
-        GetWebThreadIdentifier(traits), from_here, std::move(task), delay,
+        GetWebThreadIdentifier(traits), GetPriority(traits), from_here,
+        std::move(task), delay,
         traits.GetExtension<WebTaskTraitsExtension>().nestable());
   }
 
   scoped_refptr<base::TaskRunner> CreateTaskRunnerWithTraits(
       const base::TaskTraits& traits) override {
-    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits));
+    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits),
+                                  GetPriority(traits));
   }
 
   scoped_refptr<base::SequencedTaskRunner> CreateSequencedTaskRunnerWithTraits(
       const base::TaskTraits& traits) override {
-    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits));
+    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits),
+                                  GetPriority(traits));
   }
 
   scoped_refptr<base::SingleThreadTaskRunner>
@@ -177,7 +221,8 @@ class WebThreadTaskExecutor : public base::TaskExecutor {
       base::SingleThreadTaskRunnerThreadMode thread_mode) override {
     // It's not possible to request DEDICATED access to a WebThread.
     DCHECK_EQ(thread_mode, base::SingleThreadTaskRunnerThreadMode::SHARED);
-    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits));
+    return GetTaskRunnerForThread(GetWebThreadIdentifier(traits),
+                                  GetPriority(traits));
   }
 
  private:
@@ -203,9 +248,15 @@ class WebThreadTaskExecutor : public base::TaskExecutor {
     return id;
   }
 
+  base::TaskPriority GetPriority(const base::TaskTraits& traits) {
+    return traits.priority_set_explicitly() ? traits.priority()
+                                            : kDefaultPriority;
+  }
+
   scoped_refptr<base::SingleThreadTaskRunner> GetTaskRunnerForThread(
-      WebThread::ID identifier) {
-    return g_task_runners.Get().task_runners[identifier];
+      WebThread::ID identifier,
+      base::TaskPriority priority) {
+    return g_task_runners.Get().Get(identifier, priority);
   }
 };
 
@@ -226,19 +277,31 @@ WebThreadImpl::WebThreadImpl(
   DCHECK_GE(identifier_, 0);
   DCHECK_LT(identifier_, ID_COUNT);
 
-  DCHECK_EQ(globals.states[identifier_], WebThreadState::UNINITIALIZED);
-  globals.states[identifier_] = WebThreadState::RUNNING;
-
+  DCHECK_EQ(globals.states[identifier_].load(std::memory_order_relaxed),
+            WebThreadState::UNINITIALIZED);
   DCHECK(!globals.task_runners[identifier_]);
+  DCHECK(!globals.task_queues[identifier_]);
+  globals.task_queues[identifier_] =
+      base::MakeRefCounted<WebThreadTaskQueues>(identifier_, task_runner);
+  globals.task_queues[identifier_]->ClearOnMessageLoopDestruction();
   globals.task_runners[identifier_] = std::move(task_runner);
+
+  globals.published_task_runners[identifier_].store(
+      globals.task_runners[identifier_].get(), std::memory_order_release);
+  globals.published_task_queues[identifier_].store(
+      globals.task_queues[identifier_].get(), std::memory_order_release);
+  globals.states[identifier_].store(WebThreadState::RUNNING,
+                                    std::memory_order_release);
 }
 
 WebThreadImpl::~WebThreadImpl() {
   WebThreadGlobals& globals = g_globals.Get();
   base::AutoLock lock(globals.lock);
 
-  DCHECK_EQ(globals.states[identifier_], WebThreadState::RUNNING);
-  globals.states[identifier_] = WebThreadState::SHUTDOWN;
+  DCHECK_EQ(globals.states[identifier_].load(std::memory_order_relaxed),
+            WebThreadState::RUNNING);
+  globals.states[identifier_].store(WebThreadState::SHUTDOWN,
+                                    std::memory_order_release);
 }
 
 // static
@@ -246,9 +309,18 @@ void WebThreadImpl::ResetGlobalsForTesting(WebThread::ID identifier) {
   WebThreadGlobals& globals = g_globals.Get();
 
   base::AutoLock lock(globals.lock);
-  DCHECK_EQ(globals.states[identifier], WebThreadState::SHUTDOWN);
-  globals.states[identifier] = WebThreadState::UNINITIALIZED;
-  globals.task_runners[identifier] = nullptr;
+  DCHECK_EQ(globals.states[identifier].load(std::memory_order_relaxed),
+            WebThreadState::SHUTDOWN);
+  globals.states[identifier].store(WebThreadState::UNINITIALIZED,
+                                   std::memory_order_release);
+  globals.published_task_runners[identifier].store(nullptr,
+                                                   std::memory_order_release);
+  globals.published_task_queues[identifier].store(nullptr,
+                                                  std::memory_order_release);
+  globals.retired_task_runners.push_back(
+      std::move(globals.task_runners[identifier]));
+  globals.retired_task_queues.push_back(
+      std::move(globals.task_queues[identifier]));
 }
 
 // Friendly names for the well-known threads.
@@ -271,20 +343,21 @@ bool WebThread::IsThreadInitialized(ID identifier) {
     return false;
 
   WebThreadGlobals& globals = g_globals.Get();
-  base::AutoLock lock(globals.lock);
   DCHECK_GE(identifier, 0);
   DCHECK_LT(identifier, ID_COUNT);
-  return globals.states[identifier] == WebThreadState::RUNNING;
+  return globals.states[identifier].load(std::memory_order_acquire) ==
+         WebThreadState::RUNNING;
 }
 
 // static
 bool WebThread::CurrentlyOn(ID identifier) {
   WebThreadGlobals& globals = g_globals.Get();
-  base::AutoLock lock(globals.lock);
   DCHECK_GE(identifier, 0);
   DCHECK_LT(identifier, ID_COUNT);
-  return globals.task_runners[identifier] &&
-         globals.task_runners[identifier]->BelongsToCurrentThread();
+  base::SingleThreadTaskRunner* task_runner =
+      globals.published_task_runners[identifier].load(
+          std::memory_order_acquire);
+  return task_runner && task_runner->BelongsToCurrentThread();
 }
 
 // static
@@ -307,10 +380,10 @@ bool WebThread::GetCurrentThreadIdentifier(ID* identifier) {
     return false;
 
   WebThreadGlobals& globals = g_globals.Get();
-  base::AutoLock lock(globals.lock);
   for (int i = 0; i < ID_COUNT; ++i) {
-    if (globals.task_runners[i] &&
-        globals.task_runners[i]->BelongsToCurrentThread()) {
+    base::SingleThreadTaskRunner* task_runner =
+        globals.published_task_runners[i].load(std::memory_order_acquire);
+    if (task_runner && task_runner->BelongsToCurrentThread()) {
       *identifier = static_cast<ID>(i);
       return true;
     }
@@ -322,7 +395,7 @@ bool WebThread::GetCurrentThreadIdentifier(ID* identifier) {
 // static
 scoped_refptr<base::SingleThreadTaskRunner> WebThread::GetTaskRunnerForThread(
     ID identifier) {
-  return g_task_runners.Get().task_runners[identifier];
+  return g_task_runners.Get().Get(identifier, kDefaultPriority);
 }
 
 // static
@@ -0,0 +1,100 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/public/web_thread.h"
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/macros.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/post_task.h"
+#include "base/threading/simple_thread.h"
+#include "base/timer/elapsed_timer.h"
+#include "ios/web/public/test/test_web_thread_bundle.h"
+#include "ios/web/public/web_task_traits.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "testing/platform_test.h"
+
+namespace web {
+
+namespace {
+
+// Number of tasks posted by each posting thread.
+const int kPostsPerThread = 100000;
+
+// Posts |kPostsPerThread| empty tasks to WebThread::IO once |start_event| is
+// signaled.
+class PostingDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit PostingDelegate(base::WaitableEvent* start_event)
+      : start_event_(start_event) {}
+
+  // base::DelegateSimpleThread::Delegate implementation.
+  void Run() override {
+    start_event_->Wait();
+    for (int index = 0; index < kPostsPerThread; ++index) {
+      base::PostTaskWithTraits(FROM_HERE, {WebThread::IO}, base::DoNothing());
+    }
+  }
+
+ private:
+  base::WaitableEvent* start_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostingDelegate);
+};
+
+}  // namespace
+
+class WebThreadPerfTest : public PlatformTest {
+ protected:
+  WebThreadPerfTest()
+      : web_thread_bundle_(TestWebThreadBundle::REAL_IO_THREAD) {}
+
+  // Posts from |thread_count| threads at once and returns the average time
+  // each post took, in nanoseconds.
+  double PostFromThreads(int thread_count) {
+    base::WaitableEvent start_event(
+        base::WaitableEvent::ResetPolicy::MANUAL,
+        base::WaitableEvent::InitialState::NOT_SIGNALED);
+    PostingDelegate delegate(&start_event);
+    base::DelegateSimpleThreadPool pool("WebThreadPoster", thread_count);
+    pool.AddWork(&delegate, thread_count);
+    pool.Start();
+
+    base::ElapsedTimer timer;
+    start_event.Signal();
+    pool.JoinAll();
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    // Let WebThread::IO drain the posted tasks before the next measurement.
+    base::RunLoop run_loop;
+    base::PostTaskWithTraitsAndReply(FROM_HERE, {WebThread::IO},
+                                     base::DoNothing(),
+                                     run_loop.QuitClosure());
+    run_loop.Run();
+
+    // The threads post concurrently, so each of them spent the elapsed time
+    // posting its tasks.
+    return elapsed.InMicrosecondsF() * 1000 / kPostsPerThread;
+  }
+
+  TestWebThreadBundle web_thread_bundle_;
+};
+
+// Reports the cost of posting a task to WebThread::IO from 1, 2, 4... threads
+// at once.
+TEST_F(WebThreadPerfTest, PostTaskContention) {
+  for (int thread_count : {1, 2, 4, 8, 16}) {
+    perf_test::PrintResult(
+        "web_thread_post_task", "",
+        base::StringPrintf("%d threads", thread_count),
+        PostFromThreads(thread_count), "ns/post",
+        true /* important */);
+  }
+}
+
+}  // namespace web
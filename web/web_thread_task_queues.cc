@@ -0,0 +1,304 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/web_thread_task_queues.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/time/default_tick_clock.h"
+
+namespace web {
+
+namespace {
+
+const char* GetThreadHistogramName(WebThread::ID identifier) {
+  switch (identifier) {
+    case WebThread::UI:
+      return "UI";
+    case WebThread::IO:
+      return "IO";
+    case WebThread::ID_COUNT:
+      break;
+  }
+  NOTREACHED();
+  return "Unknown";
+}
+
+const char* GetPriorityHistogramName(base::TaskPriority priority) {
+  switch (priority) {
+    case base::TaskPriority::BEST_EFFORT:
+      return "BestEffort";
+    case base::TaskPriority::USER_VISIBLE:
+      return "UserVisible";
+    case base::TaskPriority::USER_BLOCKING:
+      return "UserBlocking";
+  }
+  NOTREACHED();
+  return "Unknown";
+}
+
+}  // namespace
+
+WebThreadTaskQueues::QueuedTask::QueuedTask(base::OnceClosure task,
+                                            const base::Location& from_here,
+                                            base::TimeTicks queue_time,
+                                            bool nestable)
+    : task(std::move(task)),
+      from_here(from_here),
+      queue_time(queue_time),
+      nestable(nestable) {}
+
+WebThreadTaskQueues::QueuedTask::QueuedTask(QueuedTask&& other) = default;
+
+WebThreadTaskQueues::QueuedTask& WebThreadTaskQueues::QueuedTask::operator=(
+    QueuedTask&& other) = default;
+
+WebThreadTaskQueues::QueuedTask::~QueuedTask() = default;
+
+WebThreadTaskQueues::IncomingTask::IncomingTask(QueuedTask queued_task,
+                                                int queue_index)
+    : queued_task(std::move(queued_task)), queue_index(queue_index) {}
+
+WebThreadTaskQueues::IncomingTask::~IncomingTask() = default;
+
+WebThreadTaskQueues::WebThreadTaskQueues(
+    WebThread::ID identifier,
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)),
+      tick_clock_(base::DefaultTickClock::GetInstance()),
+      incoming_tasks_(nullptr) {
+  DCHECK(task_runner_);
+  // The histograms are looked up once rather than by name for every task.
+  // Same parameters as base::UmaHistogramTimes().
+  for (int index = 0; index < kPriorityCount; ++index) {
+    histograms_[index] = base::Histogram::FactoryTimeGet(
+        std::string("IOS.WebThread.") + GetThreadHistogramName(identifier) +
+            ".QueueingDelay." +
+            GetPriorityHistogramName(static_cast<base::TaskPriority>(index)),
+        base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromSeconds(10),
+        50, base::HistogramBase::kUmaTargetedHistogramFlag);
+  }
+}
+
+WebThreadTaskQueues::~WebThreadTaskQueues() {
+  DeleteIncomingTasks();
+}
+
+void WebThreadTaskQueues::ClearOnMessageLoopDestruction() {
+  if (task_runner_->BelongsToCurrentThread()) {
+    AddDestructionObserver();
+    return;
+  }
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebThreadTaskQueues::AddDestructionObserver, this));
+}
+
+bool WebThreadTaskQueues::PostDelayedTask(base::TaskPriority priority,
+                                          const base::Location& from_here,
+                                          base::OnceClosure task,
+                                          base::TimeDelta delay,
+                                          bool nestable) {
+  if (delay > base::TimeDelta()) {
+    // The task is queued once its delay expired, so that it competes with the
+    // other ready tasks and its queueing delay excludes the requested delay.
+    return task_runner_->PostDelayedTask(
+        from_here,
+        base::BindOnce(
+            [](scoped_refptr<WebThreadTaskQueues> queues,
+               base::TaskPriority priority, const base::Location& from_here,
+               base::OnceClosure task, bool nestable) {
+              queues->EnqueueTask(priority, from_here, std::move(task),
+                                  nestable);
+            },
+            base::WrapRefCounted(this), priority, from_here, std::move(task),
+            nestable),
+        delay);
+  }
+
+  return EnqueueTask(priority, from_here, std::move(task), nestable);
+}
+
+// static
+base::TimeDelta WebThreadTaskQueues::GetStarvationDelay(
+    base::TaskPriority priority) {
+  switch (priority) {
+    case base::TaskPriority::BEST_EFFORT:
+      return base::TimeDelta::FromMilliseconds(500);
+    case base::TaskPriority::USER_VISIBLE:
+      return base::TimeDelta::FromMilliseconds(50);
+    case base::TaskPriority::USER_BLOCKING:
+      // Nothing runs ahead of USER_BLOCKING tasks but starved tasks.
+      return base::TimeDelta::Max();
+  }
+  NOTREACHED();
+  return base::TimeDelta::Max();
+}
+
+void WebThreadTaskQueues::SetTickClockForTesting(
+    const base::TickClock* tick_clock) {
+  tick_clock_ = tick_clock;
+}
+
+void WebThreadTaskQueues::WillDestroyCurrentMessageLoop() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  // The tasks are moved out of |queues_| before being deleted, as deleting
+  // their bound arguments may post tasks.
+  base::circular_deque<QueuedTask> queues[kPriorityCount];
+  for (int index = 0; index < kPriorityCount; ++index)
+    queues[index].swap(queues_[index]);
+  for (int index = 0; index < kPriorityCount; ++index)
+    queues[index].clear();
+  DeleteIncomingTasks();
+
+  // Balances the reference taken in AddDestructionObserver().
+  Release();
+}
+
+bool WebThreadTaskQueues::EnqueueTask(base::TaskPriority priority,
+                                      const base::Location& from_here,
+                                      base::OnceClosure task,
+                                      bool nestable) {
+  IncomingTask* incoming_task = new IncomingTask(
+      QueuedTask(std::move(task), from_here, tick_clock_->NowTicks(),
+                 nestable),
+      static_cast<int>(priority));
+  incoming_task->next = incoming_tasks_.load(std::memory_order_relaxed);
+  while (!incoming_tasks_.compare_exchange_weak(
+      incoming_task->next, incoming_task, std::memory_order_release,
+      std::memory_order_relaxed)) {
+  }
+
+  // The task is pushed before the run task is posted, so that every run task
+  // finds a task to run.
+  if (!task_runner_->PostTask(
+          from_here,
+          base::BindOnce(&WebThreadTaskQueues::RunNextTask, this))) {
+    // The MessageLoop of the thread is destroyed, so the incoming tasks will
+    // never run.
+    DeleteIncomingTasks();
+    return false;
+  }
+  return true;
+}
+
+void WebThreadTaskQueues::RunNextTask() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  const bool nested = base::RunLoop::IsNestedOnCurrentThread();
+  MoveIncomingTasksToQueues();
+
+  base::TimeTicks now = tick_clock_->NowTicks();
+  int queue_index;
+  size_t task_index;
+  if (!SelectTask(now, nested, &queue_index, &task_index)) {
+    // Only non-nestable tasks are queued, so run the next one once the nested
+    // RunLoop exits.
+    DCHECK(nested);
+    task_runner_->PostNonNestableTask(
+        FROM_HERE, base::BindOnce(&WebThreadTaskQueues::RunNextTask, this));
+    return;
+  }
+  auto queued_task = queues_[queue_index].begin() + task_index;
+  base::OnceClosure task = std::move(queued_task->task);
+  histograms_[queue_index]->AddTime(now - queued_task->queue_time);
+  queues_[queue_index].erase(queued_task);
+  std::move(task).Run();
+}
+
+void WebThreadTaskQueues::AddDestructionObserver() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  // The MessageLoop does not own its observers, so |this| is kept alive until
+  // WillDestroyCurrentMessageLoop() is called.
+  AddRef();
+  base::MessageLoopCurrent::Get()->AddDestructionObserver(this);
+}
+
+void WebThreadTaskQueues::MoveIncomingTasksToQueues() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  IncomingTask* incoming_task =
+      incoming_tasks_.exchange(nullptr, std::memory_order_acquire);
+
+  // Reverse the list, which is most recent first.
+  IncomingTask* reversed_incoming_task = nullptr;
+  while (incoming_task) {
+    IncomingTask* next = incoming_task->next;
+    incoming_task->next = reversed_incoming_task;
+    reversed_incoming_task = incoming_task;
+    incoming_task = next;
+  }
+
+  while (reversed_incoming_task) {
+    std::unique_ptr<IncomingTask> task(reversed_incoming_task);
+    reversed_incoming_task = task->next;
+    queues_[task->queue_index].push_back(std::move(task->queued_task));
+  }
+}
+
+void WebThreadTaskQueues::DeleteIncomingTasks() {
+  IncomingTask* incoming_task =
+      incoming_tasks_.exchange(nullptr, std::memory_order_acquire);
+  while (incoming_task) {
+    std::unique_ptr<IncomingTask> task(incoming_task);
+    incoming_task = task->next;
+  }
+}
+
+bool WebThreadTaskQueues::SelectTask(base::TimeTicks now,
+                                     bool nestable_only,
+                                     int* queue_index,
+                                     size_t* task_index) {
+  // The index of the first task of each queue that may run.
+  size_t first_task_indexes[kPriorityCount];
+  for (int index = 0; index < kPriorityCount; ++index) {
+    const base::circular_deque<QueuedTask>& queue = queues_[index];
+    size_t first_task_index = 0;
+    while (nestable_only && first_task_index < queue.size() &&
+           !queue[first_task_index].nestable) {
+      ++first_task_index;
+    }
+    first_task_indexes[index] = first_task_index;
+  }
+
+  // Run the task that waited the longest among those that waited longer than
+  // their starvation delay, if any.
+  int starved_queue_index = -1;
+  base::TimeTicks starved_queue_time;
+  for (int index = 0; index < kPriorityCount; ++index) {
+    if (first_task_indexes[index] == queues_[index].size())
+      continue;
+    base::TimeTicks queue_time =
+        queues_[index][first_task_indexes[index]].queue_time;
+    if (now - queue_time <
+        GetStarvationDelay(static_cast<base::TaskPriority>(index))) {
+      continue;
+    }
+    if (starved_queue_index == -1 || queue_time < starved_queue_time) {
+      starved_queue_index = index;
+      starved_queue_time = queue_time;
+    }
+  }
+  if (starved_queue_index != -1) {
+    *queue_index = starved_queue_index;
+    *task_index = first_task_indexes[starved_queue_index];
+    return true;
+  }
+
+  for (int index = kPriorityCount - 1; index >= 0; --index) {
+    if (first_task_indexes[index] != queues_[index].size()) {
+      *queue_index = index;
+      *task_index = first_task_indexes[index];
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace web
@@ -0,0 +1,162 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IOS_WEB_WEB_THREAD_TASK_QUEUES_H_
+#define IOS_WEB_WEB_THREAD_TASK_QUEUES_H_
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/message_loop/message_loop_current.h"
+#include "base/task/task_traits.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+#include "ios/web/public/web_thread.h"
+
+namespace base {
+class HistogramBase;
+class SingleThreadTaskRunner;
+}
+
+namespace web {
+
+// WebThreadTaskQueues keeps one FIFO queue per base::TaskPriority for the
+// tasks posted to a WebThread, and runs them on the thread's task runner
+// highest priority first. Every task posted to a queue posts one "run next
+// task" task to the thread, which runs the task that should go first when it
+// runs, so posting order is preserved within a priority.
+//
+// To avoid starving lower priorities during long bursts of higher priority
+// work, a task that waited longer than the starvation delay of its priority
+// runs before any task that did not, oldest first.
+//
+// The queueing delay of every task is recorded in the
+// "IOS.WebThread.<thread>.QueueingDelay.<priority>" histograms.
+//
+// Non-nestable tasks are queued with the other tasks so that they keep their
+// posting order, but a nested RunLoop skips them. When only non-nestable tasks
+// are queued, a nested RunLoop defers running the next task until it exits.
+//
+// Tasks can be posted from any thread without locking: they are pushed onto
+// a lock-free list of incoming tasks, which the thread moves to the priority
+// queues when it runs the next task.
+class WebThreadTaskQueues
+    : public base::RefCountedThreadSafe<WebThreadTaskQueues>,
+      public base::MessageLoopCurrent::DestructionObserver {
+ public:
+  WebThreadTaskQueues(WebThread::ID identifier,
+                      scoped_refptr<base::SingleThreadTaskRunner> task_runner);
+
+  // Deletes the queued tasks when the MessageLoop of the thread is destroyed,
+  // like the tasks posted to it directly. Can be called from any thread, but
+  // must be called once.
+  void ClearOnMessageLoopDestruction();
+
+  // Posts |task| to run after |delay| with |priority|. Returns false if the
+  // thread's task runner did not accept the task.
+  bool PostDelayedTask(base::TaskPriority priority,
+                       const base::Location& from_here,
+                       base::OnceClosure task,
+                       base::TimeDelta delay,
+                       bool nestable);
+
+  // Returns how long a task of |priority| may wait before it runs ahead of
+  // higher priority tasks.
+  static base::TimeDelta GetStarvationDelay(base::TaskPriority priority);
+
+  // Replaces the clock used to measure queueing delays. Must be called before
+  // tasks are posted.
+  void SetTickClockForTesting(const base::TickClock* tick_clock);
+
+  // base::MessageLoopCurrent::DestructionObserver:
+  void WillDestroyCurrentMessageLoop() override;
+
+ private:
+  friend class base::RefCountedThreadSafe<WebThreadTaskQueues>;
+
+  struct QueuedTask {
+    QueuedTask(base::OnceClosure task,
+               const base::Location& from_here,
+               base::TimeTicks queue_time,
+               bool nestable);
+    QueuedTask(QueuedTask&& other);
+    QueuedTask& operator=(QueuedTask&& other);
+    ~QueuedTask();
+
+    base::OnceClosure task;
+    base::Location from_here;
+    base::TimeTicks queue_time;
+    bool nestable;
+  };
+
+  // A task posted to the thread that is not in |queues_| yet.
+  struct IncomingTask {
+    IncomingTask(QueuedTask queued_task, int queue_index);
+    ~IncomingTask();
+
+    QueuedTask queued_task;
+    int queue_index;
+    IncomingTask* next = nullptr;
+  };
+
+  static constexpr int kPriorityCount =
+      static_cast<int>(base::TaskPriority::HIGHEST) + 1;
+
+  ~WebThreadTaskQueues() override;
+
+  // Pushes |task| onto |incoming_tasks_| and posts a task to the thread to run
+  // the next task.
+  bool EnqueueTask(base::TaskPriority priority,
+                   const base::Location& from_here,
+                   base::OnceClosure task,
+                   bool nestable);
+
+  // Dequeues the task that should run first and runs it.
+  void RunNextTask();
+
+  // Registers as a DestructionObserver of the current MessageLoop.
+  void AddDestructionObserver();
+
+  // Moves the tasks of |incoming_tasks_| to |queues_|, in posting order.
+  void MoveIncomingTasksToQueues();
+
+  // Deletes the tasks of |incoming_tasks_|.
+  void DeleteIncomingTasks();
+
+  // Finds the task that should run first, ignoring non-nestable tasks if
+  // |nestable_only| is true. Sets |queue_index| and |task_index| to its
+  // position and returns true, or returns false if there is no such task.
+  bool SelectTask(base::TimeTicks now,
+                  bool nestable_only,
+                  int* queue_index,
+                  size_t* task_index);
+
+  const scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+
+  // The queueing delay histogram of each queue.
+  base::HistogramBase* histograms_[kPriorityCount];
+
+  const base::TickClock* tick_clock_;
+
+  // The tasks posted since the thread last ran a task, most recent first.
+  // Pushed to by any thread, and taken as a whole by the thread, or by a
+  // posting thread once the MessageLoop of the thread is destroyed.
+  std::atomic<IncomingTask*> incoming_tasks_;
+
+  // The queued tasks, by priority. Only used on the thread.
+  base::circular_deque<QueuedTask> queues_[kPriorityCount];
+
+  DISALLOW_COPY_AND_ASSIGN(WebThreadTaskQueues);
+};
+
+}  // namespace web
+
+#endif  // IOS_WEB_WEB_THREAD_TASK_QUEUES_H_
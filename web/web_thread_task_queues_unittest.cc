@@ -0,0 +1,212 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/web_thread_task_queues.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/platform_test.h"
+
+namespace web {
+
+class WebThreadTaskQueuesTest : public PlatformTest {
+ protected:
+  WebThreadTaskQueuesTest()
+      : task_queues_(base::MakeRefCounted<WebThreadTaskQueues>(
+            WebThread::UI,
+            base::ThreadTaskRunnerHandle::Get())) {
+    task_queues_->SetTickClockForTesting(&tick_clock_);
+  }
+
+  // Posts a task appending |name| to |run_order_| and advancing the clock by
+  // |duration|.
+  void PostTask(base::TaskPriority priority,
+                const std::string& name,
+                base::TimeDelta duration = base::TimeDelta()) {
+    EXPECT_TRUE(task_queues_->PostDelayedTask(
+        priority, FROM_HERE,
+        base::BindOnce(&WebThreadTaskQueuesTest::RunTask,
+                       base::Unretained(this), name, duration),
+        base::TimeDelta(), true /* nestable */));
+  }
+
+  // Posts a non-nestable task appending |name| to |run_order_|.
+  void PostNonNestableTask(base::TaskPriority priority,
+                           const std::string& name) {
+    EXPECT_TRUE(task_queues_->PostDelayedTask(
+        priority, FROM_HERE,
+        base::BindOnce(&WebThreadTaskQueuesTest::RunTask,
+                       base::Unretained(this), name, base::TimeDelta()),
+        base::TimeDelta(), false /* nestable */));
+  }
+
+  void RunTask(const std::string& name, base::TimeDelta duration) {
+    run_order_.push_back(name);
+    tick_clock_.Advance(duration);
+  }
+
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  base::SimpleTestTickClock tick_clock_;
+  scoped_refptr<WebThreadTaskQueues> task_queues_;
+  std::vector<std::string> run_order_;
+};
+
+// Tests that tasks run highest priority first, and in posting order within a
+// priority.
+TEST_F(WebThreadTaskQueuesTest, RunsHigherPriorityFirst) {
+  PostTask(base::TaskPriority::BEST_EFFORT, "best_effort_1");
+  PostTask(base::TaskPriority::USER_VISIBLE, "user_visible_1");
+  PostTask(base::TaskPriority::USER_BLOCKING, "user_blocking_1");
+  PostTask(base::TaskPriority::BEST_EFFORT, "best_effort_2");
+  PostTask(base::TaskPriority::USER_BLOCKING, "user_blocking_2");
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ((std::vector<std::string>{"user_blocking_1", "user_blocking_2",
+                                      "user_visible_1", "best_effort_1",
+                                      "best_effort_2"}),
+            run_order_);
+}
+
+// Tests that a task which waited longer than its starvation delay runs ahead
+// of higher priority tasks.
+TEST_F(WebThreadTaskQueuesTest, RunsStarvedTasks) {
+  const base::TimeDelta starvation_delay =
+      WebThreadTaskQueues::GetStarvationDelay(base::TaskPriority::BEST_EFFORT);
+  PostTask(base::TaskPriority::BEST_EFFORT, "best_effort");
+  for (int index = 0; index < 4; ++index) {
+    PostTask(base::TaskPriority::USER_BLOCKING,
+             "user_blocking_" + std::to_string(index), starvation_delay / 2);
+  }
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ((std::vector<std::string>{"user_blocking_0", "user_blocking_1",
+                                      "best_effort", "user_blocking_2",
+                                      "user_blocking_3"}),
+            run_order_);
+}
+
+// Tests that delayed tasks are queued once their delay expired.
+TEST_F(WebThreadTaskQueuesTest, DelayedTask) {
+  base::RunLoop run_loop;
+  EXPECT_TRUE(task_queues_->PostDelayedTask(
+      base::TaskPriority::USER_BLOCKING, FROM_HERE,
+      base::BindOnce(
+          [](std::vector<std::string>* run_order, base::OnceClosure quit) {
+            run_order->push_back("delayed");
+            std::move(quit).Run();
+          },
+          &run_order_, run_loop.QuitClosure()),
+      base::TimeDelta::FromMilliseconds(1), true /* nestable */));
+  PostTask(base::TaskPriority::BEST_EFFORT, "best_effort");
+  run_loop.Run();
+
+  EXPECT_EQ((std::vector<std::string>{"best_effort", "delayed"}), run_order_);
+}
+
+// Tests that the queueing delay is recorded per priority.
+TEST_F(WebThreadTaskQueuesTest, RecordsQueueingDelay) {
+  base::HistogramTester histogram_tester;
+  PostTask(base::TaskPriority::USER_BLOCKING, "user_blocking",
+           base::TimeDelta::FromMilliseconds(20));
+  PostTask(base::TaskPriority::BEST_EFFORT, "best_effort");
+  base::RunLoop().RunUntilIdle();
+
+  histogram_tester.ExpectUniqueSample(
+      "IOS.WebThread.UI.QueueingDelay.UserBlocking", 0, 1);
+  histogram_tester.ExpectUniqueSample(
+      "IOS.WebThread.UI.QueueingDelay.BestEffort", 20, 1);
+  histogram_tester.ExpectTotalCount(
+      "IOS.WebThread.UI.QueueingDelay.UserVisible", 0);
+}
+
+// Tests that non-nestable tasks keep their posting order relative to the
+// other tasks of their priority.
+TEST_F(WebThreadTaskQueuesTest, NonNestableTasksKeepOrder) {
+  PostTask(base::TaskPriority::USER_BLOCKING, "nestable_1");
+  PostNonNestableTask(base::TaskPriority::USER_BLOCKING, "non_nestable");
+  PostTask(base::TaskPriority::USER_BLOCKING, "nestable_2");
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(
+      (std::vector<std::string>{"nestable_1", "non_nestable", "nestable_2"}),
+      run_order_);
+}
+
+// Tests that a nested RunLoop only runs the nestable tasks, and that the
+// non-nestable tasks run once it exits.
+TEST_F(WebThreadTaskQueuesTest, NestedRunLoopSkipsNonNestableTasks) {
+  EXPECT_TRUE(task_queues_->PostDelayedTask(
+      base::TaskPriority::USER_BLOCKING, FROM_HERE,
+      base::BindOnce(
+          [](std::vector<std::string>* run_order) {
+            run_order->push_back("nesting_begin");
+            base::RunLoop(base::RunLoop::Type::kNestableTasksAllowed)
+                .RunUntilIdle();
+            run_order->push_back("nesting_end");
+          },
+          &run_order_),
+      base::TimeDelta(), true /* nestable */));
+  PostNonNestableTask(base::TaskPriority::USER_BLOCKING, "non_nestable");
+  PostTask(base::TaskPriority::USER_BLOCKING, "nestable");
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ((std::vector<std::string>{"nesting_begin", "nestable",
+                                      "nesting_end", "non_nestable"}),
+            run_order_);
+}
+
+// Test fixture owning its MessageLoop.
+using WebThreadTaskQueuesMessageLoopTest = PlatformTest;
+
+// Tests that the queued tasks are deleted when the MessageLoop is destroyed.
+TEST_F(WebThreadTaskQueuesMessageLoopTest, ClearsQueuesOnDestruction) {
+  bool task_deleted = false;
+  auto message_loop = std::make_unique<base::MessageLoop>();
+  auto task_queues = base::MakeRefCounted<WebThreadTaskQueues>(
+      WebThread::UI, message_loop->task_runner());
+  task_queues->ClearOnMessageLoopDestruction();
+  EXPECT_TRUE(task_queues->PostDelayedTask(
+      base::TaskPriority::USER_BLOCKING, FROM_HERE,
+      base::BindOnce([](base::ScopedClosureRunner) {},
+                     base::ScopedClosureRunner(base::BindOnce(
+                         [](bool* task_deleted) { *task_deleted = true; },
+                         &task_deleted))),
+      base::TimeDelta(), true /* nestable */));
+
+  message_loop.reset();
+  EXPECT_TRUE(task_deleted);
+}
+
+// Tests that posting a task after the MessageLoop is destroyed fails and
+// deletes the task.
+TEST_F(WebThreadTaskQueuesMessageLoopTest, PostAfterDestruction) {
+  bool task_deleted = false;
+  auto message_loop = std::make_unique<base::MessageLoop>();
+  auto task_queues = base::MakeRefCounted<WebThreadTaskQueues>(
+      WebThread::UI, message_loop->task_runner());
+  task_queues->ClearOnMessageLoopDestruction();
+  message_loop.reset();
+
+  EXPECT_FALSE(task_queues->PostDelayedTask(
+      base::TaskPriority::USER_BLOCKING, FROM_HERE,
+      base::BindOnce([](base::ScopedClosureRunner) {},
+                     base::ScopedClosureRunner(base::BindOnce(
+                         [](bool* task_deleted) { *task_deleted = true; },
+                         &task_deleted))),
+      base::TimeDelta(), true /* nestable */));
+  EXPECT_TRUE(task_deleted);
+}
+
+}  // namespace web
@@ -3,7 +3,11 @@
 // found in the LICENSE file.
 
 #include "ios/web/public/web_thread.h"
+
+#include <vector>
+
 #include "base/bind.h"
+#include "base/run_loop.h"
 #include "base/task/post_task.h"
 #include "ios/web/public/test/test_web_thread_bundle.h"
 #include "ios/web/public/web_task_traits.h"
@@ -63,4 +67,49 @@ TEST_F(WebThreadTest, PostTaskViaSingleThreadTaskRunnerWithTraits) {
   run_loop.Run();
 }
 
+// Tests that tasks posted with a higher priority run first.
+TEST_F(WebThreadTest, PostTaskWithPriority) {
+  std::vector<base::TaskPriority> run_order;
+  auto record_priority = [](std::vector<base::TaskPriority>* run_order,
+                            base::TaskPriority priority) {
+    run_order->push_back(priority);
+  };
+  for (base::TaskPriority priority :
+       {base::TaskPriority::BEST_EFFORT, base::TaskPriority::USER_VISIBLE,
+        base::TaskPriority::USER_BLOCKING}) {
+    EXPECT_TRUE(base::PostTaskWithTraits(
+        FROM_HERE, {WebThread::UI, priority},
+        base::BindOnce(record_priority, &run_order, priority)));
+  }
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ((std::vector<base::TaskPriority>{
+                base::TaskPriority::USER_BLOCKING,
+                base::TaskPriority::USER_VISIBLE,
+                base::TaskPriority::BEST_EFFORT}),
+            run_order);
+}
+
+// Tests that task runners created with a priority post tasks with it, and that
+// tasks posted without a priority are USER_BLOCKING.
+TEST_F(WebThreadTest, PostTaskViaTaskRunnerWithPriority) {
+  std::vector<int> run_order;
+  auto record_index = [](std::vector<int>* run_order, int index) {
+    run_order->push_back(index);
+  };
+  scoped_refptr<base::SingleThreadTaskRunner> best_effort_task_runner =
+      base::CreateSingleThreadTaskRunnerWithTraits(
+          {WebThread::IO, base::TaskPriority::BEST_EFFORT});
+  EXPECT_TRUE(best_effort_task_runner->PostTask(
+      FROM_HERE, base::BindOnce(record_index, &run_order, 0)));
+  EXPECT_TRUE(WebThread::GetTaskRunnerForThread(WebThread::IO)
+                  ->PostTask(FROM_HERE,
+                             base::BindOnce(record_index, &run_order, 1)));
+  EXPECT_TRUE(base::PostTaskWithTraits(
+      FROM_HERE, {WebThread::IO}, base::BindOnce(record_index, &run_order, 2)));
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ((std::vector<int>{1, 2, 0}), run_order);
+}
+
 }  // namespace web
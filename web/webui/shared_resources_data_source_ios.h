@@ -22,6 +22,8 @@ class SharedResourcesDataSourceIOS : public URLDataSourceIOS {
       const std::string& path,
       const URLDataSourceIOS::GotDataCallback& callback) override;
   std::string GetMimeType(const std::string& path) const override;
+  bool ShouldServeOnIOThread(const std::string& path) const override;
+  bool IsStaticResource(const std::string& path) const override;
   bool IsGzipped(const std::string& path) const override;
 
  private:
@@ -74,6 +74,18 @@ std::string SharedResourcesDataSourceIOS::GetMimeType(
   return mime_type;
 }
 
+bool SharedResourcesDataSourceIOS::ShouldServeOnIOThread(
+    const std::string& path) const {
+  // The resources are loaded from the resource bundle, which can be used from
+  // any thread.
+  return true;
+}
+
+bool SharedResourcesDataSourceIOS::IsStaticResource(
+    const std::string& path) const {
+  return true;
+}
+
 bool SharedResourcesDataSourceIOS::IsGzipped(const std::string& path) const {
   const GzippedGritResourceMap* resource = PathToResource(path);
   return resource && resource->gzipped;
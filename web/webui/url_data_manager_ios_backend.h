@@ -11,7 +11,10 @@
 #include <vector>
 
 #include "base/compiler_specific.h"
+#include "base/containers/mru_cache.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "base/supports_user_data.h"
 #include "ios/web/public/url_data_source_ios.h"
 #include "ios/web/webui/url_data_manager_ios.h"
@@ -59,6 +62,18 @@ class URLDataManagerIOSBackend : public base::SupportsUserData::Data {
       DataSourceMap;
   typedef std::map<RequestID, URLRequestChromeJob*> PendingRequestMap;
 
+  // Response of a static resource, kept in |response_cache_|.
+  struct CachedResponse {
+    CachedResponse(const std::string& mime_type,
+                   scoped_refptr<base::RefCountedMemory> bytes);
+    CachedResponse(const CachedResponse& other);
+    ~CachedResponse();
+
+    std::string mime_type;
+    scoped_refptr<base::RefCountedMemory> bytes;
+  };
+  typedef base::MRUCache<std::string, CachedResponse> ResponseCache;
+
   // Called by the job when it's starting up.
   // Returns false if |url| is not a URL managed by this object.
   bool StartRequest(const net::URLRequest* request, URLRequestChromeJob* job);
@@ -70,6 +85,24 @@ class URLDataManagerIOSBackend : public base::SupportsUserData::Data {
                                const std::string& path,
                                int request_id);
 
+  // Same as CallStartRequest, but for sources which serve |path| on the IO
+  // thread. Notifies |job| of the mime type, then calls StartDataRequest on
+  // |source|'s delegate, which sends the data to |job| on the IO thread.
+  static void StartRequestOnIOThread(
+      scoped_refptr<URLDataSourceIOSImpl> source,
+      const std::string& path,
+      int request_id,
+      const base::WeakPtr<URLRequestChromeJob>& job);
+
+  // Adds the response for |cache_key| to |response_cache_|, and evicts the
+  // least recently used responses if the cache is full.
+  void AddToResponseCache(const std::string& cache_key,
+                          const std::string& mime_type,
+                          scoped_refptr<base::RefCountedMemory> bytes);
+
+  // Removes the cached responses of the source named |source_name|.
+  void RemoveCachedResponses(const std::string& source_name);
+
   // Remove a request from the list of pending requests.
   void RemoveRequest(URLRequestChromeJob* job);
 
@@ -93,6 +126,13 @@ class URLDataManagerIOSBackend : public base::SupportsUserData::Data {
   // The ID we'll use for the next request we receive.
   RequestID next_request_id_;
 
+  // Responses of the static resources of the sources which allow caching,
+  // keyed by source name and path.
+  ResponseCache response_cache_;
+
+  // Total size of the responses in |response_cache_|, in bytes.
+  size_t response_cache_size_;
+
   DISALLOW_COPY_AND_ASSIGN(URLDataManagerIOSBackend);
 };
 
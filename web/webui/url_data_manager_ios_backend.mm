@@ -56,6 +56,13 @@ const char kChromeURLContentSecurityPolicyHeaderBase[] =
 
 const char kChromeURLXFrameOptionsHeader[] = "X-Frame-Options: DENY";
 
+// Maximum total size of the cached responses of static resources.
+const size_t kMaxResponseCacheSize = 4 * 1024 * 1024;
+
+// Responses larger than this are not cached, so that a single large resource
+// does not evict all the other ones.
+const size_t kMaxCachedResponseSize = kMaxResponseCacheSize / 4;
+
 // Returns whether |url| passes some sanity checks and is a valid GURL.
 bool CheckURLIsValid(const GURL& url) {
   std::vector<std::string> additional_schemes;
@@ -143,6 +150,8 @@ class URLRequestChromeJob : public net::URLRequestJob {
     send_content_type_header_ = send_content_type_header;
   }
 
+  void set_cache_key(const std::string& cache_key) { cache_key_ = cache_key; }
+
   // Returns true when job was generated from an incognito profile.
   bool is_incognito() const { return is_incognito_; }
 
@@ -192,6 +201,10 @@ class URLRequestChromeJob : public net::URLRequestJob {
   // If true, sets the "Content-Type: <mime-type>" header.
   bool send_content_type_header_;
 
+  // Key of the response in the cache of the backend. Empty if the response
+  // should not be cached.
+  std::string cache_key_;
+
   // True when job is generated from an incognito profile.
   const bool is_incognito_;
 
@@ -399,6 +412,22 @@ void GetMimeTypeOnUI(URLDataSourceIOSImpl* source,
                  base::RetainedRef(source), mime_type));
 }
 
+// Notifies |job| that the cached response with |mime_type| and |bytes| is
+// available. Must be called on the IO thread.
+void SendCachedResponse(const base::WeakPtr<URLRequestChromeJob>& job,
+                        scoped_refptr<URLDataSourceIOSImpl> source,
+                        const std::string& mime_type,
+                        scoped_refptr<base::RefCountedMemory> bytes) {
+  DCHECK_CURRENTLY_ON(WebThread::IO);
+  if (!job)
+    return;
+  job->MimeTypeAvailable(source.get(), mime_type);
+  // The job is invalidated if the request was cancelled when notified of the
+  // headers.
+  if (job)
+    job->DataAvailable(bytes.get());
+}
+
 }  // namespace
 
 namespace {
@@ -435,7 +464,20 @@ class ChromeProtocolHandler
 
 }  // namespace
 
-URLDataManagerIOSBackend::URLDataManagerIOSBackend() : next_request_id_(0) {
+URLDataManagerIOSBackend::CachedResponse::CachedResponse(
+    const std::string& mime_type,
+    scoped_refptr<base::RefCountedMemory> bytes)
+    : mime_type(mime_type), bytes(std::move(bytes)) {}
+
+URLDataManagerIOSBackend::CachedResponse::CachedResponse(
+    const CachedResponse& other) = default;
+
+URLDataManagerIOSBackend::CachedResponse::~CachedResponse() = default;
+
+URLDataManagerIOSBackend::URLDataManagerIOSBackend()
+    : next_request_id_(0),
+      response_cache_(ResponseCache::NO_AUTO_EVICT),
+      response_cache_size_(0) {
   URLDataSourceIOS* shared_source = new SharedResourcesDataSourceIOS();
   URLDataSourceIOSImpl* source_impl =
       new URLDataSourceIOSImpl(shared_source->GetSource(), shared_source);
@@ -465,6 +507,7 @@ void URLDataManagerIOSBackend::AddDataSource(URLDataSourceIOSImpl* source) {
     if (!source->source()->ShouldReplaceExistingSource())
       return;
     i->second->backend_ = NULL;
+    RemoveCachedResponses(source->source_name());
   }
   data_sources_[source->source_name()] = source;
   source->backend_ = this;
@@ -494,10 +537,6 @@ bool URLDataManagerIOSBackend::StartRequest(const net::URLRequest* request,
   std::string path;
   URLToRequestPath(request->url(), &path);
 
-  // Save this request so we know where to send the data.
-  RequestID request_id = next_request_id_++;
-  pending_requests_.insert(std::make_pair(request_id, job));
-
   job->set_allow_caching(source->source()->AllowCaching());
   job->set_add_content_security_policy(true);
   job->set_content_security_policy_object_source(
@@ -507,6 +546,36 @@ bool URLDataManagerIOSBackend::StartRequest(const net::URLRequest* request,
   job->set_is_gzipped(source->source()->IsGzipped(path));
   job->set_send_content_type_header(false);
 
+  // Serve static resources from the cache when possible. The job must not be
+  // notified synchronously from Start(), hence the task.
+  if (source->source()->AllowCaching() &&
+      source->source()->IsStaticResource(path)) {
+    std::string cache_key = source->source_name() + "/" + path;
+    ResponseCache::iterator cached = response_cache_.Get(cache_key);
+    if (cached != response_cache_.end()) {
+      base::PostTaskWithTraits(
+          FROM_HERE, {WebThread::IO},
+          base::BindOnce(&SendCachedResponse, job->weak_factory_.GetWeakPtr(),
+                         base::WrapRefCounted(source),
+                         cached->second.mime_type, cached->second.bytes));
+      return true;
+    }
+    job->set_cache_key(cache_key);
+  }
+
+  // Save this request so we know where to send the data.
+  RequestID request_id = next_request_id_++;
+  pending_requests_.insert(std::make_pair(request_id, job));
+
+  if (source->source()->ShouldServeOnIOThread(path)) {
+    base::PostTaskWithTraits(
+        FROM_HERE, {WebThread::IO},
+        base::BindOnce(&URLDataManagerIOSBackend::StartRequestOnIOThread,
+                       base::WrapRefCounted(source), path, request_id,
+                       job->weak_factory_.GetWeakPtr()));
+    return true;
+  }
+
   // Forward along the request to the data source.
   // URLRequestChromeJob should receive mime type before data. This
   // is guaranteed because request for mime type is placed in the
@@ -552,6 +621,59 @@ void URLDataManagerIOSBackend::CallStartRequest(
       base::Bind(&URLDataSourceIOSImpl::SendResponse, source, request_id));
 }
 
+// static
+void URLDataManagerIOSBackend::StartRequestOnIOThread(
+    scoped_refptr<URLDataSourceIOSImpl> source,
+    const std::string& path,
+    int request_id,
+    const base::WeakPtr<URLRequestChromeJob>& job) {
+  DCHECK_CURRENTLY_ON(WebThread::IO);
+  if (!job)
+    return;
+  job->MimeTypeAvailable(source.get(), source->source()->GetMimeType(path));
+  if (!job)
+    return;
+  source->source()->StartDataRequest(
+      path, base::Bind(&URLDataSourceIOSImpl::SendResponseOnIOThread, source,
+                       request_id));
+}
+
+void URLDataManagerIOSBackend::AddToResponseCache(
+    const std::string& cache_key,
+    const std::string& mime_type,
+    scoped_refptr<base::RefCountedMemory> bytes) {
+  if (bytes->size() > kMaxCachedResponseSize)
+    return;
+
+  ResponseCache::iterator existing = response_cache_.Peek(cache_key);
+  if (existing != response_cache_.end()) {
+    response_cache_size_ -= existing->second.bytes->size();
+    response_cache_.Erase(existing);
+  }
+  response_cache_size_ += bytes->size();
+  response_cache_.Put(cache_key, CachedResponse(mime_type, std::move(bytes)));
+
+  while (response_cache_size_ > kMaxResponseCacheSize) {
+    ResponseCache::reverse_iterator oldest = response_cache_.rbegin();
+    response_cache_size_ -= oldest->second.bytes->size();
+    response_cache_.Erase(oldest);
+  }
+}
+
+void URLDataManagerIOSBackend::RemoveCachedResponses(
+    const std::string& source_name) {
+  const std::string prefix = source_name + "/";
+  ResponseCache::iterator it = response_cache_.begin();
+  while (it != response_cache_.end()) {
+    if (base::StartsWith(it->first, prefix, base::CompareCase::SENSITIVE)) {
+      response_cache_size_ -= it->second.bytes->size();
+      it = response_cache_.Erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void URLDataManagerIOSBackend::RemoveRequest(URLRequestChromeJob* job) {
   // Remove the request from our list of pending requests.
   // If/when the source sends the data that was requested, the data will just
@@ -572,6 +694,9 @@ void URLDataManagerIOSBackend::DataAvailable(RequestID request_id,
   if (i != pending_requests_.end()) {
     URLRequestChromeJob* job(i->second);
     pending_requests_.erase(i);
+    // The job has been notified of the mime type before the data.
+    if (bytes && !job->cache_key_.empty())
+      AddToResponseCache(job->cache_key_, job->mime_type_, bytes);
     job->DataAvailable(bytes);
   }
 }
@@ -0,0 +1,337 @@
+// Copyright 2019 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ios/web/webui/url_data_manager_ios_backend.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/run_loop.h"
+#include "base/task/post_task.h"
+#include "ios/web/public/test/web_test.h"
+#include "ios/web/public/url_data_source_ios.h"
+#include "ios/web/public/web_task_traits.h"
+#include "ios/web/public/web_thread.h"
+#include "ios/web/test/test_url_constants.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_job_factory_impl.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+namespace web {
+
+namespace {
+
+const char kSourceName[] = "source";
+const char kMimeType[] = "text/plain";
+
+// The size of the buffer responses are read into, smaller than the responses.
+const int kReadBufferSize = 4;
+
+// A data source which serves the same data for all paths, and records how it
+// is called.
+class FakeURLDataSource : public URLDataSourceIOS {
+ public:
+  FakeURLDataSource(const std::string& data,
+                    bool serve_on_io_thread,
+                    bool is_static,
+                    bool allow_caching)
+      : data_(data),
+        serve_on_io_thread_(serve_on_io_thread),
+        is_static_(is_static),
+        allow_caching_(allow_caching) {}
+
+  // The number of calls to StartDataRequest().
+  int request_count() const { return request_count_; }
+
+  // Whether the last call to GetMimeType() or StartDataRequest() was made on
+  // the UI thread. UI and IO are different threads in these tests.
+  bool called_on_ui_thread() const { return called_on_ui_thread_; }
+
+  // URLDataSourceIOS:
+  std::string GetSource() const override { return kSourceName; }
+  void StartDataRequest(const std::string& path,
+                        const GotDataCallback& callback) override {
+    ++request_count_;
+    called_on_ui_thread_ = WebThread::CurrentlyOn(WebThread::UI);
+    std::string data = data_;
+    callback.Run(base::RefCountedString::TakeString(&data));
+  }
+  std::string GetMimeType(const std::string& path) const override {
+    called_on_ui_thread_ = WebThread::CurrentlyOn(WebThread::UI);
+    return kMimeType;
+  }
+  bool AllowCaching() const override { return allow_caching_; }
+  bool ShouldServeOnIOThread(const std::string& path) const override {
+    return serve_on_io_thread_;
+  }
+  bool IsStaticResource(const std::string& path) const override {
+    return is_static_;
+  }
+
+ private:
+  const std::string data_;
+  const bool serve_on_io_thread_;
+  const bool is_static_;
+  const bool allow_caching_;
+  int request_count_ = 0;
+  mutable bool called_on_ui_thread_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeURLDataSource);
+};
+
+// Reads the response to a request on the IO thread, then runs a closure.
+class ResponseReader : public net::URLRequest::Delegate {
+ public:
+  explicit ResponseReader(base::OnceClosure done_closure)
+      : buffer_(base::MakeRefCounted<net::IOBuffer>(kReadBufferSize)),
+        done_closure_(std::move(done_closure)) {}
+
+  // Starts the request for |url| in |context|.
+  void Start(net::URLRequestContext* context, const GURL& url) {
+    request_ = context->CreateRequest(url, net::DEFAULT_PRIORITY, this,
+                                      TRAFFIC_ANNOTATION_FOR_TESTS);
+    request_->Start();
+  }
+
+  int net_error() const { return net_error_; }
+  const std::string& mime_type() const { return mime_type_; }
+  const std::string& body() const { return body_; }
+
+  // net::URLRequest::Delegate:
+  void OnResponseStarted(net::URLRequest* request, int net_error) override {
+    if (net_error != net::OK) {
+      Finish(net_error);
+      return;
+    }
+    request->GetMimeType(&mime_type_);
+    ReadBody();
+  }
+  void OnReadCompleted(net::URLRequest* request, int bytes_read) override {
+    if (bytes_read <= 0) {
+      Finish(bytes_read);
+      return;
+    }
+    body_.append(buffer_->data(), bytes_read);
+    ReadBody();
+  }
+
+ private:
+  // Reads the body until the request is complete or a read is pending.
+  void ReadBody() {
+    int bytes_read = 0;
+    while ((bytes_read = request_->Read(buffer_.get(), kReadBufferSize)) > 0)
+      body_.append(buffer_->data(), bytes_read);
+    if (bytes_read != net::ERR_IO_PENDING)
+      Finish(bytes_read);
+  }
+
+  void Finish(int net_error) {
+    net_error_ = net_error;
+    request_.reset();
+    std::move(done_closure_).Run();
+  }
+
+  std::unique_ptr<net::URLRequest> request_;
+  scoped_refptr<net::IOBuffer> buffer_;
+  base::OnceClosure done_closure_;
+  int net_error_ = net::ERR_IO_PENDING;
+  std::string mime_type_;
+  std::string body_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResponseReader);
+};
+
+}  // namespace
+
+// Test fixture which serves WebUI requests with a URLDataManagerIOSBackend
+// on a real IO thread.
+class URLDataManagerIOSBackendTest : public WebTest {
+ protected:
+  URLDataManagerIOSBackendTest()
+      : WebTest(TestWebThreadBundle::REAL_IO_THREAD) {}
+
+  void SetUp() override {
+    WebTest::SetUp();
+    std::unique_ptr<net::URLRequestJobFactory::ProtocolHandler>
+        protocol_handler =
+            URLDataManagerIOSBackend::CreateProtocolHandler(GetBrowserState());
+    RunOnIOThread(base::BindOnce(
+        &URLDataManagerIOSBackendTest::CreateContextOnIOThread,
+        base::Unretained(this), std::move(protocol_handler)));
+  }
+
+  void TearDown() override {
+    RunOnIOThread(base::BindOnce(
+        &URLDataManagerIOSBackendTest::DestroyContextOnIOThread,
+        base::Unretained(this)));
+    WebTest::TearDown();
+  }
+
+  // Adds a FakeURLDataSource for kSourceName and returns it.
+  FakeURLDataSource* AddDataSource(const std::string& data,
+                                   bool serve_on_io_thread,
+                                   bool is_static,
+                                   bool allow_caching) {
+    FakeURLDataSource* source = new FakeURLDataSource(
+        data, serve_on_io_thread, is_static, allow_caching);
+    URLDataSourceIOS::Add(GetBrowserState(), source);
+    return source;
+  }
+
+  // Requests |path| from kSourceName and waits for the response.
+  std::unique_ptr<ResponseReader> Fetch(const std::string& path) {
+    GURL url(std::string(kTestWebUIScheme) + "://" + kSourceName + "/" + path);
+    base::RunLoop run_loop;
+    auto reader = std::make_unique<ResponseReader>(base::BindOnce(
+        [](base::OnceClosure quit_closure) {
+          base::PostTaskWithTraits(FROM_HERE, {WebThread::UI},
+                                   std::move(quit_closure));
+        },
+        run_loop.QuitClosure()));
+    base::PostTaskWithTraits(
+        FROM_HERE, {WebThread::IO},
+        base::BindOnce(&ResponseReader::Start, base::Unretained(reader.get()),
+                       base::Unretained(context_.get()), url));
+    run_loop.Run();
+    return reader;
+  }
+
+ private:
+  // Runs |task| on the IO thread and waits for it to complete.
+  void RunOnIOThread(base::OnceClosure task) {
+    base::RunLoop run_loop;
+    base::PostTaskWithTraitsAndReply(FROM_HERE, {WebThread::IO},
+                                     std::move(task), run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+  void CreateContextOnIOThread(
+      std::unique_ptr<net::URLRequestJobFactory::ProtocolHandler>
+          protocol_handler) {
+    job_factory_ = std::make_unique<net::URLRequestJobFactoryImpl>();
+    job_factory_->SetProtocolHandler(kTestWebUIScheme,
+                                     std::move(protocol_handler));
+    context_ = std::make_unique<net::TestURLRequestContext>(
+        /*delay_initialization=*/true);
+    context_->set_job_factory(job_factory_.get());
+    context_->Init();
+  }
+
+  void DestroyContextOnIOThread() {
+    context_.reset();
+    job_factory_.reset();
+  }
+
+  // Used on the IO thread.
+  std::unique_ptr<net::URLRequestJobFactoryImpl> job_factory_;
+  std::unique_ptr<net::TestURLRequestContext> context_;
+};
+
+// Tests that a source which does not serve on the IO thread is called on the
+// UI thread.
+TEST_F(URLDataManagerIOSBackendTest, ServeOnUIThread) {
+  FakeURLDataSource* source =
+      AddDataSource("data", /*serve_on_io_thread=*/false, /*is_static=*/false,
+                    /*allow_caching=*/true);
+
+  std::unique_ptr<ResponseReader> reader = Fetch("path");
+  EXPECT_EQ(net::OK, reader->net_error());
+  EXPECT_EQ(kMimeType, reader->mime_type());
+  EXPECT_EQ("data", reader->body());
+  EXPECT_EQ(1, source->request_count());
+  EXPECT_TRUE(source->called_on_ui_thread());
+}
+
+// Tests that a source which serves on the IO thread is never called on the UI
+// thread.
+TEST_F(URLDataManagerIOSBackendTest, ServeOnIOThread) {
+  FakeURLDataSource* source =
+      AddDataSource("data", /*serve_on_io_thread=*/true, /*is_static=*/false,
+                    /*allow_caching=*/true);
+
+  std::unique_ptr<ResponseReader> reader = Fetch("path");
+  EXPECT_EQ(net::OK, reader->net_error());
+  EXPECT_EQ(kMimeType, reader->mime_type());
+  EXPECT_EQ("data", reader->body());
+  EXPECT_EQ(1, source->request_count());
+  EXPECT_FALSE(source->called_on_ui_thread());
+
+  // Resources which are not static are requested every time.
+  reader = Fetch("path");
+  EXPECT_EQ("data", reader->body());
+  EXPECT_EQ(2, source->request_count());
+}
+
+// Tests that the static resources of a source which allows caching are served
+// from the cache, with their mime type.
+TEST_F(URLDataManagerIOSBackendTest, StaticResourceCached) {
+  FakeURLDataSource* source =
+      AddDataSource("data", /*serve_on_io_thread=*/true, /*is_static=*/true,
+                    /*allow_caching=*/true);
+
+  EXPECT_EQ("data", Fetch("path")->body());
+  ASSERT_EQ(1, source->request_count());
+
+  std::unique_ptr<ResponseReader> reader = Fetch("path");
+  EXPECT_EQ(net::OK, reader->net_error());
+  EXPECT_EQ(kMimeType, reader->mime_type());
+  EXPECT_EQ("data", reader->body());
+  EXPECT_EQ(1, source->request_count());
+
+  // Other paths are cached separately.
+  EXPECT_EQ("data", Fetch("other_path")->body());
+  EXPECT_EQ(2, source->request_count());
+}
+
+// Tests that the static resources of a source served on the UI thread are
+// cached too.
+TEST_F(URLDataManagerIOSBackendTest, StaticResourceServedOnUIThreadCached) {
+  FakeURLDataSource* source =
+      AddDataSource("data", /*serve_on_io_thread=*/false, /*is_static=*/true,
+                    /*allow_caching=*/true);
+
+  EXPECT_EQ("data", Fetch("path")->body());
+  EXPECT_EQ("data", Fetch("path")->body());
+  EXPECT_EQ(1, source->request_count());
+}
+
+// Tests that the responses of a source which disallows caching are not cached.
+TEST_F(URLDataManagerIOSBackendTest, CachingDisallowed) {
+  FakeURLDataSource* source =
+      AddDataSource("data", /*serve_on_io_thread=*/true, /*is_static=*/true,
+                    /*allow_caching=*/false);
+
+  EXPECT_EQ("data", Fetch("path")->body());
+  EXPECT_EQ("data", Fetch("path")->body());
+  EXPECT_EQ(2, source->request_count());
+}
+
+// Tests that the cached responses of a source are removed when the source is
+// replaced.
+TEST_F(URLDataManagerIOSBackendTest, CachedResponsesRemovedOnReplacement) {
+  AddDataSource("old data", /*serve_on_io_thread=*/true, /*is_static=*/true,
+                /*allow_caching=*/true);
+  EXPECT_EQ("old data", Fetch("path")->body());
+
+  FakeURLDataSource* new_source =
+      AddDataSource("new data", /*serve_on_io_thread=*/true,
+                    /*is_static=*/true, /*allow_caching=*/true);
+  EXPECT_EQ("new data", Fetch("path")->body());
+  EXPECT_EQ(1, new_source->request_count());
+}
+
+}  // namespace web
@@ -27,6 +27,14 @@ bool URLDataSourceIOS::AllowCaching() const {
   return true;
 }
 
+bool URLDataSourceIOS::ShouldServeOnIOThread(const std::string& path) const {
+  return false;
+}
+
+bool URLDataSourceIOS::IsStaticResource(const std::string& path) const {
+  return false;
+}
+
 std::string URLDataSourceIOS::GetContentSecurityPolicyObjectSrc() const {
   return "object-src 'none';";
 }
@@ -35,6 +35,7 @@ class WebUIIOSDataSourceImpl : public URLDataSourceIOSImpl,
   void SetDefaultResource(int resource_id) override;
   void DisableDenyXFrameOptions() override;
   void UseGzip() override;
+  void ServeOnIOThread() override;
   const ui::TemplateReplacements* GetReplacements() const override;
 
  protected:
@@ -79,6 +80,7 @@ class WebUIIOSDataSourceImpl : public URLDataSourceIOSImpl,
   bool load_time_data_defaults_added_;
   bool replace_existing_source_;
   bool use_gzip_;
+  bool serve_on_io_thread_;
 
   DISALLOW_COPY_AND_ASSIGN(WebUIIOSDataSourceImpl);
 };
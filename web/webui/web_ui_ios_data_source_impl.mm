@@ -28,6 +28,10 @@ WebUIIOSDataSource* WebUIIOSDataSource::Create(const std::string& source_name) {
 // static
 void WebUIIOSDataSource::Add(BrowserState* browser_state,
                              WebUIIOSDataSource* source) {
+  // Sources served on the IO thread must not be modified once added.
+  WebUIIOSDataSourceImpl* impl = static_cast<WebUIIOSDataSourceImpl*>(source);
+  if (impl->serve_on_io_thread_)
+    impl->EnsureLoadTimeDataDefaultsAdded();
   URLDataManagerIOS::AddWebUIIOSDataSource(browser_state, source);
 }
 
@@ -53,6 +57,9 @@ class WebUIIOSDataSourceImpl::InternalDataSource : public URLDataSourceIOS {
     return parent_->replace_existing_source_;
   }
   bool AllowCaching() const override { return false; }
+  bool ShouldServeOnIOThread(const std::string& path) const override {
+    return parent_->serve_on_io_thread_;
+  }
   bool ShouldDenyXFrameOptions() const override {
     return parent_->deny_xframe_options_;
   }
@@ -71,7 +78,8 @@ WebUIIOSDataSourceImpl::WebUIIOSDataSourceImpl(const std::string& source_name)
       default_resource_(-1),
       deny_xframe_options_(true),
       load_time_data_defaults_added_(false),
-      replace_existing_source_(true) {}
+      replace_existing_source_(true),
+      serve_on_io_thread_(false) {}
 
 WebUIIOSDataSourceImpl::~WebUIIOSDataSourceImpl() {}
 
@@ -126,6 +134,10 @@ void WebUIIOSDataSourceImpl::UseGzip() {
   use_gzip_ = true;
 }
 
+void WebUIIOSDataSourceImpl::ServeOnIOThread() {
+  serve_on_io_thread_ = true;
+}
+
 const ui::TemplateReplacements* WebUIIOSDataSourceImpl::GetReplacements()
     const {
   return &replacements_;